@@ -145,6 +145,14 @@ GST_DEBUG_CATEGORY_STATIC (gst_qt_mux_debug);
  *   file to get the headers, but it requires copying all sample data
  *   out of the temp file at EOS, which can be expensive. Downstream does
  *   not need to be seekable, because of the use of the temp file.
+ *   If reserved-max-duration is set as well and downstream is seekable,
+ *   no temp file is used. Instead, space for the moov is reserved after
+ *   the ftyp based on reserved-max-duration and reserved-bytes-per-sec,
+ *   sample data is written straight into the mdat following it, and the
+ *   moov is written into the reserved space at EOS. If the moov turns out
+ *   not to fit, it is written after the mdat instead and the reserved
+ *   space is left as a free atom, so no sample data is ever copied. The
+ *   file is not faststart then and a warning message is posted.
  *
  * - Robust Muxing mode: In this mode, qtmux uses the reserved-max-duration
  *   and reserved-moov-update-period properties to reserve free space
@@ -331,6 +339,7 @@ enum
   PROP_START_GAP_THRESHOLD,
   PROP_FORCE_CREATE_TIMECODE_TRAK,
   PROP_FRAGMENT_MODE,
+  PROP_CHUNK_DURATION,
 };
 
 /* some spare for header size as well */
@@ -358,6 +367,7 @@ enum
 #define DEFAULT_START_GAP_THRESHOLD 0
 #define DEFAULT_FORCE_CREATE_TIMECODE_TRAK FALSE
 #define DEFAULT_FRAGMENT_MODE GST_QT_MUX_FRAGMENT_DASH_OR_MSS
+#define DEFAULT_CHUNK_DURATION 0
 
 static void gst_qt_mux_finalize (GObject * object);
 
@@ -535,7 +545,9 @@ gst_qt_mux_class_init (GstQTMuxClass * klass)
       g_param_spec_uint64 ("reserved-max-duration",
           "Reserved maximum file duration (ns)",
           "When set to a value > 0, reserves space for index tables at the "
-          "beginning of the file.",
+          "beginning of the file. Together with faststart, the index tables "
+          "are written into that space at EOS instead of using a temporary "
+          "file.",
           0, G_MAXUINT64, DEFAULT_RESERVED_MAX_DURATION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class,
@@ -620,6 +632,25 @@ gst_qt_mux_class_init (GstQTMuxClass * klass)
           GST_TYPE_QT_MUX_FRAGMENT_MODE, DEFAULT_FRAGMENT_MODE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstBaseQTMux:chunk-duration:
+   *
+   * When set to a value greater than '0' in the "dash-or-mss" fragment mode,
+   * each fragment is sent out as a series of moof/mdat chunks of about this
+   * duration as soon as each chunk is complete, as used for low-latency CMAF.
+   * New fragments still start at keyframes or when 'fragment-duration' is
+   * reached. Only the moof of the first chunk of a fragment is pushed without
+   * the DELTA_UNIT flag, so downstream can tell where fragments start.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CHUNK_DURATION,
+      g_param_spec_uint ("chunk-duration", "Chunk duration",
+          "Send out fragments in chunks of this duration in ms as soon as "
+          "they're complete (0 = send whole fragments)",
+          0, G_MAXUINT32, DEFAULT_CHUNK_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_qt_mux_request_new_pad);
   gstelement_class->release_pad = GST_DEBUG_FUNCPTR (gst_qt_mux_release_pad);
@@ -677,6 +708,7 @@ gst_qt_mux_pad_reset (GstQTMuxPad * qtpad)
     atom_traf_free (qtpad->traf);
     qtpad->traf = NULL;
   }
+  qtpad->fragment_continues = FALSE;
   atom_array_clear (&qtpad->fragment_buffers);
   if (qtpad->samples)
     g_array_unref (qtpad->samples);
@@ -1926,6 +1958,35 @@ write_error:
   }
 }
 
+/* pushes @list downstream in one go, never to the fast-start file */
+static GstFlowReturn
+gst_qt_mux_send_buffer_list (GstQTMux * qtmux, GstBufferList * list,
+    guint64 * offset)
+{
+  GstFlowReturn res;
+  gsize size;
+
+  size = gst_buffer_list_calculate_size (list);
+  GST_LOG_OBJECT (qtmux, "sending list of %u buffers, size %" G_GSIZE_FORMAT,
+      gst_buffer_list_length (list), size);
+
+  res = gst_qtmux_push_mdat_stored_buffers (qtmux);
+  if (res == GST_FLOW_OK) {
+    res = gst_aggregator_finish_buffer_list (GST_AGGREGATOR (qtmux), list);
+  } else {
+    gst_buffer_list_unref (list);
+  }
+
+  if (res != GST_FLOW_OK)
+    GST_WARNING_OBJECT (qtmux,
+        "Failed to send buffer list size %" G_GSIZE_FORMAT, size);
+
+  if (G_LIKELY (offset))
+    *offset += size;
+
+  return res;
+}
+
 static gboolean
 gst_qt_mux_seek_to_beginning (FILE * f)
 {
@@ -2019,16 +2080,12 @@ fail:
  * we need to record the position of the size field in the stream so we can
  * seek back to it later and update when the streams have finished.
  */
-static GstFlowReturn
-gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
-    gboolean extended, gboolean fsync_after)
+static GstBuffer *
+gst_qt_mux_new_mdat_header (GstQTMux * qtmux, guint64 size, gboolean extended,
+    gboolean fsync_after)
 {
   GstBuffer *buf;
   GstMapInfo map;
-  gboolean mind_fast = FALSE;
-
-  GST_DEBUG_OBJECT (qtmux, "Sending mdat's atom header, "
-      "size %" G_GUINT64_FORMAT, size);
 
   /* if the qtmux state is EOS, really write the mdat, otherwise
    * allow size == 0 for a placeholder atom */
@@ -2065,10 +2122,25 @@ gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
     gst_buffer_unmap (buf, &map);
   }
 
-  GST_LOG_OBJECT (qtmux, "Pushing mdat header");
   if (fsync_after)
     GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_SYNC_AFTER);
 
+  return buf;
+}
+
+static GstFlowReturn
+gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
+    gboolean extended, gboolean fsync_after)
+{
+  GstBuffer *buf;
+  gboolean mind_fast = FALSE;
+
+  GST_DEBUG_OBJECT (qtmux, "Sending mdat's atom header, "
+      "size %" G_GUINT64_FORMAT, size);
+
+  buf = gst_qt_mux_new_mdat_header (qtmux, size, extended, fsync_after);
+
+  GST_LOG_OBJECT (qtmux, "Pushing mdat header");
   mind_fast = qtmux->mux_mode == GST_QT_MUX_MODE_MOOV_AT_END
       && !qtmux->downstream_seekable;
 
@@ -3043,7 +3115,11 @@ gst_qt_mux_start_file (GstQTMux * qtmux)
       qtmux->fragment_mode = GST_QT_MUX_FRAGMENT_STREAMABLE;
     }
   } else if (qtmux->fast_start) {
-    qtmux->mux_mode = GST_QT_MUX_MODE_FAST_START;
+    if (reserved_max_duration != GST_CLOCK_TIME_NONE
+        && reserved_max_duration != 0)
+      qtmux->mux_mode = GST_QT_MUX_MODE_FAST_START_RESERVED;
+    else
+      qtmux->mux_mode = GST_QT_MUX_MODE_FAST_START;
   } else if (reserved_max_duration != GST_CLOCK_TIME_NONE) {
     if (reserved_max_duration == 0) {
       GST_ELEMENT_ERROR (qtmux, STREAM, MUX,
@@ -3078,6 +3154,15 @@ gst_qt_mux_start_file (GstQTMux * qtmux)
       break;
     case GST_QT_MUX_MODE_FAST_START:
       break;                    /* Don't need seekability, ignore */
+    case GST_QT_MUX_MODE_FAST_START_RESERVED:
+      /* Writing the moov into the reserved space requires seeking back,
+       * fall back to going through the temp file otherwise */
+      if (!qtmux->downstream_seekable) {
+        GST_WARNING_OBJECT (qtmux, "downstream is not seekable, will use "
+            "a temporary file instead of reserved space for faststart");
+        qtmux->mux_mode = GST_QT_MUX_MODE_FAST_START;
+      }
+      break;
     case GST_QT_MUX_MODE_FRAGMENTED:
       if (qtmux->fragment_mode == GST_QT_MUX_FRAGMENT_STREAMABLE)
         break;
@@ -3397,6 +3482,56 @@ gst_qt_mux_start_file (GstQTMux * qtmux)
 
       break;
     }
+    case GST_QT_MUX_MODE_FAST_START_RESERVED:
+    {
+      guint64 size = 0, offset = 0;
+
+      ret = gst_qt_mux_prepare_and_send_ftyp (qtmux);
+      if (ret != GST_FLOW_OK)
+        break;
+
+      /* Store this as the moov offset for writing it at EOS */
+      qtmux->moov_pos = qtmux->header_size;
+
+      gst_qt_mux_configure_moov (qtmux);
+      gst_qt_mux_setup_metadata (qtmux);
+      /* The moov without any samples yet is the 'base' size, add the
+       * estimate of the sample tables on top of that */
+      if (!atom_moov_copy_data (qtmux->moov, NULL, &size, &offset))
+        goto serialize_error;
+      qtmux->base_moov_size = offset;
+      qtmux->reserved_moov_size = qtmux->base_moov_size +
+          gst_util_uint64_scale (reserved_max_duration,
+          reserved_bytes_per_sec_per_trak *
+          atom_moov_get_trak_count (qtmux->moov), GST_SECOND);
+
+      GST_DEBUG_OBJECT (qtmux, "Base moov size is %u, reserving header area "
+          "of size %u", qtmux->base_moov_size, qtmux->reserved_moov_size);
+
+      GST_OBJECT_LOCK (qtmux);
+      qtmux->reserved_duration_remaining = reserved_max_duration;
+      GST_OBJECT_UNLOCK (qtmux);
+
+      /* A single free atom covers the reserved space until EOS */
+      ret = gst_qt_mux_send_free_atom (qtmux, &qtmux->header_size,
+          qtmux->reserved_moov_size, FALSE);
+      if (ret != GST_FLOW_OK)
+        return ret;
+
+      /* extra atoms go after the reserved space, before the mdat */
+      ret =
+          gst_qt_mux_send_extra_atoms (qtmux, TRUE, &qtmux->header_size, FALSE);
+      if (ret != GST_FLOW_OK)
+        return ret;
+
+      qtmux->mdat_pos = qtmux->header_size;
+      /* extended atom in case we go over 4GB while writing and need
+       * the full 64-bit atom */
+      ret =
+          gst_qt_mux_send_mdat_header (qtmux, &qtmux->header_size, 0, TRUE,
+          FALSE);
+      break;
+    }
     case GST_QT_MUX_MODE_FAST_START:
       GST_OBJECT_LOCK (qtmux);
       qtmux->fast_start_file = g_fopen (qtmux->fast_start_file_path, "wb+");
@@ -3465,6 +3600,12 @@ reserved_moov_too_small:
         ("Not enough reserved space for creating headers"), (NULL));
     return GST_FLOW_ERROR;
   }
+serialize_error:
+  {
+    GST_ELEMENT_ERROR (qtmux, STREAM, MUX, (NULL),
+        ("Failed to serialize moov"));
+    return GST_FLOW_ERROR;
+  }
 open_failed:
   {
     GST_ELEMENT_ERROR (qtmux, RESOURCE, OPEN_READ_WRITE,
@@ -4085,6 +4226,47 @@ gst_qt_mux_stop_file (GstQTMux * qtmux)
           qtmux->mdat_size, NULL, FALSE);
       return ret;
     }
+    case GST_QT_MUX_MODE_FAST_START_RESERVED:{
+      gst_qt_mux_configure_moov (qtmux);
+      gst_qt_mux_update_edit_lists (qtmux);
+      gst_qt_mux_setup_metadata (qtmux);
+
+      /* chunks position is set relative to the first byte of the
+       * MDAT atom payload. Set the overall offset into the file */
+      atom_moov_chunks_set_offset (qtmux->moov, qtmux->header_size);
+
+      offset = size = 0;
+      if (!atom_moov_copy_data (qtmux->moov, NULL, &size, &offset))
+        goto serialize_error;
+
+      if (offset + 8 <= qtmux->reserved_moov_size) {
+        /* Fits, write the moov padded with a free atom over the reserved
+         * space */
+        gst_qt_mux_seek_to (qtmux, qtmux->moov_pos);
+        ret =
+            gst_qt_mux_send_moov (qtmux, NULL, qtmux->reserved_moov_size,
+            FALSE, FALSE);
+      } else {
+        /* Estimate was too small. Rather than moving all data, leave the
+         * reserved free atom in place and append the moov after the mdat.
+         * The file is not faststart then, so let the application know */
+        GST_ELEMENT_WARNING (qtmux, STREAM, MUX,
+            ("Not enough reserved space for a faststart file, the headers "
+                "are written at the end of the file"),
+            ("Moov of size %" G_GUINT64_FORMAT " does not fit into reserved "
+                "space of %u bytes, increase reserved-max-duration or "
+                "reserved-bytes-per-sec", offset, qtmux->reserved_moov_size));
+        gst_qt_mux_seek_to (qtmux, qtmux->header_size + qtmux->mdat_size);
+        ret = gst_qt_mux_send_moov (qtmux, NULL, 0, FALSE, FALSE);
+      }
+      if (ret != GST_FLOW_OK)
+        return ret;
+
+      /* Finalise by writing the final size into the mdat. No need to seek
+       * back after this, we won't write any more */
+      return gst_qt_mux_update_mdat_size (qtmux, qtmux->mdat_pos,
+          qtmux->mdat_size, NULL, FALSE);
+    }
     default:
       break;
   }
@@ -4226,6 +4408,75 @@ gst_qtmux_pad_collect_traf (GstElement * element, GstPad * pad,
   return TRUE;
 }
 
+/* writes out a moof and mdat for the current fragment, or chunk of it, of a
+ * single stream. The mdat is pushed together with the moof as one buffer list
+ * of the original sample buffers. */
+static GstFlowReturn
+gst_qt_mux_pad_send_fragment (GstQTMux * qtmux, GstQTMuxPad * pad)
+{
+  AtomMOOF *moof;
+  guint64 size = 0, offset = 0;
+  guint8 *data = NULL;
+  GstBuffer *moof_buffer;
+  GstBufferList *list;
+  guint i, n_buffers, total_size;
+  AtomTRUN *first_trun;
+  GstFlowReturn ret;
+
+  n_buffers = atom_array_get_len (&pad->fragment_buffers);
+  total_size = 0;
+  for (i = 0; i < n_buffers; i++) {
+    total_size +=
+        gst_buffer_get_size (atom_array_index (&pad->fragment_buffers, i));
+  }
+
+  moof = atom_moof_new (qtmux->context, qtmux->fragment_sequence);
+  /* takes ownership */
+  atom_moof_add_traf (moof, pad->traf);
+  /* write the offset into the first 'trun'.  All other truns are assumed
+   * to follow on from this trun.  Skip over the mdat header (+12) */
+  atom_moof_copy_data (moof, &data, &size, &offset);
+  first_trun = (AtomTRUN *) pad->traf->truns->data;
+  atom_trun_set_offset (first_trun, offset + 12);
+  pad->traf = NULL;
+  size = offset = 0;
+  atom_moof_copy_data (moof, &data, &size, &offset);
+  moof_buffer = _gst_buffer_new_take_data (data, offset);
+
+  atom_moof_free (moof);
+
+  /* now we know where moof ends up, update offset in tfra */
+  if (pad->tfra)
+    atom_tfra_update_offset (pad->tfra, qtmux->header_size);
+
+  list = gst_buffer_list_new_sized (n_buffers + 2);
+  if (qtmux->chunk_duration > 0 && !pad->chunk_starts_fragment)
+    GST_BUFFER_FLAG_SET (moof_buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  gst_buffer_list_add (list, moof_buffer);
+  gst_buffer_list_add (list,
+      gst_qt_mux_new_mdat_header (qtmux, total_size, FALSE, FALSE));
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = atom_array_index (&pad->fragment_buffers, i);
+
+    if (qtmux->chunk_duration > 0) {
+      /* only the moof marks where a fragment can be decoded from */
+      buf = gst_buffer_make_writable (buf);
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    }
+    gst_buffer_list_add (list, buf);
+  }
+  atom_array_clear (&pad->fragment_buffers);
+
+  GST_LOG_OBJECT (qtmux, "writing moof size %" G_GSIZE_FORMAT " and %u "
+      "buffers, total_size %u", gst_buffer_get_size (moof_buffer), n_buffers,
+      total_size);
+  ret = gst_qt_mux_send_buffer_list (qtmux, list, &qtmux->header_size);
+  if (ret != GST_FLOW_OK)
+    GST_ERROR_OBJECT (qtmux, "Failed to send fragment");
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_qt_mux_pad_fragment_add_buffer (GstQTMux * qtmux, GstQTMuxPad * pad,
     GstBuffer * buf, gboolean force, guint32 nsamples, gint64 dts,
@@ -4233,7 +4484,6 @@ gst_qt_mux_pad_fragment_add_buffer (GstQTMux * qtmux, GstQTMuxPad * pad,
     gint64 pts_offset)
 {
   GstFlowReturn ret = GST_FLOW_OK;
-  guint index = 0;
 
   GST_LOG_OBJECT (pad, "%p %u %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
       pad->traf, force, qtmux->current_chunk_offset, chunk_offset);
@@ -4381,66 +4631,11 @@ flush:
       }
     } else {
       /* not moov-related. writes out moof then mdat for a single stream only */
-      AtomMOOF *moof;
-      guint64 size = 0, offset = 0;
-      guint8 *data = NULL;
-      GstBuffer *moof_buffer;
-      guint i, total_size;
-      AtomTRUN *first_trun;
-
-      total_size = 0;
-      for (i = 0; i < atom_array_get_len (&pad->fragment_buffers); i++) {
-        total_size +=
-            gst_buffer_get_size (atom_array_index (&pad->fragment_buffers, i));
-      }
-
-      moof = atom_moof_new (qtmux->context, qtmux->fragment_sequence);
-      /* takes ownership */
-      atom_moof_add_traf (moof, pad->traf);
-      /* write the offset into the first 'trun'.  All other truns are assumed
-       * to follow on from this trun.  Skip over the mdat header (+12) */
-      atom_moof_copy_data (moof, &data, &size, &offset);
-      first_trun = (AtomTRUN *) pad->traf->truns->data;
-      atom_trun_set_offset (first_trun, offset + 12);
-      pad->traf = NULL;
-      size = offset = 0;
-      atom_moof_copy_data (moof, &data, &size, &offset);
-      moof_buffer = _gst_buffer_new_take_data (data, offset);
-
-      atom_moof_free (moof);
-
-      /* now we know where moof ends up, update offset in tfra */
-      if (pad->tfra)
-        atom_tfra_update_offset (pad->tfra, qtmux->header_size);
-
-      GST_LOG_OBJECT (qtmux, "writing moof size %" G_GSIZE_FORMAT,
-          gst_buffer_get_size (moof_buffer));
-      ret =
-          gst_qt_mux_send_buffer (qtmux, moof_buffer, &qtmux->header_size,
-          FALSE);
-      if (ret != GST_FLOW_OK)
-        goto moof_send_error;
-
-      GST_LOG_OBJECT (qtmux, "writing %d buffers, total_size %d",
-          atom_array_get_len (&pad->fragment_buffers), total_size);
-
-      ret = gst_qt_mux_send_mdat_header (qtmux, &qtmux->header_size, total_size,
-          FALSE, FALSE);
-      if (ret != GST_FLOW_OK)
-        goto mdat_header_send_error;
-
-      for (index = 0; index < atom_array_get_len (&pad->fragment_buffers);
-          index++) {
-        GST_DEBUG_OBJECT (qtmux, "sending fragment %p",
-            atom_array_index (&pad->fragment_buffers, index));
-        ret =
-            gst_qt_mux_send_buffer (qtmux,
-            atom_array_index (&pad->fragment_buffers, index),
-            &qtmux->header_size, FALSE);
-        if (ret != GST_FLOW_OK)
-          goto fragment_buf_send_error;
+      ret = gst_qt_mux_pad_send_fragment (qtmux, pad);
+      if (ret != GST_FLOW_OK) {
+        gst_clear_buffer (&buf);
+        return ret;
       }
-
     }
     atom_array_clear (&pad->fragment_buffers);
     qtmux->fragment_sequence++;
@@ -4475,7 +4670,19 @@ init:
     GST_LOG_OBJECT (pad, "setting up new fragment");
     pad->traf = atom_traf_new (qtmux->context, atom_trak_get_id (pad->trak));
     atom_array_init (&pad->fragment_buffers, 512);
-    pad->fragment_duration = gst_util_uint64_scale (qtmux->fragment_duration,
+    /* a chunk only continues the previous fragment if it wouldn't have been
+     * flushed here in the first place */
+    if (!pad->fragment_continues || (sync && pad->sync) ||
+        pad->fragment_duration < (gint64) delta) {
+      pad->fragment_duration =
+          gst_util_uint64_scale (qtmux->fragment_duration,
+          atom_trak_get_timescale (pad->trak), 1000);
+      pad->chunk_starts_fragment = TRUE;
+    } else {
+      pad->chunk_starts_fragment = FALSE;
+    }
+    pad->fragment_continues = FALSE;
+    pad->chunk_duration = gst_util_uint64_scale (qtmux->chunk_duration,
         atom_trak_get_timescale (pad->trak), 1000);
 
     if (G_UNLIKELY (qtmux->mfra && !pad->tfra)) {
@@ -4530,6 +4737,7 @@ init:
         pts_offset, pad->sync && sync);
     GST_LOG_OBJECT (qtmux, "adding buffer %p to fragments", buf);
     atom_array_append (&pad->fragment_buffers, g_steal_pointer (&buf), 256);
+    pad->chunk_duration -= delta;
   }
   pad->fragment_duration -= delta;
 
@@ -4543,6 +4751,15 @@ init:
   if (G_UNLIKELY (force))
     goto flush;
 
+  /* in chunked mode, send the chunk out as soon as it's complete */
+  if (qtmux->chunk_duration > 0 &&
+      qtmux->fragment_mode != GST_QT_MUX_FRAGMENT_FIRST_MOOV_THEN_FINALISE &&
+      pad->chunk_duration <= 0) {
+    ret = gst_qt_mux_pad_send_fragment (qtmux, pad);
+    qtmux->fragment_sequence++;
+    pad->fragment_continues = TRUE;
+  }
+
   return ret;
 
 moof_send_error:
@@ -4568,20 +4785,6 @@ mdat_header_send_error:
     atom_array_clear (&pad->fragment_buffers);
     gst_clear_buffer (&buf);
 
-    return ret;
-  }
-
-fragment_buf_send_error:
-  {
-    guint i;
-
-    GST_ERROR_OBJECT (qtmux, "Failed to send fragment");
-    for (i = index + 1; i < atom_array_get_len (&pad->fragment_buffers); i++) {
-      gst_buffer_unref (atom_array_index (&pad->fragment_buffers, i));
-    }
-    atom_array_clear (&pad->fragment_buffers);
-    gst_clear_buffer (&buf);
-
     return ret;
   }
 }
@@ -4822,6 +5025,7 @@ gst_qt_mux_register_and_push_sample (GstQTMux * qtmux, GstQTMuxPad * pad,
     }
     case GST_QT_MUX_MODE_MOOV_AT_END:
     case GST_QT_MUX_MODE_FAST_START:
+    case GST_QT_MUX_MODE_FAST_START_RESERVED:
     case GST_QT_MUX_MODE_ROBUST_RECORDING:
       atom_trak_add_samples (pad->trak, nsamples, (gint32) scaled_duration,
           sample_size, chunk_offset, sync, pts_offset);
@@ -4836,6 +5040,13 @@ gst_qt_mux_register_and_push_sample (GstQTMux * qtmux, GstQTMuxPad * pad,
       if (ret == GST_FLOW_OK
           && qtmux->mux_mode == GST_QT_MUX_MODE_ROBUST_RECORDING)
         ret = gst_qt_mux_robust_recording_update (qtmux, pad->total_duration);
+      /* Keep the report of remaining reserved space counting down */
+      if (qtmux->mux_mode == GST_QT_MUX_MODE_FAST_START_RESERVED) {
+        GST_OBJECT_LOCK (qtmux);
+        if (pad->total_duration > qtmux->muxed_since_last_update)
+          qtmux->muxed_since_last_update = pad->total_duration;
+        GST_OBJECT_UNLOCK (qtmux);
+      }
       break;
     case GST_QT_MUX_MODE_FRAGMENTED:
       /* ensure that always sync samples are marked as such */
@@ -7180,6 +7391,9 @@ gst_qt_mux_get_property (GObject * object,
       g_value_set_enum (value, mode);
       break;
     }
+    case PROP_CHUNK_DURATION:
+      g_value_set_uint (value, qtmux->chunk_duration);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -7280,6 +7494,9 @@ gst_qt_mux_set_property (GObject * object,
         qtmux->fragment_mode = mode;
       break;
     }
+    case PROP_CHUNK_DURATION:
+      qtmux->chunk_duration = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
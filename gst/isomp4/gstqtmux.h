@@ -155,6 +155,12 @@ struct _GstQTMuxPad
   ATOM_ARRAY (GstBuffer *) fragment_buffers;
   /* running fragment duration */
   gint64 fragment_duration;
+  /* running chunk duration, in chunked mode */
+  gint64 chunk_duration;
+  /* whether the next chunk continues the current fragment */
+  gboolean fragment_continues;
+  /* whether the current chunk starts a fragment */
+  gboolean chunk_starts_fragment;
   /* optional fragment index book-keeping */
   AtomTFRA *tfra;
 
@@ -206,6 +212,7 @@ typedef enum _GstQtMuxMode {
     GST_QT_MUX_MODE_FAST_START,
     GST_QT_MUX_MODE_ROBUST_RECORDING,
     GST_QT_MUX_MODE_ROBUST_RECORDING_PREFILL,
+    GST_QT_MUX_MODE_FAST_START_RESERVED,
 } GstQtMuxMode;
 
 /**
@@ -245,7 +252,7 @@ struct _GstQTMux
   /* accumulated size of raw media data (not including mdat header) */
   guint64 mdat_size;
   /* position of the moov (for fragmented mode) or reserved moov atom
-   * area (for robust-muxing mode) */
+   * area (for robust-muxing and reserved faststart modes) */
   guint64 moov_pos;
   /* position of mdat atom header (for later updating of size) in
    * moov-at-end, fragmented and robust-muxing modes */
@@ -308,6 +315,9 @@ struct _GstQTMux
   gchar *fast_start_file_path;
   gchar *moov_recov_file_path;
   guint32 fragment_duration;
+  /* duration of the chunks fragments are sent out in, 0 for whole
+   * fragments */
+  guint32 chunk_duration;
   /* Whether or not to work in 'streamable' mode and not
    * seek to rewrite headers - only valid for fragmented
    * mode. Deprecated */
@@ -117,9 +117,17 @@ typedef struct _QtDemuxAavdEncryptionInfo QtDemuxAavdEncryptionInfo;
 enum
 {
   PROP_0,
-  PROP_MAX_AUDIO_SAMPLES
+  PROP_MAX_AUDIO_SAMPLES,
+  PROP_BACKGROUND_INDEX,
+  PROP_STATS
 };
 
+#define DEFAULT_BACKGROUND_INDEX FALSE
+
+/* number of samples parsed per step by the index thread, between which the
+ * object lock is released */
+#define QTDEMUX_INDEX_STEP 4096
+
 /* Macros for converting to/from timescale */
 #define QTSTREAMTIME_TO_GSTTIME(stream, value) (gst_util_uint64_scale((value), GST_SECOND, (stream)->timescale))
 #define GSTTIME_TO_QTSTREAMTIME(stream, value) (gst_util_uint64_scale((value), (stream)->timescale, GST_SECOND))
@@ -127,16 +135,20 @@ enum
 #define QTTIME_TO_GSTTIME(qtdemux, value) (gst_util_uint64_scale((value), GST_SECOND, (qtdemux)->timescale))
 #define GSTTIME_TO_QTTIME(qtdemux, value) (gst_util_uint64_scale((value), (qtdemux)->timescale, GST_SECOND))
 
+#define QTSAMPLE_INDEX(stream,sample) ((guint32) ((sample) - (stream)->samples))
+#define QTSAMPLE_PTS_OFFSET(stream,sample) ((stream)->pts_offsets ? (stream)->pts_offsets[QTSAMPLE_INDEX ((stream), (sample))] : 0)
+#define QTSAMPLE_IS_KEYFRAME(stream,index) (((stream)->keyframes[(index) >> 5] >> ((index) & 31)) & 1)
+
 /* timestamp is the DTS */
 #define QTSAMPLE_DTS(stream,sample) (QTSTREAMTIME_TO_GSTTIME((stream), (sample)->timestamp))
 /* timestamp + offset + cslg_shift is the outgoing PTS */
-#define QTSAMPLE_PTS(stream,sample) (QTSTREAMTIME_TO_GSTTIME((stream), (sample)->timestamp + (stream)->cslg_shift + (sample)->pts_offset))
+#define QTSAMPLE_PTS(stream,sample) (QTSTREAMTIME_TO_GSTTIME((stream), (sample)->timestamp + (stream)->cslg_shift + QTSAMPLE_PTS_OFFSET ((stream), (sample))))
 /* timestamp + offset is the PTS used for internal seek calculations */
-#define QTSAMPLE_PTS_NO_CSLG(stream,sample) (QTSTREAMTIME_TO_GSTTIME((stream), (sample)->timestamp + (sample)->pts_offset))
+#define QTSAMPLE_PTS_NO_CSLG(stream,sample) (QTSTREAMTIME_TO_GSTTIME((stream), (sample)->timestamp + QTSAMPLE_PTS_OFFSET ((stream), (sample))))
 /* timestamp + duration - dts is the duration */
 #define QTSAMPLE_DUR_DTS(stream, sample, dts) (QTSTREAMTIME_TO_GSTTIME ((stream), (sample)->timestamp + (sample)->duration) - (dts))
 
-#define QTSAMPLE_KEYFRAME(stream,sample) ((stream)->all_keyframe || (sample)->keyframe)
+#define QTSAMPLE_KEYFRAME(stream,sample) ((stream)->all_keyframe || QTSAMPLE_IS_KEYFRAME ((stream), QTSAMPLE_INDEX ((stream), (sample))))
 
 #define QTDEMUX_EXPOSE_GET_LOCK(demux) (&((demux)->expose_lock))
 #define QTDEMUX_EXPOSE_LOCK(demux) G_STMT_START { \
@@ -388,6 +400,7 @@ static void gst_qtdemux_append_protection_system_id (GstQTDemux * qtdemux,
     const gchar * id);
 static void qtdemux_gst_structure_free (GstStructure * gststructure);
 static void gst_qtdemux_reset (GstQTDemux * qtdemux, gboolean hard);
+static void gst_qtdemux_stop_index_thread (GstQTDemux * qtdemux);
 
 static void
 gst_qtdemux_set_property (GObject * object, guint prop_id,
@@ -400,6 +413,9 @@ gst_qtdemux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_AUDIO_SAMPLES:
       qtdemux->max_audio_samples = g_value_get_uint (value);
       break;
+    case PROP_BACKGROUND_INDEX:
+      qtdemux->background_index = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -418,6 +434,15 @@ gst_qtdemux_get_property (GObject * object,
     case PROP_MAX_AUDIO_SAMPLES:
       g_value_set_uint (value, qtdemux->max_audio_samples);
       break;
+    case PROP_BACKGROUND_INDEX:
+      g_value_set_boolean (value, qtdemux->background_index);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_structure_new ("application/x-qtdemux-stats",
+              "bytes-shared", G_TYPE_UINT64, qtdemux->bytes_shared,
+              "bytes-copied", G_TYPE_UINT64, qtdemux->bytes_copied, NULL));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -469,6 +494,42 @@ gst_qtdemux_class_init (GstQTDemuxClass * klass)
           "Maximum raw audio samples per buffer", 1, G_MAXUINT, 4096,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstQTDemux:background-index:
+   *
+   * Parse the sample tables of non-fragmented files in a background thread
+   * once the streams are exposed. Playback starts as soon as the headers
+   * are parsed either way, this avoids the first seek in a long file having
+   * to parse the complete index first.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BACKGROUND_INDEX,
+      g_param_spec_boolean ("background-index", "Background index",
+          "Build the sample index in a background thread",
+          DEFAULT_BACKGROUND_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstQTDemux:stats:
+   *
+   * Statistics about the sample data pushed in push mode, in a
+   * #GstStructure named application/x-qtdemux-stats:
+   *
+   * * "bytes-shared" G_TYPE_UINT64: bytes pushed as sub-buffers of the
+   *   upstream buffers, without copying
+   * * "bytes-copied" G_TYPE_UINT64: bytes that had to be copied because a
+   *   sample spanned several upstream buffers
+   *
+   * The counters are reset when going back to the READY state.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Statistics about shared and copied sample data in push mode",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (qtdemux_debug, "qtdemux", 0, "qtdemux plugin");
   gst_riff_init ();
 }
@@ -495,6 +556,7 @@ gst_qtdemux_init (GstQTDemux * qtdemux)
       ((GDestroyNotify) gst_qtdemux_stream_unref);
   qtdemux->old_streams = g_ptr_array_new_with_free_func
       ((GDestroyNotify) gst_qtdemux_stream_unref);
+  qtdemux->background_index = DEFAULT_BACKGROUND_INDEX;
 
   GST_OBJECT_FLAG_SET (qtdemux, GST_ELEMENT_FLAG_INDEXABLE);
 
@@ -516,6 +578,8 @@ gst_qtdemux_dispose (GObject * object)
 {
   GstQTDemux *qtdemux = GST_QTDEMUX (object);
 
+  gst_qtdemux_stop_index_thread (qtdemux);
+
   if (qtdemux->adapter) {
     g_object_unref (G_OBJECT (qtdemux->adapter));
     qtdemux->adapter = NULL;
@@ -906,6 +970,21 @@ find_func (QtDemuxSample * s1, gint64 * media_time, gpointer user_data)
   return -1;
 }
 
+/* the index of the last sample whose entry has been filled in. The index
+ * thread may be parsing further ahead, qtdemux_parse_samples() only publishes
+ * the new value under the object lock once the entries are written. */
+static gint64
+qtdemux_stream_get_stbl_index (GstQTDemux * qtdemux, QtDemuxStream * str)
+{
+  gint64 stbl_index;
+
+  GST_OBJECT_LOCK (qtdemux);
+  stbl_index = str->stbl_index;
+  GST_OBJECT_UNLOCK (qtdemux);
+
+  return stbl_index;
+}
+
 /* find the index of the sample that includes the data for @media_time using a
  * binary search.  Only to be called in optimized cases of linear search below.
  *
@@ -922,9 +1001,9 @@ gst_qtdemux_find_index (GstQTDemux * qtdemux, QtDemuxStream * str,
   media_time =
       gst_util_uint64_scale_ceil (media_time, str->timescale, GST_SECOND);
 
-  result = gst_util_array_binary_search (str->samples, str->stbl_index + 1,
-      sizeof (QtDemuxSample), (GCompareDataFunc) find_func,
-      GST_SEARCH_MODE_BEFORE, &media_time, NULL);
+  result = gst_util_array_binary_search (str->samples,
+      qtdemux_stream_get_stbl_index (qtdemux, str) + 1, sizeof (QtDemuxSample),
+      (GCompareDataFunc) find_func, GST_SEARCH_MODE_BEFORE, &media_time, NULL);
 
   if (G_LIKELY (result))
     index = result - str->samples;
@@ -987,6 +1066,7 @@ gst_qtdemux_find_index_linear (GstQTDemux * qtdemux, QtDemuxStream * str,
 {
   guint32 index = 0;
   guint64 mov_time;
+  gint64 stbl_index;
   QtDemuxSample *sample;
 
   /* convert media_time to mov format */
@@ -994,12 +1074,13 @@ gst_qtdemux_find_index_linear (GstQTDemux * qtdemux, QtDemuxStream * str,
       gst_util_uint64_scale_ceil (media_time, str->timescale, GST_SECOND);
 
   sample = str->samples;
-  if (mov_time == sample->timestamp + sample->pts_offset)
+  if (mov_time == sample->timestamp + QTSAMPLE_PTS_OFFSET (str, sample))
     return index;
 
   /* use faster search if requested time in already parsed range */
-  sample = str->samples + str->stbl_index;
-  if (str->stbl_index >= 0 && mov_time <= sample->timestamp) {
+  stbl_index = qtdemux_stream_get_stbl_index (qtdemux, str);
+  sample = str->samples + stbl_index;
+  if (stbl_index >= 0 && mov_time <= sample->timestamp) {
     index = gst_qtdemux_find_index (qtdemux, str, media_time);
     sample = str->samples + index;
   } else {
@@ -1019,7 +1100,8 @@ gst_qtdemux_find_index_linear (GstQTDemux * qtdemux, QtDemuxStream * str,
 
   /* sample->timestamp is now <= media_time, need to find the corresponding
    * PTS now by looking backwards */
-  while (index > 0 && sample->timestamp + sample->pts_offset > mov_time) {
+  while (index > 0
+      && sample->timestamp + QTSAMPLE_PTS_OFFSET (str, sample) > mov_time) {
     index--;
     sample = str->samples + index;
   }
@@ -1061,7 +1143,7 @@ gst_qtdemux_find_keyframe (GstQTDemux * qtdemux, QtDemuxStream * str,
     if (next && !qtdemux_parse_samples (qtdemux, str, new_index))
       goto parse_failed;
 
-    if (str->samples[new_index].keyframe)
+    if (QTSAMPLE_IS_KEYFRAME (str, new_index))
       break;
 
     if (new_index == 0)
@@ -1219,7 +1301,7 @@ gst_qtdemux_adjust_seek (GstQTDemux * qtdemux, gint64 desired_time,
 
     /* shift to next frame if we are looking for next keyframe */
     if (next && QTSAMPLE_PTS_NO_CSLG (str, &str->samples[index]) < media_start
-        && index < str->stbl_index)
+        && index < qtdemux_stream_get_stbl_index (qtdemux, str))
       index++;
 
     if (!empty_segment) {
@@ -2026,6 +2108,7 @@ gst_qtdemux_reset (GstQTDemux * qtdemux, gboolean hard)
 
   GST_DEBUG_OBJECT (qtdemux, "Resetting demux");
   gst_pad_stop_task (qtdemux->sinkpad);
+  gst_qtdemux_stop_index_thread (qtdemux);
 
   if (hard || qtdemux->upstream_format_is_time) {
     qtdemux->state = QTDEMUX_STATE_INITIAL;
@@ -2086,6 +2169,16 @@ gst_qtdemux_reset (GstQTDemux * qtdemux, gboolean hard)
 
     qtdemux->received_seek = FALSE;
     qtdemux->first_moof_already_parsed = FALSE;
+
+    GST_OBJECT_LOCK (qtdemux);
+    if (qtdemux->bytes_shared || qtdemux->bytes_copied) {
+      GST_INFO_OBJECT (qtdemux, "pushed %" G_GUINT64_FORMAT " bytes shared "
+          "with upstream buffers, %" G_GUINT64_FORMAT " bytes copied",
+          qtdemux->bytes_shared, qtdemux->bytes_copied);
+      qtdemux->bytes_shared = 0;
+      qtdemux->bytes_copied = 0;
+    }
+    GST_OBJECT_UNLOCK (qtdemux);
   }
   qtdemux->offset = 0;
   gst_adapter_clear (qtdemux->adapter);
@@ -2532,6 +2625,64 @@ gst_qtdemux_stbl_free (QtDemuxStream * stream)
   stream->ctts.data = NULL;
 }
 
+static void
+qtdemux_stream_free_samples (QtDemuxStream * stream)
+{
+  g_free (stream->samples);
+  stream->samples = NULL;
+  g_free (stream->pts_offsets);
+  stream->pts_offsets = NULL;
+  g_free (stream->keyframes);
+  stream->keyframes = NULL;
+}
+
+/* grow the sample table of @stream from stream->n_samples to @n_samples
+ * entries, pts offsets are only stored once a sample has one. Every entry is
+ * allocated here, there is no compressed or lazily decoded index, so memory
+ * use still grows linearly with the number of samples */
+static gboolean
+qtdemux_stream_alloc_samples (QtDemuxStream * stream, guint32 n_samples,
+    gboolean pts_offsets)
+{
+  guint32 old_n_samples = stream->samples ? stream->n_samples : 0;
+  guint32 old_n_words = (old_n_samples + 31) / 32;
+  guint32 n_words = (n_samples + 31) / 32;
+
+  stream->samples = g_try_renew (QtDemuxSample, stream->samples, n_samples);
+  if (!stream->samples)
+    return FALSE;
+  if (old_n_samples == 0)
+    memset (stream->samples, 0, n_samples * sizeof (QtDemuxSample));
+
+  stream->keyframes = g_try_renew (guint32, stream->keyframes, n_words);
+  if (!stream->keyframes)
+    return FALSE;
+  memset (stream->keyframes + old_n_words, 0,
+      (n_words - old_n_words) * sizeof (guint32));
+
+  if (pts_offsets || stream->pts_offsets) {
+    if (!stream->pts_offsets)
+      old_n_samples = 0;
+    stream->pts_offsets = g_try_renew (gint32, stream->pts_offsets, n_samples);
+    if (!stream->pts_offsets)
+      return FALSE;
+    memset (stream->pts_offsets + old_n_samples, 0,
+        (n_samples - old_n_samples) * sizeof (gint32));
+  }
+
+  return TRUE;
+}
+
+static inline void
+qtdemux_stream_set_keyframe (QtDemuxStream * stream, guint32 index,
+    gboolean keyframe)
+{
+  if (keyframe)
+    stream->keyframes[index >> 5] |= 1U << (index & 31);
+  else
+    stream->keyframes[index >> 5] &= ~(1U << (index & 31));
+}
+
 static void
 gst_qtdemux_stream_flush_segments_data (QtDemuxStream * stream)
 {
@@ -2544,8 +2695,7 @@ gst_qtdemux_stream_flush_segments_data (QtDemuxStream * stream)
 static void
 gst_qtdemux_stream_flush_samples_data (QtDemuxStream * stream)
 {
-  g_free (stream->samples);
-  stream->samples = NULL;
+  qtdemux_stream_free_samples (stream);
   gst_qtdemux_stbl_free (stream);
 
   /* fragments */
@@ -3371,15 +3521,12 @@ qtdemux_parse_trun (GstQTDemux * qtdemux, GstByteReader * trun,
       (stream->n_samples + samples_count) *
       sizeof (QtDemuxSample) / (1024.0 * 1024.0));
 
-  /* create a new array of samples if it's the first sample parsed */
-  if (stream->n_samples == 0) {
+  /* create a new array of samples if it's the first sample parsed, or
+   * reallocate it with space enough to insert the new samples */
+  if (stream->n_samples == 0)
     g_assert (stream->samples == NULL);
-    stream->samples = g_try_new0 (QtDemuxSample, samples_count);
-    /* or try to reallocate it with space enough to insert the new samples */
-  } else
-    stream->samples = g_try_renew (QtDemuxSample, stream->samples,
-        stream->n_samples + samples_count);
-  if (stream->samples == NULL)
+  if (!qtdemux_stream_alloc_samples (stream, stream->n_samples + samples_count,
+          flags & TR_COMPOSITION_TIME_OFFSETS))
     goto out_of_memory;
 
   if (qtdemux->fragment_start != -1) {
@@ -3474,14 +3621,16 @@ qtdemux_parse_trun (GstQTDemux * qtdemux, GstByteReader * trun,
 
     /* fill the sample information */
     sample->offset = *running_offset;
-    sample->pts_offset = ct;
+    if (stream->pts_offsets)
+      stream->pts_offsets[stream->n_samples + i] = ct;
     sample->size = size;
     sample->timestamp = timestamp;
     sample->duration = dur;
     /* sample-is-difference-sample */
     /* ismv seems to use 0x40 for keyframe, 0xc0 for non-keyframe,
      * now idea how it relates to bitfield other than massive LE/BE confusion */
-    sample->keyframe = ismv ? ((sflags & 0xff) == 0x40) : !(sflags & 0x10000);
+    qtdemux_stream_set_keyframe (stream, stream->n_samples + i,
+        ismv ? ((sflags & 0xff) == 0x40) : !(sflags & 0x10000));
     *running_offset += size;
     timestamp += dur;
     stream->duration_moof += dur;
@@ -4749,7 +4898,7 @@ gst_qtdemux_seek_to_previous_keyframe (GstQTDemux * qtdemux)
 
   target_ts =
       ref_str->samples[k_index].timestamp +
-      ref_str->samples[k_index].pts_offset;
+      QTSAMPLE_PTS_OFFSET (ref_str, &ref_str->samples[k_index]);
 
   /* get current segment for that stream */
   seg = &ref_str->segments[ref_str->segment_index];
@@ -4846,8 +4995,8 @@ gst_qtdemux_seek_to_previous_keyframe (GstQTDemux * qtdemux)
     /* Remember until where we want to go */
     str->to_sample = str->from_sample - 1;
     /* Define our time position */
-    target_ts =
-        str->samples[k_index].timestamp + str->samples[k_index].pts_offset;
+    target_ts = str->samples[k_index].timestamp +
+        QTSAMPLE_PTS_OFFSET (str, &str->samples[k_index]);
     str->time_position = QTSTREAMTIME_TO_GSTTIME (str, target_ts) + seg->time;
     if (seg->media_start != GST_CLOCK_TIME_NONE)
       str->time_position -= seg->media_start;
@@ -6228,8 +6377,7 @@ gst_qtdemux_do_fragmented_seek (GstQTDemux * qtdemux)
 
     stream = QTDEMUX_NTH_STREAM (qtdemux, i);
 
-    g_free (stream->samples);
-    stream->samples = NULL;
+    qtdemux_stream_free_samples (stream);
     stream->n_samples = 0;
     stream->stbl_index = -1;    /* no samples have yet been parsed */
     stream->sample_index = -1;
@@ -7045,6 +7193,26 @@ gst_qtdemux_chain (GstPad * sinkpad, GstObject * parent, GstBuffer * inbuf)
   return gst_qtdemux_process_adapter (demux, FALSE);
 }
 
+/* takes @size bytes of sample data from the adapter, the adapter returns a
+ * sub-buffer of the upstream buffer when the sample lies within one and
+ * only has to copy when it spans several */
+static GstBuffer *
+gst_qtdemux_take_sample_buffer (GstQTDemux * demux, gsize size)
+{
+  GST_OBJECT_LOCK (demux);
+  if (gst_adapter_available_fast (demux->adapter) >= size)
+    demux->bytes_shared += size;
+  else
+    demux->bytes_copied += size;
+  GST_OBJECT_UNLOCK (demux);
+
+  GST_LOG_OBJECT (demux, "taking %" G_GSIZE_FORMAT " bytes, %" G_GUINT64_FORMAT
+      " bytes shared, %" G_GUINT64_FORMAT " bytes copied so far", size,
+      demux->bytes_shared, demux->bytes_copied);
+
+  return gst_adapter_take_buffer (demux->adapter, size);
+}
+
 static GstFlowReturn
 gst_qtdemux_process_adapter (GstQTDemux * demux, gboolean force)
 {
@@ -7574,8 +7742,7 @@ gst_qtdemux_process_adapter (GstQTDemux * demux, gboolean force)
           } else {
             GstBuffer *outbuf;
 
-            outbuf =
-                gst_adapter_take_buffer (demux->adapter, demux->neededbytes);
+            outbuf = gst_qtdemux_take_sample_buffer (demux, demux->neededbytes);
 
             /* FIXME: should either be an assert or a plain check */
             g_return_val_if_fail (outbuf != NULL, GST_FLOW_ERROR);
@@ -9441,8 +9608,8 @@ done:
   }
 
   g_assert (stream->samples == NULL);
-  stream->samples = g_try_new0 (QtDemuxSample, stream->n_samples);
-  if (!stream->samples) {
+  if (!qtdemux_stream_alloc_samples (stream, stream->n_samples,
+          stream->ctts_present)) {
     GST_WARNING_OBJECT (qtdemux, "failed to allocate %d samples",
         stream->n_samples);
     return FALSE;
@@ -9510,11 +9677,10 @@ qtdemux_parse_samples (GstQTDemux * qtdemux, QtDemuxStream * stream, guint32 n)
   /* pointer to the sample table */
   samples = stream->samples;
 
-  /* starts from -1, moves to the next sample index to parse */
-  stream->stbl_index++;
-
-  /* keep track of the first and last sample to fill */
-  first = &samples[stream->stbl_index];
+  /* keep track of the first and last sample to fill. stbl_index starts from
+   * -1 and is only moved to @n once they are all filled, so that it never
+   * covers entries that are still being written. */
+  first = &samples[stream->stbl_index + 1];
   last = &samples[n];
 
   if (!stream->chunks_are_samples) {
@@ -9631,7 +9797,7 @@ qtdemux_parse_samples (GstQTDemux * qtdemux, QtDemuxStream * stream, guint32 n)
 
         cur->timestamp = stream->stco_sample_index;
         cur->duration = stream->samples_per_chunk;
-        cur->keyframe = TRUE;
+        qtdemux_stream_set_keyframe (stream, j, TRUE);
         cur++;
 
         stream->stco_sample_index += stream->samples_per_chunk;
@@ -9766,7 +9932,7 @@ done3:
 
           if (G_LIKELY (index > 0 && index <= n_samples)) {
             index -= 1;
-            samples[index].keyframe = TRUE;
+            qtdemux_stream_set_keyframe (stream, index, TRUE);
             GST_DEBUG_OBJECT (qtdemux, "samples at %u is keyframe", index);
             /* and exit if we have enough samples */
             if (G_UNLIKELY (index >= n)) {
@@ -9796,7 +9962,7 @@ done3:
 
             if (G_LIKELY (index > 0 && index <= n_samples)) {
               index -= 1;
-              samples[index].keyframe = TRUE;
+              qtdemux_stream_set_keyframe (stream, index, TRUE);
               GST_DEBUG_OBJECT (qtdemux, "samples at %u is keyframe", index);
               /* and exit if we have enough samples */
               if (G_UNLIKELY (index >= n)) {
@@ -9841,7 +10007,7 @@ ctts:
       ctts_soffset = stream->ctts_soffset;
 
       for (j = stream->ctts_sample_index; j < ctts_count; j++) {
-        cur->pts_offset = ctts_soffset;
+        stream->pts_offsets[cur - samples] = ctts_soffset;
         cur++;
 
         if (G_UNLIKELY (cur > last)) {
@@ -13295,6 +13461,84 @@ qtdemux_update_streams (GstQTDemux * qtdemux)
   return TRUE;
 }
 
+static gpointer
+gst_qtdemux_index_thread_func (GstQTDemux * qtdemux)
+{
+  guint i;
+
+  GST_DEBUG_OBJECT (qtdemux, "building index in the background");
+
+  for (i = 0; i < qtdemux->index_streams->len; i++) {
+    QtDemuxStream *stream = g_ptr_array_index (qtdemux->index_streams, i);
+    gint64 stbl_index;
+
+    while (!g_atomic_int_get (&qtdemux->index_thread_stop)) {
+      GST_OBJECT_LOCK (qtdemux);
+      stbl_index = stream->stbl_index;
+      GST_OBJECT_UNLOCK (qtdemux);
+
+      if (stbl_index + 1 >= stream->n_samples)
+        break;
+
+      /* takes the object lock, so the streaming and seeking threads
+       * can parse what they need in between */
+      if (!qtdemux_parse_samples (qtdemux, stream,
+              MIN (stbl_index + QTDEMUX_INDEX_STEP, stream->n_samples - 1))) {
+        GST_WARNING_OBJECT (qtdemux, "Building index of track-id %u failed",
+            stream->track_id);
+        break;
+      }
+    }
+  }
+
+  GST_DEBUG_OBJECT (qtdemux, "done building index");
+
+  return NULL;
+}
+
+static void
+gst_qtdemux_start_index_thread (GstQTDemux * qtdemux)
+{
+  GError *err = NULL;
+  guint i;
+
+  if (!qtdemux->background_index || qtdemux->fragmented)
+    return;
+
+  g_assert (qtdemux->index_thread == NULL);
+
+  qtdemux->index_streams = g_ptr_array_new_with_free_func
+      ((GDestroyNotify) gst_qtdemux_stream_unref);
+  for (i = 0; i < QTDEMUX_N_STREAMS (qtdemux); i++)
+    g_ptr_array_add (qtdemux->index_streams,
+        gst_qtdemux_stream_ref (QTDEMUX_NTH_STREAM (qtdemux, i)));
+
+  g_atomic_int_set (&qtdemux->index_thread_stop, FALSE);
+  qtdemux->index_thread = g_thread_try_new ("qtdemux-index",
+      (GThreadFunc) gst_qtdemux_index_thread_func, qtdemux, &err);
+  if (!qtdemux->index_thread) {
+    GST_WARNING_OBJECT (qtdemux, "Could not start index thread: %s",
+        err->message);
+    g_error_free (err);
+    g_ptr_array_free (qtdemux->index_streams, TRUE);
+    qtdemux->index_streams = NULL;
+  }
+}
+
+static void
+gst_qtdemux_stop_index_thread (GstQTDemux * qtdemux)
+{
+  if (!qtdemux->index_thread)
+    return;
+
+  g_atomic_int_set (&qtdemux->index_thread_stop, TRUE);
+  g_thread_join (qtdemux->index_thread);
+  qtdemux->index_thread = NULL;
+
+  g_ptr_array_free (qtdemux->index_streams, TRUE);
+  qtdemux->index_streams = NULL;
+}
+
 /* Must be called with expose lock */
 static GstFlowReturn
 qtdemux_expose_streams (GstQTDemux * qtdemux)
@@ -13303,6 +13547,8 @@ qtdemux_expose_streams (GstQTDemux * qtdemux)
 
   GST_DEBUG_OBJECT (qtdemux, "exposing streams");
 
+  gst_qtdemux_stop_index_thread (qtdemux);
+
   if (!qtdemux_is_streams_update (qtdemux)) {
     GST_DEBUG_OBJECT (qtdemux, "Reuse all streams");
     for (i = 0; i < QTDEMUX_N_STREAMS (qtdemux); i++) {
@@ -13314,6 +13560,7 @@ qtdemux_expose_streams (GstQTDemux * qtdemux)
 
     g_ptr_array_set_size (qtdemux->old_streams, 0);
     qtdemux->need_segment = TRUE;
+    gst_qtdemux_start_index_thread (qtdemux);
 
     return GST_FLOW_OK;
   }
@@ -13380,6 +13627,8 @@ qtdemux_expose_streams (GstQTDemux * qtdemux)
   qtdemux->need_segment = TRUE;
 
   qtdemux->exposed = TRUE;
+  gst_qtdemux_start_index_thread (qtdemux);
+
   return GST_FLOW_OK;
 }
 
@@ -263,6 +263,19 @@ struct _GstQTDemux {
   /** Maximum number of audio samples per buffer when demuxing raw audio.
    * Used to determine max buffer size for raw audio streams. */
   guint max_audio_samples;
+
+  /* When set, the sample tables of non-fragmented files are parsed by
+   * index_thread once the streams are exposed, instead of on the first
+   * seek. index_streams holds a ref on the streams it works on. */
+  gboolean background_index;
+  GThread *index_thread;
+  GPtrArray *index_streams;
+  gint index_thread_stop;
+  /* push mode, bytes of sample data that were pushed as sub-buffers of
+   * upstream buffers and bytes that had to be copied because the sample
+   * spans several of them */
+  guint64 bytes_shared;
+  guint64 bytes_copied;
 };
 
 struct _GstQTDemuxClass {
@@ -308,14 +321,16 @@ struct _QtDemuxStreamStsdEntry
 
 };
 
+/* one fully expanded entry per sample, 24 bytes. The pts offset and
+ * keyframe flag of a sample are kept in the pts_offsets and keyframes tables
+ * of the stream instead, which only makes the entry smaller: the whole table
+ * is still allocated up front by qtdemux_parse_samples() */
 struct _QtDemuxSample
 {
-  guint32 size;
-  gint32 pts_offset;            /* Add this value to timestamp to get the pts */
   guint64 offset;
   guint64 timestamp;            /* DTS In mov time */
+  guint32 size;
   guint32 duration;             /* In mov time */
-  gboolean keyframe;            /* TRUE when this packet is a keyframe */
 };
 
 struct _QtDemuxStream
@@ -358,6 +373,10 @@ struct _QtDemuxStream
   /* our samples */
   guint32 n_samples;
   QtDemuxSample *samples;
+  gint32 *pts_offsets;          /* Add this value to the timestamp of a sample
+                                 * to get the pts, NULL when there are no
+                                 * composition offsets */
+  guint32 *keyframes;           /* bitmap of the samples that are keyframes */
   gboolean all_keyframe;        /* TRUE when all samples are keyframes (no stss) */
   guint32 n_samples_moof;       /* sample count in a moof */
   guint64 duration_moof;        /* duration in timescale of a moof, used for figure out
@@ -332,6 +332,11 @@ gst_matroska_demux_reset (GstElement * element)
     demux->clusters = NULL;
   }
 
+  if (demux->cluster_index) {
+    g_array_free (demux->cluster_index, TRUE);
+    demux->cluster_index = NULL;
+  }
+
   g_list_foreach (demux->seek_parsed,
       (GFunc) gst_matroska_read_common_free_parsed_el, NULL);
   g_list_free (demux->seek_parsed);
@@ -2521,6 +2526,40 @@ gst_matroska_demux_scan_back_for_keyframe_cluster (GstMatroskaDemux * demux,
   return FALSE;
 }
 
+/* remember the cluster at @offset, with @time in nanoseconds, for seeking in
+ * files without Cues */
+static void
+gst_matroska_demux_add_cluster_index_entry (GstMatroskaDemux * demux,
+    guint64 offset, GstClockTime time)
+{
+  GstMatroskaIndex entry = { 0, };
+  GstMatroskaIndex *next;
+  guint idx;
+
+  if (G_UNLIKELY (!demux->cluster_index))
+    demux->cluster_index =
+        g_array_sized_new (FALSE, FALSE, sizeof (GstMatroskaIndex), 128);
+
+  /* clusters mostly come in order, so this usually appends */
+  next = gst_util_array_binary_search (demux->cluster_index->data,
+      demux->cluster_index->len, sizeof (GstMatroskaIndex),
+      (GCompareDataFunc) gst_matroska_index_seek_find, GST_SEARCH_MODE_AFTER,
+      &time, NULL);
+  if (next && next->time == time)
+    return;
+
+  idx = next ? next - (GstMatroskaIndex *) demux->cluster_index->data :
+      demux->cluster_index->len;
+
+  entry.pos = offset - demux->common.ebml_segment_start;
+  entry.time = time;
+  g_array_insert_val (demux->cluster_index, idx, entry);
+
+  GST_LOG_OBJECT (demux, "added cluster at offset %" G_GUINT64_FORMAT
+      " with time %" GST_TIME_FORMAT " to index of %u clusters", offset,
+      GST_TIME_ARGS (time), demux->cluster_index->len);
+}
+
 /* bisect and scan through file for cluster starting before @time,
  * returns fake index entry with corresponding info on cluster */
 static GstMatroskaIndex *
@@ -2567,6 +2606,47 @@ gst_matroska_demux_search_pos (GstMatroskaDemux * demux, GstClockTime time)
 
   maxpos = gst_matroska_read_common_get_length (&demux->common);
 
+  /* narrow down the search with the clusters seen before */
+  if (time != GST_CLOCK_TIME_NONE && demux->cluster_index) {
+    GstMatroskaIndex *index = (GstMatroskaIndex *) demux->cluster_index->data;
+    guint len = demux->cluster_index->len;
+    GstMatroskaIndex *before, *after;
+
+    before = gst_util_array_binary_search (index, len,
+        sizeof (GstMatroskaIndex),
+        (GCompareDataFunc) gst_matroska_index_seek_find,
+        GST_SEARCH_MODE_BEFORE, &time, NULL);
+    after = before ? before + 1 : index;
+
+    if (before) {
+      gint64 pos = before->pos + demux->common.ebml_segment_start;
+
+      /* same criterion as the scan below */
+      if (GST_CLOCK_DIFF (before->time, time) < 5 * GST_SECOND) {
+        GST_DEBUG_OBJECT (demux, "known cluster at %" G_GINT64_FORMAT
+            " with time %" GST_TIME_FORMAT " is close enough", pos,
+            GST_TIME_ARGS (before->time));
+        prev_cluster_offset = pos;
+        prev_cluster_time = before->time;
+        goto found;
+      }
+
+      if (before->time >= atime && pos >= apos) {
+        apos = pos;
+        atime = before->time;
+      }
+    }
+
+    if (after < index + len && after->time > time && after->time < otime) {
+      gint64 pos = after->pos + demux->common.ebml_segment_start;
+
+      if (pos >= apos) {
+        opos = pos;
+        otime = after->time;
+      }
+    }
+  }
+
   /* invariants;
    * apos <= opos
    * atime <= otime
@@ -2724,6 +2804,7 @@ retry:
     goto exit;
   }
 
+found:
   /* In the bisect loop above we always undershoot and then jump forward
    * cluster-by-cluster until we overshoot, so if we get here we've gone
    * over and the previous cluster is where we need to go to. */
@@ -5736,6 +5817,11 @@ gst_matroska_demux_parse_id (GstMatroskaDemux * demux, guint32 id,
             demux->stream_last_time =
                 demux->cluster_time * demux->common.time_scale;
           }
+          /* and all of them when there are no Cues to seek with */
+          if (!demux->streaming && !demux->common.index)
+            gst_matroska_demux_add_cluster_index_entry (demux,
+                demux->cluster_offset,
+                demux->cluster_time * demux->common.time_scale);
 #if 0
           if (demux->common.element_index) {
             if (demux->common.element_index_writer_id == -1)
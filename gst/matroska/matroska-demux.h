@@ -74,6 +74,10 @@ typedef struct _GstMatroskaDemux {
   /* cluster positions (optional) */
   GArray                  *clusters;
 
+  /* times and positions of the clusters seen so far, used to narrow down
+   * seeking in files without Cues (GstMatroskaIndex entries, sorted on time) */
+  GArray                  *cluster_index;
+
   /* keeping track of playback position */
   GstClockTime             last_stop_end;
   GstClockTime             stream_start_time;
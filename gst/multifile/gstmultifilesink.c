@@ -41,6 +41,12 @@
  * The filename property should contain a string with a \%d placeholder that will
  * be substituted with the index for each filename.
  *
+ * Data is written with vectored writes straight from the buffer memory, so
+ * buffer lists and multi-memory buffers are not copied on the way to disk. If
+ * the #GstMultiFileSink:background-flush property is %TRUE, finished files are
+ * synced to disk and dropped from the page cache in a background thread
+ * instead of in the streaming thread.
+ *
  * If the #GstMultiFileSink:post-messages property is %TRUE, it sends an application
  * message named `GstMultiFileSink` after writing each buffer.
  *
@@ -69,8 +75,34 @@
 #include <gst/base/gstbasetransform.h>
 #include <gst/video/video.h>
 #include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#ifdef G_OS_WIN32
+#include <io.h>
+#endif
 #include "gstmultifilesink.h"
 
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#ifndef HAVE_SYS_UIO_H
+struct iovec
+{
+  gpointer iov_base;
+  gsize iov_len;
+};
+#endif
+
+/* number of memory chunks mapped and written with one system call */
+#define MAX_IOVECS 64
+
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -87,6 +119,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_multi_file_sink_debug);
 #define DEFAULT_MAX_FILE_SIZE G_GUINT64_CONSTANT(2*1024*1024*1024)
 #define DEFAULT_MAX_FILE_DURATION GST_CLOCK_TIME_NONE
 #define DEFAULT_AGGREGATE_GOPS FALSE
+#define DEFAULT_BACKGROUND_FLUSH FALSE
 
 enum
 {
@@ -98,7 +131,8 @@ enum
   PROP_MAX_FILES,
   PROP_MAX_FILE_SIZE,
   PROP_MAX_FILE_DURATION,
-  PROP_AGGREGATE_GOPS
+  PROP_AGGREGATE_GOPS,
+  PROP_BACKGROUND_FLUSH
 };
 
 static void gst_multi_file_sink_finalize (GObject * object);
@@ -257,6 +291,22 @@ gst_multi_file_sink_class_init (GstMultiFileSinkClass * klass)
           "splitting", DEFAULT_AGGREGATE_GOPS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiFileSink:background-flush:
+   *
+   * Whether to sync finished files to disk and drop them from the page cache
+   * in a background thread. This keeps the streaming thread from blocking on
+   * writeback when recording many high-bitrate streams at once. Errors while
+   * syncing are only logged.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BACKGROUND_FLUSH,
+      g_param_spec_boolean ("background-flush", "Background flush",
+          "Sync finished files to disk and drop them from the page cache in a "
+          "background thread", DEFAULT_BACKGROUND_FLUSH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_multi_file_sink_finalize;
 
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_multi_file_sink_start);
@@ -292,6 +342,8 @@ gst_multi_file_sink_init (GstMultiFileSink * multifilesink)
 
   multifilesink->aggregate_gops = DEFAULT_AGGREGATE_GOPS;
   multifilesink->gop_adapter = NULL;
+  multifilesink->background_flush = DEFAULT_BACKGROUND_FLUSH;
+  multifilesink->fd = -1;
 
   gst_base_sink_set_sync (GST_BASE_SINK (multifilesink), FALSE);
 
@@ -351,6 +403,9 @@ gst_multi_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_GOPS:
       sink->aggregate_gops = g_value_get_boolean (value);
       break;
+    case PROP_BACKGROUND_FLUSH:
+      sink->background_flush = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -388,12 +443,46 @@ gst_multi_file_sink_get_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_GOPS:
       g_value_set_boolean (value, sink->aggregate_gops);
       break;
+    case PROP_BACKGROUND_FLUSH:
+      g_value_set_boolean (value, sink->background_flush);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* runs in the flush pool, @data is the file descriptor plus one */
+static void
+gst_multi_file_sink_flush_file (gpointer data, gpointer user_data)
+{
+  gint fd = GPOINTER_TO_INT (data) - 1;
+
+#ifdef HAVE_FDATASYNC
+  if (fdatasync (fd) < 0)
+    GST_WARNING_OBJECT (user_data, "failed to sync file: %s",
+        g_strerror (errno));
+#endif
+#ifdef HAVE_POSIX_FADVISE
+  posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+
+  GST_LOG_OBJECT (user_data, "flushed and closed fd %d", fd);
+  g_close (fd, NULL);
+}
+
+static void
+gst_multi_file_sink_close_fd (GstMultiFileSink * sink)
+{
+  if (sink->flush_pool) {
+    g_thread_pool_push (sink->flush_pool, GINT_TO_POINTER (sink->fd + 1),
+        NULL);
+  } else {
+    g_close (sink->fd, NULL);
+  }
+  sink->fd = -1;
+}
+
 static gboolean
 gst_multi_file_sink_start (GstBaseSink * bsink)
 {
@@ -401,6 +490,9 @@ gst_multi_file_sink_start (GstBaseSink * bsink)
 
   if (sink->aggregate_gops)
     sink->gop_adapter = gst_adapter_new ();
+  if (sink->background_flush)
+    sink->flush_pool = g_thread_pool_new (gst_multi_file_sink_flush_file,
+        sink, 1, FALSE, NULL);
   sink->potential_next_gop = NULL;
   sink->file_pts = GST_CLOCK_TIME_NONE;
 
@@ -417,9 +509,13 @@ gst_multi_file_sink_stop (GstBaseSink * sink)
 
   multifilesink = GST_MULTI_FILE_SINK (sink);
 
-  if (multifilesink->file != NULL) {
-    fclose (multifilesink->file);
-    multifilesink->file = NULL;
+  if (multifilesink->fd != -1)
+    gst_multi_file_sink_close_fd (multifilesink);
+
+  if (multifilesink->flush_pool) {
+    /* wait for the pending files to be flushed */
+    g_thread_pool_free (multifilesink->flush_pool, FALSE, TRUE);
+    multifilesink->flush_pool = NULL;
   }
 
   if (multifilesink->streamheaders) {
@@ -528,55 +624,212 @@ gst_multi_file_sink_post_message (GstMultiFileSink * multifilesink,
       offset, offset_end, running_time, stream_time, filename);
 }
 
+/* writes out all of @iov at @offset, retrying on short writes. Returns FALSE
+ * with errno set on error. Modifies @iov. */
 static gboolean
-gst_multi_file_sink_write_stream_headers (GstMultiFileSink * sink)
+gst_multi_file_sink_writev (gint fd, struct iovec *iov, gint n_iov,
+    guint64 offset)
 {
-  int i;
+  while (n_iov > 0) {
+    gssize ret;
+
+#ifdef HAVE_PWRITEV
+    ret = pwritev (fd, iov, n_iov, offset);
+#else
+    /* the file is only ever written sequentially, so the offset matches */
+    ret = write (fd, iov->iov_base, iov->iov_len);
+#endif
+    if (ret < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      return FALSE;
+    }
+    offset += ret;
+
+    /* skip what was written */
+    while (n_iov > 0 && (gsize) ret >= iov->iov_len) {
+      ret -= iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (n_iov > 0) {
+      iov->iov_base = (guint8 *) iov->iov_base + ret;
+      iov->iov_len -= ret;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_multi_file_sink_flush_iovecs (GstMultiFileSink * sink, struct iovec *iov,
+    GstMemory ** mems, GstMapInfo * maps, gint n_iov)
+{
+  gboolean ret;
+  gsize size = 0;
+  gint i, err;
+
+  for (i = 0; i < n_iov; i++)
+    size += iov[i].iov_len;
 
+  ret = gst_multi_file_sink_writev (sink->fd, iov, n_iov,
+      sink->cur_file_size);
+  err = errno;
+  if (ret)
+    sink->cur_file_size += size;
+
+  for (i = 0; i < n_iov; i++)
+    gst_memory_unmap (mems[i], &maps[i]);
+
+  errno = err;
+  return ret;
+}
+
+/* writes all memory of @buffers to the current file, mapping and writing up
+ * to MAX_IOVECS memory chunks at a time. Returns FALSE with errno set on
+ * error. */
+static gboolean
+gst_multi_file_sink_write_buffers (GstMultiFileSink * sink,
+    GstBuffer ** buffers, guint n_buffers)
+{
+  struct iovec iov[MAX_IOVECS];
+  GstMapInfo maps[MAX_IOVECS];
+  GstMemory *mems[MAX_IOVECS];
+  gint n_iov = 0;
+  guint b, m, n_mem;
+
+  for (b = 0; b < n_buffers; b++) {
+    n_mem = gst_buffer_n_memory (buffers[b]);
+
+    for (m = 0; m < n_mem; m++) {
+      mems[n_iov] = gst_buffer_peek_memory (buffers[b], m);
+      if (!gst_memory_map (mems[n_iov], &maps[n_iov], GST_MAP_READ))
+        goto map_failed;
+
+      iov[n_iov].iov_base = maps[n_iov].data;
+      iov[n_iov].iov_len = maps[n_iov].size;
+      n_iov++;
+
+      if (n_iov == MAX_IOVECS) {
+        if (!gst_multi_file_sink_flush_iovecs (sink, iov, mems, maps, n_iov))
+          return FALSE;
+        n_iov = 0;
+      }
+    }
+  }
+
+  if (n_iov > 0)
+    return gst_multi_file_sink_flush_iovecs (sink, iov, mems, maps, n_iov);
+
+  return TRUE;
+
+  /* ERRORS */
+map_failed:
+  {
+    while (n_iov-- > 0)
+      gst_memory_unmap (mems[n_iov], &maps[n_iov]);
+    errno = EIO;
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_multi_file_sink_write_list (GstMultiFileSink * sink, GstBufferList * list)
+{
+  GstBuffer **buffers;
+  guint i, len;
+  gboolean ret;
+
+  len = gst_buffer_list_length (list);
+  buffers = g_new (GstBuffer *, len);
+  for (i = 0; i < len; i++)
+    buffers[i] = gst_buffer_list_get (list, i);
+
+  ret = gst_multi_file_sink_write_buffers (sink, buffers, len);
+  g_free (buffers);
+
+  return ret;
+}
+
+static gboolean
+gst_multi_file_sink_write_stream_headers (GstMultiFileSink * sink)
+{
   if (sink->streamheaders == NULL)
     return TRUE;
 
   /* we want to write these at the beginning */
   g_assert (sink->cur_file_size == 0);
 
-  for (i = 0; i < sink->n_streamheaders; i++) {
-    GstBuffer *hdr;
-    GstMapInfo map;
-    int ret;
+  return gst_multi_file_sink_write_buffers (sink, sink->streamheaders,
+      sink->n_streamheaders);
+}
 
-    hdr = sink->streamheaders[i];
-    gst_buffer_map (hdr, &map, GST_MAP_READ);
-    ret = fwrite (map.data, map.size, 1, sink->file);
-    gst_buffer_unmap (hdr, &map);
+static gboolean
+buffer_list_copy_data (GstBuffer ** buf, guint idx, gpointer data)
+{
+  GstBuffer *dest = data;
+  guint num, i;
 
-    if (ret != 1)
-      return FALSE;
+  if (idx == 0)
+    gst_buffer_copy_into (dest, *buf, GST_BUFFER_COPY_METADATA, 0, -1);
+
+  num = gst_buffer_n_memory (*buf);
+  for (i = 0; i < num; ++i) {
+    GstMemory *mem;
 
-    sink->cur_file_size += map.size;
+    mem = gst_buffer_get_memory (*buf, i);
+    gst_buffer_append_memory (dest, mem);
   }
 
   return TRUE;
 }
 
+static gboolean
+gst_multi_file_sink_write_data (GstMultiFileSink * multifilesink,
+    GstBuffer * buffer, GstBufferList * list)
+{
+  if (list)
+    return gst_multi_file_sink_write_list (multifilesink, list);
+
+  return gst_multi_file_sink_write_buffers (multifilesink, &buffer, 1);
+}
+
+/* @buffer carries the timestamps and flags used to decide when to start a
+ * new file. The data written is @list if it is not %NULL, @buffer otherwise. */
 static GstFlowReturn
 gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
-    GstBuffer * buffer)
+    GstBuffer * buffer, GstBufferList * list)
 {
   GstMapInfo map;
+  GstBuffer *data_buf;
   gchar *filename;
   gboolean ret;
   GError *error = NULL;
   gboolean first_file = TRUE;
+  gsize size;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (list)
+    size = gst_buffer_list_calculate_size (list);
+  else
+    size = gst_buffer_get_size (buffer);
 
   switch (multifilesink->next_file) {
     case GST_MULTI_FILE_SINK_NEXT_BUFFER:
       gst_multi_file_sink_ensure_max_files (multifilesink);
 
+      if (list) {
+        data_buf = gst_buffer_new ();
+        gst_buffer_list_foreach (list, buffer_list_copy_data, data_buf);
+      } else {
+        data_buf = gst_buffer_ref (buffer);
+      }
+
       filename = g_strdup_printf (multifilesink->filename,
           multifilesink->index);
+      gst_buffer_map (data_buf, &map, GST_MAP_READ);
       ret = g_file_set_contents (filename, (char *) map.data, map.size, &error);
+      gst_buffer_unmap (data_buf, &map);
+      gst_buffer_unref (data_buf);
       if (!ret)
         goto write_error;
 
@@ -589,17 +842,16 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
       break;
     case GST_MULTI_FILE_SINK_NEXT_DISCONT:
       if (GST_BUFFER_IS_DISCONT (buffer)) {
-        if (multifilesink->file)
+        if (multifilesink->fd != -1)
           gst_multi_file_sink_close_file (multifilesink, buffer);
       }
 
-      if (multifilesink->file == NULL) {
+      if (multifilesink->fd == -1) {
         if (!gst_multi_file_sink_open_next_file (multifilesink))
           goto stdio_write_error;
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_data (multifilesink, buffer, list))
         goto stdio_write_error;
 
       break;
@@ -614,14 +866,14 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
       if (GST_BUFFER_TIMESTAMP_IS_VALID (buffer) &&
           GST_BUFFER_TIMESTAMP (buffer) >= multifilesink->next_segment &&
           !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
-        if (multifilesink->file) {
+        if (multifilesink->fd != -1) {
           first_file = FALSE;
           gst_multi_file_sink_close_file (multifilesink, buffer);
         }
         multifilesink->next_segment += 10 * GST_SECOND;
       }
 
-      if (multifilesink->file == NULL) {
+      if (multifilesink->fd == -1) {
         if (!gst_multi_file_sink_open_next_file (multifilesink))
           goto stdio_write_error;
 
@@ -629,13 +881,12 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
           gst_multi_file_sink_write_stream_headers (multifilesink);
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_data (multifilesink, buffer, list))
         goto stdio_write_error;
 
       break;
     case GST_MULTI_FILE_SINK_NEXT_KEY_UNIT_EVENT:
-      if (multifilesink->file == NULL) {
+      if (multifilesink->fd == -1) {
         if (!gst_multi_file_sink_open_next_file (multifilesink))
           goto stdio_write_error;
 
@@ -645,16 +896,14 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
          */
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_data (multifilesink, buffer, list))
         goto stdio_write_error;
 
       break;
     case GST_MULTI_FILE_SINK_NEXT_MAX_SIZE:{
       guint64 new_size;
 
-      new_size = multifilesink->cur_file_size + map.size;
+      new_size = multifilesink->cur_file_size + size;
       if (new_size > multifilesink->max_file_size) {
 
         GST_INFO_OBJECT (multifilesink, "current size: %" G_GUINT64_FORMAT
@@ -662,13 +911,13 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
             multifilesink->cur_file_size, new_size,
             multifilesink->max_file_size);
 
-        if (multifilesink->file != NULL) {
+        if (multifilesink->fd != -1) {
           first_file = FALSE;
           gst_multi_file_sink_close_file (multifilesink, buffer);
         }
       }
 
-      if (multifilesink->file == NULL) {
+      if (multifilesink->fd == -1) {
         if (!gst_multi_file_sink_open_next_file (multifilesink))
           goto stdio_write_error;
 
@@ -676,12 +925,9 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
           gst_multi_file_sink_write_stream_headers (multifilesink);
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_data (multifilesink, buffer, list))
         goto stdio_write_error;
 
-      multifilesink->cur_file_size += map.size;
       break;
     }
     case GST_MULTI_FILE_SINK_NEXT_MAX_DURATION:{
@@ -702,13 +948,13 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
             "new_duration: %" G_GUINT64_FORMAT ", max. duration %"
             G_GUINT64_FORMAT, new_duration, multifilesink->max_file_duration);
 
-        if (multifilesink->file != NULL) {
+        if (multifilesink->fd != -1) {
           first_file = FALSE;
           gst_multi_file_sink_close_file (multifilesink, buffer);
         }
       }
 
-      if (multifilesink->file == NULL) {
+      if (multifilesink->fd == -1) {
         if (!gst_multi_file_sink_open_next_file (multifilesink))
           goto stdio_write_error;
 
@@ -717,9 +963,7 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
           gst_multi_file_sink_write_stream_headers (multifilesink);
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_data (multifilesink, buffer, list))
         goto stdio_write_error;
 
       break;
@@ -728,7 +972,6 @@ gst_multi_file_sink_write_buffer (GstMultiFileSink * multifilesink,
       g_assert_not_reached ();
   }
 
-  gst_buffer_unmap (buffer, &map);
   return GST_FLOW_OK;
 
   /* ERRORS */
@@ -749,7 +992,6 @@ write_error:
     g_error_free (error);
     g_free (filename);
 
-    gst_buffer_unmap (buffer, &map);
     return GST_FLOW_ERROR;
   }
 stdio_write_error:
@@ -762,7 +1004,6 @@ stdio_write_error:
       GST_ELEMENT_ERROR (multifilesink, RESOURCE, WRITE,
           ("Error while writing to file."), ("%s", g_strerror (errno)));
   }
-  gst_buffer_unmap (buffer, &map);
   return GST_FLOW_ERROR;
 }
 
@@ -778,6 +1019,7 @@ gst_multi_file_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
   if (sink->aggregate_gops) {
     GstBuffer *gop_buffer = NULL;
+    GstBufferList *gop_list = NULL;
     guint avail;
 
     avail = gst_adapter_available (sink->gop_adapter);
@@ -797,7 +1039,11 @@ gst_multi_file_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
         GST_LOG_OBJECT (sink, "Grabbing pending completed GOP");
         pts = gst_adapter_prev_pts_at_offset (sink->gop_adapter, 0, NULL);
         dts = gst_adapter_prev_dts_at_offset (sink->gop_adapter, 0, NULL);
-        gop_buffer = gst_adapter_take_buffer (sink->gop_adapter, avail);
+        /* take the GOP as a list, so it's written without merging the data */
+        gop_list = gst_adapter_take_buffer_list (sink->gop_adapter, avail);
+        gop_buffer = gst_buffer_new ();
+        gst_buffer_copy_into (gop_buffer, gst_buffer_list_get (gop_list, 0),
+            GST_BUFFER_COPY_METADATA, 0, -1);
         GST_BUFFER_PTS (gop_buffer) = pts;
         GST_BUFFER_DTS (gop_buffer) = dts;
       }
@@ -826,58 +1072,53 @@ gst_multi_file_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
             GST_TIME_ARGS (GST_BUFFER_PTS (gop_buffer)),
             GST_TIME_ARGS (GST_BUFFER_DTS (gop_buffer)),
             GST_TIME_ARGS (GST_BUFFER_DURATION (gop_buffer)));
-        flow = gst_multi_file_sink_write_buffer (sink, gop_buffer);
+        flow = gst_multi_file_sink_write_buffer (sink, gop_buffer, gop_list);
+        gst_buffer_list_unref (gop_list);
         gst_buffer_unref (gop_buffer);
       }
     }
   } else {
-    flow = gst_multi_file_sink_write_buffer (sink, buffer);
+    flow = gst_multi_file_sink_write_buffer (sink, buffer, NULL);
   }
   return flow;
 }
 
-static gboolean
-buffer_list_copy_data (GstBuffer ** buf, guint idx, gpointer data)
-{
-  GstBuffer *dest = data;
-  guint num, i;
-
-  if (idx == 0)
-    gst_buffer_copy_into (dest, *buf, GST_BUFFER_COPY_METADATA, 0, -1);
-
-  num = gst_buffer_n_memory (*buf);
-  for (i = 0; i < num; ++i) {
-    GstMemory *mem;
-
-    mem = gst_buffer_get_memory (*buf, i);
-    gst_buffer_append_memory (dest, mem);
-  }
-
-  return TRUE;
-}
-
 /* Our assumption for now is that the buffers in a buffer list should always
  * end up in the same file. If someone wants different behaviour, they'll just
  * have to add a property for that. */
 static GstFlowReturn
 gst_multi_file_sink_render_list (GstBaseSink * sink, GstBufferList * list)
 {
+  GstMultiFileSink *multifilesink = GST_MULTI_FILE_SINK (sink);
   GstBuffer *buf;
+  GstFlowReturn flow;
   guint size;
 
+  if (gst_buffer_list_length (list) == 0)
+    return GST_FLOW_OK;
+
   size = gst_buffer_list_calculate_size (list);
   GST_LOG_OBJECT (sink, "total size of buffer list %p: %u", list, size);
 
-  /* copy all buffers in the list into one single buffer, so we can use
-   * the normal render function (FIXME: optimise to avoid the memcpy) */
-  buf = gst_buffer_new ();
-  gst_buffer_list_foreach (list, buffer_list_copy_data, buf);
-  g_assert (gst_buffer_get_size (buf) == size);
+  if (multifilesink->aggregate_gops) {
+    /* collect all buffers in the list into one single buffer, so we can use
+     * the normal render function */
+    buf = gst_buffer_new ();
+    gst_buffer_list_foreach (list, buffer_list_copy_data, buf);
+    g_assert (gst_buffer_get_size (buf) == size);
+
+    flow = gst_multi_file_sink_render (sink, buf);
+  } else {
+    /* the first buffer decides, and the whole list is written in one go */
+    buf = gst_buffer_new ();
+    gst_buffer_copy_into (buf, gst_buffer_list_get (list, 0),
+        GST_BUFFER_COPY_METADATA, 0, -1);
 
-  gst_multi_file_sink_render (sink, buf);
+    flow = gst_multi_file_sink_write_buffer (multifilesink, buf, list);
+  }
   gst_buffer_unref (buf);
 
-  return GST_FLOW_OK;
+  return flow;
 }
 
 static gboolean
@@ -979,7 +1220,7 @@ gst_multi_file_sink_event (GstBaseSink * sink, GstEvent * event)
 
       multifilesink->force_key_unit_count = count;
 
-      if (multifilesink->file) {
+      if (multifilesink->fd != -1) {
         duration = GST_CLOCK_TIME_NONE;
         offset = offset_end = -1;
         filename = g_strdup_printf (multifilesink->filename,
@@ -992,7 +1233,7 @@ gst_multi_file_sink_event (GstBaseSink * sink, GstEvent * event)
         g_free (filename);
       }
 
-      if (multifilesink->file == NULL) {
+      if (multifilesink->fd == -1) {
         if (!gst_multi_file_sink_open_next_file (multifilesink))
           goto stdio_write_error;
       }
@@ -1009,7 +1250,7 @@ gst_multi_file_sink_event (GstBaseSink * sink, GstEvent * event)
         gst_multi_file_sink_render (sink, buf);
         gst_buffer_unref (buf);
       }
-      if (multifilesink->file) {
+      if (multifilesink->fd != -1) {
         gchar *filename;
 
         filename = g_strdup_printf (multifilesink->filename,
@@ -1044,13 +1285,14 @@ gst_multi_file_sink_open_next_file (GstMultiFileSink * multifilesink)
 {
   char *filename;
 
-  g_return_val_if_fail (multifilesink->file == NULL, FALSE);
+  g_return_val_if_fail (multifilesink->fd == -1, FALSE);
 
   gst_multi_file_sink_ensure_max_files (multifilesink);
 
   filename = g_strdup_printf (multifilesink->filename, multifilesink->index);
-  multifilesink->file = g_fopen (filename, "wb");
-  if (multifilesink->file == NULL) {
+  multifilesink->fd = g_open (filename,
+      O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+  if (multifilesink->fd == -1) {
     g_free (filename);
     return FALSE;
   }
@@ -1069,8 +1311,7 @@ gst_multi_file_sink_close_file (GstMultiFileSink * multifilesink,
 {
   char *filename;
 
-  fclose (multifilesink->file);
-  multifilesink->file = NULL;
+  gst_multi_file_sink_close_fd (multifilesink);
 
   if (buffer) {
     filename = g_strdup_printf (multifilesink->filename, multifilesink->index);
@@ -84,7 +84,7 @@ struct _GstMultiFileSink
   gint index;
   gboolean post_messages;
   GstMultiFileSinkNext next_file;
-  FILE *file;
+  gint fd;
 
   guint max_files;
   GQueue old_files;        /* keep track of old files for max_files handling */
@@ -104,6 +104,9 @@ struct _GstMultiFileSink
   gboolean aggregate_gops;
   GstAdapter *gop_adapter;  /* to aggregate GOPs */
   GList *potential_next_gop;	/* To detect false-positives */
+
+  gboolean background_flush;
+  GThreadPool *flush_pool;  /* flushes and closes finished files */
 };
 
 struct _GstMultiFileSinkClass
@@ -44,7 +44,15 @@
  * asynchronously, and a new muxer and sink is created to continue with the
  * next fragment. For that reason, instead of muxer and sink objects, the
  * muxer-factory and sink-factory properties are used to construct the new
- * objects, together with muxer-properties and sink-properties.
+ * objects, together with muxer-properties and sink-properties. The muxer and
+ * sink for the next fragment are created and configured from a helper
+ * thread as soon as a fragment starts, so that switching fragments doesn't
+ * have to wait for them. If any of the muxer or sink factory, preset or
+ * properties settings changes in the meantime, they are discarded and
+ * created again at the switch. The muxer-added and sink-added signals are
+ * only emitted at the switch, for the elements that are actually used, and
+ * while handlers are connected to them the prepared elements are left in
+ * the NULL state for the handlers to configure.
  *
  * ## Example pipelines
  * |[
@@ -847,6 +855,7 @@ gst_splitmux_sink_set_property (GObject * object, guint prop_id,
       if (splitmux->muxer_factory)
         g_free (splitmux->muxer_factory);
       splitmux->muxer_factory = g_value_dup_string (value);
+      splitmux->fragment_config_cookie++;
       GST_OBJECT_UNLOCK (splitmux);
       break;
     case PROP_MUXER_PRESET:
@@ -854,6 +863,7 @@ gst_splitmux_sink_set_property (GObject * object, guint prop_id,
       if (splitmux->muxer_preset)
         g_free (splitmux->muxer_preset);
       splitmux->muxer_preset = g_value_dup_string (value);
+      splitmux->fragment_config_cookie++;
       GST_OBJECT_UNLOCK (splitmux);
       break;
     case PROP_MUXER_PROPERTIES:
@@ -865,6 +875,7 @@ gst_splitmux_sink_set_property (GObject * object, guint prop_id,
             gst_structure_copy (gst_value_get_structure (value));
       else
         splitmux->muxer_properties = NULL;
+      splitmux->fragment_config_cookie++;
       GST_OBJECT_UNLOCK (splitmux);
       break;
     case PROP_SINK_FACTORY:
@@ -872,6 +883,7 @@ gst_splitmux_sink_set_property (GObject * object, guint prop_id,
       if (splitmux->sink_factory)
         g_free (splitmux->sink_factory);
       splitmux->sink_factory = g_value_dup_string (value);
+      splitmux->fragment_config_cookie++;
       GST_OBJECT_UNLOCK (splitmux);
       break;
     case PROP_SINK_PRESET:
@@ -879,6 +891,7 @@ gst_splitmux_sink_set_property (GObject * object, guint prop_id,
       if (splitmux->sink_preset)
         g_free (splitmux->sink_preset);
       splitmux->sink_preset = g_value_dup_string (value);
+      splitmux->fragment_config_cookie++;
       GST_OBJECT_UNLOCK (splitmux);
       break;
     case PROP_SINK_PROPERTIES:
@@ -890,6 +903,7 @@ gst_splitmux_sink_set_property (GObject * object, guint prop_id,
             gst_structure_copy (gst_value_get_structure (value));
       else
         splitmux->sink_properties = NULL;
+      splitmux->fragment_config_cookie++;
       GST_OBJECT_UNLOCK (splitmux);
       break;
     case PROP_MUXERPAD_MAP:
@@ -1919,6 +1933,217 @@ _send_event (const GValue * value, gpointer user_data)
   gst_pad_send_event (pad, gst_event_ref (ev));
 }
 
+static GstElement *
+create_fragment_element (const gchar * factory, const gchar * prefix,
+    guint fragment_id)
+{
+  GstElement *ret;
+  gchar *name;
+
+  name = g_strdup_printf ("%s_%u", prefix, fragment_id);
+  ret = gst_element_factory_make (factory, name);
+  if (ret == NULL) {
+    g_warning ("Failed to create %s - splitmuxsink will not work", name);
+    g_free (name);
+    return NULL;
+  }
+  g_free (name);
+
+  /* The element is only added to the bin when its fragment starts, keep it
+   * locked so that the bin leaves its state alone after that */
+  gst_object_ref_sink (ret);
+  gst_element_set_locked_state (ret, TRUE);
+
+  return ret;
+}
+
+/* Creates and configures a muxer and sink for fragment @fragment_id in
+ * async-finalize mode. They're not added to the bin yet, the caller owns a
+ * reference to each. Called with the splitmux lock held. */
+static gboolean
+create_fragment_elements (GstSplitMuxSink * splitmux, guint fragment_id,
+    GstElement ** muxer_out, GstElement ** sink_out)
+{
+  GstElement *muxer, *sink;
+
+  sink = create_fragment_element (splitmux->sink_factory, "sink", fragment_id);
+  if (sink == NULL)
+    return FALSE;
+  if (splitmux->sink_preset && GST_IS_PRESET (sink))
+    gst_preset_load_preset (GST_PRESET (sink), splitmux->sink_preset);
+  if (splitmux->sink_properties)
+    gst_structure_foreach (splitmux->sink_properties,
+        _set_property_from_structure, sink);
+
+  muxer =
+      create_fragment_element (splitmux->muxer_factory, "muxer", fragment_id);
+  if (muxer == NULL) {
+    gst_object_unref (sink);
+    return FALSE;
+  }
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink),
+          "async") != NULL) {
+    /* async child elements are causing state change races and weird
+     * failures, so let's try and turn that off */
+    g_object_set (sink, "async", FALSE, NULL);
+  }
+  if (splitmux->muxer_preset && GST_IS_PRESET (muxer))
+    gst_preset_load_preset (GST_PRESET (muxer), splitmux->muxer_preset);
+  if (splitmux->muxer_properties)
+    gst_structure_foreach (splitmux->muxer_properties,
+        _set_property_from_structure, muxer);
+
+  *muxer_out = muxer;
+  *sink_out = sink;
+  return TRUE;
+}
+
+/* Adds the elements from create_fragment_elements() to the bin and links
+ * them, consuming the caller's references. Called with the state lock
+ * held */
+static gboolean
+add_fragment_elements (GstSplitMuxSink * splitmux, GstElement * muxer,
+    GstElement * sink)
+{
+  gboolean ret = FALSE;
+
+  /* Only now that they're going to be used, so that handlers never see
+   * prepared elements that end up being discarded */
+  GST_SPLITMUX_LOCK (splitmux);
+  g_signal_emit (splitmux, signals[SIGNAL_SINK_ADDED], 0, sink);
+  g_signal_emit (splitmux, signals[SIGNAL_MUXER_ADDED], 0, muxer);
+  GST_SPLITMUX_UNLOCK (splitmux);
+
+  if (!gst_bin_add (GST_BIN (splitmux), sink)) {
+    g_warning ("Could not add sink element - splitmuxsink will not work");
+    gst_element_set_state (muxer, GST_STATE_NULL);
+    gst_element_set_state (sink, GST_STATE_NULL);
+    goto done;
+  }
+  if (!gst_bin_add (GST_BIN (splitmux), muxer)) {
+    g_warning ("Could not add muxer element - splitmuxsink will not work");
+    gst_element_set_state (muxer, GST_STATE_NULL);
+    _lock_and_set_to_null (sink, splitmux);
+    goto done;
+  }
+
+  ret = gst_element_link (muxer, sink);
+  if (!ret) {
+    _lock_and_set_to_null (muxer, splitmux);
+    _lock_and_set_to_null (sink, splitmux);
+  }
+
+done:
+  gst_object_unref (muxer);
+  gst_object_unref (sink);
+  return ret;
+}
+
+/* Called with the state lock held */
+static void
+discard_next_fragment (GstSplitMuxSink * splitmux)
+{
+  if (splitmux->next_muxer == NULL)
+    return;
+
+  GST_DEBUG_OBJECT (splitmux, "Discarding muxer and sink prepared for "
+      "fragment %u", splitmux->next_fragment_id);
+  gst_element_set_state (splitmux->next_muxer, GST_STATE_NULL);
+  gst_element_set_state (splitmux->next_sink, GST_STATE_NULL);
+  gst_clear_object (&splitmux->next_muxer);
+  gst_clear_object (&splitmux->next_sink);
+}
+
+/* Called with the state lock held. Whether the prepared muxer and sink can
+ * be used for the fragment that is being started */
+static gboolean
+next_fragment_is_current (GstSplitMuxSink * splitmux)
+{
+  gboolean ret;
+
+  if (splitmux->next_muxer == NULL)
+    return FALSE;
+
+  if (splitmux->next_fragment_id != splitmux->fragment_id) {
+    GST_DEBUG_OBJECT (splitmux, "Muxer and sink were prepared for fragment "
+        "%u, not %u", splitmux->next_fragment_id, splitmux->fragment_id);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (splitmux);
+  ret = splitmux->next_config_cookie == splitmux->fragment_config_cookie;
+  GST_OBJECT_UNLOCK (splitmux);
+
+  if (!ret)
+    GST_DEBUG_OBJECT (splitmux, "Muxer or sink settings changed since the "
+        "next fragment was prepared");
+
+  return ret;
+}
+
+/* Runs from gst_element_call_async() after a fragment was started, and
+ * creates the muxer and sink for the one after it, so that the next switch
+ * only needs to link and start them. They're kept out of the bin until then,
+ * so they don't take part in EOS and state handling. */
+static void
+prepare_next_fragment (GstSplitMuxSink * splitmux, gpointer user_data)
+{
+  GstElement *muxer, *sink;
+  guint fragment_id, config_cookie;
+  gboolean have_handlers;
+
+  GST_SPLITMUX_STATE_LOCK (splitmux);
+  if (splitmux->shutdown || splitmux->next_muxer != NULL) {
+    GST_SPLITMUX_STATE_UNLOCK (splitmux);
+    return;
+  }
+
+  GST_OBJECT_LOCK (splitmux);
+  config_cookie = splitmux->fragment_config_cookie;
+  GST_OBJECT_UNLOCK (splitmux);
+
+  GST_SPLITMUX_LOCK (splitmux);
+  fragment_id = splitmux->fragment_id;
+  if (!create_fragment_elements (splitmux, fragment_id, &muxer, &sink)) {
+    GST_SPLITMUX_UNLOCK (splitmux);
+    GST_SPLITMUX_STATE_UNLOCK (splitmux);
+    GST_WARNING_OBJECT (splitmux, "Could not prepare muxer and sink for "
+        "fragment %u, creating them when switching", fragment_id);
+    return;
+  }
+  GST_SPLITMUX_UNLOCK (splitmux);
+
+  /* muxer-added and sink-added handlers expect the elements in NULL, as
+   * they were before the switch happened ahead of time */
+  have_handlers = g_signal_has_handler_pending (splitmux,
+      signals[SIGNAL_SINK_ADDED], 0, FALSE)
+      || g_signal_has_handler_pending (splitmux,
+      signals[SIGNAL_MUXER_ADDED], 0, FALSE);
+
+  if (!have_handlers
+      && (gst_element_set_state (sink, GST_STATE_READY) ==
+          GST_STATE_CHANGE_FAILURE
+          || gst_element_set_state (muxer, GST_STATE_READY) ==
+          GST_STATE_CHANGE_FAILURE)) {
+    GST_WARNING_OBJECT (splitmux, "Could not bring prepared muxer and sink "
+        "for fragment %u to READY", fragment_id);
+    gst_element_set_state (muxer, GST_STATE_NULL);
+    gst_element_set_state (sink, GST_STATE_NULL);
+    gst_object_unref (muxer);
+    gst_object_unref (sink);
+    GST_SPLITMUX_STATE_UNLOCK (splitmux);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (splitmux, "Prepared muxer %" GST_PTR_FORMAT " and sink %"
+      GST_PTR_FORMAT " for fragment %u", muxer, sink, fragment_id);
+  splitmux->next_muxer = muxer;
+  splitmux->next_sink = sink;
+  splitmux->next_fragment_id = fragment_id;
+  splitmux->next_config_cookie = config_cookie;
+  GST_SPLITMUX_STATE_UNLOCK (splitmux);
+}
+
 /* Called with lock held when a fragment
  * reaches EOS and it is time to restart
  * a new fragment
@@ -1954,51 +2179,34 @@ start_next_fragment (GstSplitMuxSink * splitmux, MqStreamCtx * ctx)
   if (splitmux->async_finalize) {
     if (splitmux->muxed_out_bytes > 0
         || splitmux->fragment_id != splitmux->start_index) {
-      gchar *newname;
       GstElement *new_sink, *new_muxer;
 
       GST_DEBUG_OBJECT (splitmux, "Starting fragment %u",
           splitmux->fragment_id);
       g_list_foreach (splitmux->contexts, (GFunc) block_context, splitmux);
-      newname = g_strdup_printf ("sink_%u", splitmux->fragment_id);
-      GST_SPLITMUX_LOCK (splitmux);
-      if ((splitmux->sink =
-              create_element (splitmux, splitmux->sink_factory, newname,
-                  TRUE)) == NULL)
-        goto fail;
-      if (splitmux->sink_preset && GST_IS_PRESET (splitmux->sink))
-        gst_preset_load_preset (GST_PRESET (splitmux->sink),
-            splitmux->sink_preset);
-      if (splitmux->sink_properties)
-        gst_structure_foreach (splitmux->sink_properties,
-            _set_property_from_structure, splitmux->sink);
-      splitmux->active_sink = splitmux->sink;
-      g_signal_emit (splitmux, signals[SIGNAL_SINK_ADDED], 0, splitmux->sink);
-      g_free (newname);
-      newname = g_strdup_printf ("muxer_%u", splitmux->fragment_id);
-      if ((splitmux->muxer =
-              create_element (splitmux, splitmux->muxer_factory, newname,
-                  TRUE)) == NULL)
-        goto fail;
-      if (g_object_class_find_property (G_OBJECT_GET_CLASS (splitmux->sink),
-              "async") != NULL) {
-        /* async child elements are causing state change races and weird
-         * failures, so let's try and turn that off */
-        g_object_set (splitmux->sink, "async", FALSE, NULL);
+      if (next_fragment_is_current (splitmux)) {
+        GST_DEBUG_OBJECT (splitmux, "Using prepared muxer and sink");
+        new_muxer = splitmux->next_muxer;
+        new_sink = splitmux->next_sink;
+        splitmux->next_muxer = NULL;
+        splitmux->next_sink = NULL;
+      } else {
+        discard_next_fragment (splitmux);
+        GST_SPLITMUX_LOCK (splitmux);
+        if (!create_fragment_elements (splitmux, splitmux->fragment_id,
+                &new_muxer, &new_sink)) {
+          GST_SPLITMUX_UNLOCK (splitmux);
+          goto fail;
+        }
+        GST_SPLITMUX_UNLOCK (splitmux);
       }
-      if (splitmux->muxer_preset && GST_IS_PRESET (splitmux->muxer))
-        gst_preset_load_preset (GST_PRESET (splitmux->muxer),
-            splitmux->muxer_preset);
-      if (splitmux->muxer_properties)
-        gst_structure_foreach (splitmux->muxer_properties,
-            _set_property_from_structure, splitmux->muxer);
-      g_signal_emit (splitmux, signals[SIGNAL_MUXER_ADDED], 0, splitmux->muxer);
-      g_free (newname);
-      new_sink = splitmux->sink;
-      new_muxer = splitmux->muxer;
+      if (!add_fragment_elements (splitmux, new_muxer, new_sink))
+        goto fail;
+      GST_SPLITMUX_LOCK (splitmux);
+      splitmux->muxer = new_muxer;
+      splitmux->sink = splitmux->active_sink = new_sink;
       GST_SPLITMUX_UNLOCK (splitmux);
       g_list_foreach (splitmux->contexts, (GFunc) relink_context, splitmux);
-      gst_element_link (new_muxer, new_sink);
 
       if (g_object_get_qdata ((GObject *) sink, EOS_FROM_US)) {
         if (GPOINTER_TO_INT (g_object_get_qdata ((GObject *) sink,
@@ -2082,6 +2290,10 @@ start_next_fragment (GstSplitMuxSink * splitmux, MqStreamCtx * ctx)
 
   splitmux->ready_for_output = TRUE;
 
+  if (splitmux->async_finalize)
+    gst_element_call_async (GST_ELEMENT (splitmux),
+        (GstElementCallAsyncFunc) prepare_next_fragment, NULL, NULL);
+
   g_list_foreach (splitmux->contexts, (GFunc) unlock_context, splitmux);
   g_list_foreach (splitmux->contexts, (GFunc) restart_context, splitmux);
 
@@ -3703,6 +3915,7 @@ gst_splitmux_sink_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_READY_TO_NULL:
       GST_SPLITMUX_STATE_LOCK (splitmux);
       splitmux->shutdown = TRUE;
+      discard_next_fragment (splitmux);
       GST_SPLITMUX_STATE_UNLOCK (splitmux);
 
       GST_SPLITMUX_LOCK (splitmux);
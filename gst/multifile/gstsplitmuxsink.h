@@ -205,6 +205,15 @@ struct _GstSplitMuxSink
   gchar *sink_factory;
   gchar *sink_preset;
   GstStructure *sink_properties;
+  /* bumped whenever one of the above factory, preset or properties
+   * settings changes, protected by the object lock */
+  guint fragment_config_cookie;
+  /* muxer and sink created ahead of the next fragment switch,
+   * protected by the state lock */
+  GstElement *next_muxer;
+  GstElement *next_sink;
+  guint next_fragment_id;
+  guint next_config_cookie;
 
   GstStructure *muxerpad_map;
 };
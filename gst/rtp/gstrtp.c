@@ -126,6 +126,8 @@ plugin_init (GstPlugin * plugin)
   ret |= GST_ELEMENT_REGISTER (rtpreddec, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpulpfecdec, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpulpfecenc, plugin);
+  ret |= GST_ELEMENT_REGISTER (rtpflexfecdec, plugin);
+  ret |= GST_ELEMENT_REGISTER (rtpflexfecenc, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpstorage, plugin);
   ret |= GST_ELEMENT_REGISTER (rtphdrextcolorspace, plugin);
 
@@ -126,6 +126,8 @@ GST_ELEMENT_REGISTER_DECLARE (rtpredenc);
 GST_ELEMENT_REGISTER_DECLARE (rtpreddec);
 GST_ELEMENT_REGISTER_DECLARE (rtpulpfecdec);
 GST_ELEMENT_REGISTER_DECLARE (rtpulpfecenc);
+GST_ELEMENT_REGISTER_DECLARE (rtpflexfecdec);
+GST_ELEMENT_REGISTER_DECLARE (rtpflexfecenc);
 GST_ELEMENT_REGISTER_DECLARE (rtpstorage);
 GST_ELEMENT_REGISTER_DECLARE (rtphdrextcolorspace);
 
@@ -0,0 +1,657 @@
+/* GStreamer plugin for forward error correction
+ * Copyright (C) 2021 Pexip
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/**
+ * SECTION:element-rtpflexfecdec
+ * @short_description: RTP FlexFEC decoder
+ * @title: rtpflexfecdec
+ *
+ * Flexible Forward Error Correction (FlexFEC) decoder as described in
+ * RFC 8627.
+ *
+ * This element will work in combination with an upstream #GstRtpStorage
+ * element and attempt to recover packets declared lost through custom
+ * 'GstRTPPacketLost' events, usually emitted by #GstRtpJitterBuffer.
+ * The repair packets are sent in their own SSRC, the #GstRtpStorage must
+ * thus be placed before the streams are demultiplexed so that it sees both
+ * the media and the repair packets.
+ *
+ * When a packet is lost, all the repair packets protecting sequence numbers
+ * around it are considered, and the ones missing a single packet are used
+ * over and over until no more progress can be made. This allows recovering
+ * bursts of losses when the sender uses column (interleaved) protection,
+ * and many more loss patterns when it combines row and column protection.
+ * The other packets recovered on the way are put back in the storage for
+ * when their own loss is signalled.
+ *
+ * Only repair packets using the flexible mask (R=0, F=0) are supported.
+ *
+ * If no storage is provided using the #GstRtpFlexFecDec:storage
+ * property, it will try to get it from an element upstream.
+ *
+ * Additionally, the payload type of the repair packets *must* be
+ * provided to this element via its #GstRtpFlexFecDec:pt property.
+ *
+ * When using #GstRtpBin, this element should be inserted through the
+ * #GstRtpBin::request-fec-decoder signal.
+ *
+ * ## Example pipeline
+ *
+ * |[
+ * gst-launch-1.0 udpsrc port=8888 caps="application/x-rtp, payload=96, clock-rate=90000" ! rtpstorage size-time=220000000 ! rtpssrcdemux ! application/x-rtp, payload=96, clock-rate=90000, media=video, encoding-name=H264 ! rtpjitterbuffer do-lost=1 latency=200 ! rtpflexfecdec pt=122 ! rtph264depay ! avdec_h264 ! videoconvert ! autovideosink
+ * ]| This example will receive a stream with FlexFEC and try to reconstruct
+ * the packets.
+ *
+ * See also: #GstRtpFlexFecEnc, #GstRtpUlpFecDec, #GstRtpBin, #GstRtpStorage
+ * Since: 1.20
+ */
+
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "gstrtpelements.h"
+#include "rtpulpfeccommon.h"
+#include "gstrtpflexfecdec.h"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+enum
+{
+  PROP_0,
+  PROP_PT,
+  PROP_STORAGE,
+  PROP_RECOVERED,
+  PROP_UNRECOVERED,
+  N_PROPERTIES
+};
+
+#define DEFAULT_FEC_PT 0
+
+static GParamSpec *klass_properties[N_PROPERTIES] = { NULL, };
+
+GST_DEBUG_CATEGORY (gst_rtp_flexfec_dec_debug);
+#define GST_CAT_DEFAULT (gst_rtp_flexfec_dec_debug)
+
+G_DEFINE_TYPE (GstRtpFlexFecDec, gst_rtp_flexfec_dec, GST_TYPE_ELEMENT);
+GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (rtpflexfecdec, "rtpflexfecdec",
+    GST_RANK_NONE, GST_TYPE_RTP_FLEXFEC_DEC, rtp_element_init (plugin));
+
+/* RtpUlpFecMapInfo must stay first, the array clear function relies on it */
+typedef struct
+{
+  RtpUlpFecMapInfo info;
+  guint16 seq_base;
+  RtpFlexFecMask mask;
+  guint header_len;
+  gboolean used;
+} RtpFlexFecPacket;
+
+#define RTP_FLEXFEC_MEDIA_NTH(dec, i) \
+    (&g_array_index ((dec)->info_media, RtpUlpFecMapInfo, (i)))
+#define RTP_FLEXFEC_FEC_NTH(dec, i) \
+    (&g_array_index ((dec)->info_fec, RtpFlexFecPacket, (i)))
+
+static gint
+gst_rtp_flexfec_dec_window_lookup (GstRtpFlexFecDec * self, guint16 seq)
+{
+  guint16 offset = seq - self->window_base;
+
+  if (offset >= RTP_FLEXFEC_DEC_WINDOW_SIZE)
+    return -1;
+  return self->window[offset];
+}
+
+/* Takes ownership of @buffer */
+static gboolean
+gst_rtp_flexfec_dec_add_media (GstRtpFlexFecDec * self, GstBuffer * buffer)
+{
+  RtpUlpFecMapInfo info = { GST_RTP_BUFFER_INIT };
+  guint16 offset;
+
+  if (!rtp_ulpfec_map_info_map (buffer, &info))
+    return FALSE;
+
+  offset = gst_rtp_buffer_get_seq (&info.rtp) - self->window_base;
+  if (offset >= RTP_FLEXFEC_DEC_WINDOW_SIZE || self->window[offset] >= 0) {
+    rtp_ulpfec_map_info_unmap (&info);
+    return FALSE;
+  }
+
+  self->window[offset] = self->info_media->len;
+  g_array_append_val (self->info_media, info);
+  return TRUE;
+}
+
+static void
+gst_rtp_flexfec_dec_start (GstRtpFlexFecDec * self, guint16 lost_seq,
+    GstBufferList * media, GstBufferList * fec)
+{
+  guint i;
+
+  g_assert (0 == self->info_media->len);
+  g_assert (0 == self->info_fec->len);
+
+  self->window_base = lost_seq - (RTP_FLEXFEC_PROTECTED_PACKETS_MAX - 1);
+  for (i = 0; i < RTP_FLEXFEC_DEC_WINDOW_SIZE; ++i)
+    self->window[i] = -1;
+
+  for (i = 0; media && i < gst_buffer_list_length (media); ++i)
+    gst_rtp_flexfec_dec_add_media (self,
+        gst_buffer_ref (gst_buffer_list_get (media, i)));
+
+  for (i = 0; fec && i < gst_buffer_list_length (fec); ++i) {
+    RtpFlexFecPacket packet = { {GST_RTP_BUFFER_INIT}, };
+    guint16 offset;
+
+    if (!rtp_ulpfec_map_info_map (gst_buffer_ref (gst_buffer_list_get (fec,
+                    i)), &packet.info))
+      continue;
+
+    if (!rtp_flexfec_buffer_parse (&packet.info.rtp, self->caps_ssrc,
+            &packet.seq_base, &packet.mask, &packet.header_len)) {
+      rtp_ulpfec_map_info_unmap (&packet.info);
+      continue;
+    }
+
+    /* Packets starting before the window can't protect the lost one, the
+     * ones starting after it might still recover packets it depends on */
+    offset = packet.seq_base - self->window_base;
+    if (offset >= RTP_FLEXFEC_DEC_WINDOW_SIZE) {
+      rtp_ulpfec_map_info_unmap (&packet.info);
+      continue;
+    }
+
+    GST_LOG_RTP_PACKET (self, "rtp header (fec)", &packet.info.rtp);
+    g_array_append_val (self->info_fec, packet);
+  }
+}
+
+static void
+gst_rtp_flexfec_dec_stop (GstRtpFlexFecDec * self)
+{
+  g_array_set_size (self->info_media, 0);
+  g_array_set_size (self->info_fec, 0);
+}
+
+/* Only the first @n_media packets are considered, so that the packet being
+ * validated does not vouch for itself */
+static gboolean
+gst_rtp_flexfec_dec_is_recovered_pt_valid (GstRtpFlexFecDec * self,
+    guint8 recovered_pt, guint n_media)
+{
+  guint i;
+
+  if (self->have_caps_pt && self->caps_pt == recovered_pt)
+    return TRUE;
+
+  for (i = 0; i < n_media; ++i) {
+    RtpUlpFecMapInfo *info = RTP_FLEXFEC_MEDIA_NTH (self, i);
+    if (gst_rtp_buffer_get_payload_type (&info->rtp) == recovered_pt)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static GstBuffer *
+gst_rtp_flexfec_dec_recover_from_fec (GstRtpFlexFecDec * self,
+    RtpFlexFecPacket * packet, guint16 seq, guint8 * dst_pt)
+{
+  RtpUlpFecMapInfo *info;
+  GstBuffer *ret;
+  guint8 recovered_pt;
+  guint offset;
+  guint i;
+
+  g_array_set_size (self->scratch_buf, 0);
+  rtp_flexfec_bitstring_add_fec (&packet->info.rtp, packet->header_len,
+      self->scratch_buf);
+
+  for (offset = 0; offset < RTP_FLEXFEC_PROTECTED_PACKETS_MAX; ++offset) {
+    guint16 protected_seq = packet->seq_base + offset;
+    gint idx;
+
+    if (!rtp_flexfec_mask_is_set (&packet->mask, offset) ||
+        protected_seq == seq)
+      continue;
+
+    idx = gst_rtp_flexfec_dec_window_lookup (self, protected_seq);
+    g_assert (idx >= 0);
+    rtp_flexfec_bitstring_add_media (&RTP_FLEXFEC_MEDIA_NTH (self, idx)->rtp,
+        self->scratch_buf);
+  }
+
+  ret = rtp_flexfec_bitstring_to_media_rtp_buffer (self->scratch_buf,
+      self->caps_ssrc, seq);
+  if (ret == NULL) {
+    GST_WARNING_OBJECT (self, "Invalid length recovery for seq=%u", seq);
+    return NULL;
+  }
+
+  /* Putting the recovered packet in the window, so that it can be used
+   * to recover the other ones */
+  i = self->info_media->len;
+  if (!gst_rtp_flexfec_dec_add_media (self, gst_buffer_ref (ret))) {
+    GST_WARNING_OBJECT (self, "Invalid recovered packet");
+    goto recovered_packet_invalid;
+  }
+
+  info = RTP_FLEXFEC_MEDIA_NTH (self, i);
+  recovered_pt = gst_rtp_buffer_get_payload_type (&info->rtp);
+  if (!gst_rtp_flexfec_dec_is_recovered_pt_valid (self, recovered_pt, i)) {
+    GST_WARNING_OBJECT (self,
+        "Recovered packet has unexpected payload type (%u)", recovered_pt);
+    self->window[(guint16) (seq - self->window_base)] = -1;
+    g_array_set_size (self->info_media, i);
+    goto recovered_packet_invalid;
+  }
+
+  GST_DEBUG_RTP_PACKET (self, "rtp header (recovered)", &info->rtp);
+  *dst_pt = recovered_pt;
+  return ret;
+
+recovered_packet_invalid:
+  gst_buffer_unref (ret);
+  return NULL;
+}
+
+/* Uses every repair packet missing a single protected packet, until the lost
+ * one is recovered or no more progress can be made */
+static GstBuffer *
+gst_rtp_flexfec_dec_recover (GstRtpFlexFecDec * self, guint16 lost_seq,
+    guint8 * dst_pt)
+{
+  gboolean progress = TRUE;
+  guint i;
+
+  while (progress) {
+    progress = FALSE;
+
+    for (i = 0; i < self->info_fec->len; ++i) {
+      RtpFlexFecPacket *packet = RTP_FLEXFEC_FEC_NTH (self, i);
+      guint16 missing_seq = 0;
+      guint missing = 0;
+      GstBuffer *recovered;
+      guint8 recovered_pt;
+      guint offset;
+
+      if (packet->used)
+        continue;
+
+      for (offset = 0; offset < RTP_FLEXFEC_PROTECTED_PACKETS_MAX; ++offset) {
+        guint16 seq = packet->seq_base + offset;
+
+        if (!rtp_flexfec_mask_is_set (&packet->mask, offset))
+          continue;
+
+        /* Protects packets which were not fetched from the storage */
+        if ((guint16) (seq - self->window_base) >=
+            RTP_FLEXFEC_DEC_WINDOW_SIZE) {
+          missing = G_MAXUINT;
+          break;
+        }
+
+        if (gst_rtp_flexfec_dec_window_lookup (self, seq) < 0) {
+          missing_seq = seq;
+          if (++missing > 1)
+            break;
+        }
+      }
+
+      if (missing > 1)
+        continue;
+
+      packet->used = TRUE;
+      if (missing == 0)
+        continue;
+
+      recovered = gst_rtp_flexfec_dec_recover_from_fec (self, packet,
+          missing_seq, &recovered_pt);
+      if (recovered == NULL)
+        continue;
+
+      if (missing_seq == lost_seq) {
+        *dst_pt = recovered_pt;
+        return recovered;
+      }
+
+      rtp_storage_put_recovered_packet (self->storage, recovered,
+          recovered_pt, self->caps_ssrc, missing_seq);
+      progress = TRUE;
+    }
+  }
+
+  return NULL;
+}
+
+static GstFlowReturn
+gst_rtp_flexfec_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstRtpFlexFecDec *self = GST_RTP_FLEXFEC_DEC (parent);
+
+  if (G_LIKELY (GST_FLOW_OK == self->chain_return_val)) {
+    if (G_UNLIKELY (self->unset_discont_flag)) {
+      self->unset_discont_flag = FALSE;
+      buf = gst_buffer_make_writable (buf);
+      GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DISCONT);
+    }
+
+    return gst_pad_push (self->srcpad, buf);
+  }
+
+  gst_buffer_unref (buf);
+  return self->chain_return_val;
+}
+
+static gboolean
+gst_rtp_flexfec_dec_handle_packet_loss (GstRtpFlexFecDec * self,
+    guint16 seqnum, GstClockTime timestamp)
+{
+  GstBufferList *media, *fec;
+  GstBuffer *recovered = NULL;
+  gboolean from_storage = FALSE;
+  guint8 recovered_pt = 0;
+  gint idx;
+
+  media = rtp_storage_get_packets_in_range (self->storage, self->caps_ssrc,
+      seqnum - (RTP_FLEXFEC_PROTECTED_PACKETS_MAX - 1),
+      seqnum + (RTP_FLEXFEC_PROTECTED_PACKETS_MAX - 1));
+  fec = rtp_storage_get_fec_packets (self->storage, self->fec_pt);
+
+  gst_rtp_flexfec_dec_start (self, seqnum, media, fec);
+
+  idx = gst_rtp_flexfec_dec_window_lookup (self, seqnum);
+  if (idx >= 0) {
+    /* Arrived too late or recovered while handling a previous loss */
+    RtpUlpFecMapInfo *info = RTP_FLEXFEC_MEDIA_NTH (self, idx);
+
+    GST_DEBUG_OBJECT (self, "Received lost packet from the storage");
+    recovered = gst_buffer_ref (info->rtp.buffer);
+    recovered_pt = gst_rtp_buffer_get_payload_type (&info->rtp);
+    from_storage = TRUE;
+  } else {
+    recovered = gst_rtp_flexfec_dec_recover (self, seqnum, &recovered_pt);
+  }
+
+  gst_rtp_flexfec_dec_stop (self);
+  if (media)
+    gst_buffer_list_unref (media);
+  if (fec)
+    gst_buffer_list_unref (fec);
+
+  if (recovered == NULL) {
+    GST_DEBUG_OBJECT (self, "Packet lost ssrc=0x%08x seq=%u", self->caps_ssrc,
+        seqnum);
+    return TRUE;
+  }
+
+  recovered = gst_buffer_make_writable (recovered);
+  GST_BUFFER_PTS (recovered) = timestamp;
+
+  if (!from_storage)
+    rtp_storage_put_recovered_packet (self->storage,
+        gst_buffer_ref (recovered), recovered_pt, self->caps_ssrc, seqnum);
+
+  GST_DEBUG_OBJECT (self,
+      "Pushing recovered packet ssrc=0x%08x seq=%u %" GST_PTR_FORMAT,
+      self->caps_ssrc, seqnum, recovered);
+
+  self->unset_discont_flag = TRUE;
+  self->chain_return_val = gst_pad_push (self->srcpad, recovered);
+  return FALSE;
+}
+
+static gboolean
+gst_rtp_flexfec_dec_handle_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRtpFlexFecDec *self = GST_RTP_FLEXFEC_DEC (parent);
+  gboolean forward = TRUE;
+
+  GST_LOG_OBJECT (self, "Received event %" GST_PTR_FORMAT, event);
+
+  if (GST_FLOW_OK == self->chain_return_val &&
+      GST_EVENT_CUSTOM_DOWNSTREAM == GST_EVENT_TYPE (event) &&
+      gst_event_has_name (event, "GstRTPPacketLost")) {
+    const GstStructure *s = gst_event_get_structure (event);
+    GstClockTime timestamp;
+    guint seqnum;
+
+    if (!self->have_caps_ssrc) {
+      GST_DEBUG_OBJECT (self, "No SSRC in the caps, can't recover packets");
+      return gst_pad_push_event (self->srcpad, event);
+    }
+
+    if (self->storage == NULL) {
+      GstQuery *q = gst_query_new_custom (GST_QUERY_CUSTOM,
+          gst_structure_new_empty ("GstRtpStorage"));
+
+      if (gst_pad_peer_query (self->sinkpad, q)) {
+        const GstStructure *qs = gst_query_get_structure (q);
+
+        if (gst_structure_has_field_typed (qs, "storage", G_TYPE_OBJECT)) {
+          gst_structure_get (qs, "storage", G_TYPE_OBJECT, &self->storage,
+              NULL);
+        }
+      }
+      gst_query_unref (q);
+    }
+
+    if (self->storage == NULL) {
+      GST_ELEMENT_WARNING (self, STREAM, FAILED, ("Internal storage not found"),
+          ("You need to add rtpstorage element upstream from rtpflexfecdec."));
+      return FALSE;
+    }
+
+    if (!gst_structure_get (s,
+            "seqnum", G_TYPE_UINT, &seqnum,
+            "timestamp", G_TYPE_UINT64, &timestamp, NULL))
+      g_assert_not_reached ();
+
+    forward = gst_rtp_flexfec_dec_handle_packet_loss (self, seqnum, timestamp);
+
+    if (forward)
+      ++self->packets_unrecovered;
+    else
+      ++self->packets_recovered;
+
+    GST_DEBUG_OBJECT (self, "Unrecovered / Recovered: %lu / %lu",
+        (gulong) self->packets_unrecovered, (gulong) self->packets_recovered);
+  } else if (GST_EVENT_CAPS == GST_EVENT_TYPE (event)) {
+    GstCaps *caps;
+    gboolean have_caps_pt = FALSE;
+    gboolean have_caps_ssrc = FALSE;
+    guint caps_ssrc = 0;
+    gint caps_pt = 0;
+
+    gst_event_parse_caps (event, &caps);
+    have_caps_ssrc =
+        gst_structure_get_uint (gst_caps_get_structure (caps, 0), "ssrc",
+        &caps_ssrc);
+    have_caps_pt =
+        gst_structure_get_int (gst_caps_get_structure (caps, 0), "payload",
+        &caps_pt);
+
+    if (self->have_caps_ssrc != have_caps_ssrc || self->caps_ssrc != caps_ssrc)
+      GST_DEBUG_OBJECT (self, "SSRC changed %u, 0x%08x -> %u, 0x%08x",
+          self->have_caps_ssrc, self->caps_ssrc, have_caps_ssrc, caps_ssrc);
+    if (self->have_caps_pt != have_caps_pt || self->caps_pt != caps_pt)
+      GST_DEBUG_OBJECT (self, "PT changed %u, %u -> %u, %u",
+          self->have_caps_pt, self->caps_pt, have_caps_pt, caps_pt);
+
+    self->have_caps_ssrc = have_caps_ssrc;
+    self->have_caps_pt = have_caps_pt;
+    self->caps_ssrc = caps_ssrc;
+    self->caps_pt = caps_pt;
+  }
+
+  if (forward)
+    return gst_pad_push_event (self->srcpad, event);
+  gst_event_unref (event);
+  return TRUE;
+}
+
+static void
+gst_rtp_flexfec_dec_init (GstRtpFlexFecDec * self)
+{
+  self->srcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+  self->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_dec_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_dec_handle_sink_event));
+
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->fec_pt = DEFAULT_FEC_PT;
+
+  self->chain_return_val = GST_FLOW_OK;
+  self->info_media = g_array_new (FALSE, TRUE, sizeof (RtpUlpFecMapInfo));
+  g_array_set_clear_func (self->info_media,
+      (GDestroyNotify) rtp_ulpfec_map_info_unmap);
+  self->info_fec = g_array_new (FALSE, TRUE, sizeof (RtpFlexFecPacket));
+  g_array_set_clear_func (self->info_fec,
+      (GDestroyNotify) rtp_ulpfec_map_info_unmap);
+  self->scratch_buf = g_array_new (FALSE, TRUE, sizeof (guint8));
+}
+
+static void
+gst_rtp_flexfec_dec_dispose (GObject * obj)
+{
+  GstRtpFlexFecDec *self = GST_RTP_FLEXFEC_DEC (obj);
+
+  GST_INFO_OBJECT (self,
+      " ssrc=0x%08x pt=%u"
+      " packets_recovered=%" G_GSIZE_FORMAT
+      " packets_unrecovered=%" G_GSIZE_FORMAT,
+      self->caps_ssrc, self->caps_pt,
+      self->packets_recovered, self->packets_unrecovered);
+
+  if (self->storage)
+    g_object_unref (self->storage);
+  self->storage = NULL;
+
+  g_clear_pointer (&self->info_media, g_array_unref);
+  g_clear_pointer (&self->info_fec, g_array_unref);
+  g_clear_pointer (&self->scratch_buf, g_array_unref);
+
+  G_OBJECT_CLASS (gst_rtp_flexfec_dec_parent_class)->dispose (obj);
+}
+
+static void
+gst_rtp_flexfec_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpFlexFecDec *self = GST_RTP_FLEXFEC_DEC (object);
+
+  switch (prop_id) {
+    case PROP_PT:
+      self->fec_pt = g_value_get_uint (value);
+      break;
+    case PROP_STORAGE:
+      if (self->storage)
+        g_object_unref (self->storage);
+      self->storage = g_value_get_object (value);
+      if (self->storage)
+        g_object_ref (self->storage);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_flexfec_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpFlexFecDec *self = GST_RTP_FLEXFEC_DEC (object);
+
+  switch (prop_id) {
+    case PROP_PT:
+      g_value_set_uint (value, self->fec_pt);
+      break;
+    case PROP_STORAGE:
+      g_value_set_object (value, self->storage);
+      break;
+    case PROP_RECOVERED:
+      g_value_set_uint (value, (guint) self->packets_recovered);
+      break;
+    case PROP_UNRECOVERED:
+      g_value_set_uint (value, (guint) self->packets_unrecovered);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_flexfec_dec_class_init (GstRtpFlexFecDecClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (gst_rtp_flexfec_dec_debug,
+      "rtpflexfecdec", 0, "RTP FlexFEC Decoder");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&srctemplate));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sinktemplate));
+
+  gst_element_class_set_static_metadata (element_class,
+      "RTP FlexFEC Decoder",
+      "Codec/Depayloader/Network/RTP",
+      "Decodes RTP FlexFEC (RFC8627)", "Pexip");
+
+  gobject_class->set_property =
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_dec_set_property);
+  gobject_class->get_property =
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_dec_get_property);
+  gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_rtp_flexfec_dec_dispose);
+
+  klass_properties[PROP_PT] = g_param_spec_uint ("pt", "pt",
+      "FEC packets payload type", 0, 127,
+      DEFAULT_FEC_PT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  klass_properties[PROP_STORAGE] =
+      g_param_spec_object ("storage", "RTP storage", "RTP storage",
+      G_TYPE_OBJECT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  klass_properties[PROP_RECOVERED] =
+      g_param_spec_uint ("recovered", "recovered",
+      "The number of recovered packets", 0, G_MAXUINT, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+  klass_properties[PROP_UNRECOVERED] =
+      g_param_spec_uint ("unrecovered", "unrecovered",
+      "The number of unrecovered packets", 0, G_MAXUINT, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, N_PROPERTIES,
+      klass_properties);
+}
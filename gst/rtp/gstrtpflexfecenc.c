@@ -0,0 +1,429 @@
+/* GStreamer plugin for forward error correction
+ * Copyright (C) 2021 Pexip
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/**
+ * SECTION:element-rtpflexfecenc
+ * @short_description: RTP FlexFEC encoder
+ * @title: rtpflexfecenc
+ *
+ * Flexible Forward Error Correction (FlexFEC) encoder as described in
+ * RFC 8627.
+ *
+ * Unlike #GstRtpUlpFecEnc, the repair packets are sent in their own SSRC
+ * (#GstRtpFlexFecEnc:ssrc) and sequence number space, the protected media
+ * packets are left untouched.
+ *
+ * The media packets are grouped in blocks of #GstRtpFlexFecEnc:columns by
+ * #GstRtpFlexFecEnc:rows packets. With #GstRtpFlexFecEnc:enable-row-fec,
+ * a repair packet is sent for every row of consecutive packets, with
+ * #GstRtpFlexFecEnc:enable-column-fec one is sent for every column, that is
+ * for packets interleaved by #GstRtpFlexFecEnc:columns sequence numbers.
+ * Column protection allows recovering bursts of up to
+ * #GstRtpFlexFecEnc:columns consecutive lost packets, and combined with row
+ * protection a receiver can iteratively recover many more loss patterns than
+ * a single XOR protection group.
+ *
+ * All the repair packets are signalled with the flexible mask of RFC 8627,
+ * a block can thus contain at most 110 packets.
+ *
+ * A payload type for the protection packets *must* be specified with the
+ * #GstRtpFlexFecEnc:pt property, otherwise this element passes the media
+ * through without protecting it.
+ *
+ * When using #GstRtpBin, this element should be inserted through the
+ * #GstRtpBin::request-fec-encoder signal.
+ *
+ * ## Example pipeline
+ *
+ * |[
+ * gst-launch-1.0 videotestsrc ! x264enc ! video/x-h264, profile=baseline ! rtph264pay pt=96 ! rtpflexfecenc pt=122 columns=5 rows=4 ! udpsink port=8888
+ * ]| This example will send a stream protected with 5x4 FlexFEC blocks.
+ *
+ * See also: #GstRtpFlexFecDec, #GstRtpUlpFecEnc, #GstRtpBin
+ * Since: 1.20
+ */
+
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "gstrtpelements.h"
+#include "rtpulpfeccommon.h"
+#include "rtpflexfeccommon.h"
+#include "gstrtpflexfecenc.h"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp"));
+
+#define UNDEF_PT                255
+
+#define DEFAULT_PT              UNDEF_PT
+#define DEFAULT_SSRC            -1
+#define DEFAULT_COLUMNS         10
+#define DEFAULT_ROWS            10
+#define DEFAULT_ENABLE_ROW      TRUE
+#define DEFAULT_ENABLE_COLUMN   FALSE
+
+GST_DEBUG_CATEGORY (gst_rtp_flexfec_enc_debug);
+#define GST_CAT_DEFAULT (gst_rtp_flexfec_enc_debug)
+
+G_DEFINE_TYPE (GstRtpFlexFecEnc, gst_rtp_flexfec_enc, GST_TYPE_ELEMENT);
+GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (rtpflexfecenc, "rtpflexfecenc",
+    GST_RANK_NONE, GST_TYPE_RTP_FLEXFEC_ENC, rtp_element_init (plugin));
+
+enum
+{
+  PROP_0,
+  PROP_PT,
+  PROP_SSRC,
+  PROP_COLUMNS,
+  PROP_ROWS,
+  PROP_ENABLE_ROW,
+  PROP_ENABLE_COLUMN,
+  PROP_PROTECTED,
+};
+
+static void
+gst_rtp_flexfec_enc_reset_block (GstRtpFlexFecEnc * self)
+{
+  g_ptr_array_set_size (self->block, 0);
+}
+
+/* Called with the object lock */
+static void
+gst_rtp_flexfec_enc_start_block (GstRtpFlexFecEnc * self)
+{
+  self->block_columns = self->columns;
+  self->block_row_fec = self->enable_row_fec;
+  self->block_column_fec = self->enable_column_fec;
+  self->block_rows = self->block_column_fec ? self->rows : 1;
+
+  if (self->block_columns * self->block_rows >
+      RTP_FLEXFEC_PROTECTED_PACKETS_MAX) {
+    GST_WARNING_OBJECT (self, "%ux%u block is too big, limiting to %u rows",
+        self->block_columns, self->block_rows,
+        RTP_FLEXFEC_PROTECTED_PACKETS_MAX / self->block_columns);
+    self->block_rows =
+        RTP_FLEXFEC_PROTECTED_PACKETS_MAX / self->block_columns;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_flexfec_enc_protect (GstRtpFlexFecEnc * self, guint8 pt, guint start,
+    guint stride, guint count, guint32 timestamp, GstBuffer * latest)
+{
+  gboolean have_seq_base = FALSE;
+  guint16 seq_base = 0;
+  RtpFlexFecMask mask;
+  GstBuffer *fec;
+  guint i;
+
+  rtp_flexfec_mask_clear (&mask);
+  g_array_set_size (self->scratch_buf, 0);
+
+  for (i = 0; i < count; ++i) {
+    GstBuffer *buffer = g_ptr_array_index (self->block, start + i * stride);
+    RtpUlpFecMapInfo info = { GST_RTP_BUFFER_INIT };
+    guint16 seq;
+
+    if (!rtp_ulpfec_map_info_map (gst_buffer_ref (buffer), &info))
+      continue;
+
+    seq = gst_rtp_buffer_get_seq (&info.rtp);
+    if (!have_seq_base) {
+      seq_base = seq;
+      have_seq_base = TRUE;
+    }
+
+    if (rtp_flexfec_mask_set (&mask, (guint16) (seq - seq_base))) {
+      rtp_flexfec_bitstring_add_media (&info.rtp, self->scratch_buf);
+    } else {
+      GST_WARNING_OBJECT (self, "Packet seq=%u is too far from seq_base=%u,"
+          " not protecting it", seq, seq_base);
+    }
+
+    rtp_ulpfec_map_info_unmap (&info);
+  }
+
+  if (!have_seq_base)
+    return GST_FLOW_OK;
+
+  fec = rtp_flexfec_bitstring_to_fec_rtp_buffer (self->scratch_buf,
+      self->media_ssrc, seq_base, &mask, pt, self->fec_seqnum++, timestamp,
+      self->fec_ssrc);
+  gst_buffer_copy_into (fec, latest, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  ++self->num_packets_fec;
+
+  GST_LOG_OBJECT (self, "Pushing FEC packet protecting %u packets from"
+      " seq_base=%u, stride %u", count, seq_base, stride);
+
+  return gst_pad_push (self->srcpad, fec);
+}
+
+static GstFlowReturn
+gst_rtp_flexfec_enc_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer)
+{
+  GstRtpFlexFecEnc *self = GST_RTP_FLEXFEC_ENC (parent);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstFlowReturn ret;
+  guint32 timestamp;
+  guint32 ssrc;
+  guint columns;
+  guint idx;
+  guint pt;
+
+  GST_OBJECT_LOCK (self);
+  pt = self->pt;
+  GST_OBJECT_UNLOCK (self);
+
+  if (pt == UNDEF_PT)
+    return gst_pad_push (self->srcpad, buffer);
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp)) {
+    GST_WARNING_OBJECT (self, "Not protecting invalid RTP packet");
+    return gst_pad_push (self->srcpad, buffer);
+  }
+  ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+  timestamp = gst_rtp_buffer_get_timestamp (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  if (!self->have_media_ssrc || self->media_ssrc != ssrc) {
+    GST_DEBUG_OBJECT (self, "Protecting ssrc=0x%08x", ssrc);
+    gst_rtp_flexfec_enc_reset_block (self);
+    self->have_media_ssrc = TRUE;
+    self->media_ssrc = ssrc;
+  }
+
+  if (self->block->len == 0) {
+    GST_OBJECT_LOCK (self);
+    gst_rtp_flexfec_enc_start_block (self);
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  ret = gst_pad_push (self->srcpad, gst_buffer_ref (buffer));
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+
+  if (!self->block_row_fec && !self->block_column_fec) {
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+
+  g_ptr_array_add (self->block, buffer);
+  ++self->num_packets_protected;
+
+  idx = self->block->len - 1;
+  columns = self->block_columns;
+
+  if (self->block_row_fec && idx % columns == columns - 1)
+    ret = gst_rtp_flexfec_enc_protect (self, pt, idx + 1 - columns, 1,
+        columns, timestamp, buffer);
+
+  if (ret == GST_FLOW_OK && self->block_column_fec &&
+      idx >= columns * (self->block_rows - 1))
+    ret = gst_rtp_flexfec_enc_protect (self, pt, idx % columns, columns,
+        self->block_rows, timestamp, buffer);
+
+  if (self->block->len == columns * self->block_rows)
+    gst_rtp_flexfec_enc_reset_block (self);
+
+  return ret;
+}
+
+static void
+gst_rtp_flexfec_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpFlexFecEnc *self = GST_RTP_FLEXFEC_ENC (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_PT:
+      self->pt = g_value_get_uint (value);
+      break;
+    case PROP_SSRC:
+      self->ssrc = g_value_get_uint (value);
+      self->fec_ssrc = self->ssrc == (guint32) DEFAULT_SSRC ?
+          g_random_int () : self->ssrc;
+      break;
+    case PROP_COLUMNS:
+      self->columns = g_value_get_uint (value);
+      break;
+    case PROP_ROWS:
+      self->rows = g_value_get_uint (value);
+      break;
+    case PROP_ENABLE_ROW:
+      self->enable_row_fec = g_value_get_boolean (value);
+      break;
+    case PROP_ENABLE_COLUMN:
+      self->enable_column_fec = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rtp_flexfec_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpFlexFecEnc *self = GST_RTP_FLEXFEC_ENC (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_PT:
+      g_value_set_uint (value, self->pt);
+      break;
+    case PROP_SSRC:
+      g_value_set_uint (value, self->fec_ssrc);
+      break;
+    case PROP_COLUMNS:
+      g_value_set_uint (value, self->columns);
+      break;
+    case PROP_ROWS:
+      g_value_set_uint (value, self->rows);
+      break;
+    case PROP_ENABLE_ROW:
+      g_value_set_boolean (value, self->enable_row_fec);
+      break;
+    case PROP_ENABLE_COLUMN:
+      g_value_set_boolean (value, self->enable_column_fec);
+      break;
+    case PROP_PROTECTED:
+      g_value_set_uint (value, self->num_packets_protected);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_rtp_flexfec_enc_dispose (GObject * obj)
+{
+  GstRtpFlexFecEnc *self = GST_RTP_FLEXFEC_ENC (obj);
+
+  if (self->num_packets_protected) {
+    GST_INFO_OBJECT (self, "Actual FEC overhead is %4.2f%% (%u/%u)",
+        self->num_packets_fec * (double) 100. / self->num_packets_protected,
+        self->num_packets_fec, self->num_packets_protected);
+  }
+
+  g_clear_pointer (&self->block, g_ptr_array_unref);
+  g_clear_pointer (&self->scratch_buf, g_array_unref);
+
+  G_OBJECT_CLASS (gst_rtp_flexfec_enc_parent_class)->dispose (obj);
+}
+
+static void
+gst_rtp_flexfec_enc_init (GstRtpFlexFecEnc * self)
+{
+  self->srcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
+  GST_PAD_SET_PROXY_CAPS (self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (self->sinkpad);
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_enc_chain));
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->fec_seqnum = g_random_int_range (0, G_MAXUINT16 / 2);
+  self->fec_ssrc = g_random_int ();
+
+  self->block = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_buffer_unref);
+  self->scratch_buf = g_array_new (FALSE, TRUE, sizeof (guint8));
+}
+
+static void
+gst_rtp_flexfec_enc_class_init (GstRtpFlexFecEncClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (gst_rtp_flexfec_enc_debug, "rtpflexfecenc", 0,
+      "FlexFEC encoder element");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&srctemplate));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sinktemplate));
+
+  gst_element_class_set_static_metadata (element_class,
+      "RTP FlexFEC Encoder",
+      "Codec/Payloader/Network/RTP",
+      "Encodes RTP FlexFEC (RFC8627)", "Pexip");
+
+  gobject_class->set_property =
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_enc_set_property);
+  gobject_class->get_property =
+      GST_DEBUG_FUNCPTR (gst_rtp_flexfec_enc_get_property);
+  gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_rtp_flexfec_enc_dispose);
+
+  g_object_class_install_property (gobject_class, PROP_PT,
+      g_param_spec_uint ("pt", "payload type",
+          "The payload type of FEC packets", 0, 255, DEFAULT_PT,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SSRC,
+      g_param_spec_uint ("ssrc", "SSRC",
+          "The SSRC of FEC packets (-1 == random)", 0, G_MAXUINT32,
+          DEFAULT_SSRC,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_COLUMNS,
+      g_param_spec_uint ("columns", "Columns",
+          "Number of packets per row (L)", 1,
+          RTP_FLEXFEC_PROTECTED_PACKETS_MAX, DEFAULT_COLUMNS,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ROWS,
+      g_param_spec_uint ("rows", "Rows",
+          "Number of packets per column (D)", 1,
+          RTP_FLEXFEC_PROTECTED_PACKETS_MAX, DEFAULT_ROWS,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ENABLE_ROW,
+      g_param_spec_boolean ("enable-row-fec", "Enable Row FEC",
+          "Whether to send repair packets for rows of consecutive packets",
+          DEFAULT_ENABLE_ROW,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ENABLE_COLUMN,
+      g_param_spec_boolean ("enable-column-fec", "Enable Column FEC",
+          "Whether to send repair packets for columns of interleaved packets",
+          DEFAULT_ENABLE_COLUMN,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PROTECTED,
+      g_param_spec_uint ("protected", "Protected",
+          "Count of protected packets", 0, G_MAXUINT32, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
@@ -0,0 +1,78 @@
+/* GStreamer plugin for forward error correction
+ * Copyright (C) 2021 Pexip
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __GST_RTP_FLEXFEC_ENC_H__
+#define __GST_RTP_FLEXFEC_ENC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_RTP_FLEXFEC_ENC \
+  (gst_rtp_flexfec_enc_get_type())
+#define GST_RTP_FLEXFEC_ENC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTP_FLEXFEC_ENC,GstRtpFlexFecEnc))
+#define GST_RTP_FLEXFEC_ENC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_RTP_FLEXFEC_ENC,GstRtpFlexFecEncClass))
+#define GST_IS_RTP_FLEXFEC_ENC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTP_FLEXFEC_ENC))
+#define GST_IS_RTP_FLEXFEC_ENC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_RTP_FLEXFEC_ENC))
+
+typedef struct _GstRtpFlexFecEnc GstRtpFlexFecEnc;
+typedef struct _GstRtpFlexFecEncClass GstRtpFlexFecEncClass;
+
+struct _GstRtpFlexFecEncClass {
+  GstElementClass parent_class;
+};
+
+struct _GstRtpFlexFecEnc {
+  GstElement parent;
+  GstPad *srcpad;
+  GstPad *sinkpad;
+
+  /* properties */
+  guint pt;
+  guint32 ssrc;
+  guint columns;
+  guint rows;
+  gboolean enable_row_fec;
+  gboolean enable_column_fec;
+
+  /* internal stuff */
+  guint32 fec_ssrc;
+  guint16 fec_seqnum;
+  gboolean have_media_ssrc;
+  guint32 media_ssrc;
+  guint block_columns;
+  guint block_rows;
+  gboolean block_row_fec;
+  gboolean block_column_fec;
+  GPtrArray *block;
+  GArray *scratch_buf;
+
+  /* stats */
+  guint num_packets_protected;
+  guint num_packets_fec;
+};
+
+GType gst_rtp_flexfec_enc_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_RTP_FLEXFEC_ENC_H__ */
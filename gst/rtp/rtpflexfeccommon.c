@@ -0,0 +1,343 @@
+/* GStreamer plugin for forward error correction
+ * Copyright (C) 2021 Pexip
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <string.h>
+#include "rtpflexfeccommon.h"
+#include "rtpfecorc.h"
+
+#define MIN_RTP_HEADER_LEN 12
+
+/* The bitstring is laid out as the first 8 bytes of the FEC header
+ * (P|X|CC|M|PT, length recovery and TS recovery) followed by the XOR of
+ * everything past the fixed RTP header */
+#define BITSTRING_HEADER_LEN 8
+
+#define FLEXFEC_HEADER_LEN_SHORT 12
+#define FLEXFEC_HEADER_LEN_MEDIUM 16
+#define FLEXFEC_HEADER_LEN_LONG 24
+
+void
+rtp_flexfec_mask_clear (RtpFlexFecMask * mask)
+{
+  mask->bits[0] = 0;
+  mask->bits[1] = 0;
+}
+
+gboolean
+rtp_flexfec_mask_set (RtpFlexFecMask * mask, guint offset)
+{
+  if (offset >= RTP_FLEXFEC_PROTECTED_PACKETS_MAX)
+    return FALSE;
+
+  mask->bits[offset / 64] |= G_GUINT64_CONSTANT (1) << (offset % 64);
+  return TRUE;
+}
+
+gboolean
+rtp_flexfec_mask_is_set (const RtpFlexFecMask * mask, guint offset)
+{
+  if (offset >= RTP_FLEXFEC_PROTECTED_PACKETS_MAX)
+    return FALSE;
+
+  return (mask->bits[offset / 64] >> (offset % 64)) & 1;
+}
+
+/**
+ * rtp_flexfec_mask_get_header_len:
+ * @mask: #RtpFlexFecMask
+ *
+ * Returns: the length of the FEC header needed to signal @mask, picking the
+ * shortest of the three mask sizes allowed by RFC 8627
+ **/
+guint
+rtp_flexfec_mask_get_header_len (const RtpFlexFecMask * mask)
+{
+  if (mask->bits[1] || (mask->bits[0] >> 46))
+    return FLEXFEC_HEADER_LEN_LONG;
+  if (mask->bits[0] >> 15)
+    return FLEXFEC_HEADER_LEN_MEDIUM;
+  return FLEXFEC_HEADER_LEN_SHORT;
+}
+
+static void
+rtp_flexfec_mask_write (const RtpFlexFecMask * mask, guint8 * data,
+    guint header_len)
+{
+  guint16 mask0 = 0;
+  guint32 mask1 = 0;
+  guint64 mask2 = 0;
+  guint i;
+
+  for (i = 0; i < 15; ++i)
+    if (rtp_flexfec_mask_is_set (mask, i))
+      mask0 |= 1 << (14 - i);
+  for (i = 0; i < 31; ++i)
+    if (rtp_flexfec_mask_is_set (mask, 15 + i))
+      mask1 |= 1U << (30 - i);
+  for (i = 0; i < 64; ++i)
+    if (rtp_flexfec_mask_is_set (mask, 46 + i))
+      mask2 |= G_GUINT64_CONSTANT (1) << (63 - i);
+
+  switch (header_len) {
+    case FLEXFEC_HEADER_LEN_SHORT:
+      GST_WRITE_UINT16_BE (data, mask0 | 0x8000);
+      break;
+    case FLEXFEC_HEADER_LEN_MEDIUM:
+      GST_WRITE_UINT16_BE (data, mask0);
+      GST_WRITE_UINT32_BE (data + 2, mask1 | 0x80000000);
+      break;
+    case FLEXFEC_HEADER_LEN_LONG:
+      GST_WRITE_UINT16_BE (data, mask0);
+      GST_WRITE_UINT32_BE (data + 2, mask1);
+      GST_WRITE_UINT64_BE (data + 6, mask2);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+/* Parses the k-bit terminated mask at @data, returns the number of bytes it
+ * occupies or 0 if @len is too short */
+static guint
+rtp_flexfec_mask_read (RtpFlexFecMask * mask, const guint8 * data, guint len)
+{
+  guint16 mask0;
+  guint32 mask1;
+  guint64 mask2;
+  guint i;
+
+  rtp_flexfec_mask_clear (mask);
+
+  if (len < 2)
+    return 0;
+  mask0 = GST_READ_UINT16_BE (data);
+  for (i = 0; i < 15; ++i)
+    if (mask0 & (1 << (14 - i)))
+      rtp_flexfec_mask_set (mask, i);
+  if (mask0 & 0x8000)
+    return 2;
+
+  if (len < 6)
+    return 0;
+  mask1 = GST_READ_UINT32_BE (data + 2);
+  for (i = 0; i < 31; ++i)
+    if (mask1 & (1U << (30 - i)))
+      rtp_flexfec_mask_set (mask, 15 + i);
+  if (mask1 & 0x80000000)
+    return 6;
+
+  if (len < 14)
+    return 0;
+  mask2 = GST_READ_UINT64_BE (data + 6);
+  for (i = 0; i < 64; ++i)
+    if (mask2 & (G_GUINT64_CONSTANT (1) << (63 - i)))
+      rtp_flexfec_mask_set (mask, 46 + i);
+  return 14;
+}
+
+/**
+ * rtp_flexfec_buffer_parse:
+ * @rtp: mapped FlexFEC repair packet
+ * @ssrc: the SSRC of the protected stream
+ * @seq_base: (out): the first sequence number protected for @ssrc
+ * @mask: (out): the packets protected for @ssrc
+ * @header_len: (out): length of the whole FEC header, the repair payload
+ *   starts right after it
+ *
+ * Returns: %TRUE if @rtp is a valid flexible mask repair packet
+ * protecting @ssrc
+ **/
+gboolean
+rtp_flexfec_buffer_parse (GstRTPBuffer * rtp, guint32 ssrc,
+    guint16 * seq_base, RtpFlexFecMask * mask, guint * header_len)
+{
+  const guint8 *data = gst_rtp_buffer_get_payload (rtp);
+  guint len = gst_rtp_buffer_get_payload_len (rtp);
+  guint csrc_count = gst_rtp_buffer_get_csrc_count (rtp);
+  gboolean found = FALSE;
+  guint offset = BITSTRING_HEADER_LEN;
+  guint i;
+
+  if (len < FLEXFEC_HEADER_LEN_SHORT || csrc_count == 0)
+    return FALSE;
+
+  /* R=1 is retransmission and F=1 the fixed L/D mask, neither is supported */
+  if (data[0] & 0xc0)
+    return FALSE;
+
+  for (i = 0; i < csrc_count; ++i) {
+    RtpFlexFecMask tmp_mask;
+    guint16 tmp_seq_base;
+    guint mask_len;
+
+    if (offset + 2 > len)
+      return FALSE;
+    tmp_seq_base = GST_READ_UINT16_BE (data + offset);
+    mask_len = rtp_flexfec_mask_read (&tmp_mask, data + offset + 2,
+        len - offset - 2);
+    if (mask_len == 0)
+      return FALSE;
+
+    if (!found && gst_rtp_buffer_get_csrc (rtp, i) == ssrc) {
+      *seq_base = tmp_seq_base;
+      *mask = tmp_mask;
+      found = TRUE;
+    }
+    offset += 2 + mask_len;
+  }
+
+  *header_len = offset;
+  return found;
+}
+
+/**
+ * rtp_flexfec_bitstring_add_media:
+ * @rtp: mapped media packet
+ * @dst_arr: #GArray of guint8 holding the bitstring
+ *
+ * XORs @rtp into @dst_arr, growing it if needed
+ **/
+void
+rtp_flexfec_bitstring_add_media (GstRTPBuffer * rtp, GArray * dst_arr)
+{
+  const guint8 *src = rtp->data[0];
+  guint len = gst_rtp_buffer_get_packet_len (rtp) - MIN_RTP_HEADER_LEN;
+  guint8 *dst;
+
+  g_array_set_size (dst_arr, MAX (BITSTRING_HEADER_LEN + len, dst_arr->len));
+  dst = (guint8 *) dst_arr->data;
+
+  dst[0] ^= src[0];
+  dst[1] ^= src[1];
+  GST_WRITE_UINT16_BE (dst + 2, GST_READ_UINT16_BE (dst + 2) ^ len);
+  GST_WRITE_UINT32_BE (dst + 4,
+      GST_READ_UINT32_BE (dst + 4) ^ GST_READ_UINT32_BE (src + 4));
+  rtp_fec_orc_xor (dst + BITSTRING_HEADER_LEN, src + MIN_RTP_HEADER_LEN, len);
+}
+
+/**
+ * rtp_flexfec_bitstring_add_fec:
+ * @rtp: mapped FlexFEC repair packet
+ * @header_len: FEC header length as returned by rtp_flexfec_buffer_parse()
+ * @dst_arr: #GArray of guint8 holding the bitstring
+ *
+ * XORs the repair bits of @rtp into @dst_arr, growing it if needed
+ **/
+void
+rtp_flexfec_bitstring_add_fec (GstRTPBuffer * rtp, guint header_len,
+    GArray * dst_arr)
+{
+  const guint8 *src = gst_rtp_buffer_get_payload (rtp);
+  guint len = gst_rtp_buffer_get_payload_len (rtp) - header_len;
+  guint8 *dst;
+  guint i;
+
+  g_array_set_size (dst_arr, MAX (BITSTRING_HEADER_LEN + len, dst_arr->len));
+  dst = (guint8 *) dst_arr->data;
+
+  dst[0] ^= src[0] & 0x3f;
+  for (i = 1; i < BITSTRING_HEADER_LEN; ++i)
+    dst[i] ^= src[i];
+  rtp_fec_orc_xor (dst + BITSTRING_HEADER_LEN, src + header_len, len);
+}
+
+/**
+ * rtp_flexfec_bitstring_to_media_rtp_buffer:
+ * @arr: bitstring of the FEC packet XORed with all the other protected
+ *   media packets
+ * @ssrc: SSRC of the recovered packet
+ * @seq: sequence number of the recovered packet
+ *
+ * Returns: (transfer full): the recovered packet, or %NULL if @arr is
+ * inconsistent with its length recovery field
+ **/
+GstBuffer *
+rtp_flexfec_bitstring_to_media_rtp_buffer (GArray * arr, guint32 ssrc,
+    guint16 seq)
+{
+  const guint8 *bits = (const guint8 *) arr->data;
+  GstMapInfo map;
+  GstBuffer *ret;
+  guint len;
+
+  if (arr->len < BITSTRING_HEADER_LEN)
+    return NULL;
+
+  len = GST_READ_UINT16_BE (bits + 2);
+  if (BITSTRING_HEADER_LEN + len > arr->len)
+    return NULL;
+
+  ret = gst_buffer_new_allocate (NULL, MIN_RTP_HEADER_LEN + len, NULL);
+  gst_buffer_map (ret, &map, GST_MAP_WRITE);
+  map.data[0] = 0x80 | (bits[0] & 0x3f);
+  map.data[1] = bits[1];
+  GST_WRITE_UINT16_BE (map.data + 2, seq);
+  memcpy (map.data + 4, bits + 4, 4);
+  GST_WRITE_UINT32_BE (map.data + 8, ssrc);
+  memcpy (map.data + MIN_RTP_HEADER_LEN, bits + BITSTRING_HEADER_LEN, len);
+  gst_buffer_unmap (ret, &map);
+
+  return ret;
+}
+
+/**
+ * rtp_flexfec_bitstring_to_fec_rtp_buffer:
+ * @arr: XOR of the bitstrings of all the protected media packets
+ * @protected_ssrc: SSRC of the protected stream
+ * @seq_base: first protected sequence number
+ * @mask: protected packets, relative to @seq_base
+ * @pt: payload type of the repair packet
+ * @seq: sequence number of the repair packet
+ * @timestamp: timestamp of the repair packet
+ * @ssrc: SSRC of the repair stream
+ *
+ * Returns: (transfer full): the FlexFEC repair packet
+ **/
+GstBuffer *
+rtp_flexfec_bitstring_to_fec_rtp_buffer (GArray * arr, guint32 protected_ssrc,
+    guint16 seq_base, const RtpFlexFecMask * mask, guint8 pt, guint16 seq,
+    guint32 timestamp, guint32 ssrc)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  const guint8 *bits = (const guint8 *) arr->data;
+  guint header_len = rtp_flexfec_mask_get_header_len (mask);
+  guint payload_len;
+  GstBuffer *ret;
+  guint8 *data;
+
+  g_assert (arr->len >= BITSTRING_HEADER_LEN);
+  payload_len = arr->len - BITSTRING_HEADER_LEN;
+
+  ret = gst_rtp_buffer_new_allocate (header_len + payload_len, 0, 1);
+  gst_rtp_buffer_map (ret, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, pt);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, timestamp);
+  gst_rtp_buffer_set_ssrc (&rtp, ssrc);
+  gst_rtp_buffer_set_csrc (&rtp, 0, protected_ssrc);
+
+  data = gst_rtp_buffer_get_payload (&rtp);
+  data[0] = bits[0] & 0x3f;
+  memcpy (data + 1, bits + 1, BITSTRING_HEADER_LEN - 1);
+  GST_WRITE_UINT16_BE (data + BITSTRING_HEADER_LEN, seq_base);
+  rtp_flexfec_mask_write (mask, data + BITSTRING_HEADER_LEN + 2, header_len);
+  memcpy (data + header_len, bits + BITSTRING_HEADER_LEN, payload_len);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return ret;
+}
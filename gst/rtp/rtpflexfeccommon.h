@@ -0,0 +1,78 @@
+/* GStreamer plugin for forward error correction
+ * Copyright (C) 2021 Pexip
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __RTP_FLEXFEC_COMMON_H__
+#define __RTP_FLEXFEC_COMMON_H__
+
+#include <gst/gst.h>
+#include <gst/rtp/rtp.h>
+
+G_BEGIN_DECLS
+
+/* RFC 8627, flexible mask (R=0, F=0) */
+/*
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   |0|0|P|X|  CC   |M| PT recovery |         length recovery       |
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   |                          TS recovery                          |
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   |           SN base_i           |k|          Mask [0-14]        |
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   |k|                   Mask [15-45] (optional)                   |
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   |                     Mask [46-109] (optional)                  |
+   |                                                               |
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+   The protected SSRCs are carried in the CSRC list of the repair packet,
+   with one SN base / mask pair per CSRC.
+*/
+
+#define RTP_FLEXFEC_PROTECTED_PACKETS_MAX  110
+
+/**
+ * RtpFlexFecMask: Set of protected packets, bit i stands for SN base + i
+ **/
+typedef struct {
+  guint64 bits[2];
+} RtpFlexFecMask;
+
+void       rtp_flexfec_mask_clear                   (RtpFlexFecMask * mask);
+gboolean   rtp_flexfec_mask_set                     (RtpFlexFecMask * mask, guint offset);
+gboolean   rtp_flexfec_mask_is_set                  (const RtpFlexFecMask * mask, guint offset);
+guint      rtp_flexfec_mask_get_header_len          (const RtpFlexFecMask * mask);
+
+gboolean   rtp_flexfec_buffer_parse                 (GstRTPBuffer * rtp, guint32 ssrc,
+                                                     guint16 * seq_base, RtpFlexFecMask * mask,
+                                                     guint * header_len);
+
+void       rtp_flexfec_bitstring_add_media          (GstRTPBuffer * rtp, GArray * dst_arr);
+void       rtp_flexfec_bitstring_add_fec            (GstRTPBuffer * rtp, guint header_len,
+                                                     GArray * dst_arr);
+
+GstBuffer *rtp_flexfec_bitstring_to_media_rtp_buffer (GArray * arr, guint32 ssrc, guint16 seq);
+GstBuffer *rtp_flexfec_bitstring_to_fec_rtp_buffer  (GArray * arr, guint32 protected_ssrc,
+                                                     guint16 seq_base, const RtpFlexFecMask * mask,
+                                                     guint8 pt, guint16 seq,
+                                                     guint32 timestamp, guint32 ssrc);
+
+G_END_DECLS
+
+#endif /* __RTP_FLEXFEC_COMMON_H__ */
@@ -141,6 +141,72 @@ rtp_storage_get_redundant_packet (RtpStorage * self, guint32 ssrc,
   return ret;
 }
 
+GstBufferList *
+rtp_storage_get_packets_in_range (RtpStorage * self, guint32 ssrc,
+    guint16 first_seq, guint16 last_seq)
+{
+  GstBufferList *ret = NULL;
+  RtpStorageStream *stream;
+
+  if (0 == self->size_time) {
+    GST_WARNING_OBJECT (self, "Received request for RTP packets in range"
+        " [%u, %u] for ssrc=%08x, but size is 0", first_seq, last_seq, ssrc);
+    return NULL;
+  }
+
+  STORAGE_LOCK (self);
+  stream = g_hash_table_lookup (self->streams, GUINT_TO_POINTER (ssrc));
+  STORAGE_UNLOCK (self);
+
+  if (NULL == stream) {
+    GST_ERROR_OBJECT (self, "Can't find ssrc = 0x%x", ssrc);
+  } else {
+    STREAM_LOCK (stream);
+    ret = rtp_storage_stream_get_packets_in_range (stream, first_seq,
+        last_seq);
+    STREAM_UNLOCK (stream);
+  }
+
+  return ret;
+}
+
+/* Returns all the stored packets with payload type @fec_pt, whichever SSRC
+ * they were sent with. Used by FEC schemes that send the repair packets in
+ * their own SSRC (e.g. FlexFEC) */
+GstBufferList *
+rtp_storage_get_fec_packets (RtpStorage * self, guint8 fec_pt)
+{
+  GstBufferList *ret;
+  GHashTableIter iter;
+  gpointer value;
+
+  if (0 == self->size_time) {
+    GST_WARNING_OBJECT (self, "Received request for FEC packets with"
+        " fec_pt=%u, but size is 0", fec_pt);
+    return NULL;
+  }
+
+  ret = gst_buffer_list_new ();
+
+  STORAGE_LOCK (self);
+  g_hash_table_iter_init (&iter, self->streams);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    RtpStorageStream *stream = value;
+
+    STREAM_LOCK (stream);
+    rtp_storage_stream_add_packets_with_pt (stream, fec_pt, ret);
+    STREAM_UNLOCK (stream);
+  }
+  STORAGE_UNLOCK (self);
+
+  if (gst_buffer_list_length (ret) == 0) {
+    gst_buffer_list_unref (ret);
+    return NULL;
+  }
+
+  return ret;
+}
+
 static void
 rtp_storage_do_put_recovered_packet (RtpStorage * self,
     GstBuffer * buffer, guint8 pt, guint32 ssrc, guint16 seq)
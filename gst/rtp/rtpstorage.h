@@ -56,6 +56,9 @@ void            rtp_storage_put_recovered_packet     (RtpStorage * self, GstBuff
                                                       guint8 pt, guint32 ssrc, guint16 seq);
 GstBuffer     * rtp_storage_get_redundant_packet     (RtpStorage * self, guint32 ssrc,
                                                       guint16 lost_seq);
+GstBufferList * rtp_storage_get_packets_in_range     (RtpStorage * self, guint32 ssrc,
+                                                      guint16 first_seq, guint16 last_seq);
+GstBufferList * rtp_storage_get_fec_packets          (RtpStorage * self, guint8 fec_pt);
 gboolean        rtp_storage_append_buffer            (RtpStorage *self, GstBuffer *buffer);
 void            rtp_storage_clear                    (RtpStorage *self);
 RtpStorage    * rtp_storage_new                      (void);
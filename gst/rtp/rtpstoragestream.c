@@ -275,3 +275,51 @@ rtp_storage_stream_get_redundant_packet (RtpStorageStream * stream,
       lost_seq, stream->ssrc);
   return NULL;
 }
+
+GstBufferList *
+rtp_storage_stream_get_packets_in_range (RtpStorageStream * stream,
+    guint16 first_seq, guint16 last_seq)
+{
+  GstBufferList *ret = NULL;
+  GList *it;
+
+  /* Iterating from oldest sequence numbers to newest */
+  for (it = stream->queue.tail; it; it = it->prev) {
+    RtpStorageItem *item = it->data;
+
+    if (gst_rtp_buffer_compare_seqnum (first_seq, item->seq) < 0)
+      continue;
+    if (gst_rtp_buffer_compare_seqnum (item->seq, last_seq) < 0)
+      break;
+
+    if (ret == NULL)
+      ret = gst_buffer_list_new ();
+    gst_buffer_list_add (ret, gst_buffer_ref (item->buffer));
+  }
+
+  GST_LOG ("Found %u buffers in range [%u, %u] for ssrc=%08x",
+      ret ? gst_buffer_list_length (ret) : 0, first_seq, last_seq,
+      stream->ssrc);
+
+  return ret;
+}
+
+void
+rtp_storage_stream_add_packets_with_pt (RtpStorageStream * stream, guint8 pt,
+    GstBufferList * list)
+{
+  RtpStorageItem *newest = g_queue_peek_head (&stream->queue);
+  GList *it;
+
+  /* Streams carrying repair packets in their own SSRC only ever contain
+   * that payload type, skip the others without walking them */
+  if (newest == NULL || newest->pt != pt)
+    return;
+
+  for (it = stream->queue.tail; it; it = it->prev) {
+    RtpStorageItem *item = it->data;
+
+    if (item->pt == pt)
+      gst_buffer_list_add (list, gst_buffer_ref (item->buffer));
+  }
+}
@@ -57,6 +57,12 @@ GstBufferList    * rtp_storage_stream_get_packets_for_recovery (RtpStorageStream
                                                                 guint16 lost_seq);
 GstBuffer        * rtp_storage_stream_get_redundant_packet     (RtpStorageStream *stream,
                                                                 guint16 lost_seq);
+GstBufferList    * rtp_storage_stream_get_packets_in_range     (RtpStorageStream *stream,
+                                                                guint16 first_seq,
+                                                                guint16 last_seq);
+void               rtp_storage_stream_add_packets_with_pt      (RtpStorageStream *stream,
+                                                                guint8 pt,
+                                                                GstBufferList *list);
 
 #endif /* __GST_RTP_STORAGE_ITEM_H__ */
 
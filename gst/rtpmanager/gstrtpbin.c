@@ -353,6 +353,7 @@ enum
 #define DEFAULT_MAX_STREAMS          G_MAXUINT
 #define DEFAULT_MAX_TS_OFFSET_ADJUSTMENT G_GUINT64_CONSTANT(0)
 #define DEFAULT_MAX_TS_OFFSET        G_GINT64_CONSTANT(3000000000)
+#define DEFAULT_SCHEDULER_THREADS    0
 
 enum
 {
@@ -382,6 +383,7 @@ enum
   PROP_MAX_TS_OFFSET,
   PROP_FEC_DECODERS,
   PROP_FEC_ENCODERS,
+  PROP_SCHEDULER_THREADS,
 };
 
 #define GST_RTP_BIN_RTCP_SYNC_TYPE (gst_rtp_bin_rtcp_sync_get_type())
@@ -765,6 +767,9 @@ create_session (GstRtpBin * rtpbin, gint id)
 
   g_object_set (session, "max-dropout-time", rtpbin->max_dropout_time,
       "max-misorder-time", rtpbin->max_misorder_time, NULL);
+  if (rtpbin->scheduler)
+    gst_rtp_session_set_scheduler (GST_RTP_SESSION (session),
+        rtpbin->scheduler);
   GST_OBJECT_UNLOCK (rtpbin);
 
   /* provide clock_rate to the session manager when needed */
@@ -2805,6 +2810,24 @@ gst_rtp_bin_class_init (GstRtpBinClass * klass)
           "fec-encoders='fec,0=\"rtpst2022-1-fecenc\\ rows\\=5\\ columns\\=5\";'",
           GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpBin:scheduler-threads:
+   *
+   * When non-zero, the RTCP timeouts of all sessions are handled by this
+   * many shared worker threads instead of one thread per session. This
+   * keeps the number of threads small with many sessions. Only affects
+   * sessions created after setting the property. The jitterbuffers keep
+   * their own timer thread each.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SCHEDULER_THREADS,
+      g_param_spec_uint ("scheduler-threads", "Scheduler Threads",
+          "Number of threads shared by all sessions for RTCP timeouts "
+          "(0 = one thread per session)", 0, G_MAXUINT,
+          DEFAULT_SCHEDULER_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_rtp_bin_change_state);
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_rtp_bin_request_new_pad);
@@ -2893,6 +2916,7 @@ gst_rtp_bin_init (GstRtpBin * rtpbin)
   rtpbin->max_ts_offset_adjustment = DEFAULT_MAX_TS_OFFSET_ADJUSTMENT;
   rtpbin->max_ts_offset = DEFAULT_MAX_TS_OFFSET;
   rtpbin->max_ts_offset_is_set = FALSE;
+  rtpbin->scheduler_threads = DEFAULT_SCHEDULER_THREADS;
 
   /* some default SDES entries */
   cname = g_strdup_printf ("user%u@host-%x", g_random_int (), g_random_int ());
@@ -2938,6 +2962,9 @@ gst_rtp_bin_finalize (GObject * object)
   if (rtpbin->fec_encoders)
     gst_structure_free (rtpbin->fec_encoders);
 
+  if (rtpbin->scheduler)
+    rtp_scheduler_unref (rtpbin->scheduler);
+
   g_mutex_clear (&rtpbin->priv->bin_lock);
   g_mutex_clear (&rtpbin->priv->dyn_lock);
 
@@ -3213,6 +3240,22 @@ gst_rtp_bin_set_property (GObject * object, guint prop_id,
     case PROP_FEC_ENCODERS:
       gst_rtp_bin_set_fec_encoders_struct (rtpbin, g_value_get_boxed (value));
       break;
+    case PROP_SCHEDULER_THREADS:
+      GST_OBJECT_LOCK (rtpbin);
+      rtpbin->scheduler_threads = g_value_get_uint (value);
+      if (rtpbin->scheduler_threads == 0) {
+        /* sessions that have it keep their reference */
+        if (rtpbin->scheduler)
+          rtp_scheduler_unref (rtpbin->scheduler);
+        rtpbin->scheduler = NULL;
+      } else if (rtpbin->scheduler) {
+        rtp_scheduler_set_n_threads (rtpbin->scheduler,
+            rtpbin->scheduler_threads);
+      } else {
+        rtpbin->scheduler = rtp_scheduler_new (rtpbin->scheduler_threads);
+      }
+      GST_OBJECT_UNLOCK (rtpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3313,6 +3356,11 @@ gst_rtp_bin_get_property (GObject * object, guint prop_id,
     case PROP_FEC_ENCODERS:
       g_value_take_boxed (value, gst_rtp_bin_get_fec_encoders_struct (rtpbin));
       break;
+    case PROP_SCHEDULER_THREADS:
+      GST_OBJECT_LOCK (rtpbin);
+      g_value_set_uint (value, rtpbin->scheduler_threads);
+      GST_OBJECT_UNLOCK (rtpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4676,6 +4724,11 @@ setup_aux_sender_fold (const GValue * item, GValue * result, gpointer user_data)
   if (!complete_session_src (rtpbin, newsess))
     goto session_src_failed;
 
+  /* rtprtxsend understands retransmission requests covering a whole generic
+   * NACK and does not forward them further upstream */
+  if (g_value_get_boolean (result))
+    g_object_set (newsess->session, "batch-rtx-requests", TRUE, NULL);
+
   return TRUE;
 
   /* ERRORS */
@@ -4713,6 +4766,44 @@ session_src_failed:
   }
 }
 
+static gboolean
+element_is_rtx_sender (GstElement * element)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  return factory != NULL
+      && g_strcmp0 (GST_OBJECT_NAME (factory), "rtprtxsend") == 0;
+}
+
+static gint
+find_rtx_sender (const GValue * item, gconstpointer user_data)
+{
+  return element_is_rtx_sender (g_value_get_object (item)) ? 0 : 1;
+}
+
+static gboolean
+aux_sender_has_rtx_sender (GstElement * aux)
+{
+  GstIterator *it;
+  GValue item = { 0, };
+  gboolean found;
+
+  if (element_is_rtx_sender (aux))
+    return TRUE;
+
+  if (!GST_IS_BIN (aux))
+    return FALSE;
+
+  it = gst_bin_iterate_recurse (GST_BIN_CAST (aux));
+  found = gst_iterator_find_custom (it, find_rtx_sender, &item, NULL);
+  gst_iterator_free (it);
+
+  if (found)
+    g_value_unset (&item);
+
+  return found;
+}
+
 static gboolean
 setup_aux_sender (GstRtpBin * rtpbin, GstRtpBinSession * session,
     GstElement * aux)
@@ -4721,10 +4812,15 @@ setup_aux_sender (GstRtpBin * rtpbin, GstRtpBinSession * session,
   GValue result = { 0, };
   GstIteratorResult res;
 
+  g_value_init (&result, G_TYPE_BOOLEAN);
+  g_value_set_boolean (&result, aux_sender_has_rtx_sender (aux));
+
   it = gst_element_iterate_src_pads (aux);
   res = gst_iterator_fold (it, setup_aux_sender_fold, &result, session);
   gst_iterator_free (it);
 
+  g_value_unset (&result);
+
   return res == GST_ITERATOR_DONE;
 }
 
@@ -78,6 +78,10 @@ struct _GstRtpBin {
   guint64         max_ts_offset_adjustment;
   gint64          max_ts_offset;
   gboolean        max_ts_offset_is_set;
+  guint           scheduler_threads;
+
+  /* shared RTCP scheduler for the sessions, NULL when disabled */
+  RtpScheduler   *scheduler;
 
   /* a list of session */
   GSList         *sessions;
@@ -156,10 +156,14 @@ enum
 #define DEFAULT_MAX_MISORDER_TIME   2000
 #define DEFAULT_RFC7273_SYNC        FALSE
 #define DEFAULT_FASTSTART_MIN_PACKETS 0
+#define DEFAULT_TIMER_BACKEND       RTP_TIMER_QUEUE_BACKEND_LIST
 
 #define DEFAULT_AUTO_RTX_DELAY (20 * GST_MSECOND)
 #define DEFAULT_AUTO_RTX_TIMEOUT (40 * GST_MSECOND)
 
+/* freed items and timers kept for reuse */
+#define OBJECT_POOL_MAX_FREE 256
+
 enum
 {
   PROP_0,
@@ -188,7 +192,8 @@ enum
   PROP_MAX_DROPOUT_TIME,
   PROP_MAX_MISORDER_TIME,
   PROP_RFC7273_SYNC,
-  PROP_FASTSTART_MIN_PACKETS
+  PROP_FASTSTART_MIN_PACKETS,
+  PROP_TIMER_BACKEND
 };
 
 #define JBUF_LOCK(priv)   G_STMT_START {			\
@@ -365,6 +370,8 @@ struct _GstRtpJitterBufferPrivate
   RtpTimerQueue *timers;
   /* timers used for RTX statistics backlog */
   RtpTimerQueue *rtx_stats_timers;
+  /* recycles the memory of the jitterbuffer items and timers */
+  RtpObjectPool *object_pool;
 
   /* start and stop ranges */
   GstClockTime npt_start;
@@ -554,6 +561,9 @@ static GQuark quark_rtx_count;
 static GQuark quark_rtx_success_count;
 static GQuark quark_rtx_per_packet;
 static GQuark quark_rtx_rtt;
+static GQuark quark_pool_hits;
+static GQuark quark_pool_misses;
+static GQuark quark_pool_high_water;
 
 static void
 gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
@@ -579,6 +589,9 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
   quark_rtx_success_count = g_quark_from_static_string ("rtx-success-count");
   quark_rtx_per_packet = g_quark_from_static_string ("rtx-per-packet");
   quark_rtx_rtt = g_quark_from_static_string ("rtx-rtt");
+  quark_pool_hits = g_quark_from_static_string ("pool-hits");
+  quark_pool_misses = g_quark_from_static_string ("pool-misses");
+  quark_pool_high_water = g_quark_from_static_string ("pool-high-water");
 
   gobject_class->finalize = gst_rtp_jitter_buffer_finalize;
 
@@ -898,6 +911,12 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
    * * #guint64 `rtx-success-count`: the number of successful retransmissions.
    * * #gdouble `rtx-per-packet`: average number of RTX per packet.
    * * #guint64 `rtx-rtt`: average round trip time per RTX.
+   * * #guint64 `pool-hits`: the number of items and timers that reused the
+   *   memory of a freed one (Since: 1.20).
+   * * #guint64 `pool-misses`: the number of items and timers that needed
+   *   new memory (Since: 1.20).
+   * * #guint `pool-high-water`: the maximum number of items and timers
+   *   alive at the same time (Since: 1.20).
    *
    * Since: 1.4
    */
@@ -945,6 +964,19 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
           0, G_MAXUINT, DEFAULT_FASTSTART_MIN_PACKETS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpJitterBuffer:timer-backend:
+   *
+   * How the retransmission and lost timers are indexed. The timing wheel
+   * avoids walking the timer list when bursts of loss create many timers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TIMER_BACKEND,
+      g_param_spec_enum ("timer-backend", "Timer backend",
+          "How the timers are indexed", RTP_TYPE_TIMER_QUEUE_BACKEND,
+          DEFAULT_TIMER_BACKEND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstRtpJitterBuffer::request-pt-map:
    * @buffer: the object which received the signal
@@ -1041,6 +1073,7 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
   GST_DEBUG_REGISTER_FUNCPTR (gst_rtp_jitter_buffer_chain_rtcp);
 
   gst_type_mark_as_plugin_api (RTP_TYPE_JITTER_BUFFER_MODE, 0);
+  gst_type_mark_as_plugin_api (RTP_TYPE_TIMER_QUEUE_BACKEND, 0);
 }
 
 static void
@@ -1085,9 +1118,15 @@ gst_rtp_jitter_buffer_init (GstRtpJitterBuffer * jitterbuffer)
   priv->num_too_late = 0;
   priv->num_drop_on_latency = 0;
   priv->segment_seqnum = GST_SEQNUM_INVALID;
+  priv->object_pool =
+      rtp_object_pool_new (MAX (sizeof (RTPJitterBufferItem),
+          sizeof (RtpTimer)), OBJECT_POOL_MAX_FREE);
   priv->timers = rtp_timer_queue_new ();
+  rtp_timer_queue_set_pool (priv->timers, priv->object_pool);
   priv->rtx_stats_timers = rtp_timer_queue_new ();
+  rtp_timer_queue_set_pool (priv->rtx_stats_timers, priv->object_pool);
   priv->jbuf = rtp_jitter_buffer_new ();
+  rtp_jitter_buffer_set_item_pool (priv->jbuf, priv->object_pool);
   g_mutex_init (&priv->jbuf_lock);
   g_cond_init (&priv->jbuf_queue);
   g_cond_init (&priv->jbuf_timer);
@@ -1170,6 +1209,7 @@ gst_rtp_jitter_buffer_finalize (GObject * object)
   g_queue_foreach (&priv->gap_packets, (GFunc) gst_buffer_unref, NULL);
   g_queue_clear (&priv->gap_packets);
   g_object_unref (priv->jbuf);
+  rtp_object_pool_unref (priv->object_pool);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -4915,6 +4955,13 @@ gst_rtp_jitter_buffer_set_property (GObject * object,
       priv->faststart_min_packets = g_value_get_uint (value);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_TIMER_BACKEND:
+      JBUF_LOCK (priv);
+      rtp_timer_queue_set_backend (priv->timers, g_value_get_enum (value));
+      rtp_timer_queue_set_backend (priv->rtx_stats_timers,
+          g_value_get_enum (value));
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5071,6 +5118,11 @@ gst_rtp_jitter_buffer_get_property (GObject * object,
       g_value_set_uint (value, priv->faststart_min_packets);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_TIMER_BACKEND:
+      JBUF_LOCK (priv);
+      g_value_set_enum (value, rtp_timer_queue_get_backend (priv->timers));
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5082,6 +5134,11 @@ gst_rtp_jitter_buffer_create_stats (GstRtpJitterBuffer * jbuf)
 {
   GstRtpJitterBufferPrivate *priv = jbuf->priv;
   GstStructure *s;
+  guint64 pool_hits, pool_misses;
+  guint pool_high_water;
+
+  rtp_object_pool_get_stats (priv->object_pool, &pool_hits, &pool_misses,
+      &pool_high_water);
 
   JBUF_LOCK (priv);
   s = gst_structure_new_id (quark_application_x_rtp_jitterbuffer_stats,
@@ -5097,7 +5154,10 @@ gst_rtp_jitter_buffer_create_stats (GstRtpJitterBuffer * jbuf)
       quark_rtx_count, G_TYPE_UINT64, priv->num_rtx_requests,
       quark_rtx_success_count, G_TYPE_UINT64, priv->num_rtx_success,
       quark_rtx_per_packet, G_TYPE_DOUBLE, priv->avg_rtx_num,
-      quark_rtx_rtt, G_TYPE_UINT64, priv->avg_rtx_rtt, NULL);
+      quark_rtx_rtt, G_TYPE_UINT64, priv->avg_rtx_rtt,
+      quark_pool_hits, G_TYPE_UINT64, pool_hits,
+      quark_pool_misses, G_TYPE_UINT64, pool_misses,
+      quark_pool_high_water, G_TYPE_UINT, pool_high_water, NULL);
   JBUF_UNLOCK (priv);
 
   return s;
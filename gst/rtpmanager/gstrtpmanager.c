@@ -32,6 +32,7 @@
 #include "gstrtpdtmfmux.h"
 #include "gstrtpmux.h"
 #include "gstrtpfunnel.h"
+#include "gstrtppacer.h"
 #include "gstrtpst2022-1-fecdec.h"
 #include "gstrtpst2022-1-fecenc.h"
 #include "gstrtphdrext-twcc.h"
@@ -54,6 +55,7 @@ plugin_init (GstPlugin * plugin)
   ret |= GST_ELEMENT_REGISTER (rtpmux, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpdtmfmux, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpfunnel, plugin);
+  ret |= GST_ELEMENT_REGISTER (rtppacer, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpst2022_1_fecdec, plugin);
   ret |= GST_ELEMENT_REGISTER (rtpst2022_1_fecenc, plugin);
   ret |= GST_ELEMENT_REGISTER (rtphdrexttwcc, plugin);
@@ -0,0 +1,886 @@
+/* GStreamer
+ * Copyright (C) 2021 Pexip (http://pexip.com/)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-rtppacer
+ * @title: rtppacer
+ *
+ * rtppacer spreads outgoing RTP packets over time instead of sending each
+ * frame as one burst. Packets are released at #GstRtpPacer:pacing-factor
+ * times the target #GstRtpPacer:bitrate, using a token bucket that is
+ * allowed to go into debt, so a packet is sent as soon as the previous
+ * ones have been paid for.
+ *
+ * Waiting packets are released by priority: audio first, then
+ * retransmissions, then video and finally padding. Retransmissions are
+ * recognised by the %GST_RTP_BUFFER_FLAG_RETRANSMISSION flag and padding by
+ * an empty payload with the padding bit set. Audio and video are told apart
+ * from the "media" field of the caps, optionally per SSRC when the caps
+ * also carry an "ssrc" field.
+ *
+ * The target bitrate is normally driven by a bandwidth estimator: a
+ * "GstRTPBandwidthEstimate" custom event with a "bitrate" field (in bits per
+ * second) updates #GstRtpPacer:bitrate. The event is accepted both as an
+ * upstream event and as an out-of-band downstream event, which is how
+ * #GstRtpSession forwards its estimate on the send_rtp_src pad. When packets
+ * have been waiting longer than #GstRtpPacer:max-queue-time allows, the
+ * pacing rate is raised so that the queue drains within that time.
+ *
+ * When more than #GstRtpPacer:max-queue-bytes are waiting, the element stops
+ * accepting packets until some have been sent, blocking upstream.
+ *
+ * The element is meant to sit right after the send_rtp_src pad of
+ * #GstRtpSession, or the send_rtp_src_\%u pad of #GstRtpBin, so that it also
+ * paces the retransmissions and FEC packets produced by the auxiliary
+ * senders of the session.
+ *
+ * ## Example pipeline
+ *
+ * |[
+ * gst-launch-1.0 videotestsrc ! vp8enc ! rtpvp8pay ! .send_rtp_sink rtpsession .send_rtp_src ! rtppacer bitrate=1000000 ! udpsink port=5000
+ * ]|
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "gstrtppacer.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtp_pacer_debug);
+#define GST_CAT_DEFAULT gst_rtp_pacer_debug
+
+#define DEFAULT_BITRATE        (-1)
+#define DEFAULT_PACING_FACTOR  2.5
+#define DEFAULT_MAX_QUEUE_TIME (2 * GST_SECOND)
+#define DEFAULT_MAX_QUEUE_BYTES (10 * 1024 * 1024)
+
+/* keeps the token bucket arithmetic from overflowing */
+#define MAX_PACING_BITRATE G_GINT64_CONSTANT (1000000000000)
+
+/* how much sending time may be accumulated while idle */
+#define MAX_BURST_TIME (5 * GST_MSECOND)
+
+enum
+{
+  PROP_0,
+  PROP_BITRATE,
+  PROP_PACING_FACTOR,
+  PROP_MAX_QUEUE_TIME,
+  PROP_MAX_QUEUE_BYTES,
+  PROP_STATS,
+};
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+typedef struct
+{
+  GstMiniObject *object;
+  guint64 seqnum;
+  GstClockTime enqueue_time;
+  guint size;
+} RtpPacerItem;
+
+static gboolean gst_rtp_pacer_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event);
+static gboolean gst_rtp_pacer_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event);
+static GstFlowReturn gst_rtp_pacer_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer);
+static GstFlowReturn gst_rtp_pacer_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
+
+static void gst_rtp_pacer_src_loop (GstRtpPacer * pacer);
+static gboolean gst_rtp_pacer_src_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+
+static void gst_rtp_pacer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_rtp_pacer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_rtp_pacer_finalize (GObject * object);
+
+G_DEFINE_TYPE_WITH_CODE (GstRtpPacer, gst_rtp_pacer, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT (gst_rtp_pacer_debug, "rtppacer", 0,
+        "RTP pacer"));
+GST_ELEMENT_REGISTER_DEFINE (rtppacer, "rtppacer", GST_RANK_NONE,
+    GST_TYPE_RTP_PACER);
+
+static void
+gst_rtp_pacer_class_init (GstRtpPacerClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *gstelement_class = (GstElementClass *) klass;
+
+  gobject_class->get_property = gst_rtp_pacer_get_property;
+  gobject_class->set_property = gst_rtp_pacer_set_property;
+  gobject_class->finalize = gst_rtp_pacer_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_BITRATE,
+      g_param_spec_int ("bitrate", "Bitrate",
+          "Target bitrate in bits per second, updated by upstream "
+          "GstRTPBandwidthEstimate events (-1 = unlimited, no pacing)",
+          -1, G_MAXINT, DEFAULT_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PACING_FACTOR,
+      g_param_spec_double ("pacing-factor", "Pacing Factor",
+          "Packets are sent at this multiple of the target bitrate",
+          1.0, G_MAXDOUBLE, DEFAULT_PACING_FACTOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_TIME,
+      g_param_spec_uint64 ("max-queue-time", "Max Queue Time",
+          "The pacing rate is raised so that queued packets are sent within "
+          "this time (0 = disabled)", 0, G_MAXUINT64, DEFAULT_MAX_QUEUE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_BYTES,
+      g_param_spec_uint64 ("max-queue-bytes", "Max Queue Bytes",
+          "Block upstream while more than this many bytes are queued "
+          "(0 = unlimited)", 0, G_MAXUINT64, DEFAULT_MAX_QUEUE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpPacer:stats:
+   *
+   * Various statistics. This property returns a GstStructure
+   * with name application/x-rtp-pacer-stats with the following fields:
+   *
+   * * "pacing-bitrate"  G_TYPE_INT64   the current pacing rate in bits per
+   *   second, -1 when not pacing
+   * * "queue-delay"     G_TYPE_UINT64  time the oldest queued packet has
+   *   been waiting
+   * * "avg-queue-delay" G_TYPE_UINT64  average time packets spent queued
+   * * "queued-packets"  G_TYPE_UINT    number of packets waiting
+   * * "queued-bytes"    G_TYPE_UINT64  number of bytes waiting
+   * * "packets-sent"    G_TYPE_UINT64  number of packets sent
+   * * "bytes-sent"      G_TYPE_UINT64  number of bytes sent
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Various statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
+  gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "RTP Pacer", "Network/RTP",
+      "Spreads RTP packets over time according to a target bitrate",
+      "Pexip");
+}
+
+static RtpPacerItem *
+rtp_pacer_item_new (GstMiniObject * object, guint64 seqnum,
+    GstClockTime enqueue_time, guint size)
+{
+  RtpPacerItem *item = g_slice_new (RtpPacerItem);
+
+  item->object = object;
+  item->seqnum = seqnum;
+  item->enqueue_time = enqueue_time;
+  item->size = size;
+
+  return item;
+}
+
+static void
+rtp_pacer_item_free (RtpPacerItem * item)
+{
+  if (item->object)
+    gst_mini_object_unref (item->object);
+  g_slice_free (RtpPacerItem, item);
+}
+
+/* with pacer->lock */
+static void
+gst_rtp_pacer_flush_queues (GstRtpPacer * pacer)
+{
+  guint i;
+
+  for (i = 0; i < RTP_PACER_N_PRIORITIES; i++)
+    g_queue_clear_full (&pacer->queues[i], (GDestroyNotify) rtp_pacer_item_free);
+  g_queue_clear_full (&pacer->events, (GDestroyNotify) rtp_pacer_item_free);
+  pacer->queued_packets = 0;
+  pacer->queued_bytes = 0;
+  token_bucket_reset (&pacer->tb);
+}
+
+static void
+gst_rtp_pacer_set_flushing (GstRtpPacer * pacer, gboolean flushing)
+{
+  g_mutex_lock (&pacer->lock);
+  pacer->flushing = flushing;
+  if (flushing) {
+    pacer->srcresult = GST_FLOW_FLUSHING;
+    if (pacer->clock_id)
+      gst_clock_id_unschedule (pacer->clock_id);
+    gst_rtp_pacer_flush_queues (pacer);
+    g_cond_signal (&pacer->cond);
+    g_cond_signal (&pacer->space_cond);
+  } else {
+    pacer->srcresult = GST_FLOW_OK;
+  }
+  g_mutex_unlock (&pacer->lock);
+}
+
+static void
+gst_rtp_pacer_reset (GstRtpPacer * pacer)
+{
+  g_mutex_lock (&pacer->lock);
+  g_hash_table_remove_all (pacer->ssrc_priority);
+  pacer->default_priority = RTP_PACER_PRIORITY_VIDEO;
+  pacer->packets_sent = 0;
+  pacer->bytes_sent = 0;
+  pacer->avg_queue_delay = 0;
+  g_mutex_unlock (&pacer->lock);
+}
+
+static void
+gst_rtp_pacer_finalize (GObject * object)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (object);
+
+  gst_rtp_pacer_flush_queues (pacer);
+  g_hash_table_unref (pacer->ssrc_priority);
+  g_mutex_clear (&pacer->lock);
+  g_cond_clear (&pacer->cond);
+  g_cond_clear (&pacer->space_cond);
+
+  G_OBJECT_CLASS (gst_rtp_pacer_parent_class)->finalize (object);
+}
+
+static void
+gst_rtp_pacer_init (GstRtpPacer * pacer)
+{
+  GstElementClass *klass = GST_ELEMENT_GET_CLASS (pacer);
+  guint i;
+
+  pacer->srcpad =
+      gst_pad_new_from_template (gst_element_class_get_pad_template (klass,
+          "src"), "src");
+  GST_PAD_SET_PROXY_CAPS (pacer->srcpad);
+  GST_PAD_SET_PROXY_ALLOCATION (pacer->srcpad);
+  gst_pad_set_event_function (pacer->srcpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_src_event));
+  gst_pad_set_activatemode_function (pacer->srcpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_src_activate_mode));
+  gst_element_add_pad (GST_ELEMENT (pacer), pacer->srcpad);
+
+  pacer->sinkpad =
+      gst_pad_new_from_template (gst_element_class_get_pad_template (klass,
+          "sink"), "sink");
+  GST_PAD_SET_PROXY_CAPS (pacer->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (pacer->sinkpad);
+  gst_pad_set_event_function (pacer->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_sink_event));
+  gst_pad_set_chain_function (pacer->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_chain));
+  gst_pad_set_chain_list_function (pacer->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_pacer_chain_list));
+  gst_element_add_pad (GST_ELEMENT (pacer), pacer->sinkpad);
+
+  g_mutex_init (&pacer->lock);
+  g_cond_init (&pacer->cond);
+  g_cond_init (&pacer->space_cond);
+  pacer->flushing = TRUE;
+  pacer->srcresult = GST_FLOW_FLUSHING;
+
+  for (i = 0; i < RTP_PACER_N_PRIORITIES; i++)
+    g_queue_init (&pacer->queues[i]);
+  g_queue_init (&pacer->events);
+
+  pacer->ssrc_priority = g_hash_table_new (NULL, NULL);
+  pacer->default_priority = RTP_PACER_PRIORITY_VIDEO;
+
+  pacer->bitrate = DEFAULT_BITRATE;
+  pacer->pacing_factor = DEFAULT_PACING_FACTOR;
+  pacer->max_queue_time = DEFAULT_MAX_QUEUE_TIME;
+  pacer->max_queue_bytes = DEFAULT_MAX_QUEUE_BYTES;
+
+  pacer->pacing_bitrate = -1;
+  token_bucket_init (&pacer->tb, -1, -1);
+}
+
+static GstClockTime
+gst_rtp_pacer_get_time (GstRtpPacer * pacer)
+{
+  GstClock *clock;
+  GstClockTime now;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (pacer));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+
+  return now;
+}
+
+/* with pacer->lock */
+static RtpPacerPriority
+gst_rtp_pacer_get_priority (GstRtpPacer * pacer, GstBuffer * buffer)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  RtpPacerPriority priority;
+  gboolean padding;
+  gpointer value;
+
+  if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp))
+    return pacer->default_priority;
+
+  padding = gst_rtp_buffer_get_padding (&rtp);
+
+  if (padding && gst_rtp_buffer_get_payload_len (&rtp) == 0) {
+    priority = RTP_PACER_PRIORITY_PADDING;
+  } else if (GST_BUFFER_FLAG_IS_SET (buffer,
+          GST_RTP_BUFFER_FLAG_RETRANSMISSION)) {
+    /* rtprtxsend stuffing is sent as padded retransmissions */
+    priority = padding ? RTP_PACER_PRIORITY_PADDING : RTP_PACER_PRIORITY_RTX;
+  } else if (g_hash_table_lookup_extended (pacer->ssrc_priority,
+          GUINT_TO_POINTER (gst_rtp_buffer_get_ssrc (&rtp)), NULL, &value)) {
+    priority = GPOINTER_TO_UINT (value);
+  } else {
+    priority = pacer->default_priority;
+  }
+
+  gst_rtp_buffer_unmap (&rtp);
+
+  return priority;
+}
+
+/* with pacer->lock, releases it while waiting for the queue to drain below
+ * max-queue-bytes. Takes ownership of @buffer. */
+static GstFlowReturn
+gst_rtp_pacer_enqueue_buffer (GstRtpPacer * pacer, GstBuffer * buffer,
+    GstClockTime now)
+{
+  RtpPacerPriority priority;
+  guint size;
+
+  while (pacer->srcresult == GST_FLOW_OK && pacer->max_queue_bytes > 0 &&
+      pacer->queued_bytes >= pacer->max_queue_bytes) {
+    GST_LOG_OBJECT (pacer, "Queue full (%" G_GUINT64_FORMAT " bytes), "
+        "waiting", pacer->queued_bytes);
+    g_cond_wait (&pacer->space_cond, &pacer->lock);
+  }
+
+  if (pacer->srcresult != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return pacer->srcresult;
+  }
+
+  priority = gst_rtp_pacer_get_priority (pacer, buffer);
+  size = gst_buffer_get_size (buffer);
+
+  g_queue_push_tail (&pacer->queues[priority],
+      rtp_pacer_item_new (GST_MINI_OBJECT_CAST (buffer), pacer->next_seqnum++,
+          now, size));
+  pacer->queued_packets++;
+  pacer->queued_bytes += size;
+  g_cond_signal (&pacer->cond);
+
+  return GST_FLOW_OK;
+}
+
+/* with pacer->lock */
+static void
+gst_rtp_pacer_update_priorities (GstRtpPacer * pacer, GstCaps * caps)
+{
+  const GstStructure *s = gst_caps_get_structure (caps, 0);
+  const gchar *media = gst_structure_get_string (s, "media");
+  RtpPacerPriority priority;
+  guint ssrc;
+
+  if (media == NULL)
+    return;
+
+  if (g_strcmp0 (media, "audio") == 0)
+    priority = RTP_PACER_PRIORITY_AUDIO;
+  else
+    priority = RTP_PACER_PRIORITY_VIDEO;
+
+  if (gst_structure_get_uint (s, "ssrc", &ssrc)) {
+    GST_DEBUG_OBJECT (pacer, "SSRC %08x is %s", ssrc, media);
+    g_hash_table_insert (pacer->ssrc_priority, GUINT_TO_POINTER (ssrc),
+        GUINT_TO_POINTER (priority));
+  } else {
+    GST_DEBUG_OBJECT (pacer, "Default media is %s", media);
+    pacer->default_priority = priority;
+  }
+}
+
+/* with pacer->lock */
+static void
+gst_rtp_pacer_update_pacing_rate (GstRtpPacer * pacer)
+{
+  gint64 bps = -1;
+
+  if (pacer->bitrate > 0) {
+    gdouble rate = pacer->bitrate * pacer->pacing_factor;
+
+    bps = rate >= MAX_PACING_BITRATE ? MAX_PACING_BITRATE : (gint64) rate;
+
+    /* never let the queue build up beyond max-queue-time */
+    if (pacer->max_queue_time > 0) {
+      guint64 drain_bps = gst_util_uint64_scale (pacer->queued_bytes, 8 *
+          GST_SECOND, pacer->max_queue_time);
+      drain_bps = MIN (drain_bps, MAX_PACING_BITRATE);
+      bps = MAX (bps, (gint64) drain_bps);
+    }
+  }
+
+  if (bps == pacer->pacing_bitrate)
+    return;
+
+  GST_LOG_OBJECT (pacer, "Pacing at %" G_GINT64_FORMAT " bps", bps);
+
+  token_bucket_set_bps (&pacer->tb, bps);
+  token_bucket_set_max_bucket_size (&pacer->tb,
+      bps == -1 ? -1 : gst_util_uint64_scale (bps, MAX_BURST_TIME,
+          GST_SECOND));
+  pacer->pacing_bitrate = bps;
+}
+
+/* with pacer->lock. Returns the highest priority queue holding a packet
+ * that is older than the first pending serialized event. */
+static GQueue *
+gst_rtp_pacer_get_next_queue (GstRtpPacer * pacer)
+{
+  RtpPacerItem *event = g_queue_peek_head (&pacer->events);
+  guint i;
+
+  for (i = 0; i < RTP_PACER_N_PRIORITIES; i++) {
+    RtpPacerItem *item = g_queue_peek_head (&pacer->queues[i]);
+
+    if (item && (event == NULL || item->seqnum < event->seqnum))
+      return &pacer->queues[i];
+  }
+
+  return NULL;
+}
+
+/* with pacer->lock, releases it while waiting. Returns FALSE when woken
+ * up before the token bucket had enough tokens for the next packet */
+static gboolean
+gst_rtp_pacer_wait_for_tokens (GstRtpPacer * pacer, GstClockTime now)
+{
+  GstClockTime wait;
+  GstClock *clock;
+  GstClockID id;
+
+  if (!GST_CLOCK_TIME_IS_VALID (now))
+    return TRUE;
+
+  token_bucket_add_tokens (&pacer->tb, now);
+  /* the bucket may go into debt, wait until that has been paid off */
+  wait = token_bucket_get_missing_tokens_time (&pacer->tb, 0);
+  if (wait == 0)
+    return TRUE;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (pacer));
+  if (clock == NULL)
+    return TRUE;
+
+  GST_LOG_OBJECT (pacer, "Waiting %" GST_TIME_FORMAT " for tokens",
+      GST_TIME_ARGS (wait));
+
+  id = pacer->clock_id = gst_clock_new_single_shot_id (clock, now + wait);
+  gst_object_unref (clock);
+  g_mutex_unlock (&pacer->lock);
+
+  gst_clock_id_wait (id, NULL);
+
+  g_mutex_lock (&pacer->lock);
+  gst_clock_id_unref (id);
+  pacer->clock_id = NULL;
+
+  return FALSE;
+}
+
+static void
+gst_rtp_pacer_src_loop (GstRtpPacer * pacer)
+{
+  RtpPacerItem *item = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime now;
+
+  g_mutex_lock (&pacer->lock);
+  while (!pacer->flushing) {
+    GQueue *queue = gst_rtp_pacer_get_next_queue (pacer);
+
+    if (queue == NULL) {
+      if (!g_queue_is_empty (&pacer->events)) {
+        item = g_queue_pop_head (&pacer->events);
+        break;
+      }
+      g_cond_wait (&pacer->cond, &pacer->lock);
+      continue;
+    }
+
+    gst_rtp_pacer_update_pacing_rate (pacer);
+    now = gst_rtp_pacer_get_time (pacer);
+    if (!gst_rtp_pacer_wait_for_tokens (pacer, now))
+      continue;
+
+    item = g_queue_pop_head (queue);
+    token_bucket_take_tokens (&pacer->tb, item->size * 8, TRUE);
+
+    pacer->queued_packets--;
+    pacer->queued_bytes -= item->size;
+    g_cond_signal (&pacer->space_cond);
+    pacer->packets_sent++;
+    pacer->bytes_sent += item->size;
+    if (GST_CLOCK_TIME_IS_VALID (now) &&
+        GST_CLOCK_TIME_IS_VALID (item->enqueue_time)) {
+      GstClockTime delay = now - item->enqueue_time;
+      pacer->avg_queue_delay = (delay + 15 * pacer->avg_queue_delay) / 16;
+    }
+    break;
+  }
+
+  if (pacer->flushing)
+    goto flushing;
+  g_mutex_unlock (&pacer->lock);
+
+  if (GST_IS_BUFFER (item->object)) {
+    ret = gst_pad_push (pacer->srcpad, GST_BUFFER_CAST (item->object));
+  } else {
+    GstEvent *event = GST_EVENT_CAST (item->object);
+    gboolean is_eos = GST_EVENT_TYPE (event) == GST_EVENT_EOS;
+
+    gst_pad_push_event (pacer->srcpad, event);
+
+    /* nothing more will come until the next flush */
+    if (is_eos)
+      ret = GST_FLOW_EOS;
+  }
+
+  item->object = NULL;          /* we no longer own that object */
+  rtp_pacer_item_free (item);
+
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+  /* ERRORS */
+flushing:
+  {
+    GST_DEBUG_OBJECT (pacer, "flushing, pausing task");
+    g_mutex_unlock (&pacer->lock);
+    gst_pad_pause_task (pacer->srcpad);
+    return;
+  }
+pause:
+  {
+    GST_DEBUG_OBJECT (pacer, "pausing task, reason %s",
+        gst_flow_get_name (ret));
+
+    g_mutex_lock (&pacer->lock);
+    pacer->srcresult = ret;
+    g_cond_signal (&pacer->space_cond);
+    g_mutex_unlock (&pacer->lock);
+    gst_pad_pause_task (pacer->srcpad);
+
+    if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+      GST_ELEMENT_FLOW_ERROR (pacer, ret);
+      gst_pad_push_event (pacer->srcpad, gst_event_new_eos ());
+    }
+    return;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_pacer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (parent);
+  GstClockTime now = gst_rtp_pacer_get_time (pacer);
+  GstFlowReturn ret;
+
+  g_mutex_lock (&pacer->lock);
+  ret = gst_rtp_pacer_enqueue_buffer (pacer, buffer, now);
+  g_mutex_unlock (&pacer->lock);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rtp_pacer_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (parent);
+  GstClockTime now = gst_rtp_pacer_get_time (pacer);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  /* the packets of a list are spread out individually */
+  g_mutex_lock (&pacer->lock);
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+    ret = gst_rtp_pacer_enqueue_buffer (pacer, gst_buffer_ref (buffer), now);
+  }
+  g_mutex_unlock (&pacer->lock);
+
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+static void
+gst_rtp_pacer_handle_bandwidth_estimate (GstRtpPacer * pacer,
+    GstEvent * event)
+{
+  const GstStructure *s = gst_event_get_structure (event);
+  guint bitrate;
+
+  if (!gst_structure_get_uint (s, "bitrate", &bitrate))
+    return;
+
+  GST_DEBUG_OBJECT (pacer, "Bandwidth estimate: %u bps", bitrate);
+
+  g_mutex_lock (&pacer->lock);
+  pacer->bitrate = MIN (bitrate, G_MAXINT);
+  if (pacer->clock_id)
+    gst_clock_id_unschedule (pacer->clock_id);
+  g_mutex_unlock (&pacer->lock);
+}
+
+static gboolean
+gst_rtp_pacer_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (parent);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CUSTOM_DOWNSTREAM_OOB:
+      if (gst_event_has_name (event, "GstRTPBandwidthEstimate"))
+        gst_rtp_pacer_handle_bandwidth_estimate (pacer, event);
+      break;
+    case GST_EVENT_FLUSH_START:
+    {
+      gboolean ret = gst_pad_push_event (pacer->srcpad, event);
+      gst_rtp_pacer_set_flushing (pacer, TRUE);
+      gst_pad_pause_task (pacer->srcpad);
+      return ret;
+    }
+    case GST_EVENT_FLUSH_STOP:
+    {
+      gboolean ret = gst_pad_push_event (pacer->srcpad, event);
+      gst_rtp_pacer_set_flushing (pacer, FALSE);
+      gst_pad_start_task (pacer->srcpad,
+          (GstTaskFunction) gst_rtp_pacer_src_loop, pacer, NULL);
+      return ret;
+    }
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      g_mutex_lock (&pacer->lock);
+      gst_rtp_pacer_update_priorities (pacer, caps);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    }
+    default:
+      break;
+  }
+
+  if (GST_EVENT_IS_SERIALIZED (event)) {
+    gboolean ret = TRUE;
+
+    g_mutex_lock (&pacer->lock);
+    if (pacer->srcresult == GST_FLOW_OK) {
+      g_queue_push_tail (&pacer->events,
+          rtp_pacer_item_new (GST_MINI_OBJECT_CAST (event),
+              pacer->next_seqnum++, GST_CLOCK_TIME_NONE, 0));
+      g_cond_signal (&pacer->cond);
+    } else {
+      GST_DEBUG_OBJECT (pacer, "dropping event %" GST_PTR_FORMAT
+          ", reason %s", event, gst_flow_get_name (pacer->srcresult));
+      gst_event_unref (event);
+      ret = FALSE;
+    }
+    g_mutex_unlock (&pacer->lock);
+
+    return ret;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_rtp_pacer_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (parent);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_UPSTREAM &&
+      gst_event_has_name (event, "GstRTPBandwidthEstimate"))
+    gst_rtp_pacer_handle_bandwidth_estimate (pacer, event);
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_rtp_pacer_src_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (parent);
+  gboolean ret = FALSE;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      if (active) {
+        gst_rtp_pacer_reset (pacer);
+        gst_rtp_pacer_set_flushing (pacer, FALSE);
+        ret = gst_pad_start_task (pacer->srcpad,
+            (GstTaskFunction) gst_rtp_pacer_src_loop, pacer, NULL);
+      } else {
+        gst_rtp_pacer_set_flushing (pacer, TRUE);
+        ret = gst_pad_stop_task (pacer->srcpad);
+      }
+      GST_INFO_OBJECT (pacer, "activate_mode: active %d, ret %d", active, ret);
+      break;
+    default:
+      break;
+  }
+  return ret;
+}
+
+static GstStructure *
+gst_rtp_pacer_create_stats (GstRtpPacer * pacer)
+{
+  GstClockTime now = gst_rtp_pacer_get_time (pacer);
+  GstClockTime queue_delay = 0;
+  GstStructure *s;
+  guint i;
+
+  g_mutex_lock (&pacer->lock);
+  if (GST_CLOCK_TIME_IS_VALID (now)) {
+    for (i = 0; i < RTP_PACER_N_PRIORITIES; i++) {
+      RtpPacerItem *item = g_queue_peek_head (&pacer->queues[i]);
+
+      if (item && GST_CLOCK_TIME_IS_VALID (item->enqueue_time) &&
+          now > item->enqueue_time)
+        queue_delay = MAX (queue_delay, now - item->enqueue_time);
+    }
+  }
+
+  s = gst_structure_new ("application/x-rtp-pacer-stats",
+      "pacing-bitrate", G_TYPE_INT64, pacer->pacing_bitrate,
+      "queue-delay", G_TYPE_UINT64, queue_delay,
+      "avg-queue-delay", G_TYPE_UINT64, pacer->avg_queue_delay,
+      "queued-packets", G_TYPE_UINT, pacer->queued_packets,
+      "queued-bytes", G_TYPE_UINT64, pacer->queued_bytes,
+      "packets-sent", G_TYPE_UINT64, pacer->packets_sent,
+      "bytes-sent", G_TYPE_UINT64, pacer->bytes_sent, NULL);
+  g_mutex_unlock (&pacer->lock);
+
+  return s;
+}
+
+static void
+gst_rtp_pacer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (object);
+
+  switch (prop_id) {
+    case PROP_BITRATE:
+      g_mutex_lock (&pacer->lock);
+      pacer->bitrate = g_value_get_int (value);
+      if (pacer->clock_id)
+        gst_clock_id_unschedule (pacer->clock_id);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_PACING_FACTOR:
+      g_mutex_lock (&pacer->lock);
+      pacer->pacing_factor = g_value_get_double (value);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      g_mutex_lock (&pacer->lock);
+      pacer->max_queue_time = g_value_get_uint64 (value);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_MAX_QUEUE_BYTES:
+      g_mutex_lock (&pacer->lock);
+      pacer->max_queue_bytes = g_value_get_uint64 (value);
+      g_cond_signal (&pacer->space_cond);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_pacer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpPacer *pacer = GST_RTP_PACER (object);
+
+  switch (prop_id) {
+    case PROP_BITRATE:
+      g_mutex_lock (&pacer->lock);
+      g_value_set_int (value, pacer->bitrate);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_PACING_FACTOR:
+      g_mutex_lock (&pacer->lock);
+      g_value_set_double (value, pacer->pacing_factor);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_MAX_QUEUE_TIME:
+      g_mutex_lock (&pacer->lock);
+      g_value_set_uint64 (value, pacer->max_queue_time);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_MAX_QUEUE_BYTES:
+      g_mutex_lock (&pacer->lock);
+      g_value_set_uint64 (value, pacer->max_queue_bytes);
+      g_mutex_unlock (&pacer->lock);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtp_pacer_create_stats (pacer));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -0,0 +1,99 @@
+/* GStreamer
+ * Copyright (C) 2021 Pexip (http://pexip.com/)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_RTP_PACER_H__
+#define __GST_RTP_PACER_H__
+
+#include <gst/gst.h>
+
+#include "tokenbucket.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_RTP_PACER            (gst_rtp_pacer_get_type())
+#define GST_RTP_PACER(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTP_PACER,GstRtpPacer))
+#define GST_RTP_PACER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_RTP_PACER,GstRtpPacerClass))
+#define GST_IS_RTP_PACER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTP_PACER))
+#define GST_IS_RTP_PACER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_RTP_PACER))
+
+typedef struct _GstRtpPacer GstRtpPacer;
+typedef struct _GstRtpPacerClass GstRtpPacerClass;
+
+/* in order of decreasing priority */
+typedef enum
+{
+  RTP_PACER_PRIORITY_AUDIO,
+  RTP_PACER_PRIORITY_RTX,
+  RTP_PACER_PRIORITY_VIDEO,
+  RTP_PACER_PRIORITY_PADDING,
+  RTP_PACER_N_PRIORITIES
+} RtpPacerPriority;
+
+struct _GstRtpPacer
+{
+  GstElement parent;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  GMutex lock;
+  GCond cond;                   /* signalled when there is something to send */
+  GCond space_cond;             /* signalled when the queues shrink */
+  gboolean flushing;
+  GstFlowReturn srcresult;
+  GstClockID clock_id;
+
+  /* RtpPacerItem queues, one per priority and one for serialized events */
+  GQueue queues[RTP_PACER_N_PRIORITIES];
+  GQueue events;
+  guint64 next_seqnum;
+  guint queued_packets;
+  guint64 queued_bytes;
+
+  /* ssrc -> RtpPacerPriority + 1, learnt from caps */
+  GHashTable *ssrc_priority;
+  RtpPacerPriority default_priority;
+
+  TokenBucket tb;
+
+  /* properties */
+  gint bitrate;
+  gdouble pacing_factor;
+  GstClockTime max_queue_time;
+  guint64 max_queue_bytes;
+
+  /* stats */
+  gint64 pacing_bitrate;
+  guint64 packets_sent;
+  guint64 bytes_sent;
+  GstClockTime avg_queue_delay;
+};
+
+struct _GstRtpPacerClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_rtp_pacer_get_type (void);
+
+GST_ELEMENT_REGISTER_DECLARE (rtppacer);
+
+G_END_DECLS
+
+#endif /* __GST_RTP_PACER_H__ */
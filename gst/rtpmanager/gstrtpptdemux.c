@@ -134,6 +134,8 @@ static gboolean gst_rtp_pt_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstFlowReturn gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
+static GstFlowReturn gst_rtp_pt_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstStateChangeReturn gst_rtp_pt_demux_change_state (GstElement * element,
     GstStateChange transition);
 static void gst_rtp_pt_demux_clear_pt_map (GstRtpPtDemux * rtpdemux);
@@ -282,6 +284,7 @@ gst_rtp_pt_demux_class_init (GstRtpPtDemuxClass * klass)
       "rtpptdemux", 0, "RTP codec demuxer");
 
   GST_DEBUG_REGISTER_FUNCPTR (gst_rtp_pt_demux_chain);
+  GST_DEBUG_REGISTER_FUNCPTR (gst_rtp_pt_demux_chain_list);
 }
 
 static void
@@ -295,6 +298,7 @@ gst_rtp_pt_demux_init (GstRtpPtDemux * ptdemux)
   g_assert (ptdemux->sink != NULL);
 
   gst_pad_set_chain_function (ptdemux->sink, gst_rtp_pt_demux_chain);
+  gst_pad_set_chain_list_function (ptdemux->sink, gst_rtp_pt_demux_chain_list);
   gst_pad_set_event_function (ptdemux->sink, gst_rtp_pt_demux_sink_event);
 
   gst_element_add_pad (GST_ELEMENT (ptdemux), ptdemux->sink);
@@ -442,23 +446,15 @@ gst_rtp_pt_demux_pt_is_ignored (GstRtpPtDemux * ptdemux, guint8 pt)
   return ret;
 }
 
+/* pushes either @buf or @list, taking ownership of it, to the src pad of
+ * @pt, creating that pad first if needed */
 static GstFlowReturn
-gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+gst_rtp_pt_demux_push (GstRtpPtDemux * rtpdemux, guint8 pt, GstBuffer * buf,
+    GstBufferList * list)
 {
   GstFlowReturn ret = GST_FLOW_OK;
-  GstRtpPtDemux *rtpdemux;
-  guint8 pt;
-  GstPad *srcpad;
+  GstPad *srcpad = NULL;
   GstCaps *caps;
-  GstRTPBuffer rtp = { NULL };
-
-  rtpdemux = GST_RTP_PT_DEMUX (parent);
-
-  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
-    goto invalid_buffer;
-
-  pt = gst_rtp_buffer_get_payload_type (&rtp);
-  gst_rtp_buffer_unmap (&rtp);
 
   if (gst_rtp_pt_demux_pt_is_ignored (rtpdemux, pt))
     goto ignored;
@@ -543,7 +539,10 @@ gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   }
 
   /* push to srcpad */
-  ret = gst_pad_push (srcpad, buf);
+  if (list)
+    ret = gst_pad_push_list (srcpad, list);
+  else
+    ret = gst_pad_push (srcpad, buf);
 
   gst_object_unref (srcpad);
 
@@ -552,10 +551,55 @@ gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 ignored:
   {
     GST_DEBUG_OBJECT (rtpdemux, "Dropped buffer for pt %d", pt);
-    gst_buffer_unref (buf);
+    if (list)
+      gst_buffer_list_unref (list);
+    else
+      gst_buffer_unref (buf);
     return GST_FLOW_OK;
   }
 
+  /* ERRORS */
+no_caps:
+  {
+    GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
+        ("Could not get caps for payload"));
+    if (list)
+      gst_buffer_list_unref (list);
+    else
+      gst_buffer_unref (buf);
+    if (srcpad)
+      gst_object_unref (srcpad);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static gboolean
+get_rtp_pt (GstBuffer * buf, guint8 * pt)
+{
+  GstRTPBuffer rtp = { NULL };
+
+  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
+    return FALSE;
+
+  *pt = gst_rtp_buffer_get_payload_type (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstRtpPtDemux *rtpdemux;
+  guint8 pt;
+
+  rtpdemux = GST_RTP_PT_DEMUX (parent);
+
+  if (!get_rtp_pt (buf, &pt))
+    goto invalid_buffer;
+
+  return gst_rtp_pt_demux_push (rtpdemux, pt, buf, NULL);
+
   /* ERRORS */
 invalid_buffer:
   {
@@ -565,15 +609,63 @@ invalid_buffer:
     gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
   }
-no_caps:
-  {
-    GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
-        ("Could not get caps for payload"));
-    gst_buffer_unref (buf);
-    if (srcpad)
-      gst_object_unref (srcpad);
-    return GST_FLOW_ERROR;
+}
+
+/* Pushes each run of consecutive packets with the same payload type as one
+ * sub-list. Splitting on every change, rather than per payload type, keeps
+ * the payload-type-changed signal and the order across pads the same as
+ * when pushing buffer by buffer. */
+static GstFlowReturn
+gst_rtp_pt_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpPtDemux *rtpdemux;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *sublist = NULL;
+  guint8 sublist_pt = 0;
+  guint i, len;
+
+  rtpdemux = GST_RTP_PT_DEMUX (parent);
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+    guint8 pt;
+
+    if (!get_rtp_pt (buf, &pt)) {
+      /* this should not be fatal */
+      GST_ELEMENT_WARNING (rtpdemux, STREAM, DEMUX, (NULL),
+          ("Dropping invalid RTP payload"));
+      ret = GST_FLOW_ERROR;
+      break;
+    }
+
+    if (sublist && pt != sublist_pt) {
+      ret = gst_rtp_pt_demux_push (rtpdemux, sublist_pt, NULL, sublist);
+      sublist = NULL;
+      if (ret != GST_FLOW_OK)
+        break;
+    }
+
+    if (sublist == NULL) {
+      sublist = gst_buffer_list_new_sized (len - i);
+      sublist_pt = pt;
+    }
+    gst_buffer_list_add (sublist, gst_buffer_ref (buf));
   }
+  gst_buffer_list_unref (list);
+
+  /* packets before an invalid one are still pushed, like they would be
+   * without a list */
+  if (sublist) {
+    GstFlowReturn sub_ret;
+
+    sub_ret = gst_rtp_pt_demux_push (rtpdemux, sublist_pt, NULL, sublist);
+    if (ret == GST_FLOW_OK)
+      ret = sub_ret;
+  }
+
+  return ret;
 }
 
 static GstPad *
@@ -279,19 +279,36 @@ gst_rtp_rtx_queue_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       s = gst_event_get_structure (event);
       if (gst_structure_has_name (s, "GstRTPRetransmissionRequest")) {
         guint seqnum;
+        guint blp = 0;
         RTXData data;
 
         if (!gst_structure_get_uint (s, "seqnum", &seqnum))
           seqnum = -1;
 
-        GST_DEBUG_OBJECT (rtx, "request %d", seqnum);
+        /* bitmask of following lost packets, if any */
+        gst_structure_get_uint (s, "blp", &blp);
+        blp &= 0xffff;
+
+        GST_DEBUG_OBJECT (rtx, "request %d, blp %04x", seqnum, blp);
 
         g_mutex_lock (&rtx->lock);
         data.rtx = rtx;
-        data.seqnum = seqnum;
-        data.found = FALSE;
-        rtx->n_requests += 1;
-        g_queue_foreach (rtx->queue, (GFunc) push_seqnum, &data);
+        while (TRUE) {
+          data.seqnum = seqnum;
+          data.found = FALSE;
+          rtx->n_requests += 1;
+          g_queue_foreach (rtx->queue, (GFunc) push_seqnum, &data);
+
+          if (blp == 0)
+            break;
+
+          seqnum = (seqnum + 1) & 0xffff;
+          while ((blp & 1) == 0) {
+            seqnum = (seqnum + 1) & 0xffff;
+            blp >>= 1;
+          }
+          blp >>= 1;
+        }
         g_mutex_unlock (&rtx->lock);
 
         gst_event_unref (event);
@@ -182,6 +182,8 @@ static gboolean gst_rtp_rtx_receive_src_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstFlowReturn gst_rtp_rtx_receive_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
+static GstFlowReturn gst_rtp_rtx_receive_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 
 static GstStateChangeReturn gst_rtp_rtx_receive_change_state (GstElement *
     element, GstStateChange transition);
@@ -322,6 +324,8 @@ gst_rtp_rtx_receive_init (GstRtpRtxReceive * rtx)
   GST_PAD_SET_PROXY_ALLOCATION (rtx->sinkpad);
   gst_pad_set_chain_function (rtx->sinkpad,
       GST_DEBUG_FUNCPTR (gst_rtp_rtx_receive_chain));
+  gst_pad_set_chain_list_function (rtx->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_rtp_rtx_receive_chain_list));
   gst_element_add_pad (GST_ELEMENT (rtx), rtx->sinkpad);
 
   rtx->ssrc2_ssrc1_map = g_hash_table_new (g_direct_hash, g_direct_equal);
@@ -521,12 +525,14 @@ _gst_rtp_buffer_new_from_rtx (GstRTPBuffer * rtp, guint32 ssrc1,
   return new_buffer;
 }
 
-static GstFlowReturn
-gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+/* Takes ownership of @buffer and returns the packet to push downstream, which
+ * is either @buffer itself or, for a retransmission, the reconstructed
+ * original packet. Returns %NULL if the packet must be dropped.
+ * MUST be called with a map set */
+static GstBuffer *
+gst_rtp_rtx_receive_process (GstRtpRtxReceive * rtx, GstBuffer * buffer)
 {
-  GstRtpRtxReceive *rtx = GST_RTP_RTX_RECEIVE_CAST (parent);
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *new_buffer = NULL;
   guint32 ssrc = 0;
   gpointer ssrc1 = 0;
@@ -539,9 +545,6 @@ gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   gboolean is_rtx;
   gboolean drop = FALSE;
 
-  if (rtx->rtx_pt_map_structure == NULL)
-    goto no_map;
-
   /* map current rtp packet to parse its header */
   if (!gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp))
     goto invalid_buffer;
@@ -671,7 +674,7 @@ gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (drop) {
     gst_rtp_buffer_unmap (&rtp);
     gst_buffer_unref (buffer);
-    return GST_FLOW_OK;
+    return NULL;
   }
 
   /* create the retransmission packet */
@@ -688,26 +691,79 @@ gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     GST_LOG_OBJECT (rtx, "pushing packet seqnum:%u from restransmission "
         "stream ssrc: %X (master ssrc %X)", orign_seqnum, ssrc2,
         GPOINTER_TO_UINT (ssrc1));
-    ret = gst_pad_push (rtx->srcpad, new_buffer);
-  } else {
-    GST_TRACE_OBJECT (rtx, "pushing packet seqnum:%u from master stream "
-        "ssrc: %X", seqnum, ssrc);
-    ret = gst_pad_push (rtx->srcpad, buffer);
+    return new_buffer;
   }
 
-  return ret;
+  GST_TRACE_OBJECT (rtx, "pushing packet seqnum:%u from master stream "
+      "ssrc: %X", seqnum, ssrc);
+  return buffer;
+
+invalid_buffer:
+  {
+    GST_INFO_OBJECT (rtx, "Received invalid RTP payload, dropping");
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRtpRtxReceive *rtx = GST_RTP_RTX_RECEIVE_CAST (parent);
+
+  if (rtx->rtx_pt_map_structure == NULL)
+    goto no_map;
+
+  buffer = gst_rtp_rtx_receive_process (rtx, buffer);
+  if (buffer == NULL)
+    return GST_FLOW_OK;
+
+  return gst_pad_push (rtx->srcpad, buffer);
 
 no_map:
   {
     GST_DEBUG_OBJECT (pad, "No map set, passthrough");
     return gst_pad_push (rtx->srcpad, buffer);
   }
-invalid_buffer:
-  {
-    GST_INFO_OBJECT (pad, "Received invalid RTP payload, dropping");
-    gst_buffer_unref (buffer);
+}
+
+/* Rewrites the retransmitted packets of the list into an output list, which
+ * is then pushed downstream at once */
+static GstFlowReturn
+gst_rtp_rtx_receive_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpRtxReceive *rtx = GST_RTP_RTX_RECEIVE_CAST (parent);
+  GstBufferList *new_list;
+  guint i, len;
+
+  if (rtx->rtx_pt_map_structure == NULL)
+    goto no_map;
+
+  len = gst_buffer_list_length (list);
+  new_list = gst_buffer_list_new_sized (len);
+
+  for (i = 0; i < len; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+
+    buffer = gst_rtp_rtx_receive_process (rtx, gst_buffer_ref (buffer));
+    if (buffer)
+      gst_buffer_list_add (new_list, buffer);
+  }
+  gst_buffer_list_unref (list);
+
+  if (gst_buffer_list_length (new_list) == 0) {
+    gst_buffer_list_unref (new_list);
     return GST_FLOW_OK;
   }
+
+  return gst_pad_push_list (rtx->srcpad, new_list);
+
+no_map:
+  {
+    GST_DEBUG_OBJECT (pad, "No map set, passthrough");
+    return gst_pad_push_list (rtx->srcpad, list);
+  }
 }
 
 static void
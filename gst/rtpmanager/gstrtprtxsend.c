@@ -34,6 +34,10 @@
  * look up the requested seqnum in its list of stored packets. If the packet
  * is available, it will create a RTX packet according to RFC 4588 and send
  * this as an auxiliary stream. RTX is SSRC-multiplexed
+ *
+ * A request can carry an optional "blp" field, the bitmask of following lost
+ * packets of a RFC 4585 generic NACK. All the packets it covers are then
+ * retransmitted together as one buffer list.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -126,6 +130,12 @@ static void gst_rtp_rtx_send_reset_stuffing_bucket (GstRtpRtxSend * rtx,
 #define IS_RTX_ENABLED(rtx) (g_hash_table_size ((rtx)->rtx_pt_map) > 0)
 #define RTX_OVERHEAD 2
 
+/* The history starts with this many slots and doubles when needed, up to half
+ * of the seqnum space so that the distance between two seqnums in it is never
+ * ambiguous. Sizes are always a power of two. */
+#define RTX_HISTORY_MIN_SIZE 64
+#define RTX_HISTORY_MAX_SIZE 32768
+
 typedef struct
 {
   guint16 seqnum;
@@ -133,21 +143,20 @@ typedef struct
   GstBuffer *buffer;
 } BufferQueueItem;
 
-static void
-buffer_queue_item_free (BufferQueueItem * item)
-{
-  gst_buffer_unref (item->buffer);
-  g_slice_free (BufferQueueItem, item);
-}
-
 typedef struct
 {
   guint32 rtx_ssrc;
   guint16 seqnum_base, next_seqnum;
   gint clock_rate;
 
-  /* history of rtp packets */
-  GSequence *queue;
+  /* history of rtp packets, a ring indexed by seqnum modulo history_size.
+   * It covers the span seqnums starting at first_seqnum, and the packets at
+   * both ends of that range are always present. */
+  BufferQueueItem *history;
+  guint history_size;
+  guint16 first_seqnum;
+  guint span;
+  guint n_packets;
 } SSRCRtxData;
 
 static SSRCRtxData *
@@ -157,15 +166,127 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 
   data->rtx_ssrc = rtx_ssrc;
   data->next_seqnum = data->seqnum_base = g_random_int_range (0, G_MAXUINT16);
-  data->queue = g_sequence_new ((GDestroyNotify) buffer_queue_item_free);
 
   return data;
 }
 
+static inline BufferQueueItem *
+history_slot (SSRCRtxData * data, guint16 seqnum)
+{
+  return &data->history[seqnum & (data->history_size - 1)];
+}
+
+static BufferQueueItem *
+history_lookup (SSRCRtxData * data, guint16 seqnum)
+{
+  BufferQueueItem *item;
+
+  if ((guint16) (seqnum - data->first_seqnum) >= data->span)
+    return NULL;
+
+  item = history_slot (data, seqnum);
+  return item->buffer ? item : NULL;
+}
+
+static BufferQueueItem *
+history_newest (SSRCRtxData * data)
+{
+  return history_slot (data, data->first_seqnum + data->span - 1);
+}
+
+static void
+history_pop_oldest (SSRCRtxData * data)
+{
+  BufferQueueItem *item = history_slot (data, data->first_seqnum);
+
+  gst_buffer_unref (item->buffer);
+  item->buffer = NULL;
+  data->n_packets--;
+
+  /* skip the holes, so that the oldest slot is occupied again */
+  do {
+    data->first_seqnum++;
+    data->span--;
+  } while (data->span > 0 && !history_slot (data, data->first_seqnum)->buffer);
+}
+
+static void
+history_resize (SSRCRtxData * data, guint size)
+{
+  BufferQueueItem *history = g_new0 (BufferQueueItem, size);
+  guint i;
+
+  for (i = 0; i < data->span; i++) {
+    guint16 seqnum = data->first_seqnum + i;
+    BufferQueueItem *item = history_slot (data, seqnum);
+
+    if (item->buffer)
+      history[seqnum & (size - 1)] = *item;
+  }
+
+  g_free (data->history);
+  data->history = history;
+  data->history_size = size;
+}
+
+static void
+history_clear (SSRCRtxData * data)
+{
+  while (data->n_packets > 0)
+    history_pop_oldest (data);
+}
+
+/* Stores a new reference to @buffer. Packets slightly older than the oldest
+ * one in the history are not stored, while a larger jump in seqnums restarts
+ * the history. */
+static void
+history_insert (SSRCRtxData * data, guint16 seqnum, guint32 timestamp,
+    GstBuffer * buffer, guint max_size)
+{
+  BufferQueueItem *item;
+
+  if (data->history == NULL)
+    history_resize (data, MIN (RTX_HISTORY_MIN_SIZE, max_size));
+
+  if (data->span > 0) {
+    gint16 delta = (gint16) (seqnum - data->first_seqnum);
+
+    if (delta < 0 && (guint) - delta < data->history_size)
+      return;
+
+    if (delta < 0) {
+      history_clear (data);
+    } else {
+      /* grow the ring if allowed, else forget the oldest packets */
+      while ((guint) delta >= data->history_size
+          && data->history_size < max_size)
+        history_resize (data, data->history_size * 2);
+      while (data->span > 0 &&
+          (guint16) (seqnum - data->first_seqnum) >= data->history_size)
+        history_pop_oldest (data);
+    }
+  }
+
+  if (data->span == 0)
+    data->first_seqnum = seqnum;
+  data->span = MAX (data->span, (guint16) (seqnum - data->first_seqnum) + 1);
+
+  item = history_slot (data, seqnum);
+  if (item->buffer)
+    gst_buffer_unref (item->buffer);
+  else
+    data->n_packets++;
+
+  item->seqnum = seqnum;
+  item->timestamp = timestamp;
+  item->buffer = gst_buffer_ref (buffer);
+}
+
 static void
 ssrc_rtx_data_free (SSRCRtxData * data)
 {
-  g_sequence_free (data->queue);
+  history_clear (data);
+  g_free (data->history);
   g_slice_free (SSRCRtxData, data);
 }
 
@@ -555,16 +676,6 @@ gst_rtp_rtx_buffer_new (GstRtpRtxSend * rtx, GstBuffer * buffer, guint8 padlen)
   return new_buffer;
 }
 
-static gint
-buffer_queue_items_cmp (BufferQueueItem * a, BufferQueueItem * b,
-    gpointer user_data)
-{
-  /* gst_rtp_buffer_compare_seqnum returns the opposite of what we want,
-   * it returns negative when seqnum1 > seqnum2 and we want negative
-   * when b > a, i.e. a is smaller, so it comes first in the sequence */
-  return gst_rtp_buffer_compare_seqnum (b->seqnum, a->seqnum);
-}
-
 static gboolean
 gst_rtp_rtx_send_token_bucket (GstRtpRtxSend * rtx, GstBuffer * buf)
 {
@@ -587,6 +698,40 @@ gst_rtp_rtx_send_token_bucket (GstRtpRtxSend * rtx, GstBuffer * buf)
   return token_bucket_take_tokens (&rtx->max_tb, tokens, FALSE);
 }
 
+/* Must be called with lock */
+static GstBuffer *
+gst_rtp_rtx_send_handle_request (GstRtpRtxSend * rtx, SSRCRtxData * data,
+    guint16 seqnum)
+{
+  BufferQueueItem *item;
+
+  /* update statistics */
+  ++rtx->num_rtx_requests;
+
+  item = history_lookup (data, seqnum);
+  if (item) {
+    GST_LOG_OBJECT (rtx, "found %" G_GUINT16_FORMAT, item->seqnum);
+    if (gst_rtp_rtx_send_token_bucket (rtx, item->buffer))
+      return gst_rtp_rtx_buffer_new (rtx, item->buffer, 0);
+
+    GST_DEBUG_OBJECT (rtx, "Packet #%" G_GUINT16_FORMAT
+        " dropped due to full bucket", item->seqnum);
+  }
+#ifndef GST_DISABLE_DEBUG
+  else if (data->n_packets > 0 && (gint16) (seqnum - data->first_seqnum) < 0) {
+    GST_DEBUG_OBJECT (rtx, "requested seqnum %u has already been "
+        "removed from the rtx queue; the first available is %u",
+        seqnum, data->first_seqnum);
+  } else {
+    GST_WARNING_OBJECT (rtx, "requested seqnum %u has not been "
+        "transmitted yet in the original stream; either the remote end "
+        "is not configured correctly, or the source is too slow", seqnum);
+  }
+#endif
+
+  return NULL;
+}
+
 static gboolean
 gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -602,7 +747,8 @@ gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       if (gst_structure_has_name (s, "GstRTPRetransmissionRequest")) {
         guint seqnum = 0;
         guint ssrc = 0;
-        GstBuffer *rtx_buf = NULL;
+        guint blp = 0;
+        GstBufferList *rtx_list = NULL;
 
         /* retrieve seqnum of the packet that need to be retransmitted */
         if (!gst_structure_get_uint (s, "seqnum", &seqnum))
@@ -612,59 +758,48 @@ gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         if (!gst_structure_get_uint (s, "ssrc", &ssrc))
           ssrc = -1;
 
-        GST_DEBUG_OBJECT (rtx, "got rtx request for seqnum: %u, ssrc: %X",
-            seqnum, ssrc);
+        /* bitmask of following lost packets, if any */
+        gst_structure_get_uint (s, "blp", &blp);
+
+        GST_DEBUG_OBJECT (rtx, "got rtx request for seqnum: %u, ssrc: %X, "
+            "blp: %04x", seqnum, ssrc, blp);
 
         GST_OBJECT_LOCK (rtx);
         /* check if request is for us */
         if (g_hash_table_contains (rtx->ssrc_data, GUINT_TO_POINTER (ssrc))) {
-          SSRCRtxData *data;
-          GSequenceIter *iter;
-          BufferQueueItem search_item;
-
-          /* update statistics */
-          ++rtx->num_rtx_requests;
-
-          data = gst_rtp_rtx_send_get_ssrc_data (rtx, ssrc);
-
-          search_item.seqnum = seqnum;
-          iter = g_sequence_lookup (data->queue, &search_item,
-              (GCompareDataFunc) buffer_queue_items_cmp, NULL);
-          if (iter) {
-            BufferQueueItem *item = g_sequence_get (iter);
-            GST_LOG_OBJECT (rtx, "found %" G_GUINT16_FORMAT, item->seqnum);
-            if (gst_rtp_rtx_send_token_bucket (rtx, item->buffer)) {
-              rtx_buf = gst_rtp_rtx_buffer_new (rtx, item->buffer, 0);
-            } else {
-              GST_DEBUG_OBJECT (rtx, "Packet #%" G_GUINT16_FORMAT
-                  " dropped due to full bucket", item->seqnum);
+          SSRCRtxData *data = gst_rtp_rtx_send_get_ssrc_data (rtx, ssrc);
+
+          blp &= 0xffff;
+          while (TRUE) {
+            GstBuffer *rtx_buf;
+
+            rtx_buf = gst_rtp_rtx_send_handle_request (rtx, data, seqnum);
+            if (rtx_buf) {
+              if (rtx_list == NULL)
+                rtx_list = gst_buffer_list_new ();
+              gst_buffer_list_add (rtx_list, rtx_buf);
             }
-          }
-#ifndef GST_DISABLE_DEBUG
-          else {
-            BufferQueueItem *item = NULL;
-
-            iter = g_sequence_get_begin_iter (data->queue);
-            if (!g_sequence_iter_is_end (iter))
-              item = g_sequence_get (iter);
-
-            if (item && seqnum < item->seqnum) {
-              GST_DEBUG_OBJECT (rtx, "requested seqnum %u has already been "
-                  "removed from the rtx queue; the first available is %u",
-                  seqnum, item->seqnum);
-            } else {
-              GST_WARNING_OBJECT (rtx, "requested seqnum %u has not been "
-                  "transmitted yet in the original stream; either the remote end "
-                  "is not configured correctly, or the source is too slow",
-                  seqnum);
+
+            if (blp == 0)
+              break;
+
+            seqnum++;
+            while ((blp & 1) == 0) {
+              seqnum++;
+              blp >>= 1;
             }
+            blp >>= 1;
           }
-#endif
         }
         GST_OBJECT_UNLOCK (rtx);
 
-        if (rtx_buf)
-          gst_rtp_rtx_send_push_out (rtx, rtx_buf);
+        if (rtx_list && gst_buffer_list_length (rtx_list) == 1) {
+          gst_rtp_rtx_send_push_out (rtx,
+              gst_buffer_ref (gst_buffer_list_get (rtx_list, 0)));
+          gst_buffer_list_unref (rtx_list);
+        } else if (rtx_list) {
+          gst_rtp_rtx_send_push_out (rtx, rtx_list);
+        }
 
         gst_event_unref (event);
         res = TRUE;
@@ -823,14 +958,12 @@ gst_rtp_rtx_send_get_ts_diff (SSRCRtxData * data)
   BufferQueueItem *high_buf, *low_buf;
   guint32 result;
 
-  high_buf =
-      g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter
-          (data->queue)));
-  low_buf = g_sequence_get (g_sequence_get_begin_iter (data->queue));
-
-  if (!high_buf || !low_buf || high_buf == low_buf)
+  if (data->n_packets < 2)
     return 0;
 
+  high_buf = history_newest (data);
+  low_buf = history_slot (data, data->first_seqnum);
+
   if (data->clock_rate) {
     high_ts = high_buf->timestamp;
     low_ts = low_buf->timestamp;
@@ -856,11 +989,11 @@ static SSRCRtxData *
 process_buffer (GstRtpRtxSend * rtx, GstBuffer * buffer)
 {
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  BufferQueueItem *item;
   SSRCRtxData *data = NULL;
   guint16 seqnum;
   guint8 payload_type;
   guint32 ssrc, rtptime;
+  guint max_size;
 
   /* read the information we want from the buffer */
   gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp);
@@ -883,21 +1016,21 @@ process_buffer (GstRtpRtxSend * rtx, GstBuffer * buffer)
               GUINT_TO_POINTER (payload_type)));
     }
 
-    /* add current rtp buffer to queue history */
-    item = g_slice_new0 (BufferQueueItem);
-    item->seqnum = seqnum;
-    item->timestamp = rtptime;
-    item->buffer = gst_buffer_ref (buffer);
-    g_sequence_append (data->queue, item);
+    /* add current rtp buffer to queue history, the ring never needs to be
+     * larger than max-size-packets */
+    max_size = RTX_HISTORY_MAX_SIZE;
+    if (rtx->max_size_packets)
+      max_size = MIN (max_size, 1U << g_bit_storage (rtx->max_size_packets));
+    history_insert (data, seqnum, rtptime, buffer, max_size);
 
     /* remove oldest packets from history if they are too many */
     if (rtx->max_size_packets) {
-      while (g_sequence_get_length (data->queue) > rtx->max_size_packets)
-        g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+      while (data->n_packets > rtx->max_size_packets)
+        history_pop_oldest (data);
     }
     if (rtx->max_size_time) {
       while (gst_rtp_rtx_send_get_ts_diff (data) > rtx->max_size_time)
-        g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+        history_pop_oldest (data);
     }
   }
 
@@ -1026,10 +1159,6 @@ gst_rtp_rtx_send_chain_list (GstPad * pad, GstObject * parent,
       GST_WARNING_OBJECT (rtx, "RTX stuffing for chain_list not implemented");
 
     gst_buffer_list_foreach (list, process_buffer_from_list, rtx);
-
-    GST_OBJECT_UNLOCK (rtx);
-    gst_rtp_rtx_send_push_out (rtx, list);
-    return GST_FLOW_OK;
   }
   GST_OBJECT_UNLOCK (rtx);
 
@@ -1053,6 +1182,14 @@ gst_rtp_rtx_send_src_loop (GstRtpRtxSend * rtx)
       GST_OBJECT_UNLOCK (rtx);
 
       gst_pad_push (rtx->srcpad, GST_BUFFER (data->object));
+    } else if (GST_IS_BUFFER_LIST (data->object)) {
+      GstBufferList *list = GST_BUFFER_LIST (data->object);
+
+      GST_OBJECT_LOCK (rtx);
+      rtx->num_rtx_packets += gst_buffer_list_length (list);
+      GST_OBJECT_UNLOCK (rtx);
+
+      gst_pad_push_list (rtx->srcpad, list);
     } else if (GST_IS_EVENT (data->object)) {
       gst_pad_push_event (rtx->srcpad, GST_EVENT (data->object));
 
@@ -228,6 +228,7 @@ enum
 #define DEFAULT_RTP_PROFILE          GST_RTP_PROFILE_AVP
 #define DEFAULT_NTP_TIME_SOURCE      GST_RTP_NTP_TIME_SOURCE_NTP
 #define DEFAULT_RTCP_SYNC_SEND_TIME  TRUE
+#define DEFAULT_BATCH_RTX_REQUESTS   FALSE
 
 enum
 {
@@ -249,7 +250,8 @@ enum
   PROP_TWCC_STATS,
   PROP_RTP_PROFILE,
   PROP_NTP_TIME_SOURCE,
-  PROP_RTCP_SYNC_SEND_TIME
+  PROP_RTCP_SYNC_SEND_TIME,
+  PROP_BATCH_RTX_REQUESTS
 };
 
 #define GST_RTP_SESSION_LOCK(sess)   g_mutex_lock (&(sess)->priv->lock)
@@ -273,6 +275,10 @@ struct _GstRtpSessionPrivate
   gboolean thread_stopped;
   gboolean wait_send;
 
+  /* shared scheduler replacing the thread, when set */
+  RtpScheduler *scheduler;
+  gboolean timeout_running;
+
   /* caps mapping */
   GHashTable *ptmap;
 
@@ -281,6 +287,7 @@ struct _GstRtpSessionPrivate
   gboolean use_pipeline_clock;
   GstRtpNtpTimeSource ntp_time_source;
   gboolean rtcp_sync_send_time;
+  gboolean batch_rtx_requests;
 
   guint recv_rtx_req_count;
   guint sent_rtx_req_count;
@@ -807,6 +814,21 @@ gst_rtp_session_class_init (GstRtpSessionClass * klass)
    *      sender and receiver. A sudden increase in this number can indicate
    *      network congestion.
    *
+   * When #RTPSession:bandwidth-estimation is enabled on the internal session,
+   * the structure also contains:
+   *
+   *  "estimated-bitrate" G_TYPE_UINT   The estimated available send bitrate.
+   *  "bwe-state"         G_TYPE_STRING The rate control state, one of
+   *      "hold", "increase" or "decrease".
+   *  "bwe-probing"       G_TYPE_BOOLEAN Whether the estimate is growing fast
+   *      because no capacity limit has been found near the current rate.
+   *
+   * The estimate is also sent upstream from the send_rtp_sink pad as a
+   * "GstRTPBandwidthEstimate" custom event with "bitrate" (G_TYPE_UINT),
+   * "state" (G_TYPE_STRING) and "probing" (G_TYPE_BOOLEAN) fields, which
+   * encoders can act on. The same structure is sent downstream from the
+   * send_rtp_src pad as an out-of-band event for #GstRtpPacer.
+   *
    * Since: 1.18
    */
   g_object_class_install_property (gobject_class, PROP_TWCC_STATS,
@@ -832,6 +854,25 @@ gst_rtp_session_class_init (GstRtpSessionClass * klass)
           DEFAULT_RTCP_SYNC_SEND_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpSession:batch-rtx-requests:
+   *
+   * Send one GstRTPRetransmissionRequest event per received generic NACK,
+   * carrying the bitmask of following lost packets in a "blp" field, instead
+   * of one event per sequence number. Only enable this when the upstream
+   * element handling the requests understands the "blp" field, like
+   * #GstRtpRtxSend does. #GstRtpBin enables it automatically when its
+   * auxiliary sender contains an rtprtxsend element.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_RTX_REQUESTS,
+      g_param_spec_boolean ("batch-rtx-requests", "Batch RTX Requests",
+          "Send one retransmission request event per generic NACK instead "
+          "of one per sequence number",
+          DEFAULT_BATCH_RTX_REQUESTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_rtp_session_change_state);
   gstelement_class->request_new_pad =
@@ -888,6 +929,7 @@ gst_rtp_session_init (GstRtpSession * rtpsession)
   rtpsession->priv->session = rtp_session_new ();
   rtpsession->priv->use_pipeline_clock = DEFAULT_USE_PIPELINE_CLOCK;
   rtpsession->priv->rtcp_sync_send_time = DEFAULT_RTCP_SYNC_SEND_TIME;
+  rtpsession->priv->batch_rtx_requests = DEFAULT_BATCH_RTX_REQUESTS;
 
   /* configure callbacks */
   rtp_session_set_callbacks (rtpsession->priv->session, &callbacks, rtpsession);
@@ -945,6 +987,8 @@ gst_rtp_session_finalize (GObject * object)
   g_cond_clear (&rtpsession->priv->cond);
   g_object_unref (rtpsession->priv->sysclock);
   g_object_unref (rtpsession->priv->session);
+  if (rtpsession->priv->scheduler)
+    rtp_scheduler_unref (rtpsession->priv->scheduler);
   if (rtpsession->priv->last_twcc_stats)
     gst_structure_free (rtpsession->priv->last_twcc_stats);
 
@@ -1006,6 +1050,11 @@ gst_rtp_session_set_property (GObject * object, guint prop_id,
     case PROP_RTCP_SYNC_SEND_TIME:
       priv->rtcp_sync_send_time = g_value_get_boolean (value);
       break;
+    case PROP_BATCH_RTX_REQUESTS:
+      GST_RTP_SESSION_LOCK (rtpsession);
+      priv->batch_rtx_requests = g_value_get_boolean (value);
+      GST_RTP_SESSION_UNLOCK (rtpsession);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1085,6 +1134,11 @@ gst_rtp_session_get_property (GObject * object, guint prop_id,
     case PROP_RTCP_SYNC_SEND_TIME:
       g_value_set_boolean (value, priv->rtcp_sync_send_time);
       break;
+    case PROP_BATCH_RTX_REQUESTS:
+      GST_RTP_SESSION_LOCK (rtpsession);
+      g_value_set_boolean (value, priv->batch_rtx_requests);
+      GST_RTP_SESSION_UNLOCK (rtpsession);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1167,14 +1221,130 @@ get_current_times (GstRtpSession * rtpsession, GstClockTime * running_time,
     *ntpnstime = ntpns;
 }
 
+static void rtcp_scheduler_timeout (GstClockID id, GstRtpSession * rtpsession);
+
+static void
+rtcp_scheduler_post_error (GstElement * element, gpointer user_data)
+{
+  GST_ELEMENT_ERROR (element, CORE, CLOCK, (NULL),
+      ("Failed to schedule the RTCP timeout"));
+}
+
+/* must be called with GST_RTP_SESSION_LOCK */
+static void
+rtcp_scheduler_wait_unlocked (GstRtpSession * rtpsession, GstClockTime time)
+{
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+
+  priv->id = gst_clock_new_single_shot_id (priv->sysclock, time);
+  if (rtp_scheduler_wait_async (priv->scheduler, priv->id,
+          (RtpSchedulerFunc) rtcp_scheduler_timeout,
+          gst_object_ref (rtpsession), gst_object_unref))
+    return;
+
+  /* the scheduler leaves the reference to us when it fails */
+  gst_object_unref (rtpsession);
+
+  GST_WARNING_OBJECT (rtpsession, "failed to schedule RTCP timeout");
+  gst_clock_id_unref (priv->id);
+  priv->id = NULL;
+  priv->thread_stopped = TRUE;
+
+  /* we hold the session lock, post the error from another thread */
+  gst_element_call_async (GST_ELEMENT_CAST (rtpsession),
+      rtcp_scheduler_post_error, NULL, NULL);
+}
+
+/* must be called with GST_RTP_SESSION_LOCK */
+static void
+rtcp_scheduler_next_unlocked (GstRtpSession * rtpsession,
+    GstClockTime current_time)
+{
+  GstClockTime next_timeout;
+
+  /* get initial estimate */
+  next_timeout = rtp_session_next_timeout (rtpsession->priv->session,
+      current_time);
+
+  GST_DEBUG_OBJECT (rtpsession, "next check time %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (next_timeout));
+
+  /* stop when there are no more timeouts, the session ended */
+  if (next_timeout == GST_CLOCK_TIME_NONE) {
+    rtpsession->priv->thread_stopped = TRUE;
+    return;
+  }
+
+  rtcp_scheduler_wait_unlocked (rtpsession, next_timeout);
+}
+
+/* must be called with GST_RTP_SESSION_LOCK */
+static void
+rtcp_scheduler_start_unlocked (GstRtpSession * rtpsession)
+{
+  GstClockTime current_time;
+
+  current_time = gst_clock_get_time (rtpsession->priv->sysclock);
+
+  GST_DEBUG_OBJECT (rtpsession, "starting at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (current_time));
+  rtpsession->priv->session->start_time = current_time;
+
+  rtcp_scheduler_next_unlocked (rtpsession, current_time);
+}
+
+/* the same as one iteration of rtcp_thread, called from a scheduler worker */
+static void
+rtcp_scheduler_timeout (GstClockID id, GstRtpSession * rtpsession)
+{
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+  GstClockTime current_time;
+  guint64 ntpnstime;
+  GstClockTime running_time;
+
+  GST_RTP_SESSION_LOCK (rtpsession);
+  /* ignore timeouts that got stopped or replaced after they fired */
+  if (priv->stop_thread || id != priv->id) {
+    GST_RTP_SESSION_UNLOCK (rtpsession);
+    return;
+  }
+  gst_clock_id_unref (priv->id);
+  priv->id = NULL;
+  priv->timeout_running = TRUE;
+
+  current_time = gst_clock_get_time (priv->sysclock);
+  get_current_times (rtpsession, &running_time, &ntpnstime);
+  GST_RTP_SESSION_UNLOCK (rtpsession);
+
+  rtp_session_on_timeout (priv->session, current_time, ntpnstime,
+      running_time);
+
+  GST_RTP_SESSION_LOCK (rtpsession);
+  priv->timeout_running = FALSE;
+  if (priv->stop_thread)
+    priv->thread_stopped = TRUE;
+  else
+    rtcp_scheduler_next_unlocked (rtpsession, current_time);
+  /* wake up join_rtcp_thread */
+  GST_RTP_SESSION_SIGNAL (rtpsession);
+  GST_RTP_SESSION_UNLOCK (rtpsession);
+}
+
 /* must be called with GST_RTP_SESSION_LOCK */
 static void
 signal_waiting_rtcp_thread_unlocked (GstRtpSession * rtpsession)
 {
-  if (rtpsession->priv->wait_send) {
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+
+  if (priv->wait_send) {
     GST_LOG_OBJECT (rtpsession, "signal RTCP thread");
-    rtpsession->priv->wait_send = FALSE;
-    GST_RTP_SESSION_SIGNAL (rtpsession);
+    priv->wait_send = FALSE;
+    if (priv->scheduler) {
+      if (!priv->thread_stopped && !priv->stop_thread)
+        rtcp_scheduler_start_unlocked (rtpsession);
+    } else {
+      GST_RTP_SESSION_SIGNAL (rtpsession);
+    }
   }
 }
 
@@ -1267,7 +1437,14 @@ start_rtcp_thread (GstRtpSession * rtpsession)
 
   GST_RTP_SESSION_LOCK (rtpsession);
   rtpsession->priv->stop_thread = FALSE;
-  if (rtpsession->priv->thread_stopped) {
+  if (rtpsession->priv->scheduler) {
+    /* the first timeout is scheduled once we are not waiting for data */
+    if (rtpsession->priv->thread_stopped) {
+      rtpsession->priv->thread_stopped = FALSE;
+      if (!rtpsession->priv->wait_send)
+        rtcp_scheduler_start_unlocked (rtpsession);
+    }
+  } else if (rtpsession->priv->thread_stopped) {
     /* if the thread stopped, and we still have a handle to the thread, join it
      * now. We can safely join with the lock held, the thread will not take it
      * anymore. */
@@ -1301,6 +1478,15 @@ stop_rtcp_thread (GstRtpSession * rtpsession)
   signal_waiting_rtcp_thread_unlocked (rtpsession);
   if (rtpsession->priv->id)
     gst_clock_id_unschedule (rtpsession->priv->id);
+  if (rtpsession->priv->scheduler) {
+    /* with a scheduler we own the pending id */
+    if (rtpsession->priv->id) {
+      gst_clock_id_unref (rtpsession->priv->id);
+      rtpsession->priv->id = NULL;
+    }
+    if (!rtpsession->priv->timeout_running)
+      rtpsession->priv->thread_stopped = TRUE;
+  }
   GST_RTP_SESSION_UNLOCK (rtpsession);
 }
 
@@ -1320,6 +1506,9 @@ join_rtcp_thread (GstRtpSession * rtpsession)
      * is supposed to not concurrently call start and join. */
     rtpsession->priv->thread = NULL;
   }
+  /* with a scheduler, wait for a timeout that is still being handled */
+  while (rtpsession->priv->timeout_running)
+    GST_RTP_SESSION_WAIT (rtpsession);
   GST_RTP_SESSION_UNLOCK (rtpsession);
 }
 
@@ -1380,6 +1569,28 @@ failed_thread:
   }
 }
 
+/**
+ * gst_rtp_session_set_scheduler:
+ * @sess: a #GstRtpSession
+ * @sched: (nullable): a #RtpScheduler
+ *
+ * Handle the RTCP timeouts on the worker threads of @sched instead of on a
+ * thread of our own. Only takes effect when set before going to PLAYING.
+ */
+void
+gst_rtp_session_set_scheduler (GstRtpSession * sess, RtpScheduler * sched)
+{
+  GST_RTP_SESSION_LOCK (sess);
+  if (sess->priv->thread_stopped && sess->priv->thread == NULL) {
+    if (sess->priv->scheduler)
+      rtp_scheduler_unref (sess->priv->scheduler);
+    sess->priv->scheduler = sched ? rtp_scheduler_ref (sched) : NULL;
+  } else {
+    GST_WARNING_OBJECT (sess, "can't change scheduler while running");
+  }
+  GST_RTP_SESSION_UNLOCK (sess);
+}
+
 static gboolean
 return_true (gpointer key, gpointer value, gpointer user_data)
 {
@@ -1760,8 +1971,15 @@ gst_rtp_session_reconsider (RTPSession * sess, gpointer user_data)
 
   GST_RTP_SESSION_LOCK (rtpsession);
   GST_DEBUG_OBJECT (rtpsession, "unlock timer for reconsideration");
-  if (rtpsession->priv->id)
+  if (rtpsession->priv->id) {
     gst_clock_id_unschedule (rtpsession->priv->id);
+    if (rtpsession->priv->scheduler) {
+      /* nobody is waiting on the id, schedule the timeout right away */
+      gst_clock_id_unref (rtpsession->priv->id);
+      rtcp_scheduler_wait_unlocked (rtpsession,
+          gst_clock_get_time (rtpsession->priv->sysclock));
+    }
+  }
   GST_RTP_SESSION_UNLOCK (rtpsession);
 }
 
@@ -2854,13 +3072,36 @@ gst_rtp_session_notify_nack (RTPSession * sess, guint16 seqnum,
   GstRtpSession *rtpsession = GST_RTP_SESSION (user_data);
   GstEvent *event;
   GstPad *send_rtp_sink;
+  gboolean batch;
 
   GST_RTP_SESSION_LOCK (rtpsession);
   if ((send_rtp_sink = rtpsession->send_rtp_sink))
     gst_object_ref (send_rtp_sink);
+  batch = rtpsession->priv->batch_rtx_requests;
   GST_RTP_SESSION_UNLOCK (rtpsession);
 
-  if (send_rtp_sink) {
+  if (send_rtp_sink && batch) {
+    GstStructure *s;
+    guint n_seqnums = 1;
+    guint16 bits;
+
+    /* one request for the whole generic NACK, so that the sender can answer
+     * it at once */
+    s = gst_structure_new ("GstRTPRetransmissionRequest",
+        "seqnum", G_TYPE_UINT, (guint) seqnum,
+        "ssrc", G_TYPE_UINT, (guint) ssrc, NULL);
+    if (blp != 0) {
+      gst_structure_set (s, "blp", G_TYPE_UINT, (guint) blp, NULL);
+      for (bits = blp; bits; bits &= bits - 1)
+        n_seqnums++;
+    }
+    event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, s);
+    gst_pad_push_event (send_rtp_sink, event);
+
+    GST_RTP_SESSION_LOCK (rtpsession);
+    rtpsession->priv->sent_rtx_req_count += n_seqnums;
+    GST_RTP_SESSION_UNLOCK (rtpsession);
+  } else if (send_rtp_sink) {
     while (TRUE) {
       event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
           gst_structure_new ("GstRTPRetransmissionRequest",
@@ -2882,8 +3123,10 @@ gst_rtp_session_notify_nack (RTPSession * sess, guint16 seqnum,
       }
       blp >>= 1;
     }
-    gst_object_unref (send_rtp_sink);
   }
+
+  if (send_rtp_sink)
+    gst_object_unref (send_rtp_sink);
 }
 
 static void
@@ -2892,11 +3135,33 @@ gst_rtp_session_notify_twcc (RTPSession * sess,
 {
   GstRtpSession *rtpsession = GST_RTP_SESSION (user_data);
   GstEvent *event;
-  GstPad *send_rtp_sink;
+  GstEvent *bwe_event = NULL;
+  GstEvent *bwe_downstream_event = NULL;
+  GstPad *send_rtp_sink, *send_rtp_src;
+  guint bitrate;
+
+  if (gst_structure_get_uint (twcc_stats, "estimated-bitrate", &bitrate)) {
+    gboolean probing = FALSE;
+
+    gst_structure_get_boolean (twcc_stats, "bwe-probing", &probing);
+    bwe_event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+        gst_structure_new ("GstRTPBandwidthEstimate",
+            "bitrate", G_TYPE_UINT, bitrate,
+            "state", G_TYPE_STRING,
+            gst_structure_get_string (twcc_stats, "bwe-state"),
+            "probing", G_TYPE_BOOLEAN, probing, NULL));
+    /* for elements after the session, like rtppacer, that also need to see
+     * the retransmissions */
+    bwe_downstream_event =
+        gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM_OOB,
+        gst_structure_copy (gst_event_get_structure (bwe_event)));
+  }
 
   GST_RTP_SESSION_LOCK (rtpsession);
   if ((send_rtp_sink = rtpsession->send_rtp_sink))
     gst_object_ref (send_rtp_sink);
+  if ((send_rtp_src = rtpsession->send_rtp_src))
+    gst_object_ref (send_rtp_src);
   if (rtpsession->priv->last_twcc_stats)
     gst_structure_free (rtpsession->priv->last_twcc_stats);
   rtpsession->priv->last_twcc_stats = twcc_stats;
@@ -2905,7 +3170,21 @@ gst_rtp_session_notify_twcc (RTPSession * sess,
   if (send_rtp_sink) {
     event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, twcc_packets);
     gst_pad_push_event (send_rtp_sink, event);
+    if (bwe_event)
+      gst_pad_push_event (send_rtp_sink, bwe_event);
     gst_object_unref (send_rtp_sink);
+  } else {
+    gst_structure_free (twcc_packets);
+    if (bwe_event)
+      gst_event_unref (bwe_event);
+  }
+
+  if (send_rtp_src) {
+    if (bwe_downstream_event)
+      gst_pad_push_event (send_rtp_src, bwe_downstream_event);
+    gst_object_unref (send_rtp_src);
+  } else if (bwe_downstream_event) {
+    gst_event_unref (bwe_downstream_event);
   }
 
   g_object_notify (G_OBJECT (rtpsession), "twcc-stats");
@@ -22,6 +22,8 @@
 
 #include <gst/gst.h>
 
+#include "rtpscheduler.h"
+
 #define GST_TYPE_RTP_SESSION \
   (gst_rtp_session_get_type())
 #define GST_RTP_SESSION(obj) \
@@ -81,6 +83,8 @@ struct _GstRtpSessionClass {
 
 GType gst_rtp_session_get_type (void);
 
+void gst_rtp_session_set_scheduler (GstRtpSession *sess, RtpScheduler *sched);
+
 GST_ELEMENT_REGISTER_DECLARE (rtpsession);
 
 typedef enum {
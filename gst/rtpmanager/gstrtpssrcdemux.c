@@ -128,6 +128,8 @@ static void gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux,
 /* sinkpad stuff */
 static GstFlowReturn gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
+static GstFlowReturn gst_rtp_ssrc_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_rtp_ssrc_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 
@@ -163,15 +165,7 @@ typedef struct
 static GstRtpSsrcDemuxPads *
 find_demux_pads_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
 {
-  GSList *walk;
-
-  for (walk = demux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpSsrcDemuxPads *pad = (GstRtpSsrcDemuxPads *) walk->data;
-
-    if (pad->ssrc == ssrc)
-      return pad;
-  }
-  return NULL;
+  return g_hash_table_lookup (demux->srcpads_by_ssrc, GUINT_TO_POINTER (ssrc));
 }
 
 /* returns a reference to the pad if found, %NULL otherwise */
@@ -322,6 +316,7 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
 
   GST_OBJECT_LOCK (demux);
   demux->srcpads = g_slist_prepend (demux->srcpads, dpads);
+  g_hash_table_insert (demux->srcpads_by_ssrc, GUINT_TO_POINTER (ssrc), dpads);
   GST_OBJECT_UNLOCK (demux);
 
   gst_pad_set_query_function (rtp_pad, gst_rtp_ssrc_demux_src_query);
@@ -480,6 +475,7 @@ gst_rtp_ssrc_demux_class_init (GstRtpSsrcDemuxClass * klass)
       "rtpssrcdemux", 0, "RTP SSRC demuxer");
 
   GST_DEBUG_REGISTER_FUNCPTR (gst_rtp_ssrc_demux_chain);
+  GST_DEBUG_REGISTER_FUNCPTR (gst_rtp_ssrc_demux_chain_list);
   GST_DEBUG_REGISTER_FUNCPTR (gst_rtp_ssrc_demux_rtcp_chain);
 }
 
@@ -492,6 +488,8 @@ gst_rtp_ssrc_demux_init (GstRtpSsrcDemux * demux)
       gst_pad_new_from_template (gst_element_class_get_pad_template (klass,
           "sink"), "sink");
   gst_pad_set_chain_function (demux->rtp_sink, gst_rtp_ssrc_demux_chain);
+  gst_pad_set_chain_list_function (demux->rtp_sink,
+      gst_rtp_ssrc_demux_chain_list);
   gst_pad_set_event_function (demux->rtp_sink, gst_rtp_ssrc_demux_sink_event);
   gst_pad_set_iterate_internal_links_function (demux->rtp_sink,
       gst_rtp_ssrc_demux_iterate_internal_links_sink);
@@ -507,6 +505,7 @@ gst_rtp_ssrc_demux_init (GstRtpSsrcDemux * demux)
   gst_element_add_pad (GST_ELEMENT_CAST (demux), demux->rtcp_sink);
 
   demux->max_streams = DEFAULT_MAX_STREAMS;
+  demux->srcpads_by_ssrc = g_hash_table_new (NULL, NULL);
 
   g_rec_mutex_init (&demux->padlock);
 }
@@ -526,6 +525,7 @@ gst_rtp_ssrc_demux_pads_free (GstRtpSsrcDemuxPads * dpads)
 static void
 gst_rtp_ssrc_demux_reset (GstRtpSsrcDemux * demux)
 {
+  g_hash_table_remove_all (demux->srcpads_by_ssrc);
   g_slist_free_full (demux->srcpads,
       (GDestroyNotify) gst_rtp_ssrc_demux_pads_free);
   demux->srcpads = NULL;
@@ -549,6 +549,7 @@ gst_rtp_ssrc_demux_finalize (GObject * object)
   GstRtpSsrcDemux *demux;
 
   demux = GST_RTP_SSRC_DEMUX (object);
+  g_hash_table_unref (demux->srcpads_by_ssrc);
   g_rec_mutex_clear (&demux->padlock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -569,6 +570,7 @@ gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
   GST_DEBUG_OBJECT (demux, "clearing pad for SSRC %08x", ssrc);
 
   demux->srcpads = g_slist_remove (demux->srcpads, dpads);
+  g_hash_table_remove (demux->srcpads_by_ssrc, GUINT_TO_POINTER (ssrc));
   GST_OBJECT_UNLOCK (demux);
 
   g_signal_emit (G_OBJECT (demux),
@@ -648,25 +650,15 @@ gst_rtp_ssrc_demux_sink_event (GstPad * pad, GstObject * parent,
   return fdata.res;
 }
 
+/* pushes either @buf or @list, taking ownership of it, to the RTP src pad of
+ * @ssrc */
 static GstFlowReturn
-gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+gst_rtp_ssrc_demux_push_rtp (GstRtpSsrcDemux * demux, guint32 ssrc,
+    GstBuffer * buf, GstBufferList * list)
 {
   GstFlowReturn ret;
-  GstRtpSsrcDemux *demux;
-  guint32 ssrc;
-  GstRTPBuffer rtp = { NULL };
   GstPad *srcpad;
 
-  demux = GST_RTP_SSRC_DEMUX (parent);
-
-  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
-    goto invalid_payload;
-
-  ssrc = gst_rtp_buffer_get_ssrc (&rtp);
-  gst_rtp_buffer_unmap (&rtp);
-
-  GST_DEBUG_OBJECT (demux, "received buffer of SSRC %08x", ssrc);
-
   srcpad = find_or_create_demux_pad_for_ssrc (demux, ssrc, RTP_PAD);
   if (srcpad == NULL)
     goto create_failed;
@@ -677,7 +669,10 @@ gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   }
 
   /* push to srcpad */
-  ret = gst_pad_push (srcpad, buf);
+  if (list)
+    ret = gst_pad_push_list (srcpad, list);
+  else
+    ret = gst_pad_push (srcpad, buf);
 
   if (ret != GST_FLOW_OK) {
     GstPad *active_pad;
@@ -698,15 +693,12 @@ gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return ret;
 
   /* ERRORS */
-invalid_payload:
-  {
-    GST_DEBUG_OBJECT (demux, "Dropping invalid RTP packet");
-    gst_buffer_unref (buf);
-    return GST_FLOW_OK;
-  }
 create_failed:
   {
-    gst_buffer_unref (buf);
+    if (list)
+      gst_buffer_list_unref (list);
+    else
+      gst_buffer_unref (buf);
     if ((demux->err_num & 0xff) == 0)
       GST_WARNING_OBJECT (demux,
           "Dropping buffer SSRC %08x. "
@@ -716,6 +708,116 @@ create_failed:
   }
 }
 
+static gboolean
+get_rtp_ssrc (GstBuffer * buf, guint32 * ssrc)
+{
+  GstRTPBuffer rtp = { NULL };
+
+  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
+    return FALSE;
+
+  *ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstRtpSsrcDemux *demux;
+  guint32 ssrc;
+
+  demux = GST_RTP_SSRC_DEMUX (parent);
+
+  if (!get_rtp_ssrc (buf, &ssrc))
+    goto invalid_payload;
+
+  GST_DEBUG_OBJECT (demux, "received buffer of SSRC %08x", ssrc);
+
+  return gst_rtp_ssrc_demux_push_rtp (demux, ssrc, buf, NULL);
+
+  /* ERRORS */
+invalid_payload:
+  {
+    GST_DEBUG_OBJECT (demux, "Dropping invalid RTP packet");
+    gst_buffer_unref (buf);
+    return GST_FLOW_OK;
+  }
+}
+
+typedef struct
+{
+  guint32 ssrc;
+  GstBufferList *list;
+} SsrcBufferList;
+
+/* Splits the list into one sub-list per SSRC, keeping the order of the
+ * buffers within each SSRC, and pushes every sub-list with a single
+ * gst_pad_push_list(). A list usually only carries a handful of SSRCs, so
+ * a linear scan over the sub-lists is cheaper than a hash table here. */
+static GstFlowReturn
+gst_rtp_ssrc_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRtpSsrcDemux *demux;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GArray *sublists;
+  guint i, j, len;
+
+  demux = GST_RTP_SSRC_DEMUX (parent);
+
+  len = gst_buffer_list_length (list);
+  sublists = g_array_sized_new (FALSE, FALSE, sizeof (SsrcBufferList), 4);
+
+  for (i = 0; i < len; i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+    SsrcBufferList *sub = NULL;
+    guint32 ssrc;
+
+    if (!get_rtp_ssrc (buf, &ssrc)) {
+      GST_DEBUG_OBJECT (demux, "Dropping invalid RTP packet");
+      continue;
+    }
+
+    for (j = 0; j < sublists->len; j++) {
+      sub = &g_array_index (sublists, SsrcBufferList, j);
+      if (sub->ssrc == ssrc)
+        break;
+      sub = NULL;
+    }
+
+    if (sub == NULL) {
+      SsrcBufferList new_sub;
+
+      new_sub.ssrc = ssrc;
+      new_sub.list = gst_buffer_list_new_sized (len - i);
+      g_array_append_val (sublists, new_sub);
+      sub = &g_array_index (sublists, SsrcBufferList, sublists->len - 1);
+    }
+
+    gst_buffer_list_add (sub->list, gst_buffer_ref (buf));
+  }
+  gst_buffer_list_unref (list);
+
+  GST_LOG_OBJECT (demux, "received list of %u buffers for %u SSRCs", len,
+      sublists->len);
+
+  /* keep pushing to the other SSRCs when one of them fails, and report the
+   * first error upstream */
+  for (j = 0; j < sublists->len; j++) {
+    SsrcBufferList *sub = &g_array_index (sublists, SsrcBufferList, j);
+    GstFlowReturn sub_ret;
+
+    sub_ret = gst_rtp_ssrc_demux_push_rtp (demux, sub->ssrc, NULL, sub->list);
+    if (ret == GST_FLOW_OK)
+      ret = sub_ret;
+  }
+  g_array_free (sublists, TRUE);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_rtp_ssrc_demux_rtcp_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf)
@@ -40,6 +40,7 @@ struct _GstRtpSsrcDemux
 
   GRecMutex padlock;
   GSList *srcpads;
+  GHashTable *srcpads_by_ssrc;
   guint max_streams;
   guint err_num;
 };
@@ -87,6 +87,7 @@
 #include <gst/rtp/gstrtpbuffer.h>
 
 #include "gstrtpst2022-1-fecdec.h"
+#include "rtpstfecorc.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_rtpst_2022_1_fecdec_debug);
 #define GST_CAT_DEFAULT gst_rtpst_2022_1_fecdec_debug
@@ -369,26 +370,6 @@ done:
   return ret;
 }
 
-static void
-_xor_mem (guint8 * restrict dst, const guint8 * restrict src, gsize length)
-{
-  guint i;
-
-  for (i = 0; i < (length / sizeof (guint64)); ++i) {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-    GST_WRITE_UINT64_LE (dst,
-        GST_READ_UINT64_LE (dst) ^ GST_READ_UINT64_LE (src));
-#else
-    GST_WRITE_UINT64_BE (dst,
-        GST_READ_UINT64_BE (dst) ^ GST_READ_UINT64_BE (src));
-#endif
-    dst += sizeof (guint64);
-    src += sizeof (guint64);
-  }
-  for (i = 0; i < (length % sizeof (guint64)); ++i)
-    dst[i] ^= src[i];
-}
-
 static GstFlowReturn
 xor_items (GstRTPST_2022_1_FecDec * dec, Rtp2DFecHeader * fec, GList * packets,
     guint16 seqnum)
@@ -441,7 +422,7 @@ xor_items (GstRTPST_2022_1_FecDec * dec, Rtp2DFecHeader * fec, GList * packets,
     Item *item = (Item *) tmp->data;
 
     gst_rtp_buffer_map (item->buffer, GST_MAP_READ, &media_rtp);
-    _xor_mem (xored, gst_rtp_buffer_get_payload (&media_rtp),
+    rtp_st_fec_orc_xor (xored, gst_rtp_buffer_get_payload (&media_rtp),
         MIN (gst_rtp_buffer_get_payload_len (&media_rtp), xored_payload_len));
     xored_timestamp ^= gst_rtp_buffer_get_timestamp (&media_rtp);
     xored_pt ^= gst_rtp_buffer_get_payload_type (&media_rtp);
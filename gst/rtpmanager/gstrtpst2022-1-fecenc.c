@@ -69,6 +69,7 @@
 #include <gst/rtp/gstrtpbuffer.h>
 
 #include "gstrtpst2022-1-fecenc.h"
+#include "rtpstfecorc.h"
 
 #if !GLIB_CHECK_VERSION(2, 60, 0)
 #define g_queue_clear_full queue_clear_full
@@ -232,26 +233,6 @@ free_fec_packet (FecPacket * packet)
   g_free (packet);
 }
 
-static void
-_xor_mem (guint8 * restrict dst, const guint8 * restrict src, gsize length)
-{
-  guint i;
-
-  for (i = 0; i < (length / sizeof (guint64)); ++i) {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-    GST_WRITE_UINT64_LE (dst,
-        GST_READ_UINT64_LE (dst) ^ GST_READ_UINT64_LE (src));
-#else
-    GST_WRITE_UINT64_BE (dst,
-        GST_READ_UINT64_BE (dst) ^ GST_READ_UINT64_BE (src));
-#endif
-    dst += sizeof (guint64);
-    src += sizeof (guint64);
-  }
-  for (i = 0; i < (length % sizeof (guint64)); ++i)
-    dst[i] ^= src[i];
-}
-
 static void
 fec_packet_update (FecPacket * fec, GstRTPBuffer * rtp)
 {
@@ -284,7 +265,8 @@ fec_packet_update (FecPacket * fec, GstRTPBuffer * rtp)
     fec->xored_marker ^= gst_rtp_buffer_get_marker (rtp);
     fec->xored_padding ^= gst_rtp_buffer_get_padding (rtp);
     fec->xored_extension ^= gst_rtp_buffer_get_extension (rtp);
-    _xor_mem (fec->xored_payload, gst_rtp_buffer_get_payload (rtp), plen);
+    rtp_st_fec_orc_xor (fec->xored_payload, gst_rtp_buffer_get_payload (rtp),
+        plen);
   }
 
   fec->n_packets += 1;
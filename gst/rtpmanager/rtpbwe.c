@@ -0,0 +1,457 @@
+/* GStreamer
+ * Copyright (C) 2021 Pexip (http://pexip.com/)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <math.h>
+
+#include "rtpbwe.h"
+#include "rtptwcc.h"
+
+GST_DEBUG_CATEGORY_EXTERN (rtp_session_debug);
+#define GST_CAT_DEFAULT rtp_session_debug
+
+/* The delay-based part follows the trendline estimator and AIMD rate
+ * controller of draft-ietf-rmcat-gcc, the loss-based part its
+ * loss-based controller. */
+
+/* packets sent this close to the first one of a group form one burst */
+#define BURST_TIME (5 * GST_MSECOND)
+
+#define TRENDLINE_SMOOTHING   0.9
+#define TRENDLINE_GAIN        4.0
+#define TRENDLINE_MAX_DELTAS  60
+
+/* all in ms */
+#define OVERUSE_TIME_THRESHOLD 10.0
+#define THRESHOLD_INITIAL      12.5
+#define THRESHOLD_MIN          6.0
+#define THRESHOLD_MAX          600.0
+#define THRESHOLD_MAX_JUMP     15.0
+#define THRESHOLD_MAX_DT       100.0
+#define THRESHOLD_K_UP         0.0087
+#define THRESHOLD_K_DOWN       0.039
+
+#define DECREASE_FACTOR           0.85
+#define INCREASE_FACTOR_PER_SEC   1.08
+#define ADDITIVE_INCREASE_BITS    (1200 * 8)
+#define RESPONSE_TIME             0.2
+#define MAX_ACKED_RATIO           1.5
+#define MAX_ACKED_MARGIN          10000
+
+#define LOSS_HIGH                 0.10
+#define LOSS_LOW                  0.02
+#define LOSS_INCREASE_FACTOR      1.05
+
+#define CAPACITY_SMOOTHING        0.05
+#define CAPACITY_VAR_MIN          0.4
+#define CAPACITY_VAR_MAX          2.5
+
+#define TIME_TO_MS(t) ((gdouble) (t) / GST_MSECOND)
+
+const gchar *
+rtp_bwe_state_get_name (RTPBweState state)
+{
+  switch (state) {
+    case RTP_BWE_STATE_HOLD:
+      return "hold";
+    case RTP_BWE_STATE_INCREASE:
+      return "increase";
+    case RTP_BWE_STATE_DECREASE:
+      return "decrease";
+  }
+  return "unknown";
+}
+
+RTPBandwidthEstimator *
+rtp_bwe_new (void)
+{
+  RTPBandwidthEstimator *bwe = g_new0 (RTPBandwidthEstimator, 1);
+  bwe->max_bitrate = G_MAXUINT;
+  rtp_bwe_reset (bwe, 0);
+  return bwe;
+}
+
+void
+rtp_bwe_free (RTPBandwidthEstimator * bwe)
+{
+  g_free (bwe);
+}
+
+void
+rtp_bwe_reset (RTPBandwidthEstimator * bwe, guint start_bitrate)
+{
+  bwe->have_group = FALSE;
+  bwe->prev_local_ts = GST_CLOCK_TIME_NONE;
+  bwe->prev_remote_ts = GST_CLOCK_TIME_NONE;
+
+  bwe->accumulated_delay = 0.0;
+  bwe->smoothed_delay = 0.0;
+  bwe->window_len = 0;
+  bwe->window_pos = 0;
+  bwe->num_deltas = 0;
+  bwe->trend = 0.0;
+  bwe->prev_trend = 0.0;
+
+  bwe->threshold = THRESHOLD_INITIAL;
+  bwe->last_threshold_update = -1.0;
+  bwe->time_over_using = -1.0;
+  bwe->overuse_counter = 0;
+  bwe->usage = RTP_BWE_USAGE_NORMAL;
+
+  bwe->state = RTP_BWE_STATE_HOLD;
+  bwe->delay_bitrate =
+      CLAMP (start_bitrate, bwe->min_bitrate, bwe->max_bitrate);
+  bwe->loss_bitrate = bwe->delay_bitrate;
+  bwe->avg_max_bitrate = -1.0;
+  bwe->var_max_bitrate = CAPACITY_VAR_MIN;
+  bwe->last_update = GST_CLOCK_TIME_NONE;
+  bwe->last_decrease = GST_CLOCK_TIME_NONE;
+  bwe->probing = FALSE;
+}
+
+void
+rtp_bwe_set_bitrate_limits (RTPBandwidthEstimator * bwe,
+    guint min_bitrate, guint max_bitrate)
+{
+  bwe->min_bitrate = min_bitrate;
+  bwe->max_bitrate = MAX (min_bitrate, max_bitrate);
+  bwe->delay_bitrate =
+      CLAMP (bwe->delay_bitrate, bwe->min_bitrate, bwe->max_bitrate);
+  bwe->loss_bitrate =
+      CLAMP (bwe->loss_bitrate, bwe->min_bitrate, bwe->max_bitrate);
+}
+
+guint
+rtp_bwe_get_bitrate (RTPBandwidthEstimator * bwe)
+{
+  return (guint) MIN (bwe->delay_bitrate, bwe->loss_bitrate);
+}
+
+static gboolean
+rtp_bwe_trendline_slope (RTPBandwidthEstimator * bwe, gdouble * slope)
+{
+  gdouble sum_x = 0.0, sum_y = 0.0;
+  gdouble avg_x, avg_y;
+  gdouble num = 0.0, den = 0.0;
+  guint i;
+
+  for (i = 0; i < bwe->window_len; i++) {
+    sum_x += bwe->window_x[i];
+    sum_y += bwe->window_y[i];
+  }
+  avg_x = sum_x / bwe->window_len;
+  avg_y = sum_y / bwe->window_len;
+
+  for (i = 0; i < bwe->window_len; i++) {
+    gdouble dx = bwe->window_x[i] - avg_x;
+    num += dx * (bwe->window_y[i] - avg_y);
+    den += dx * dx;
+  }
+
+  if (den == 0.0)
+    return FALSE;
+
+  *slope = num / den;
+  return TRUE;
+}
+
+static void
+rtp_bwe_update_threshold (RTPBandwidthEstimator * bwe, gdouble modified_trend,
+    gdouble now)
+{
+  gdouble abs_trend = fabs (modified_trend);
+  gdouble k, dt;
+
+  if (bwe->last_threshold_update < 0.0)
+    bwe->last_threshold_update = now;
+
+  /* don't let single spikes drag the threshold along */
+  if (abs_trend > bwe->threshold + THRESHOLD_MAX_JUMP) {
+    bwe->last_threshold_update = now;
+    return;
+  }
+
+  k = abs_trend < bwe->threshold ? THRESHOLD_K_DOWN : THRESHOLD_K_UP;
+  dt = MIN (now - bwe->last_threshold_update, THRESHOLD_MAX_DT);
+  bwe->threshold += k * (abs_trend - bwe->threshold) * dt;
+  bwe->threshold = CLAMP (bwe->threshold, THRESHOLD_MIN, THRESHOLD_MAX);
+  bwe->last_threshold_update = now;
+}
+
+static void
+rtp_bwe_detect (RTPBandwidthEstimator * bwe, gdouble send_delta,
+    gdouble now)
+{
+  gdouble modified_trend;
+
+  if (bwe->num_deltas < 2) {
+    bwe->usage = RTP_BWE_USAGE_NORMAL;
+    return;
+  }
+
+  modified_trend = MIN (bwe->num_deltas, TRENDLINE_MAX_DELTAS) *
+      bwe->trend * TRENDLINE_GAIN;
+
+  if (modified_trend > bwe->threshold) {
+    if (bwe->time_over_using < 0.0)
+      bwe->time_over_using = send_delta / 2;
+    else
+      bwe->time_over_using += send_delta;
+    bwe->overuse_counter++;
+
+    if (bwe->time_over_using > OVERUSE_TIME_THRESHOLD &&
+        bwe->overuse_counter > 1 && bwe->trend >= bwe->prev_trend) {
+      bwe->time_over_using = 0.0;
+      bwe->overuse_counter = 0;
+      bwe->usage = RTP_BWE_USAGE_OVERUSING;
+    }
+  } else if (modified_trend < -bwe->threshold) {
+    bwe->time_over_using = -1.0;
+    bwe->overuse_counter = 0;
+    bwe->usage = RTP_BWE_USAGE_UNDERUSING;
+  } else {
+    bwe->time_over_using = -1.0;
+    bwe->overuse_counter = 0;
+    bwe->usage = RTP_BWE_USAGE_NORMAL;
+  }
+
+  GST_LOG ("trend: %f, modified trend: %f, threshold: %f, usage: %d",
+      bwe->trend, modified_trend, bwe->threshold, bwe->usage);
+
+  bwe->prev_trend = bwe->trend;
+  rtp_bwe_update_threshold (bwe, modified_trend, now);
+}
+
+static void
+rtp_bwe_trendline_update (RTPBandwidthEstimator * bwe, gdouble delay,
+    gdouble send_delta, gdouble arrival)
+{
+  gdouble slope;
+
+  if (bwe->num_deltas == 0)
+    bwe->first_arrival = arrival;
+  bwe->num_deltas = MIN (bwe->num_deltas + 1, 1000);
+
+  bwe->accumulated_delay += delay;
+  bwe->smoothed_delay = TRENDLINE_SMOOTHING * bwe->smoothed_delay +
+      (1.0 - TRENDLINE_SMOOTHING) * bwe->accumulated_delay;
+
+  bwe->window_x[bwe->window_pos] = arrival - bwe->first_arrival;
+  bwe->window_y[bwe->window_pos] = bwe->smoothed_delay;
+  bwe->window_pos = (bwe->window_pos + 1) % RTP_BWE_TRENDLINE_WINDOW_SIZE;
+  bwe->window_len = MIN (bwe->window_len + 1, RTP_BWE_TRENDLINE_WINDOW_SIZE);
+
+  if (bwe->window_len == RTP_BWE_TRENDLINE_WINDOW_SIZE &&
+      rtp_bwe_trendline_slope (bwe, &slope))
+    bwe->trend = slope;
+
+  rtp_bwe_detect (bwe, send_delta, arrival);
+}
+
+static void
+rtp_bwe_add_packet (RTPBandwidthEstimator * bwe, GstClockTime local_ts,
+    GstClockTime remote_ts)
+{
+  GstClockTimeDiff send_delta, recv_delta;
+
+  if (!bwe->have_group)
+    goto new_group;
+
+  /* sent before the current group, too late to be of any use */
+  if (local_ts < bwe->group_first_local_ts)
+    return;
+
+  if (local_ts - bwe->group_first_local_ts < BURST_TIME) {
+    bwe->group_last_local_ts = MAX (bwe->group_last_local_ts, local_ts);
+    bwe->group_last_remote_ts = MAX (bwe->group_last_remote_ts, remote_ts);
+    return;
+  }
+
+  /* the current group is complete, compare it with the previous one */
+  if (GST_CLOCK_TIME_IS_VALID (bwe->prev_local_ts)) {
+    send_delta = GST_CLOCK_DIFF (bwe->prev_local_ts, bwe->group_last_local_ts);
+    recv_delta =
+        GST_CLOCK_DIFF (bwe->prev_remote_ts, bwe->group_last_remote_ts);
+    rtp_bwe_trendline_update (bwe, TIME_TO_MS (recv_delta - send_delta),
+        TIME_TO_MS (send_delta), TIME_TO_MS (bwe->group_last_remote_ts));
+  }
+  bwe->prev_local_ts = bwe->group_last_local_ts;
+  bwe->prev_remote_ts = bwe->group_last_remote_ts;
+
+new_group:
+  bwe->have_group = TRUE;
+  bwe->group_first_local_ts = local_ts;
+  bwe->group_last_local_ts = local_ts;
+  bwe->group_last_remote_ts = remote_ts;
+}
+
+/* keeps track of the acked bitrate at which we had to back off before,
+ * in kbps, to tell when we are close to the link capacity */
+static void
+rtp_bwe_update_capacity (RTPBandwidthEstimator * bwe, gdouble acked_kbps)
+{
+  gdouble norm;
+
+  if (bwe->avg_max_bitrate < 0.0)
+    bwe->avg_max_bitrate = acked_kbps;
+  else
+    bwe->avg_max_bitrate = (1.0 - CAPACITY_SMOOTHING) * bwe->avg_max_bitrate +
+        CAPACITY_SMOOTHING * acked_kbps;
+
+  norm = MAX (bwe->avg_max_bitrate, 1.0);
+  bwe->var_max_bitrate = (1.0 - CAPACITY_SMOOTHING) * bwe->var_max_bitrate +
+      CAPACITY_SMOOTHING * (bwe->avg_max_bitrate - acked_kbps) *
+      (bwe->avg_max_bitrate - acked_kbps) / norm;
+  bwe->var_max_bitrate =
+      CLAMP (bwe->var_max_bitrate, CAPACITY_VAR_MIN, CAPACITY_VAR_MAX);
+}
+
+static void
+rtp_bwe_update_delay_based (RTPBandwidthEstimator * bwe, guint acked_bitrate,
+    GstClockTime current_time)
+{
+  gdouble acked_kbps = acked_bitrate / 1000.0;
+  gdouble bitrate = bwe->delay_bitrate;
+  gdouble dt = 0.0;
+
+  switch (bwe->usage) {
+    case RTP_BWE_USAGE_NORMAL:
+      if (bwe->state == RTP_BWE_STATE_HOLD)
+        bwe->state = RTP_BWE_STATE_INCREASE;
+      else if (bwe->state == RTP_BWE_STATE_DECREASE)
+        bwe->state = RTP_BWE_STATE_HOLD;
+      break;
+    case RTP_BWE_USAGE_OVERUSING:
+      bwe->state = RTP_BWE_STATE_DECREASE;
+      break;
+    case RTP_BWE_USAGE_UNDERUSING:
+      bwe->state = RTP_BWE_STATE_HOLD;
+      break;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (bwe->last_update) &&
+      current_time > bwe->last_update)
+    dt = MIN ((gdouble) (current_time - bwe->last_update) / GST_SECOND, 1.0);
+  bwe->last_update = current_time;
+
+  /* the acked bitrate went well above the capacity we knew of */
+  if (bwe->avg_max_bitrate >= 0.0 && acked_bitrate > 0) {
+    gdouble std = sqrt (bwe->var_max_bitrate * bwe->avg_max_bitrate);
+    if (acked_kbps > bwe->avg_max_bitrate + 3 * std)
+      bwe->avg_max_bitrate = -1.0;
+  }
+
+  switch (bwe->state) {
+    case RTP_BWE_STATE_HOLD:
+      bwe->probing = FALSE;
+      break;
+    case RTP_BWE_STATE_INCREASE:
+    {
+      gdouble limit;
+
+      if (bwe->avg_max_bitrate >= 0.0) {
+        /* close to the capacity, about one packet per response time */
+        bitrate += ADDITIVE_INCREASE_BITS / RESPONSE_TIME * dt;
+        bwe->probing = FALSE;
+      } else {
+        bitrate *= pow (INCREASE_FACTOR_PER_SEC, dt);
+        bwe->probing = TRUE;
+      }
+
+      /* don't run far ahead of what actually gets through */
+      if (acked_bitrate > 0) {
+        limit = MAX_ACKED_RATIO * acked_bitrate + MAX_ACKED_MARGIN;
+        if (bitrate > limit)
+          bitrate = MAX (bwe->delay_bitrate, limit);
+      }
+      break;
+    }
+    case RTP_BWE_STATE_DECREASE:
+      bwe->probing = FALSE;
+
+      /* give the previous decrease time to take effect */
+      if (GST_CLOCK_TIME_IS_VALID (bwe->last_decrease) &&
+          current_time < bwe->last_decrease + RESPONSE_TIME * GST_SECOND)
+        break;
+      bwe->last_decrease = current_time;
+
+      if (acked_bitrate > 0) {
+        bitrate = MIN (bitrate, DECREASE_FACTOR * acked_bitrate);
+        rtp_bwe_update_capacity (bwe, acked_kbps);
+      } else {
+        bitrate *= DECREASE_FACTOR;
+      }
+      break;
+  }
+
+  bwe->delay_bitrate = CLAMP (bitrate, bwe->min_bitrate, bwe->max_bitrate);
+}
+
+static void
+rtp_bwe_update_loss_based (RTPBandwidthEstimator * bwe, gdouble loss)
+{
+  gdouble bitrate = bwe->loss_bitrate;
+
+  if (loss > LOSS_HIGH) {
+    bitrate *= 1.0 - 0.5 * loss;
+  } else if (loss < LOSS_LOW) {
+    /* follow the delay-based estimate, so that a loss episode backs
+     * off from the rate we are actually sending at */
+    bitrate = MIN (bitrate * LOSS_INCREASE_FACTOR,
+        MAX (bitrate, bwe->delay_bitrate));
+  }
+
+  bwe->loss_bitrate = CLAMP (bitrate, bwe->min_bitrate, bwe->max_bitrate);
+}
+
+void
+rtp_bwe_process_packets (RTPBandwidthEstimator * bwe, GArray * twcc_packets,
+    guint acked_bitrate, GstClockTime current_time)
+{
+  guint packets_lost = 0;
+  guint packets = 0;
+  guint i;
+
+  for (i = 0; i < twcc_packets->len; i++) {
+    RTPTWCCPacket *pkt = &g_array_index (twcc_packets, RTPTWCCPacket, i);
+
+    /* without a send time the packet was not sent by us */
+    if (!GST_CLOCK_TIME_IS_VALID (pkt->local_ts))
+      continue;
+
+    packets++;
+    if (pkt->status == RTP_TWCC_PACKET_STATUS_NOT_RECV ||
+        !GST_CLOCK_TIME_IS_VALID (pkt->remote_ts)) {
+      packets_lost++;
+      continue;
+    }
+
+    rtp_bwe_add_packet (bwe, pkt->local_ts, pkt->remote_ts);
+  }
+
+  if (packets == 0)
+    return;
+
+  rtp_bwe_update_delay_based (bwe, acked_bitrate, current_time);
+  rtp_bwe_update_loss_based (bwe, (gdouble) packets_lost / packets);
+
+  GST_DEBUG ("estimate: %u bps (delay-based: %.0f, loss-based: %.0f), "
+      "state: %s, probing: %d, acked: %u bps, lost %u/%u",
+      rtp_bwe_get_bitrate (bwe), bwe->delay_bitrate, bwe->loss_bitrate,
+      rtp_bwe_state_get_name (bwe->state), bwe->probing, acked_bitrate,
+      packets_lost, packets);
+}
@@ -0,0 +1,105 @@
+/* GStreamer
+ * Copyright (C) 2021 Pexip (http://pexip.com/)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __RTP_BWE_H__
+#define __RTP_BWE_H__
+
+#include <gst/gst.h>
+
+#define RTP_BWE_TRENDLINE_WINDOW_SIZE 20
+
+typedef enum
+{
+  RTP_BWE_USAGE_NORMAL,
+  RTP_BWE_USAGE_UNDERUSING,
+  RTP_BWE_USAGE_OVERUSING,
+} RTPBweUsage;
+
+typedef enum
+{
+  RTP_BWE_STATE_HOLD,
+  RTP_BWE_STATE_INCREASE,
+  RTP_BWE_STATE_DECREASE,
+} RTPBweState;
+
+/**
+ * RTPBandwidthEstimator:
+ *
+ * Send-side bandwidth estimator fed with parsed TWCC feedback. The target
+ * bitrate is the lowest of a delay-based estimate, using a trendline filter
+ * on the inter-group delay variation and AIMD rate control, and a
+ * loss-based estimate.
+ */
+typedef struct {
+  guint min_bitrate;
+  guint max_bitrate;
+
+  /* packet group being accumulated */
+  gboolean have_group;
+  GstClockTime group_first_local_ts;
+  GstClockTime group_last_local_ts;
+  GstClockTime group_last_remote_ts;
+
+  /* last completed group */
+  GstClockTime prev_local_ts;
+  GstClockTime prev_remote_ts;
+
+  /* trendline filter, times in ms */
+  gdouble first_arrival;
+  gdouble accumulated_delay;
+  gdouble smoothed_delay;
+  gdouble window_x[RTP_BWE_TRENDLINE_WINDOW_SIZE];
+  gdouble window_y[RTP_BWE_TRENDLINE_WINDOW_SIZE];
+  guint window_len;
+  guint window_pos;
+  guint num_deltas;
+  gdouble trend;
+  gdouble prev_trend;
+
+  /* overuse detector, times in ms */
+  gdouble threshold;
+  gdouble last_threshold_update;
+  gdouble time_over_using;
+  guint overuse_counter;
+  RTPBweUsage usage;
+
+  /* rate control */
+  RTPBweState state;
+  gdouble delay_bitrate;
+  gdouble loss_bitrate;
+  gdouble avg_max_bitrate;
+  gdouble var_max_bitrate;
+  GstClockTime last_update;
+  GstClockTime last_decrease;
+  gboolean probing;
+} RTPBandwidthEstimator;
+
+RTPBandwidthEstimator * rtp_bwe_new (void);
+void rtp_bwe_free (RTPBandwidthEstimator * bwe);
+void rtp_bwe_reset (RTPBandwidthEstimator * bwe, guint start_bitrate);
+void rtp_bwe_set_bitrate_limits (RTPBandwidthEstimator * bwe,
+    guint min_bitrate, guint max_bitrate);
+
+void rtp_bwe_process_packets (RTPBandwidthEstimator * bwe,
+    GArray * twcc_packets, guint acked_bitrate, GstClockTime current_time);
+
+guint rtp_bwe_get_bitrate (RTPBandwidthEstimator * bwe);
+const gchar * rtp_bwe_state_get_name (RTPBweState state);
+
+#endif /* __RTP_BWE_H__ */
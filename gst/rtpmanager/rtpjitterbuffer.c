@@ -30,6 +30,11 @@ GST_DEBUG_CATEGORY_STATIC (rtp_jitter_buffer_debug);
 #define MAX_WINDOW	RTP_JITTER_BUFFER_MAX_WINDOW
 #define MAX_TIME	(2 * GST_SECOND)
 
+/* initial size of the seqnum indexed slot array */
+#define MIN_SLOTS	256
+/* slots per word of the in-use bitmap */
+#define SLOT_BITS	(sizeof (gulong) * 8)
+
 /* signals and args */
 enum
 {
@@ -88,6 +93,9 @@ rtp_jitter_buffer_init (RTPJitterBuffer * jbuf)
   g_mutex_init (&jbuf->clock_lock);
 
   g_queue_init (&jbuf->packets);
+  jbuf->slots = g_new0 (RTPJitterBufferItem *, MIN_SLOTS);
+  jbuf->slots_used = g_new0 (gulong, MIN_SLOTS / SLOT_BITS);
+  jbuf->slots_mask = MIN_SLOTS - 1;
   jbuf->mode = RTP_JITTER_BUFFER_MODE_SLAVE;
 
   rtp_jitter_buffer_reset_skew (jbuf);
@@ -116,6 +124,10 @@ rtp_jitter_buffer_finalize (GObject * object)
    * g_slice_free() which may lead to data corruption in the slice allocator.
    */
   rtp_jitter_buffer_flush (jbuf, NULL, NULL);
+  g_free (jbuf->slots);
+  g_free (jbuf->slots_used);
+  if (jbuf->item_pool)
+    rtp_object_pool_unref (jbuf->item_pool);
 
   g_mutex_clear (&jbuf->clock_lock);
 
@@ -322,6 +334,24 @@ rtp_jitter_buffer_set_rfc7273_sync (RTPJitterBuffer * jbuf,
   jbuf->rfc7273_sync = rfc7273_sync;
 }
 
+/**
+ * rtp_jitter_buffer_set_item_pool:
+ * @jbuf: an #RTPJitterBuffer
+ * @pool: (transfer none): an #RtpObjectPool
+ *
+ * Allocate the items of @jbuf from @pool. The objects of @pool must be at
+ * least the size of an #RTPJitterBufferItem.
+ */
+void
+rtp_jitter_buffer_set_item_pool (RTPJitterBuffer * jbuf, RtpObjectPool * pool)
+{
+  if (pool)
+    rtp_object_pool_ref (pool);
+  if (jbuf->item_pool)
+    rtp_object_pool_unref (jbuf->item_pool);
+  jbuf->item_pool = pool;
+}
+
 /**
  * rtp_jitter_buffer_reset_skew:
  * @jbuf: an #RTPJitterBuffer
@@ -700,6 +730,132 @@ queue_do_insert (RTPJitterBuffer * jbuf, GList * list, GList * item)
   queue->length++;
 }
 
+/* Rebuild the slot array with @size entries. When two packets in the queue
+ * end up in the same slot we keep doubling the size, with 65536 entries
+ * every seqnum has its own slot. Should the queue span more than the seqnum
+ * range, the newest packet with a given seqnum owns the slot. */
+static void
+slots_resize (RTPJitterBuffer * jbuf, guint size)
+{
+  RTPJitterBufferItem **slots;
+  gulong *used;
+  GList *l;
+
+again:
+  slots = g_new0 (RTPJitterBufferItem *, size);
+  used = g_new0 (gulong, size / SLOT_BITS);
+  for (l = jbuf->packets.head; l; l = l->next) {
+    RTPJitterBufferItem *item = (RTPJitterBufferItem *) l;
+    guint idx;
+
+    if (item->seqnum == -1)
+      continue;
+
+    idx = item->seqnum & (size - 1);
+    if (G_UNLIKELY (slots[idx] != NULL
+            && slots[idx]->seqnum != item->seqnum)) {
+      g_free (slots);
+      g_free (used);
+      size <<= 1;
+      goto again;
+    }
+    slots[idx] = item;
+    used[idx / SLOT_BITS] |= 1UL << (idx % SLOT_BITS);
+  }
+
+  GST_DEBUG ("resized slots from %u to %u", jbuf->slots_mask + 1, size);
+
+  g_free (jbuf->slots);
+  g_free (jbuf->slots_used);
+  jbuf->slots = slots;
+  jbuf->slots_used = used;
+  jbuf->slots_mask = size - 1;
+}
+
+static void
+slots_add (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item)
+{
+  guint idx = item->seqnum & jbuf->slots_mask;
+
+  if (G_UNLIKELY (jbuf->slots[idx] != NULL &&
+          jbuf->slots[idx]->seqnum != item->seqnum)) {
+    /* the item is already queued, the resize will pick it up */
+    slots_resize (jbuf, (jbuf->slots_mask + 1) << 1);
+    return;
+  }
+  jbuf->slots[idx] = item;
+  jbuf->slots_used[idx / SLOT_BITS] |= 1UL << (idx % SLOT_BITS);
+}
+
+static void
+slots_remove (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item)
+{
+  guint idx = item->seqnum & jbuf->slots_mask;
+
+  if (jbuf->slots[idx] == item) {
+    jbuf->slots[idx] = NULL;
+    jbuf->slots_used[idx / SLOT_BITS] &= ~(1UL << (idx % SLOT_BITS));
+  }
+}
+
+static inline RTPJitterBufferItem *
+slots_lookup (RTPJitterBuffer * jbuf, guint16 seqnum)
+{
+  RTPJitterBufferItem *item = jbuf->slots[seqnum & jbuf->slots_mask];
+
+  if (item && item->seqnum == seqnum)
+    return item;
+  return NULL;
+}
+
+/* Find the queued packet closest after @seqnum, less than @dist ahead. Only
+ * the slots in use are visited, a word of the bitmap at a time, so a large
+ * gap costs a few bit scans instead of a lookup per missing seqnum. */
+static RTPJitterBufferItem *
+slots_find_next (RTPJitterBuffer * jbuf, guint16 seqnum, guint16 dist)
+{
+  RTPJitterBufferItem *best = NULL;
+  guint size = jbuf->slots_mask + 1;
+  guint16 best_dist = dist;
+  guint pos, offset, remaining;
+
+  /* when the gap fits in the ring, every slot we visit maps to one seqnum
+   * of the gap and the first match is the closest. Otherwise a slot can
+   * hold a packet a multiple of the ring size further, check them all. */
+  remaining = MIN ((guint) dist - 1, size);
+  pos = (seqnum + 1) & jbuf->slots_mask;
+  offset = 1;
+
+  while (remaining > 0) {
+    guint bit = pos % SLOT_BITS;
+    guint n = MIN (SLOT_BITS - bit, remaining);
+    gulong bits = jbuf->slots_used[pos / SLOT_BITS] >> bit;
+
+    if (n < SLOT_BITS)
+      bits &= (1UL << n) - 1;
+
+    while (bits) {
+      guint i = g_bit_nth_lsf (bits, -1);
+      RTPJitterBufferItem *item = jbuf->slots[pos + i];
+      guint16 d = item->seqnum - seqnum;
+
+      if (d > 0 && d < best_dist) {
+        if (d == offset + i)
+          return item;
+        best = item;
+        best_dist = d;
+      }
+      bits &= bits - 1;
+    }
+
+    pos = (pos + n) & jbuf->slots_mask;
+    offset += n;
+    remaining -= n;
+  }
+
+  return best;
+}
+
 GstClockTime
 rtp_jitter_buffer_calculate_pts (RTPJitterBuffer * jbuf, GstClockTime dts,
     gboolean estimated_dts, guint32 rtptime, GstClockTime base_time,
@@ -1010,8 +1166,9 @@ static gboolean
 rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
     gboolean * head, gint * percent, gboolean prepend)
 {
-  GList *list, *event = NULL;
-  guint16 seqnum;
+  GList *list;
+  RTPJitterBufferItem *next;
+  guint16 seqnum, dist;
 
   g_return_val_if_fail (jbuf != NULL, FALSE);
   g_return_val_if_fail (item != NULL, FALSE);
@@ -1027,47 +1184,37 @@ rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
 
   seqnum = item->seqnum;
 
-  /* loop the list to skip strictly larger seqnum buffers */
-  for (; list; list = g_list_previous (list)) {
-    guint16 qseq;
-    gint gap;
-    RTPJitterBufferItem *qitem = (RTPJitterBufferItem *) list;
-
-    if (qitem->seqnum == -1) {
-      /* keep a pointer to the first consecutive event if not already
-       * set. we will insert the packet after the event if we can't find
-       * a packet with lower sequence number before the event. */
-      if (event == NULL)
-        event = list;
-      continue;
-    }
-
-    qseq = qitem->seqnum;
-
-    /* compare the new seqnum to the one in the buffer */
-    gap = gst_rtp_buffer_compare_seqnum (seqnum, qseq);
+  /* most packets are newer than anything we have, they go after the last
+   * packet and any events that were queued after it */
+  if (G_LIKELY (jbuf->last_packet == NULL ||
+          gst_rtp_buffer_compare_seqnum (seqnum,
+              jbuf->last_packet->seqnum) < 0)) {
+    jbuf->last_packet = item;
+    goto insert_packet;
+  }
 
-    /* we hit a packet with the same seqnum, notify a duplicate */
-    if (G_UNLIKELY (gap == 0))
-      goto duplicate;
+  if (G_UNLIKELY (slots_lookup (jbuf, seqnum) != NULL))
+    goto duplicate;
 
-    /* seqnum > qseq, we can stop looking */
-    if (G_LIKELY (gap < 0))
-      break;
+  /* find the closest newer packet and insert right before it, which puts us
+   * after the events that were queued between the older and the newer
+   * packet. The last packet is newer, so we always find one. */
+  dist = jbuf->last_packet->seqnum - seqnum;
+  next = slots_find_next (jbuf, seqnum, dist);
+  if (next == NULL)
+    next = jbuf->last_packet;
 
-    /* if we've found a packet with greater sequence number, cleanup the
-     * event pointer as the packet will be inserted before the event */
-    event = NULL;
-  }
+  list = ((GList *) next)->prev;
 
-  /* if event is set it means that packets before the event had smaller
-   * sequence number, so we will insert our packet after the event */
-  if (event)
-    list = event;
+insert_packet:
+  queue_do_insert (jbuf, list, (GList *) item);
+  slots_add (jbuf, item);
+  goto done;
 
 insert:
   queue_do_insert (jbuf, list, (GList *) item);
 
+done:
   /* buffering mode, update buffer stats */
   if (jbuf->mode == RTP_JITTER_BUFFER_MODE_BUFFER)
     update_buffer_level (jbuf, percent);
@@ -1095,6 +1242,7 @@ duplicate:
 
 /**
  * rtp_jitter_buffer_alloc_item:
+ * @jbuf: an #RTPJitterBuffer
  * @data: The data stored in this item
  * @type: User specific item type
  * @dts: Decoding Timestamp
@@ -1109,13 +1257,17 @@ duplicate:
  * Returns: a newly allocated RTPJitterbufferItem
  */
 static RTPJitterBufferItem *
-rtp_jitter_buffer_alloc_item (gpointer data, guint type, GstClockTime dts,
-    GstClockTime pts, guint seqnum, guint count, guint rtptime,
-    GDestroyNotify free_data)
+rtp_jitter_buffer_alloc_item (RTPJitterBuffer * jbuf, gpointer data,
+    guint type, GstClockTime dts, GstClockTime pts, guint seqnum, guint count,
+    guint rtptime, GDestroyNotify free_data)
 {
   RTPJitterBufferItem *item;
 
-  item = g_slice_new (RTPJitterBufferItem);
+  if (jbuf->item_pool)
+    item = rtp_object_pool_alloc (jbuf->item_pool);
+  else
+    item = g_slice_new (RTPJitterBufferItem);
+  item->pool = jbuf->item_pool;
   item->data = data;
   item->next = NULL;
   item->prev = NULL;
@@ -1131,10 +1283,10 @@ rtp_jitter_buffer_alloc_item (gpointer data, guint type, GstClockTime dts,
 }
 
 static inline RTPJitterBufferItem *
-alloc_event_item (GstEvent * event)
+alloc_event_item (RTPJitterBuffer * jbuf, GstEvent * event)
 {
-  return rtp_jitter_buffer_alloc_item (event, ITEM_TYPE_EVENT, -1, -1, -1, 0,
-      -1, (GDestroyNotify) gst_mini_object_unref);
+  return rtp_jitter_buffer_alloc_item (jbuf, event, ITEM_TYPE_EVENT, -1, -1,
+      -1, 0, -1, (GDestroyNotify) gst_mini_object_unref);
 }
 
 /**
@@ -1149,7 +1301,7 @@ alloc_event_item (GstEvent * event)
 gboolean
 rtp_jitter_buffer_append_event (RTPJitterBuffer * jbuf, GstEvent * event)
 {
-  RTPJitterBufferItem *item = alloc_event_item (event);
+  RTPJitterBufferItem *item = alloc_event_item (jbuf, event);
   gboolean head;
   rtp_jitter_buffer_insert (jbuf, item, &head, NULL, FALSE);
   return head;
@@ -1165,7 +1317,7 @@ rtp_jitter_buffer_append_event (RTPJitterBuffer * jbuf, GstEvent * event)
 void
 rtp_jitter_buffer_prepend_event (RTPJitterBuffer * jbuf, GstEvent * event)
 {
-  RTPJitterBufferItem *item = alloc_event_item (event);
+  RTPJitterBufferItem *item = alloc_event_item (jbuf, event);
   rtp_jitter_buffer_insert (jbuf, item, NULL, NULL, TRUE);
 }
 
@@ -1182,8 +1334,8 @@ gboolean
 rtp_jitter_buffer_append_query (RTPJitterBuffer * jbuf, GstQuery * query)
 {
   RTPJitterBufferItem *item =
-      rtp_jitter_buffer_alloc_item (query, ITEM_TYPE_QUERY, -1, -1, -1, 0, -1,
-      NULL);
+      rtp_jitter_buffer_alloc_item (jbuf, query, ITEM_TYPE_QUERY, -1, -1, -1,
+      0, -1, NULL);
   gboolean head;
   rtp_jitter_buffer_insert (jbuf, item, &head, NULL, FALSE);
   return head;
@@ -1204,7 +1356,7 @@ gboolean
 rtp_jitter_buffer_append_lost_event (RTPJitterBuffer * jbuf, GstEvent * event,
     guint16 seqnum, guint lost_packets)
 {
-  RTPJitterBufferItem *item = rtp_jitter_buffer_alloc_item (event,
+  RTPJitterBufferItem *item = rtp_jitter_buffer_alloc_item (jbuf, event,
       ITEM_TYPE_LOST, -1, -1, seqnum, lost_packets, -1,
       (GDestroyNotify) gst_mini_object_unref);
   gboolean head;
@@ -1235,7 +1387,7 @@ rtp_jitter_buffer_append_buffer (RTPJitterBuffer * jbuf, GstBuffer * buf,
     GstClockTime dts, GstClockTime pts, guint16 seqnum, guint rtptime,
     gboolean * duplicate, gint * percent)
 {
-  RTPJitterBufferItem *item = rtp_jitter_buffer_alloc_item (buf,
+  RTPJitterBufferItem *item = rtp_jitter_buffer_alloc_item (jbuf, buf,
       ITEM_TYPE_BUFFER, dts, pts, seqnum, 1, rtptime,
       (GDestroyNotify) gst_mini_object_unref);
   gboolean head;
@@ -1280,6 +1432,10 @@ rtp_jitter_buffer_pop (RTPJitterBuffer * jbuf, gint * percent)
     else
       queue->tail = NULL;
     queue->length--;
+
+    slots_remove (jbuf, (RTPJitterBufferItem *) item);
+    if (item == (GList *) jbuf->last_packet)
+      jbuf->last_packet = NULL;
   }
 
   /* buffering mode, update buffer stats */
@@ -1335,6 +1491,11 @@ rtp_jitter_buffer_flush (RTPJitterBuffer * jbuf, GFunc free_func,
 
   while ((item = g_queue_pop_head_link (&jbuf->packets)))
     free_func ((RTPJitterBufferItem *) item, user_data);
+
+  memset (jbuf->slots, 0, (jbuf->slots_mask + 1) * sizeof (gpointer));
+  memset (jbuf->slots_used, 0,
+      (jbuf->slots_mask + 1) / SLOT_BITS * sizeof (gulong));
+  jbuf->last_packet = NULL;
 }
 
 /**
@@ -1463,12 +1624,9 @@ rtp_jitter_buffer_get_seqnum_diff (RTPJitterBuffer * jbuf)
 
   g_return_val_if_fail (jbuf != NULL, 0);
 
-  high_buf = (RTPJitterBufferItem *) g_queue_peek_tail_link (&jbuf->packets);
+  high_buf = jbuf->last_packet;
   low_buf = (RTPJitterBufferItem *) g_queue_peek_head_link (&jbuf->packets);
 
-  while (high_buf && high_buf->seqnum == -1)
-    high_buf = (RTPJitterBufferItem *) high_buf->prev;
-
   while (low_buf && low_buf->seqnum == -1)
     low_buf = (RTPJitterBufferItem *) low_buf->next;
 
@@ -1580,5 +1738,8 @@ rtp_jitter_buffer_free_item (RTPJitterBufferItem * item)
 
   if (item->data && item->free_data)
     item->free_data (item->data);
-  g_slice_free (RTPJitterBufferItem, item);
+  if (item->pool)
+    rtp_object_pool_free (item->pool, item);
+  else
+    g_slice_free (RTPJitterBufferItem, item);
 }
@@ -23,6 +23,8 @@
 #include <gst/gst.h>
 #include <gst/rtp/gstrtcpbuffer.h>
 
+#include "rtpobjectpool.h"
+
 typedef struct _RTPJitterBuffer RTPJitterBuffer;
 typedef struct _RTPJitterBufferClass RTPJitterBufferClass;
 typedef struct _RTPJitterBufferItem RTPJitterBufferItem;
@@ -74,6 +76,15 @@ struct _RTPJitterBuffer {
   GObject        object;
 
   GQueue         packets;
+  /* seqnum indexed view on the packets in the queue, events and queries
+   * only live in the queue */
+  RTPJitterBufferItem **slots;
+  /* bitmap of the slots in use */
+  gulong        *slots_used;
+  guint          slots_mask;
+  RTPJitterBufferItem *last_packet;
+
+  RtpObjectPool *item_pool;
 
   RTPJitterBufferMode mode;
 
@@ -136,6 +147,7 @@ struct _RTPJitterBufferClass {
  * @count: amount of seqnum in this item
  * @rtptime: rtp timestamp
  * @data_free: Function to free @data (optional)
+ * @pool: the #RtpObjectPool the item was allocated from, or %NULL
  *
  * An object containing an RTP packet or event. First members of this structure
  * copied from GList so they can be inserted into lists without doing more
@@ -156,6 +168,8 @@ struct _RTPJitterBufferItem {
   guint rtptime;
 
   GDestroyNotify free_data;
+
+  RtpObjectPool *pool;
 };
 
 GType rtp_jitter_buffer_get_type (void);
@@ -180,6 +194,8 @@ void                  rtp_jitter_buffer_set_rfc7273_sync (RTPJitterBuffer *jbuf,
 
 void                  rtp_jitter_buffer_reset_skew       (RTPJitterBuffer *jbuf);
 
+void                  rtp_jitter_buffer_set_item_pool    (RTPJitterBuffer *jbuf, RtpObjectPool *pool);
+
 
 void                  rtp_jitter_buffer_prepend_event     (RTPJitterBuffer * jbuf, GstEvent * event);
 gboolean              rtp_jitter_buffer_append_event      (RTPJitterBuffer * jbuf, GstEvent * event);
@@ -0,0 +1,158 @@
+/* GStreamer
+* Copyright (C) 2021 Pexip (http://pexip.com/)
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation; either
+* version 2 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+#include "rtpobjectpool.h"
+
+/* A pool of fixed size objects. Freed objects are kept on a free list, linked
+ * through their first pointer, and handed out again before falling back to
+ * the slice allocator. The pool is shared between the streaming threads, so
+ * objects may be allocated on one thread and freed on another. */
+struct _RtpObjectPool
+{
+  gint refcount;
+  GMutex lock;
+
+  gsize object_size;
+  gpointer free_list;
+  guint n_free;
+  guint max_free;
+
+  guint in_use;
+  guint high_water;
+  guint64 hits;
+  guint64 misses;
+};
+
+/**
+ * rtp_object_pool_new:
+ * @object_size: the size of the objects
+ * @max_free: the maximum number of freed objects to keep around
+ *
+ * Returns: a new #RtpObjectPool, use rtp_object_pool_unref() after usage.
+ */
+RtpObjectPool *
+rtp_object_pool_new (gsize object_size, guint max_free)
+{
+  RtpObjectPool *pool = g_new0 (RtpObjectPool, 1);
+
+  pool->refcount = 1;
+  g_mutex_init (&pool->lock);
+  pool->object_size = MAX (object_size, sizeof (gpointer));
+  pool->max_free = max_free;
+
+  return pool;
+}
+
+RtpObjectPool *
+rtp_object_pool_ref (RtpObjectPool * pool)
+{
+  g_atomic_int_inc (&pool->refcount);
+  return pool;
+}
+
+/**
+ * rtp_object_pool_unref:
+ * @pool: a #RtpObjectPool
+ *
+ * Drop a reference. All objects must have been returned to the pool before
+ * the last reference goes away.
+ */
+void
+rtp_object_pool_unref (RtpObjectPool * pool)
+{
+  if (!g_atomic_int_dec_and_test (&pool->refcount))
+    return;
+
+  g_warn_if_fail (pool->in_use == 0);
+
+  while (pool->free_list) {
+    gpointer object = pool->free_list;
+    pool->free_list = *(gpointer *) object;
+    g_slice_free1 (pool->object_size, object);
+  }
+  g_mutex_clear (&pool->lock);
+  g_free (pool);
+}
+
+/**
+ * rtp_object_pool_alloc:
+ * @pool: a #RtpObjectPool
+ *
+ * Returns: an uninitialized object, free with rtp_object_pool_free().
+ */
+gpointer
+rtp_object_pool_alloc (RtpObjectPool * pool)
+{
+  gpointer object;
+
+  g_mutex_lock (&pool->lock);
+  object = pool->free_list;
+  if (object) {
+    pool->free_list = *(gpointer *) object;
+    pool->n_free--;
+    pool->hits++;
+  } else {
+    pool->misses++;
+  }
+  pool->in_use++;
+  pool->high_water = MAX (pool->high_water, pool->in_use);
+  g_mutex_unlock (&pool->lock);
+
+  if (object == NULL)
+    object = g_slice_alloc (pool->object_size);
+
+  return object;
+}
+
+void
+rtp_object_pool_free (RtpObjectPool * pool, gpointer object)
+{
+  g_mutex_lock (&pool->lock);
+  pool->in_use--;
+  if (pool->n_free < pool->max_free) {
+    *(gpointer *) object = pool->free_list;
+    pool->free_list = object;
+    pool->n_free++;
+    object = NULL;
+  }
+  g_mutex_unlock (&pool->lock);
+
+  if (object)
+    g_slice_free1 (pool->object_size, object);
+}
+
+/**
+ * rtp_object_pool_get_stats:
+ * @pool: a #RtpObjectPool
+ * @hits: (out) (optional): allocations served from the free list
+ * @misses: (out) (optional): allocations that needed new memory
+ * @high_water: (out) (optional): the maximum number of objects in use at once
+ */
+void
+rtp_object_pool_get_stats (RtpObjectPool * pool, guint64 * hits,
+    guint64 * misses, guint * high_water)
+{
+  g_mutex_lock (&pool->lock);
+  if (hits)
+    *hits = pool->hits;
+  if (misses)
+    *misses = pool->misses;
+  if (high_water)
+    *high_water = pool->high_water;
+  g_mutex_unlock (&pool->lock);
+}
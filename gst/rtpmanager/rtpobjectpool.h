@@ -0,0 +1,36 @@
+/* GStreamer
+* Copyright (C) 2021 Pexip (http://pexip.com/)
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation; either
+* version 2 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+#ifndef __RTP_OBJECT_POOL_H__
+#define __RTP_OBJECT_POOL_H__
+
+#include <gst/gst.h>
+
+typedef struct _RtpObjectPool RtpObjectPool;
+
+RtpObjectPool * rtp_object_pool_new (gsize object_size, guint max_free);
+RtpObjectPool * rtp_object_pool_ref (RtpObjectPool * pool);
+void rtp_object_pool_unref (RtpObjectPool * pool);
+
+gpointer rtp_object_pool_alloc (RtpObjectPool * pool);
+void rtp_object_pool_free (RtpObjectPool * pool, gpointer object);
+
+void rtp_object_pool_get_stats (RtpObjectPool * pool, guint64 * hits,
+    guint64 * misses, guint * high_water);
+
+#endif /* __RTP_OBJECT_POOL_H__ */
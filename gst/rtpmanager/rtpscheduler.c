@@ -0,0 +1,195 @@
+/* GStreamer
+* Copyright (C) 2021 Pexip (http://pexip.com/)
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation; either
+* version 2 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+#include "rtpscheduler.h"
+
+/* A small, fixed set of worker threads shared by many sessions. Timeouts are
+ * registered as async waits on a clock, so all pending deadlines end up in
+ * the single wait queue of that clock, and the expired ones are handed to
+ * the workers. This replaces one sleeping thread per session with one clock
+ * thread and a handful of workers. */
+struct _RtpScheduler
+{
+  gint refcount;
+  GThreadPool *pool;
+};
+
+typedef struct
+{
+  gint refcount;
+  GThreadPool *pool;
+  GstClockID id;
+  RtpSchedulerFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} RtpSchedulerJob;
+
+static RtpSchedulerJob *
+rtp_scheduler_job_ref (RtpSchedulerJob * job)
+{
+  g_atomic_int_inc (&job->refcount);
+  return job;
+}
+
+static void
+rtp_scheduler_job_unref (RtpSchedulerJob * job)
+{
+  if (!g_atomic_int_dec_and_test (&job->refcount))
+    return;
+
+  if (job->notify)
+    job->notify (job->user_data);
+  g_free (job);
+}
+
+static void
+rtp_scheduler_worker (RtpSchedulerJob * job, gpointer user_data)
+{
+  GstClockID id = job->id;
+
+  job->func (id, job->user_data);
+
+  /* the entry holds a reference to the job, release it first */
+  job->id = NULL;
+  gst_clock_id_unref (id);
+  rtp_scheduler_job_unref (job);
+}
+
+static gboolean
+rtp_scheduler_clock_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    RtpSchedulerJob * job)
+{
+  /* keep the id alive until the job ran, so that it can't be mistaken for
+   * a new id at the same address. The clock drops its reference to the job
+   * when the entry goes away. */
+  job->id = gst_clock_id_ref (id);
+  g_thread_pool_push (job->pool, rtp_scheduler_job_ref (job), NULL);
+
+  return TRUE;
+}
+
+/**
+ * rtp_scheduler_new:
+ * @n_threads: the number of worker threads
+ *
+ * Returns: a new #RtpScheduler, use rtp_scheduler_unref() after usage.
+ */
+RtpScheduler *
+rtp_scheduler_new (guint n_threads)
+{
+  RtpScheduler *sched = g_new0 (RtpScheduler, 1);
+
+  sched->refcount = 1;
+  sched->pool = g_thread_pool_new ((GFunc) rtp_scheduler_worker, sched,
+      MAX (n_threads, 1), FALSE, NULL);
+
+  return sched;
+}
+
+RtpScheduler *
+rtp_scheduler_ref (RtpScheduler * sched)
+{
+  g_atomic_int_inc (&sched->refcount);
+  return sched;
+}
+
+/**
+ * rtp_scheduler_unref:
+ * @sched: a #RtpScheduler
+ *
+ * Drop a reference. The worker threads exit once they finished the job they
+ * are running, so this is safe to call from a job.
+ */
+void
+rtp_scheduler_unref (RtpScheduler * sched)
+{
+  if (!g_atomic_int_dec_and_test (&sched->refcount))
+    return;
+
+  g_thread_pool_free (sched->pool, FALSE, FALSE);
+  g_free (sched);
+}
+
+void
+rtp_scheduler_set_n_threads (RtpScheduler * sched, guint n_threads)
+{
+  g_thread_pool_set_max_threads (sched->pool, MAX (n_threads, 1), NULL);
+}
+
+guint
+rtp_scheduler_get_n_threads (RtpScheduler * sched)
+{
+  return g_thread_pool_get_max_threads (sched->pool);
+}
+
+/**
+ * rtp_scheduler_wait_async:
+ * @sched: a #RtpScheduler
+ * @id: a #GstClockID
+ * @func: function to call when @id fires
+ * @user_data: data passed to @func
+ * @notify: (nullable): called to free @user_data
+ *
+ * Call @func on one of the worker threads when @id fires. Cancel with
+ * gst_clock_id_unschedule(); @func might still be called when @id already
+ * fired, so callers should check that @id is still the one they expect.
+ * @notify is called once the wait is gone. When this function fails it is
+ * not called and @user_data is still owned by the caller.
+ * @user_data has to keep @sched alive while the wait is pending.
+ *
+ * Returns: %TRUE when the wait was scheduled.
+ */
+gboolean
+rtp_scheduler_wait_async (RtpScheduler * sched, GstClockID id,
+    RtpSchedulerFunc func, gpointer user_data, GDestroyNotify notify)
+{
+  RtpSchedulerJob *job;
+  GstClockReturn ret;
+
+  job = g_new0 (RtpSchedulerJob, 1);
+  job->refcount = 1;
+  job->pool = sched->pool;
+  job->func = func;
+  job->user_data = user_data;
+  job->notify = notify;
+
+  if (!GST_CLOCK_TIME_IS_VALID (gst_clock_id_get_time (id)))
+    goto invalid_time;
+
+  /* from here on the clock owns the job and releases it with the entry. Keep
+   * our own reference until we know whether the wait was scheduled. */
+  rtp_scheduler_job_ref (job);
+  ret = gst_clock_id_wait_async (id, (GstClockCallback) rtp_scheduler_clock_cb,
+      job, (GDestroyNotify) rtp_scheduler_job_unref);
+  if (ret != GST_CLOCK_OK) {
+    /* the clock can still release the job later, don't let that touch
+     * @user_data */
+    job->notify = NULL;
+  }
+  rtp_scheduler_job_unref (job);
+
+  return ret == GST_CLOCK_OK;
+
+  /* ERRORS */
+invalid_time:
+  {
+    job->notify = NULL;
+    rtp_scheduler_job_unref (job);
+    return FALSE;
+  }
+}
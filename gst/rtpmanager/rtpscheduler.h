@@ -0,0 +1,45 @@
+/* GStreamer
+* Copyright (C) 2021 Pexip (http://pexip.com/)
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation; either
+* version 2 of the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+#ifndef __RTP_SCHEDULER_H__
+#define __RTP_SCHEDULER_H__
+
+#include <gst/gst.h>
+
+typedef struct _RtpScheduler RtpScheduler;
+
+/**
+ * RtpSchedulerFunc:
+ * @id: the #GstClockID that fired
+ * @user_data: user data passed to rtp_scheduler_wait_async()
+ *
+ * Called from one of the scheduler worker threads.
+ */
+typedef void (*RtpSchedulerFunc) (GstClockID id, gpointer user_data);
+
+RtpScheduler * rtp_scheduler_new (guint n_threads);
+RtpScheduler * rtp_scheduler_ref (RtpScheduler * sched);
+void rtp_scheduler_unref (RtpScheduler * sched);
+
+void rtp_scheduler_set_n_threads (RtpScheduler * sched, guint n_threads);
+guint rtp_scheduler_get_n_threads (RtpScheduler * sched);
+
+gboolean rtp_scheduler_wait_async (RtpScheduler * sched, GstClockID id,
+    RtpSchedulerFunc func, gpointer user_data, GDestroyNotify notify);
+
+#endif /* __RTP_SCHEDULER_H__ */
@@ -83,6 +83,10 @@ enum
 #define DEFAULT_RTCP_REDUCED_SIZE    FALSE
 #define DEFAULT_RTCP_DISABLE_SR_TIMESTAMP FALSE
 #define DEFAULT_TWCC_FEEDBACK_INTERVAL GST_CLOCK_TIME_NONE
+#define DEFAULT_BANDWIDTH_ESTIMATION FALSE
+#define DEFAULT_BWE_START_BITRATE    300000
+#define DEFAULT_BWE_MIN_BITRATE      30000
+#define DEFAULT_BWE_MAX_BITRATE      10000000
 #define DEFAULT_STATS_NOTIFY_MIN_INTERVAL   0
 
 enum
@@ -113,6 +117,10 @@ enum
   PROP_RTCP_REDUCED_SIZE,
   PROP_RTCP_DISABLE_SR_TIMESTAMP,
   PROP_TWCC_FEEDBACK_INTERVAL,
+  PROP_BANDWIDTH_ESTIMATION,
+  PROP_BWE_START_BITRATE,
+  PROP_BWE_MIN_BITRATE,
+  PROP_BWE_MAX_BITRATE,
 };
 
 /* update average packet size */
@@ -733,6 +741,63 @@ rtp_session_class_init (RTPSessionClass * klass)
           0, G_MAXUINT64, DEFAULT_TWCC_FEEDBACK_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * RTPSession:bandwidth-estimation:
+   *
+   * Estimate the available send bandwidth from the TWCC feedback of the
+   * receivers. The estimate is combined from a delay-based and a loss-based
+   * estimator and is reported as the "estimated-bitrate", "bwe-state" and
+   * "bwe-probing" fields of the TWCC stats.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BANDWIDTH_ESTIMATION,
+      g_param_spec_boolean ("bandwidth-estimation", "Bandwidth Estimation",
+          "Estimate the available send bandwidth from TWCC feedback",
+          DEFAULT_BANDWIDTH_ESTIMATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * RTPSession:bwe-start-bitrate:
+   *
+   * The bitrate the bandwidth estimation starts from, in bits per second.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BWE_START_BITRATE,
+      g_param_spec_uint ("bwe-start-bitrate", "BWE Start Bitrate",
+          "The bitrate the bandwidth estimation starts from (in bps)",
+          0, G_MAXUINT, DEFAULT_BWE_START_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * RTPSession:bwe-min-bitrate:
+   *
+   * The lowest bitrate the bandwidth estimation will report, in bits per
+   * second.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BWE_MIN_BITRATE,
+      g_param_spec_uint ("bwe-min-bitrate", "BWE Min Bitrate",
+          "The lowest bitrate the bandwidth estimation will report (in bps)",
+          0, G_MAXUINT, DEFAULT_BWE_MIN_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * RTPSession:bwe-max-bitrate:
+   *
+   * The highest bitrate the bandwidth estimation will report, in bits per
+   * second.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BWE_MAX_BITRATE,
+      g_param_spec_uint ("bwe-max-bitrate", "BWE Max Bitrate",
+          "The highest bitrate the bandwidth estimation will report (in bps)",
+          0, G_MAXUINT, DEFAULT_BWE_MAX_BITRATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   klass->get_source_by_ssrc =
       GST_DEBUG_FUNCPTR (rtp_session_get_source_by_ssrc);
   klass->send_rtcp = GST_DEBUG_FUNCPTR (rtp_session_send_rtcp);
@@ -825,6 +890,13 @@ rtp_session_init (RTPSession * sess)
 
   sess->twcc = rtp_twcc_manager_new (sess->mtu);
   sess->twcc_stats = rtp_twcc_stats_new ();
+
+  sess->bwe = rtp_bwe_new ();
+  sess->bwe_enabled = DEFAULT_BANDWIDTH_ESTIMATION;
+  sess->bwe_start_bitrate = DEFAULT_BWE_START_BITRATE;
+  rtp_bwe_set_bitrate_limits (sess->bwe, DEFAULT_BWE_MIN_BITRATE,
+      DEFAULT_BWE_MAX_BITRATE);
+  rtp_bwe_reset (sess->bwe, sess->bwe_start_bitrate);
 }
 
 static void
@@ -848,6 +920,7 @@ rtp_session_finalize (GObject * object)
 
   g_object_unref (sess->twcc);
   rtp_twcc_stats_free (sess->twcc_stats);
+  rtp_bwe_free (sess->bwe);
 
   g_mutex_clear (&sess->lock);
 
@@ -885,26 +958,19 @@ rtp_session_create_sources (RTPSession * sess)
 }
 
 static void
-create_source_stats (gpointer key, RTPSource * source, GValueArray * arr)
+collect_source (gpointer key, RTPSource * source, GPtrArray * arr)
 {
-  GValue *value;
-  GstStructure *s;
-
-  g_object_get (source, "stats", &s, NULL);
-
-  g_value_array_append (arr, NULL);
-  value = g_value_array_get_nth (arr, arr->n_values - 1);
-  g_value_init (value, GST_TYPE_STRUCTURE);
-  g_value_take_boxed (value, s);
+  g_ptr_array_add (arr, g_object_ref (source));
 }
 
 static GstStructure *
 rtp_session_create_stats (RTPSession * sess)
 {
   GstStructure *s;
+  GPtrArray *sources;
   GValueArray *source_stats;
   GValue source_stats_v = G_VALUE_INIT;
-  guint size;
+  guint i;
 
   RTP_SESSION_LOCK (sess);
   s = gst_structure_new_id (quark_application_x_rtp_session_stats,
@@ -912,12 +978,30 @@ rtp_session_create_stats (RTPSession * sess)
       quark_sent_nack_count, G_TYPE_UINT, sess->stats.nacks_sent,
       quark_recv_nack_count, G_TYPE_UINT, sess->stats.nacks_received, NULL);
 
-  size = g_hash_table_size (sess->ssrcs[sess->mask_idx]);
-  source_stats = g_value_array_new (size);
+  sources = g_ptr_array_new_full (g_hash_table_size (sess->ssrcs
+          [sess->mask_idx]), g_object_unref);
   g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) create_source_stats, source_stats);
+      (GHFunc) collect_source, sources);
   RTP_SESSION_UNLOCK (sess);
 
+  /* only hold the lock for one source at a time, so that polling the stats
+   * of a session with many sources doesn't stall the streaming threads */
+  source_stats = g_value_array_new (sources->len);
+  for (i = 0; i < sources->len; i++) {
+    GValue *value;
+    GstStructure *src_stats;
+
+    RTP_SESSION_LOCK (sess);
+    src_stats = rtp_source_create_stats (g_ptr_array_index (sources, i));
+    RTP_SESSION_UNLOCK (sess);
+
+    g_value_array_append (source_stats, NULL);
+    value = g_value_array_get_nth (source_stats, source_stats->n_values - 1);
+    g_value_init (value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (value, src_stats);
+  }
+  g_ptr_array_unref (sources);
+
   g_value_init (&source_stats_v, G_TYPE_VALUE_ARRAY);
   g_value_take_boxed (&source_stats_v, source_stats);
   gst_structure_id_take_value (s, quark_source_stats, &source_stats_v);
@@ -1027,6 +1111,30 @@ rtp_session_set_property (GObject * object, guint prop_id,
       rtp_twcc_manager_set_feedback_interval (sess->twcc,
           g_value_get_uint64 (value));
       break;
+    case PROP_BANDWIDTH_ESTIMATION:
+      RTP_SESSION_LOCK (sess);
+      if (g_value_get_boolean (value) && !sess->bwe_enabled)
+        rtp_bwe_reset (sess->bwe, sess->bwe_start_bitrate);
+      sess->bwe_enabled = g_value_get_boolean (value);
+      RTP_SESSION_UNLOCK (sess);
+      break;
+    case PROP_BWE_START_BITRATE:
+      RTP_SESSION_LOCK (sess);
+      sess->bwe_start_bitrate = g_value_get_uint (value);
+      RTP_SESSION_UNLOCK (sess);
+      break;
+    case PROP_BWE_MIN_BITRATE:
+      RTP_SESSION_LOCK (sess);
+      rtp_bwe_set_bitrate_limits (sess->bwe, g_value_get_uint (value),
+          sess->bwe->max_bitrate);
+      RTP_SESSION_UNLOCK (sess);
+      break;
+    case PROP_BWE_MAX_BITRATE:
+      RTP_SESSION_LOCK (sess);
+      rtp_bwe_set_bitrate_limits (sess->bwe, sess->bwe->min_bitrate,
+          g_value_get_uint (value));
+      RTP_SESSION_UNLOCK (sess);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1119,6 +1227,18 @@ rtp_session_get_property (GObject * object, guint prop_id,
       g_value_set_uint64 (value,
           rtp_twcc_manager_get_feedback_interval (sess->twcc));
       break;
+    case PROP_BANDWIDTH_ESTIMATION:
+      g_value_set_boolean (value, sess->bwe_enabled);
+      break;
+    case PROP_BWE_START_BITRATE:
+      g_value_set_uint (value, sess->bwe_start_bitrate);
+      break;
+    case PROP_BWE_MIN_BITRATE:
+      g_value_set_uint (value, sess->bwe->min_bitrate);
+      break;
+    case PROP_BWE_MAX_BITRATE:
+      g_value_set_uint (value, sess->bwe->max_bitrate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2263,7 +2383,7 @@ invalid_packet:
 /* update the RTPPacketInfo structure with the current time and other bits
  * about the current buffer we are handling.
  * This function is typically called when a validated packet is received.
- * This function should be called with the RTP_SESSION_LOCK
+ * This function only reads the packet and doesn't need the RTP_SESSION_LOCK
  */
 static gboolean
 update_packet_info (RTPSession * sess, RTPPacketInfo * pinfo,
@@ -2431,17 +2551,18 @@ rtp_session_process_rtp (RTPSession * sess, GstBuffer * buffer,
   g_return_val_if_fail (RTP_IS_SESSION (sess), GST_FLOW_ERROR);
   g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
 
-  RTP_SESSION_LOCK (sess);
-
-  /* update pinfo stats */
+  /* update pinfo stats, this only looks at the packet so it doesn't need
+   * the lock. Everything after it, down to the source stats, is still done
+   * with the session lock held */
   if (!update_packet_info (sess, &pinfo, FALSE, TRUE, FALSE, buffer,
           current_time, running_time, ntpnstime)) {
     GST_DEBUG ("invalid RTP packet received");
-    RTP_SESSION_UNLOCK (sess);
     return rtp_session_process_rtcp (sess, buffer, current_time, running_time,
         ntpnstime);
   }
 
+  RTP_SESSION_LOCK (sess);
+
   ssrc = pinfo.ssrc;
 
   source = obtain_source (sess, ssrc, &created, &pinfo, TRUE);
@@ -3043,7 +3164,8 @@ rtp_session_process_nack (RTPSession * sess, guint32 sender_ssrc,
 
 static void
 rtp_session_process_twcc (RTPSession * sess, guint32 sender_ssrc,
-    guint32 media_ssrc, guint8 * fci_data, guint fci_length)
+    guint32 media_ssrc, guint8 * fci_data, guint fci_length,
+    GstClockTime current_time)
 {
   GArray *twcc_packets;
   GstStructure *twcc_packets_s;
@@ -3058,6 +3180,15 @@ rtp_session_process_twcc (RTPSession * sess, guint32 sender_ssrc,
   twcc_stats_s =
       rtp_twcc_stats_process_packets (sess->twcc_stats, twcc_packets);
 
+  if (sess->bwe_enabled) {
+    rtp_bwe_process_packets (sess->bwe, twcc_packets,
+        sess->twcc_stats->bitrate_recv, current_time);
+    gst_structure_set (twcc_stats_s,
+        "estimated-bitrate", G_TYPE_UINT, rtp_bwe_get_bitrate (sess->bwe),
+        "bwe-state", G_TYPE_STRING, rtp_bwe_state_get_name (sess->bwe->state),
+        "bwe-probing", G_TYPE_BOOLEAN, sess->bwe->probing, NULL);
+  }
+
   GST_DEBUG_OBJECT (sess, "Parsed TWCC: %" GST_PTR_FORMAT, twcc_packets_s);
   GST_INFO_OBJECT (sess, "Current TWCC stats %" GST_PTR_FORMAT, twcc_stats_s);
 
@@ -3163,7 +3294,7 @@ rtp_session_process_feedback (RTPSession * sess, GstRTCPPacket * packet,
             break;
           case GST_RTCP_RTPFB_TYPE_TWCC:
             rtp_session_process_twcc (sess, sender_ssrc, media_ssrc,
-                fci_data, fci_length);
+                fci_data, fci_length, current_time);
             break;
           default:
             break;
@@ -3210,11 +3341,12 @@ rtp_session_process_rtcp (RTPSession * sess, GstBuffer * buffer,
   g_signal_emit (sess, rtp_session_signals[SIGNAL_ON_RECEIVING_RTCP], 0,
       buffer);
 
-  RTP_SESSION_LOCK (sess);
   /* update pinfo stats */
   update_packet_info (sess, &pinfo, FALSE, FALSE, FALSE, buffer, current_time,
       running_time, ntpnstime);
 
+  RTP_SESSION_LOCK (sess);
+
   /* start processing the compound packet */
   gst_rtcp_buffer_map (buffer, GST_MAP_READ, &rtcp);
   more = gst_rtcp_buffer_get_first_packet (&rtcp, &packet);
@@ -3385,11 +3517,14 @@ rtp_session_send_rtp (RTPSession * sess, gpointer data, gboolean is_list,
 
   GST_LOG ("received RTP %s for sending", is_list ? "list" : "packet");
 
-  RTP_SESSION_LOCK (sess);
   if (!update_packet_info (sess, &pinfo, TRUE, TRUE, is_list, data,
           current_time, running_time, -1))
     goto invalid_packet;
 
+  /* the source lookup, the source stats and the push downstream in
+   * rtp_source_send_rtp() all still happen with the session lock held, only
+   * the parsing above is done without it */
+  RTP_SESSION_LOCK (sess);
   rtp_twcc_manager_send_packet (sess->twcc, &pinfo);
 
   source = obtain_internal_source (sess, pinfo.ssrc, &created, current_time);
@@ -3444,7 +3579,6 @@ rtp_session_send_rtp (RTPSession * sess, gpointer data, gboolean is_list,
 invalid_packet:
   {
     gst_mini_object_unref (GST_MINI_OBJECT_CAST (data));
-    RTP_SESSION_UNLOCK (sess);
     GST_DEBUG ("invalid RTP packet received");
     return GST_FLOW_OK;
   }
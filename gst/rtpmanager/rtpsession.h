@@ -24,6 +24,7 @@
 
 #include "rtpsource.h"
 #include "rtptwcc.h"
+#include "rtpbwe.h"
 
 typedef struct _RTPSession RTPSession;
 typedef struct _RTPSessionClass RTPSessionClass;
@@ -319,6 +320,11 @@ struct _RTPSession {
   guint8 twcc_recv_ext_id;
   guint8 twcc_send_ext_id;
 
+  /* send-side bandwidth estimation on TWCC feedback */
+  RTPBandwidthEstimator *bwe;
+  gboolean bwe_enabled;
+  guint bwe_start_bitrate;
+
   /* nack probe */
   guint32 nack_probe_ssrc;
   guint nack_probe_pct;
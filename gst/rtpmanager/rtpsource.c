@@ -487,7 +487,14 @@ rtp_source_finalize (GObject * object)
   G_OBJECT_CLASS (rtp_source_parent_class)->finalize (object);
 }
 
-static GstStructure *
+/**
+ * rtp_source_create_stats:
+ * @src: an #RTPSource
+ *
+ * Returns: a new #GstStructure with the stats of @src, same as the
+ * #RTPSource:stats property.
+ */
+GstStructure *
 rtp_source_create_stats (RTPSource * src)
 {
   GstStructure *s;
@@ -275,6 +275,8 @@ gboolean        rtp_source_get_last_rb         (RTPSource *src, guint32 * ssrc,
 
 void            rtp_source_reset               (RTPSource * src);
 
+GstStructure *  rtp_source_create_stats        (RTPSource * src);
+
 gboolean        rtp_source_find_conflicting_address (RTPSource * src,
                                                 GSocketAddress *address,
                                                 GstClockTime time);
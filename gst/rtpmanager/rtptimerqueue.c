@@ -24,22 +24,63 @@
 
 #include "rtptimerqueue.h"
 
+/* The timing wheel has WHEEL_SIZE slots of WHEEL_TICK each. A slot points to
+ * one of the queued timers whose timeout falls in that tick, which gives a
+ * starting point for inserting other timers into the sorted list. The wheel
+ * is only a hint, a slot may point to a timer of an older revolution or to a
+ * timer whose timeout was modified in place. */
+#define WHEEL_TICK	GST_MSECOND
+#define WHEEL_SIZE	2048
+#define WHEEL_MASK	(WHEEL_SIZE - 1)
+#define WHEEL_WORDS	(WHEEL_SIZE / 32)
+
 struct _RtpTimerQueue
 {
   GObject parent;
 
   GQueue timers;
   GHashTable *hashtable;
+
+  RtpTimerQueueBackend backend;
+  RtpTimer **wheel;
+  guint32 *wheel_map;
+
+  RtpObjectPool *pool;
 };
 
 G_DEFINE_TYPE (RtpTimerQueue, rtp_timer_queue, G_TYPE_OBJECT);
 
+GType
+rtp_timer_queue_backend_get_type (void)
+{
+  static GType backend_type = 0;
+  static const GEnumValue backends[] = {
+    {RTP_TIMER_QUEUE_BACKEND_LIST, "Sorted list", "list"},
+    {RTP_TIMER_QUEUE_BACKEND_WHEEL, "Sorted list indexed by a timing wheel",
+        "wheel"},
+    {0, NULL, NULL},
+  };
+
+  if (!backend_type)
+    backend_type = g_enum_register_static ("RtpTimerQueueBackend", backends);
+  return backend_type;
+}
+
 /* some timer private helpers */
 
 static RtpTimer *
-rtp_timer_new (void)
+rtp_timer_new (RtpTimerQueue * queue)
 {
-  return g_slice_new0 (RtpTimer);
+  RtpTimer *timer;
+
+  if (queue->pool == NULL)
+    return g_slice_new0 (RtpTimer);
+
+  timer = rtp_object_pool_alloc (queue->pool);
+  memset (timer, 0, sizeof (RtpTimer));
+  timer->pool = queue->pool;
+
+  return timer;
 }
 
 static inline void
@@ -288,6 +329,123 @@ rtp_timer_queue_insert_head (RtpTimerQueue * queue, RtpTimer * timer)
     rtp_timer_queue_insert_before (queue, it, timer);
 }
 
+static inline void
+rtp_timer_queue_wheel_set (RtpTimerQueue * queue, guint slot, RtpTimer * timer)
+{
+  queue->wheel[slot] = timer;
+  if (timer)
+    queue->wheel_map[slot / 32] |= (1u << (slot % 32));
+  else
+    queue->wheel_map[slot / 32] &= ~(1u << (slot % 32));
+}
+
+static void
+rtp_timer_queue_wheel_add (RtpTimerQueue * queue, RtpTimer * timer)
+{
+  if (!GST_CLOCK_TIME_IS_VALID (timer->timeout))
+    return;
+
+  timer->wheel_tick = timer->timeout / WHEEL_TICK;
+  rtp_timer_queue_wheel_set (queue, timer->wheel_tick & WHEEL_MASK, timer);
+}
+
+/* Called before @timer leaves the list, hands its slot over to a neighbour
+ * from the same tick so the wheel never points to an unqueued timer */
+static void
+rtp_timer_queue_wheel_remove (RtpTimerQueue * queue, RtpTimer * timer)
+{
+  guint slot = timer->wheel_tick & WHEEL_MASK;
+  RtpTimer *other;
+
+  if (queue->wheel[slot] != timer)
+    return;
+
+  other = rtp_timer_get_prev (timer);
+  if (other == NULL || other->wheel_tick != timer->wheel_tick)
+    other = rtp_timer_get_next (timer);
+  if (other != NULL && other->wheel_tick != timer->wheel_tick)
+    other = NULL;
+
+  rtp_timer_queue_wheel_set (queue, slot, other);
+}
+
+/* Find the closest indexed timer at or before @tick, scanning the occupancy
+ * bitmap backward so that empty slots are skipped 32 at a time. */
+static RtpTimer *
+rtp_timer_queue_wheel_lookup (RtpTimerQueue * queue, guint64 tick)
+{
+  guint slot = tick & WHEEL_MASK;
+  guint word = slot / 32;
+  gint bit = slot % 32 + 1;
+  guint i;
+
+  for (i = 0; i <= WHEEL_WORDS; i++) {
+    gulong bits = queue->wheel_map[word];
+    gint nth;
+
+    while ((nth = g_bit_nth_msf (bits, bit)) != -1) {
+      RtpTimer *timer = queue->wheel[word * 32 + nth];
+
+      if (timer->wheel_tick <= tick)
+        return timer;
+      bit = nth;
+    }
+
+    word = (word + WHEEL_WORDS - 1) % WHEEL_WORDS;
+    bit = -1;
+  }
+
+  return NULL;
+}
+
+static void
+rtp_timer_queue_wheel_insert (RtpTimerQueue * queue, RtpTimer * timer)
+{
+  RtpTimer *it;
+
+  it = rtp_timer_queue_wheel_lookup (queue, timer->timeout / WHEEL_TICK);
+  if (it == NULL) {
+    rtp_timer_queue_insert_tail (queue, timer);
+    return;
+  }
+
+  /* the hint may be off, move to the exact position */
+  while (it && rtp_timer_is_sooner (timer, it))
+    it = rtp_timer_get_prev (it);
+
+  if (it == NULL) {
+    rtp_timer_queue_insert_head (queue, timer);
+    return;
+  }
+
+  while (rtp_timer_is_later (timer, rtp_timer_get_next (it)))
+    it = rtp_timer_get_next (it);
+
+  rtp_timer_queue_insert_after (queue, it, timer);
+}
+
+static void
+rtp_timer_queue_unlink (RtpTimerQueue * queue, RtpTimer * timer)
+{
+  if (queue->wheel)
+    rtp_timer_queue_wheel_remove (queue, timer);
+  g_queue_unlink (&queue->timers, (GList *) timer);
+}
+
+static void
+rtp_timer_queue_link (RtpTimerQueue * queue, RtpTimer * timer)
+{
+  if (timer->timeout == -1)
+    rtp_timer_queue_insert_head (queue, timer);
+  else if (queue->wheel)
+    rtp_timer_queue_wheel_insert (queue, timer);
+  else
+    rtp_timer_queue_insert_tail (queue, timer);
+
+  if (queue->wheel)
+    rtp_timer_queue_wheel_add (queue, timer);
+}
+
 static void
 rtp_timer_queue_init (RtpTimerQueue * queue)
 {
@@ -304,6 +462,13 @@ rtp_timer_queue_finalize (GObject * object)
     rtp_timer_free (timer);
   g_hash_table_unref (queue->hashtable);
   g_assert (queue->timers.length == 0);
+
+  g_free (queue->wheel);
+  g_free (queue->wheel_map);
+  if (queue->pool)
+    rtp_object_pool_unref (queue->pool);
+
+  G_OBJECT_CLASS (rtp_timer_queue_parent_class)->finalize (object);
 }
 
 static void
@@ -327,7 +492,10 @@ rtp_timer_free (RtpTimer * timer)
   g_return_if_fail (timer->list.next == NULL);
   g_return_if_fail (timer->list.prev == NULL);
 
-  g_slice_free (RtpTimer, timer);
+  if (timer->pool)
+    rtp_object_pool_free (timer->pool, timer);
+  else
+    g_slice_free (RtpTimer, timer);
 }
 
 /**
@@ -341,7 +509,12 @@ rtp_timer_free (RtpTimer * timer)
 RtpTimer *
 rtp_timer_dup (const RtpTimer * timer)
 {
-  RtpTimer *copy = g_slice_new (RtpTimer);
+  RtpTimer *copy;
+
+  if (timer->pool)
+    copy = rtp_object_pool_alloc (timer->pool);
+  else
+    copy = g_slice_new (RtpTimer);
   memcpy (copy, timer, sizeof (RtpTimer));
   memset (&copy->list, 0, sizeof (GList));
   copy->queued = FALSE;
@@ -388,6 +561,71 @@ rtp_timer_queue_new (void)
   return g_object_new (RTP_TYPE_TIMER_QUEUE, NULL);
 }
 
+/**
+ * rtp_timer_queue_set_backend:
+ * @queue: the #RtpTimerQueue object
+ * @backend: the #RtpTimerQueueBackend to use
+ *
+ * Select how the timers are indexed. This can be changed at any time, the
+ * queued timers are kept. With %RTP_TIMER_QUEUE_BACKEND_WHEEL, insertion and
+ * rescheduling are o(1) amortized as long as the timers are spread over
+ * time, at the cost of a few kilobytes of memory.
+ */
+void
+rtp_timer_queue_set_backend (RtpTimerQueue * queue,
+    RtpTimerQueueBackend backend)
+{
+  GList *l;
+
+  if (queue->backend == backend)
+    return;
+
+  queue->backend = backend;
+
+  g_clear_pointer (&queue->wheel, g_free);
+  g_clear_pointer (&queue->wheel_map, g_free);
+
+  if (backend != RTP_TIMER_QUEUE_BACKEND_WHEEL)
+    return;
+
+  queue->wheel = g_new0 (RtpTimer *, WHEEL_SIZE);
+  queue->wheel_map = g_new0 (guint32, WHEEL_WORDS);
+
+  for (l = queue->timers.head; l; l = l->next)
+    rtp_timer_queue_wheel_add (queue, (RtpTimer *) l);
+}
+
+/**
+ * rtp_timer_queue_set_pool:
+ * @queue: the #RtpTimerQueue object
+ * @pool: (transfer none): an #RtpObjectPool
+ *
+ * Allocate new timers from @pool. The objects of @pool must be at least the
+ * size of an #RtpTimer. Timers keep track of their pool, so they can move
+ * between queues.
+ */
+void
+rtp_timer_queue_set_pool (RtpTimerQueue * queue, RtpObjectPool * pool)
+{
+  if (pool)
+    rtp_object_pool_ref (pool);
+  if (queue->pool)
+    rtp_object_pool_unref (queue->pool);
+  queue->pool = pool;
+}
+
+/**
+ * rtp_timer_queue_get_backend:
+ * @queue: the #RtpTimerQueue object
+ *
+ * Returns: the #RtpTimerQueueBackend in use
+ */
+RtpTimerQueueBackend
+rtp_timer_queue_get_backend (RtpTimerQueue * queue)
+{
+  return queue->backend;
+}
+
 /**
  * rtp_timer_queue_insert:
  * @queue: the #RtpTimerQueue object
@@ -411,10 +649,7 @@ rtp_timer_queue_insert (RtpTimerQueue * queue, RtpTimer * timer)
     return FALSE;
   }
 
-  if (timer->timeout == -1)
-    rtp_timer_queue_insert_head (queue, timer);
-  else
-    rtp_timer_queue_insert_tail (queue, timer);
+  rtp_timer_queue_link (queue, timer);
 
   g_hash_table_insert (queue->hashtable,
       GINT_TO_POINTER (timer->seqnum), timer);
@@ -441,6 +676,23 @@ rtp_timer_queue_reschedule (RtpTimerQueue * queue, RtpTimer * timer)
 
   g_return_val_if_fail (timer->queued == TRUE, FALSE);
 
+  if (queue->wheel) {
+    RtpTimer *prev = rtp_timer_get_prev (timer);
+    RtpTimer *next = rtp_timer_get_next (timer);
+
+    if (!rtp_timer_is_sooner (timer, prev) &&
+        !rtp_timer_is_later (timer, next)) {
+      /* still in place, but the timeout may have moved to another tick */
+      rtp_timer_queue_wheel_remove (queue, timer);
+      rtp_timer_queue_wheel_add (queue, timer);
+      return FALSE;
+    }
+
+    rtp_timer_queue_unlink (queue, timer);
+    rtp_timer_queue_link (queue, timer);
+    return TRUE;
+  }
+
   if (rtp_timer_is_closer_to_head (timer, rtp_timer_queue_get_head (queue))) {
     g_queue_unlink (&queue->timers, (GList *) timer);
     rtp_timer_queue_insert_head (queue, timer);
@@ -487,7 +739,7 @@ rtp_timer_queue_unschedule (RtpTimerQueue * queue, RtpTimer * timer)
 {
   g_return_if_fail (timer->queued == TRUE);
 
-  g_queue_unlink (&queue->timers, (GList *) timer);
+  rtp_timer_queue_unlink (queue, timer);
   g_hash_table_remove (queue->hashtable, GINT_TO_POINTER (timer->seqnum));
   timer->queued = FALSE;
 }
@@ -576,7 +828,7 @@ rtp_timer_queue_set_timer (RtpTimerQueue * queue, RtpTimerType type,
 
   timer = rtp_timer_queue_find (queue, seqnum);
   if (!timer)
-    timer = rtp_timer_new ();
+    timer = rtp_timer_new (queue);
 
   /* for new timers or on seqnum change reset the RTX data */
   if (!timer->queued || timer->seqnum != seqnum) {
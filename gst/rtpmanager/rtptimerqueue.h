@@ -33,9 +33,28 @@
 #ifndef __RTP_TIMER_QUEUE_H__
 #define __RTP_TIMER_QUEUE_H__
 
+#include "rtpobjectpool.h"
+
 #define RTP_TYPE_TIMER_QUEUE rtp_timer_queue_get_type()
 G_DECLARE_FINAL_TYPE (RtpTimerQueue, rtp_timer_queue, RTP_TIMER, QUEUE, GObject);
 
+/**
+ * RtpTimerQueueBackend:
+ * @RTP_TIMER_QUEUE_BACKEND_LIST: Timers are kept in a sorted list, insertion
+ *                                searches from the head or the tail.
+ * @RTP_TIMER_QUEUE_BACKEND_WHEEL: The sorted list is indexed by a timing wheel
+ *                                 so that insertion and rescheduling start
+ *                                 next to the final position of the timer.
+ */
+typedef enum
+{
+  RTP_TIMER_QUEUE_BACKEND_LIST,
+  RTP_TIMER_QUEUE_BACKEND_WHEEL,
+} RtpTimerQueueBackend;
+
+#define RTP_TYPE_TIMER_QUEUE_BACKEND (rtp_timer_queue_backend_get_type())
+GType rtp_timer_queue_backend_get_type (void);
+
 /**
  * RtpTimerType:
  * @RTP_TIMER_EXPECTED: This is used to track when to emit retranmission
@@ -71,6 +90,11 @@ typedef struct
   GstClockTime rtx_last;
   guint num_rtx_retry;
   guint num_rtx_received;
+
+  /* timing wheel tick this timer was indexed at */
+  guint64 wheel_tick;
+
+  RtpObjectPool *pool;
 } RtpTimer;
 
 void         rtp_timer_free (RtpTimer * timer);
@@ -90,6 +114,13 @@ static inline RtpTimer * rtp_timer_get_prev (RtpTimer * timer)
 
 RtpTimerQueue * rtp_timer_queue_new (void);
 
+void            rtp_timer_queue_set_backend (RtpTimerQueue * queue,
+                                             RtpTimerQueueBackend backend);
+
+RtpTimerQueueBackend rtp_timer_queue_get_backend (RtpTimerQueue * queue);
+
+void            rtp_timer_queue_set_pool (RtpTimerQueue * queue, RtpObjectPool * pool);
+
 RtpTimer *      rtp_timer_queue_find (RtpTimerQueue * queue, guint seqnum);
 
 RtpTimer *      rtp_timer_queue_peek_earliest (RtpTimerQueue * queue);
@@ -81,7 +81,16 @@ struct _RTPTWCCManager
 
   guint mtu;
   guint max_packets_per_rtcp;
+
+  /* received packets, sorted on seqnum, with their status, delta and
+   * equal_run kept up to date as they arrive */
   GArray *recv_packets;
+  /* the recv deltas of recv_packets, as written in the feedback */
+  GArray *recv_deltas;
+  GstClockTime recv_base_time;
+  GstClockTime recv_ts_rounded;
+  guint recv_large_deltas;
+  gint recv_run_start;
 
   guint64 fb_pkt_count;
   gint32 last_seqnum;
@@ -122,6 +131,8 @@ static void
 rtp_twcc_manager_init (RTPTWCCManager * twcc)
 {
   twcc->recv_packets = g_array_new (FALSE, FALSE, sizeof (RecvPacket));
+  twcc->recv_deltas = g_array_new (FALSE, FALSE, sizeof (guint8));
+  twcc->recv_run_start = -1;
   twcc->sent_packets = g_array_new (FALSE, FALSE, sizeof (SentPacket));
   twcc->parsed_packets = g_array_new (FALSE, FALSE, sizeof (RecvPacket));
 
@@ -143,6 +154,7 @@ rtp_twcc_manager_finalize (GObject * object)
   RTPTWCCManager *twcc = RTP_TWCC_MANAGER_CAST (object);
 
   g_array_unref (twcc->recv_packets);
+  g_array_unref (twcc->recv_deltas);
   g_array_unref (twcc->sent_packets);
   g_array_unref (twcc->parsed_packets);
   g_queue_free_full (twcc->rtcp_buffers, (GDestroyNotify) gst_buffer_unref);
@@ -322,36 +334,6 @@ rtp_twcc_manager_get_next_timeout (RTPTWCCManager * twcc,
   return GST_CLOCK_TIME_NONE;
 }
 
-static gint
-_twcc_seqnum_sort (gconstpointer a, gconstpointer b)
-{
-  gint32 seqa = ((RecvPacket *) a)->seqnum;
-  gint32 seqb = ((RecvPacket *) b)->seqnum;
-  gint res = seqa - seqb;
-  if (res < -65000)
-    res = 1;
-  if (res > 65000)
-    res = -1;
-  return res;
-}
-
-static void
-rtp_twcc_write_recv_deltas (guint8 * fci_data, GArray * twcc_packets)
-{
-  guint i;
-  for (i = 0; i < twcc_packets->len; i++) {
-    RecvPacket *pkt = &g_array_index (twcc_packets, RecvPacket, i);
-
-    if (pkt->status == RTP_TWCC_PACKET_STATUS_SMALL_DELTA) {
-      GST_WRITE_UINT8 (fci_data, pkt->delta);
-      fci_data += 1;
-    } else if (pkt->status == RTP_TWCC_PACKET_STATUS_LARGE_NEGATIVE_DELTA) {
-      GST_WRITE_UINT16_BE (fci_data, pkt->delta);
-      fci_data += 2;
-    }
-  }
-}
-
 static void
 rtp_twcc_write_run_length_chunk (GArray * packet_chunks,
     RTPTWCCPacketStatus status, guint run_length)
@@ -478,33 +460,6 @@ rtp_twcc_write_status_vector_chunk (ChunkBitWriter * writer, RecvPacket * pkt)
   chunk_bit_writer_write (writer, pkt->status);
 }
 
-typedef struct
-{
-  RecvPacket *equal;
-} RunLengthHelper;
-
-static void
-run_lenght_helper_update (RunLengthHelper * rlh, RecvPacket * pkt)
-{
-  /* for missing packets we reset */
-  if (pkt->missing_run > 0) {
-    rlh->equal = NULL;
-  }
-
-  /* all status equal run */
-  if (rlh->equal == NULL) {
-    rlh->equal = pkt;
-    rlh->equal->equal_run = 0;
-  }
-
-  if (rlh->equal->status == pkt->status) {
-    rlh->equal->equal_run++;
-  } else {
-    rlh->equal = pkt;
-    rlh->equal->equal_run = 1;
-  }
-}
-
 static guint
 _get_max_packets_capacity (guint symbol_size)
 {
@@ -583,31 +538,166 @@ rtp_twcc_write_chunks (GArray * packet_chunks,
   chunk_bit_writer_flush (&writer);
 }
 
+/* a gap or a change of status starts a new run, equal_run is only set
+   on the first packet of each run */
+static void
+rtp_twcc_manager_update_recv_run (RTPTWCCManager * twcc, guint idx)
+{
+  RecvPacket *pkt = &g_array_index (twcc->recv_packets, RecvPacket, idx);
+
+  if (twcc->recv_run_start != -1 && pkt->missing_run == 0) {
+    RecvPacket *start = &g_array_index (twcc->recv_packets, RecvPacket,
+        twcc->recv_run_start);
+    if (start->status == pkt->status) {
+      start->equal_run++;
+      pkt->equal_run = 0;
+      return;
+    }
+  }
+
+  twcc->recv_run_start = idx;
+  pkt->equal_run = 1;
+}
+
+static gint
+rtp_twcc_manager_find_recv_run_start (RTPTWCCManager * twcc, guint idx)
+{
+  while (idx > 0) {
+    RecvPacket *pkt = &g_array_index (twcc->recv_packets, RecvPacket, idx);
+    RecvPacket *prev =
+        &g_array_index (twcc->recv_packets, RecvPacket, idx - 1);
+
+    if (pkt->missing_run > 0 || prev->status != pkt->status)
+      break;
+    idx--;
+  }
+  return idx;
+}
+
+static void
+rtp_twcc_manager_append_recv_packet (RTPTWCCManager * twcc,
+    RecvPacket * packet)
+{
+  guint idx = twcc->recv_packets->len;
+  GstClockTimeDiff delta_ts;
+  gint64 delta_ts_rounded;
+
+  if (idx == 0) {
+    twcc->recv_base_time = (packet->ts / REF_TIME_UNIT) * REF_TIME_UNIT;
+    twcc->recv_ts_rounded = twcc->recv_base_time;
+    packet->missing_run = 0;
+  } else {
+    RecvPacket *prev = &g_array_index (twcc->recv_packets, RecvPacket,
+        idx - 1);
+    packet->missing_run = packet->seqnum - prev->seqnum - 1;
+  }
+
+  delta_ts = GST_CLOCK_DIFF (twcc->recv_ts_rounded, packet->ts);
+  packet->delta = delta_ts / DELTA_UNIT;
+  delta_ts_rounded = packet->delta * DELTA_UNIT;
+  twcc->recv_ts_rounded += delta_ts_rounded;
+
+  if (delta_ts_rounded < 0 || delta_ts_rounded > MAX_TS_DELTA) {
+    guint8 delta[2];
+
+    packet->status = RTP_TWCC_PACKET_STATUS_LARGE_NEGATIVE_DELTA;
+    GST_WRITE_UINT16_BE (delta, packet->delta);
+    g_array_append_vals (twcc->recv_deltas, delta, 2);
+    twcc->recv_large_deltas++;
+  } else {
+    guint8 delta = packet->delta;
+
+    packet->status = RTP_TWCC_PACKET_STATUS_SMALL_DELTA;
+    g_array_append_val (twcc->recv_deltas, delta);
+  }
+
+  g_array_append_val (twcc->recv_packets, *packet);
+  rtp_twcc_manager_update_recv_run (twcc, idx);
+
+  GST_LOG ("pkt: #%u, ts: %" GST_TIME_FORMAT
+      " ts_rounded: %" GST_TIME_FORMAT
+      " delta_ts: %" GST_STIME_FORMAT
+      " delta_ts_rounded: %" GST_STIME_FORMAT
+      " missing_run: %u, status: %u", packet->seqnum,
+      GST_TIME_ARGS (packet->ts), GST_TIME_ARGS (twcc->recv_ts_rounded),
+      GST_STIME_ARGS (delta_ts), GST_STIME_ARGS (delta_ts_rounded),
+      packet->missing_run, packet->status);
+}
+
+/* drops the packets from len and onwards, undoing what appending them did */
+static void
+rtp_twcc_manager_truncate_recv_packets (RTPTWCCManager * twcc, guint len)
+{
+  if (len == 0) {
+    g_array_set_size (twcc->recv_packets, 0);
+    g_array_set_size (twcc->recv_deltas, 0);
+    twcc->recv_large_deltas = 0;
+    twcc->recv_run_start = -1;
+    return;
+  }
+
+  while (twcc->recv_packets->len > len) {
+    guint idx = twcc->recv_packets->len - 1;
+    RecvPacket *pkt = &g_array_index (twcc->recv_packets, RecvPacket, idx);
+
+    twcc->recv_ts_rounded -= pkt->delta * DELTA_UNIT;
+    if (pkt->status == RTP_TWCC_PACKET_STATUS_LARGE_NEGATIVE_DELTA) {
+      g_array_set_size (twcc->recv_deltas, twcc->recv_deltas->len - 2);
+      twcc->recv_large_deltas--;
+    } else {
+      g_array_set_size (twcc->recv_deltas, twcc->recv_deltas->len - 1);
+    }
+
+    if (idx == twcc->recv_run_start) {
+      twcc->recv_run_start =
+          rtp_twcc_manager_find_recv_run_start (twcc, idx - 1);
+    } else {
+      g_array_index (twcc->recv_packets, RecvPacket,
+          twcc->recv_run_start).equal_run--;
+    }
+
+    g_array_set_size (twcc->recv_packets, idx);
+  }
+}
+
+/* a reordered packet is put in place and the packets after it are
+   appended again, as their missing runs, deltas and runs change */
+static void
+rtp_twcc_manager_insert_recv_packet (RTPTWCCManager * twcc, guint pos,
+    RecvPacket * packet)
+{
+  guint n_after = twcc->recv_packets->len - pos;
+  RecvPacket *after = g_new (RecvPacket, n_after);
+  guint i;
+
+  memcpy (after, &g_array_index (twcc->recv_packets, RecvPacket, pos),
+      n_after * sizeof (RecvPacket));
+  rtp_twcc_manager_truncate_recv_packets (twcc, pos);
+
+  rtp_twcc_manager_append_recv_packet (twcc, packet);
+  for (i = 0; i < n_after; i++)
+    rtp_twcc_manager_append_recv_packet (twcc, &after[i]);
+
+  g_free (after);
+}
+
 static void
 rtp_twcc_manager_add_fci (RTPTWCCManager * twcc, GstRTCPPacket * packet)
 {
-  RecvPacket *first, *last, *prev;
+  RecvPacket *first, *last;
   guint16 packet_count;
-  GstClockTime base_time;
-  GstClockTime ts_rounded;
-  guint i;
   GArray *packet_chunks = g_array_new (FALSE, FALSE, 2);
   RTPTWCCHeader header;
   guint header_size = sizeof (RTPTWCCHeader);
   guint packet_chunks_size;
-  guint recv_deltas_size = 0;
+  guint recv_deltas_size = twcc->recv_deltas->len;
   guint16 fci_length;
   guint16 fci_chunks;
   guint8 *fci_data;
   guint8 *fci_data_ptr;
-  RunLengthHelper rlh = { NULL };
-  guint symbol_size = 1;
-  GstClockTimeDiff delta_ts;
-  gint64 delta_ts_rounded;
+  guint symbol_size = twcc->recv_large_deltas > 0 ? 2 : 1;
   guint8 fb_pkt_count;
 
-  g_array_sort (twcc->recv_packets, _twcc_seqnum_sort);
-
   /* get first and last packet */
   first = &g_array_index (twcc->recv_packets, RecvPacket, 0);
   last =
@@ -615,58 +705,24 @@ rtp_twcc_manager_add_fci (RTPTWCCManager * twcc, GstRTCPPacket * packet)
       twcc->recv_packets->len - 1);
 
   packet_count = last->seqnum - first->seqnum + 1;
-  base_time = first->ts / REF_TIME_UNIT;
   fb_pkt_count = (guint8) (twcc->fb_pkt_count % G_MAXUINT8);
 
   GST_WRITE_UINT16_BE (header.base_seqnum, first->seqnum);
   GST_WRITE_UINT16_BE (header.packet_count, packet_count);
-  GST_WRITE_UINT24_BE (header.base_time, base_time);
+  GST_WRITE_UINT24_BE (header.base_time, twcc->recv_base_time / REF_TIME_UNIT);
   GST_WRITE_UINT8 (header.fb_pkt_count, fb_pkt_count);
 
-  base_time *= REF_TIME_UNIT;
-  ts_rounded = base_time;
-
   GST_DEBUG ("Created TWCC feedback: base_seqnum: #%u, packet_count: %u, "
       "base_time %" GST_TIME_FORMAT " fb_pkt_count: %u",
-      first->seqnum, packet_count, GST_TIME_ARGS (base_time), fb_pkt_count);
+      first->seqnum, packet_count, GST_TIME_ARGS (twcc->recv_base_time),
+      fb_pkt_count);
 
   twcc->fb_pkt_count++;
   twcc->expected_recv_seqnum = first->seqnum + packet_count;
 
-  /* calculate all deltas and check for gaps etc */
-  prev = first;
-  for (i = 0; i < twcc->recv_packets->len; i++) {
-    RecvPacket *pkt = &g_array_index (twcc->recv_packets, RecvPacket, i);
-    if (i != 0) {
-      pkt->missing_run = pkt->seqnum - prev->seqnum - 1;
-    }
-
-    delta_ts = GST_CLOCK_DIFF (ts_rounded, pkt->ts);
-    pkt->delta = delta_ts / DELTA_UNIT;
-    delta_ts_rounded = pkt->delta * DELTA_UNIT;
-    ts_rounded += delta_ts_rounded;
-
-    if (delta_ts_rounded < 0 || delta_ts_rounded > MAX_TS_DELTA) {
-      pkt->status = RTP_TWCC_PACKET_STATUS_LARGE_NEGATIVE_DELTA;
-      recv_deltas_size += 2;
-      symbol_size = 2;
-    } else {
-      pkt->status = RTP_TWCC_PACKET_STATUS_SMALL_DELTA;
-      recv_deltas_size += 1;
-    }
-    run_lenght_helper_update (&rlh, pkt);
-
-    GST_LOG ("pkt: #%u, ts: %" GST_TIME_FORMAT
-        " ts_rounded: %" GST_TIME_FORMAT
-        " delta_ts: %" GST_STIME_FORMAT
-        " delta_ts_rounded: %" GST_STIME_FORMAT
-        " missing_run: %u, status: %u", pkt->seqnum,
-        GST_TIME_ARGS (pkt->ts), GST_TIME_ARGS (ts_rounded),
-        GST_STIME_ARGS (delta_ts), GST_STIME_ARGS (delta_ts_rounded),
-        pkt->missing_run, pkt->status);
-    prev = pkt;
-  }
-
+  /* statuses, deltas and runs are already up to date, only the choice
+     between run-length and status vector chunks depends on the feedback
+     as a whole */
   rtp_twcc_write_chunks (packet_chunks, twcc->recv_packets, symbol_size);
 
   packet_chunks_size = packet_chunks->len * 2;
@@ -687,7 +743,7 @@ rtp_twcc_manager_add_fci (RTPTWCCManager * twcc, GstRTCPPacket * packet)
   memcpy (fci_data_ptr, packet_chunks->data, packet_chunks_size);
   fci_data_ptr += packet_chunks_size;
 
-  rtp_twcc_write_recv_deltas (fci_data_ptr, twcc->recv_packets);
+  memcpy (fci_data_ptr, twcc->recv_deltas->data, recv_deltas_size);
 
   GST_MEMDUMP ("twcc-header:", (guint8 *) & header, header_size);
   GST_MEMDUMP ("packet-chunks:", (guint8 *) packet_chunks->data,
@@ -695,7 +751,7 @@ rtp_twcc_manager_add_fci (RTPTWCCManager * twcc, GstRTCPPacket * packet)
   GST_MEMDUMP ("full fci:", fci_data, fci_length);
 
   g_array_unref (packet_chunks);
-  g_array_set_size (twcc->recv_packets, 0);
+  rtp_twcc_manager_truncate_recv_packets (twcc, 0);
 }
 
 static void
@@ -768,6 +824,7 @@ rtp_twcc_manager_recv_packet (RTPTWCCManager * twcc, RTPPacketInfo * pinfo)
   gboolean send_feedback = FALSE;
   RecvPacket packet;
   gint32 seqnum;
+  guint pos;
   gint diff;
 
   seqnum = rtp_twcc_manager_get_recv_twcc_seqnum (twcc, pinfo);
@@ -797,20 +854,28 @@ rtp_twcc_manager_recv_packet (RTPTWCCManager * twcc, RTPPacketInfo * pinfo)
     return FALSE;
   }
 
-  if (twcc->recv_packets->len > 0) {
-    RecvPacket *last = &g_array_index (twcc->recv_packets, RecvPacket,
-        twcc->recv_packets->len - 1);
+  /* find where the packet goes, reordering is rare and shallow */
+  pos = twcc->recv_packets->len;
+  while (pos > 0) {
+    RecvPacket *prev = &g_array_index (twcc->recv_packets, RecvPacket,
+        pos - 1);
 
-    diff = gst_rtp_buffer_compare_seqnum (last->seqnum, seqnum);
+    diff = gst_rtp_buffer_compare_seqnum (prev->seqnum, seqnum);
     if (diff == 0) {
       GST_INFO ("Received duplicate packet (%u), dropping", seqnum);
       return FALSE;
     }
+    if (diff > 0)
+      break;
+    pos--;
   }
 
   /* store the packet for Transport-wide RTCP feedback message */
   recv_packet_init (&packet, seqnum, pinfo);
-  g_array_append_val (twcc->recv_packets, packet);
+  if (pos == twcc->recv_packets->len)
+    rtp_twcc_manager_append_recv_packet (twcc, &packet);
+  else
+    rtp_twcc_manager_insert_recv_packet (twcc, pos, &packet);
   twcc->last_seqnum = seqnum;
 
   GST_LOG ("Receive: twcc-seqnum: %u, pt: %u, marker: %d, ts: %"
@@ -294,6 +294,9 @@ gst_rtsp_backchannel_get_type (void)
 #define DEFAULT_IS_LIVE TRUE
 #define DEFAULT_IGNORE_X_SERVER_REPLY FALSE
 
+/* max number of interleaved RTP buffers pushed downstream in one list */
+#define MAX_PENDING_BUFFERS 64
+
 enum
 {
   PROP_0,
@@ -2438,6 +2441,7 @@ gst_rtspsrc_stream_free (GstRTSPSrc * src, GstRTSPStream * stream)
       gst_object_unref (stream->udpsink[i]);
     }
   }
+  gst_clear_buffer_list (&stream->pending);
   if (stream->rtpsrc) {
     gst_element_set_state (stream->rtpsrc, GST_STATE_NULL);
     gst_bin_remove (GST_BIN_CAST (src), stream->rtpsrc);
@@ -5405,8 +5409,65 @@ send_error:
   }
 }
 
+/* pushes the RTP buffers collected for @stream as one buffer list */
 static GstFlowReturn
-gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+gst_rtspsrc_stream_push_pending (GstRTSPSrc * src, GstRTSPStream * stream)
+{
+  GstFlowReturn ret;
+  GstPad *outpad = stream->channelpad[0];
+  GstBufferList *list = stream->pending;
+
+  if (list == NULL)
+    return GST_FLOW_OK;
+  stream->pending = NULL;
+
+  GST_DEBUG_OBJECT (src, "pushing list of %u buffers on channel %d",
+      gst_buffer_list_length (list), stream->channel[0]);
+
+  if (GST_PAD_IS_SINK (outpad))
+    ret = gst_pad_chain_list (outpad, list);
+  else
+    ret = gst_pad_push_list (outpad, list);
+
+  /* combine all stream flows for the data transport */
+  return gst_rtspsrc_combine_flows (src, stream, ret);
+}
+
+static GstFlowReturn
+gst_rtspsrc_push_pending (GstRTSPSrc * src)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *walk;
+
+  for (walk = src->streams; walk; walk = g_list_next (walk)) {
+    GstRTSPStream *stream = (GstRTSPStream *) walk->data;
+    GstFlowReturn res;
+
+    res = gst_rtspsrc_stream_push_pending (src, stream);
+    if (ret == GST_FLOW_OK)
+      ret = res;
+  }
+  return ret;
+}
+
+static void
+gst_rtspsrc_clear_pending (GstRTSPSrc * src)
+{
+  GList *walk;
+
+  for (walk = src->streams; walk; walk = g_list_next (walk)) {
+    GstRTSPStream *stream = (GstRTSPStream *) walk->data;
+
+    gst_clear_buffer_list (&stream->pending);
+  }
+}
+
+/* Handles an interleaved data message. When @batch is set, RTP buffers are
+ * collected per stream instead of being pushed right away, the caller pushes
+ * them with gst_rtspsrc_push_pending() once the socket has been drained. */
+static GstFlowReturn
+gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message,
+    gboolean batch)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   gint channel;
@@ -5465,6 +5526,15 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
   GST_DEBUG_OBJECT (src, "pushing data of size %d on channel %d", size,
       channel);
 
+  /* events below must not overtake buffers that are still pending */
+  if (src->need_activate || src->need_segment || stream->need_caps) {
+    ret = gst_rtspsrc_push_pending (src);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (buf);
+      return ret;
+    }
+  }
+
   if (src->need_activate) {
     gchar *stream_id;
     GstEvent *event;
@@ -5613,6 +5683,25 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
     GST_BUFFER_TIMESTAMP (buf) = src->base_time;
   }
 
+  if (is_rtcp) {
+    /* RTCP must not overtake the RTP collected for this stream, a BYE would
+     * otherwise send EOS downstream ahead of it */
+    ret = gst_rtspsrc_stream_push_pending (src, stream);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (buf);
+      return ret;
+    }
+  } else if (batch) {
+    if (stream->pending == NULL)
+      stream->pending = gst_buffer_list_new_sized (MAX_PENDING_BUFFERS);
+    gst_buffer_list_add (stream->pending, buf);
+
+    if (gst_buffer_list_length (stream->pending) < MAX_PENDING_BUFFERS)
+      return GST_FLOW_OK;
+
+    return gst_rtspsrc_stream_push_pending (src, stream);
+  }
+
   /* chain to the peer pad */
   if (GST_PAD_IS_SINK (outpad))
     ret = gst_pad_chain (outpad, buf);
@@ -5641,6 +5730,28 @@ invalid_length:
   }
 }
 
+/* Whether more interleaved data is already waiting to be read, so that the
+ * RTP collected so far can be held back a little longer.
+ *
+ * This only looks at the socket. Messages that GstRTSPConnection has already
+ * read into its own buffers are not seen, we then push what we have early,
+ * which only costs some batching. Bytes of a partially received frame do
+ * count, so the pending RTP is held until the rest of that frame arrives.
+ * This is bounded by #GstRTSPSrc:tcp-timeout, gst_rtspsrc_loop_interleaved()
+ * pushes everything pending when the receive times out. */
+static gboolean
+gst_rtspsrc_data_available (GstRTSPSrc * src)
+{
+  GSocket *socket;
+
+  if (src->conninfo.connection == NULL)
+    return FALSE;
+
+  socket = gst_rtsp_connection_get_read_socket (src->conninfo.connection);
+
+  return socket != NULL && g_socket_get_available_bytes (socket) > 0;
+}
+
 static GstFlowReturn
 gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
 {
@@ -5669,6 +5780,10 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
         /* we got interrupted this means we need to stop */
         goto interrupt;
       case GST_RTSP_ETIMEOUT:
+        /* don't hold on to data while waiting for a partial message */
+        ret = gst_rtspsrc_push_pending (src);
+        if (ret != GST_FLOW_OK)
+          goto handle_data_failed;
         /* no reply, send keep alive */
         GST_DEBUG_OBJECT (src, "timeout, sending keep-alive");
         if ((res = gst_rtspsrc_send_keep_alive (src)) == GST_RTSP_EINTR)
@@ -5697,7 +5812,7 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
         break;
       case GST_RTSP_MESSAGE_DATA:
         GST_DEBUG_OBJECT (src, "got data message");
-        ret = gst_rtspsrc_handle_data (src, &message);
+        ret = gst_rtspsrc_handle_data (src, &message, TRUE);
         if (ret != GST_FLOW_OK)
           goto handle_data_failed;
         break;
@@ -5706,6 +5821,14 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
             message.type);
         break;
     }
+
+    /* keep collecting while more data is already waiting on the socket,
+     * push everything downstream as soon as we would block */
+    if (!gst_rtspsrc_data_available (src)) {
+      ret = gst_rtspsrc_push_pending (src);
+      if (ret != GST_FLOW_OK)
+        goto handle_data_failed;
+    }
   }
   g_assert_not_reached ();
 
@@ -5713,6 +5836,8 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
 server_eof:
   {
     GST_DEBUG_OBJECT (src, "we got an eof from the server");
+    /* what we received before the connection was closed is still valid */
+    gst_rtspsrc_push_pending (src);
     GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
         ("The server closed the connection."));
     src->conninfo.connected = FALSE;
@@ -5721,6 +5846,19 @@ server_eof:
   }
 interrupt:
   {
+    gint cmd;
+
+    GST_OBJECT_LOCK (src);
+    cmd = src->pending_cmd;
+    GST_OBJECT_UNLOCK (src);
+
+    /* a GET_PARAMETER or SET_PARAMETER only borrows the connection, the
+     * stream carries on afterwards so what we collected is still valid. Only
+     * drop it when we are flushing, seeking or tearing down. */
+    if (cmd == CMD_GET_PARAMETER || cmd == CMD_SET_PARAMETER)
+      gst_rtspsrc_push_pending (src);
+    else
+      gst_rtspsrc_clear_pending (src);
     gst_rtsp_message_unset (&message);
     GST_DEBUG_OBJECT (src, "got interrupted");
     return GST_FLOW_FLUSHING;
@@ -5732,6 +5870,7 @@ receive_error:
     GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
         ("Could not receive message. (%s)", str));
     g_free (str);
+    gst_rtspsrc_clear_pending (src);
 
     gst_rtsp_message_unset (&message);
     return GST_FLOW_ERROR;
@@ -5743,12 +5882,14 @@ handle_request_failed:
     GST_ELEMENT_ERROR (src, RESOURCE, WRITE, (NULL),
         ("Could not handle server message. (%s)", str));
     g_free (str);
+    gst_rtspsrc_clear_pending (src);
     gst_rtsp_message_unset (&message);
     return GST_FLOW_ERROR;
   }
 handle_data_failed:
   {
     GST_DEBUG_OBJECT (src, "could no handle data message");
+    gst_rtspsrc_clear_pending (src);
     return ret;
   }
 }
@@ -6457,7 +6598,7 @@ next:
     case GST_RTSP_MESSAGE_DATA:
       /* get next response */
       GST_DEBUG_OBJECT (src, "handle data response message");
-      gst_rtspsrc_handle_data (src, response);
+      gst_rtspsrc_handle_data (src, response, FALSE);
 
       /* Not a response, receive next message */
       goto next;
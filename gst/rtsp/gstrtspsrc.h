@@ -112,6 +112,8 @@ struct _GstRTSPStream {
   /* for interleaved mode */
   guint8        channel[2];
   GstPad       *channelpad[2];
+  /* RTP buffers received back to back, not yet pushed on channelpad[0] */
+  GstBufferList *pending;
 
   /* our udp sources */
   GstElement   *udpsrc[2];
@@ -44,6 +44,11 @@
 
 #include <gio/gnetworking.h>
 
+/* Needed for UDP_SEGMENT, can be included after glib.h */
+#ifndef G_PLATFORM_WIN32
+#include <netinet/udp.h>
+#endif
+
 #include "gst/net/net.h"
 #include "gst/glib-compat-private.h"
 
@@ -52,6 +57,109 @@ GST_DEBUG_CATEGORY_STATIC (multiudpsink_debug);
 
 #define UDP_MAX_SIZE 65507
 
+/* maximum number of segments the kernel accepts in one UDP_SEGMENT send */
+#define UDP_MAX_SEGMENTS 64
+
+#ifdef UDP_SEGMENT
+GType gst_udp_segment_message_get_type (void);
+
+#define GST_TYPE_UDP_SEGMENT_MESSAGE         (gst_udp_segment_message_get_type ())
+#define GST_UDP_SEGMENT_MESSAGE(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), GST_TYPE_UDP_SEGMENT_MESSAGE, GstUDPSegmentMessage))
+#define GST_IS_UDP_SEGMENT_MESSAGE(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), GST_TYPE_UDP_SEGMENT_MESSAGE))
+
+typedef struct _GstUDPSegmentMessage GstUDPSegmentMessage;
+typedef struct _GstUDPSegmentMessageClass GstUDPSegmentMessageClass;
+
+struct _GstUDPSegmentMessageClass
+{
+  GSocketControlMessageClass parent_class;
+};
+
+struct _GstUDPSegmentMessage
+{
+  GSocketControlMessage parent;
+
+  guint16 gso_size;
+};
+
+G_DEFINE_TYPE (GstUDPSegmentMessage, gst_udp_segment_message,
+    G_TYPE_SOCKET_CONTROL_MESSAGE);
+
+static gsize
+gst_udp_segment_message_get_size (GSocketControlMessage * message)
+{
+  return sizeof (guint16);
+}
+
+static int
+gst_udp_segment_message_get_level (GSocketControlMessage * message)
+{
+  return IPPROTO_UDP;
+}
+
+static int
+gst_udp_segment_message_get_msg_type (GSocketControlMessage * message)
+{
+  return UDP_SEGMENT;
+}
+
+static void
+gst_udp_segment_message_serialize (GSocketControlMessage * message,
+    gpointer data)
+{
+  GstUDPSegmentMessage *msg = GST_UDP_SEGMENT_MESSAGE (message);
+
+  memcpy (data, &msg->gso_size, sizeof (guint16));
+}
+
+static GSocketControlMessage *
+gst_udp_segment_message_deserialize (gint level,
+    gint type, gsize size, gpointer data)
+{
+  GstUDPSegmentMessage *message;
+
+  if (level != IPPROTO_UDP || type != UDP_SEGMENT)
+    return NULL;
+
+  if (size < sizeof (guint16))
+    return NULL;
+
+  message = g_object_new (GST_TYPE_UDP_SEGMENT_MESSAGE, NULL);
+  memcpy (&message->gso_size, data, sizeof (guint16));
+
+  return G_SOCKET_CONTROL_MESSAGE (message);
+}
+
+static void
+gst_udp_segment_message_init (GstUDPSegmentMessage * message)
+{
+}
+
+static void
+gst_udp_segment_message_class_init (GstUDPSegmentMessageClass * class)
+{
+  GSocketControlMessageClass *scm_class;
+
+  scm_class = G_SOCKET_CONTROL_MESSAGE_CLASS (class);
+  scm_class->get_size = gst_udp_segment_message_get_size;
+  scm_class->get_level = gst_udp_segment_message_get_level;
+  scm_class->get_type = gst_udp_segment_message_get_msg_type;
+  scm_class->serialize = gst_udp_segment_message_serialize;
+  scm_class->deserialize = gst_udp_segment_message_deserialize;
+}
+
+static GSocketControlMessage *
+gst_udp_segment_message_new (guint16 gso_size)
+{
+  GstUDPSegmentMessage *message;
+
+  message = g_object_new (GST_TYPE_UDP_SEGMENT_MESSAGE, NULL);
+  message->gso_size = gso_size;
+
+  return G_SOCKET_CONTROL_MESSAGE (message);
+}
+#endif
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -92,6 +200,7 @@ enum
 #define DEFAULT_BUFFER_SIZE        0
 #define DEFAULT_BIND_ADDRESS       NULL
 #define DEFAULT_BIND_PORT          0
+#define DEFAULT_GSO                FALSE
 
 enum
 {
@@ -114,7 +223,10 @@ enum
   PROP_SEND_DUPLICATES,
   PROP_BUFFER_SIZE,
   PROP_BIND_ADDRESS,
-  PROP_BIND_PORT
+  PROP_BIND_PORT,
+  PROP_GSO,
+  PROP_GSO_SENDS,
+  PROP_GSO_SEGMENTS
 };
 
 static void gst_multiudpsink_finalize (GObject * object);
@@ -351,6 +463,49 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
           "Port to bind the socket to", 0, G_MAXUINT16,
           DEFAULT_BIND_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiUDPSink:gso:
+   *
+   * Use UDP generic segmentation offload (UDP_SEGMENT) to hand consecutive
+   * packets of the same size for the same client to the kernel as a single
+   * message, which is split into individual datagrams as late as possible
+   * (or by the network hardware). If the kernel does not support it, packets
+   * are sent individually.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GSO,
+      g_param_spec_boolean ("gso", "GSO",
+          "Coalesce consecutive equal-sized packets to the same client into "
+          "one UDP segmentation offload send when supported", DEFAULT_GSO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMultiUDPSink:gso-sends:
+   *
+   * Number of segmentation offload messages sent, each carrying more than
+   * one packet.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GSO_SENDS,
+      g_param_spec_uint64 ("gso-sends", "GSO sends",
+          "Number of segmentation offload messages sent to all clients",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMultiUDPSink:gso-segments:
+   *
+   * Total number of packets sent as part of segmentation offload messages.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GSO_SEGMENTS,
+      g_param_spec_uint64 ("gso-segments", "GSO segments",
+          "Number of packets sent to all clients as part of segmentation "
+          "offload messages", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
   gst_element_class_set_static_metadata (gstelement_class, "UDP packet sender",
@@ -371,6 +526,10 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
   klass->get_stats = gst_multiudpsink_get_stats;
 
   GST_DEBUG_CATEGORY_INIT (multiudpsink_debug, "multiudpsink", 0, "UDP sink");
+
+#ifdef UDP_SEGMENT
+  GST_TYPE_UDP_SEGMENT_MESSAGE;
+#endif
 }
 
 static void
@@ -419,6 +578,7 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
   sink->qos_dscp = DEFAULT_QOS_DSCP;
   sink->send_duplicates = DEFAULT_SEND_DUPLICATES;
   sink->multi_iface = g_strdup (DEFAULT_MULTICAST_IFACE);
+  sink->gso = DEFAULT_GSO;
 
   gst_multiudpsink_create_cancellable (sink);
 
@@ -557,6 +717,10 @@ gst_multiudpsink_finalize (GObject * object)
   sink->maps = NULL;
   g_free (sink->messages);
   sink->messages = NULL;
+  g_free (sink->msg_gso);
+  sink->msg_gso = NULL;
+  g_free (sink->msg_segments);
+  sink->msg_segments = NULL;
 
   g_free (sink->bind_address);
   sink->bind_address = NULL;
@@ -634,6 +798,11 @@ gst_udp_address_get_string (GSocketAddress * addr, gchar * s, gsize size)
   return s;
 }
 
+#ifdef UDP_SEGMENT
+static GstFlowReturn gst_multiudpsink_send_segments (GstMultiUDPSink * sink,
+    GSocket * socket, GstOutputMessage * msg, GError * err);
+#endif
+
 /* Wrapper around g_socket_send_messages() plus error handling (ignoring).
  * Returns FALSE if we got cancelled, otherwise TRUE. */
 static GstFlowReturn
@@ -674,6 +843,23 @@ gst_multiudpsink_send_messages (GstMultiUDPSink * sink, GSocket * socket,
       msg = &messages[err_idx];
       msg_size = gst_udp_calc_message_size (msg);
 
+#ifdef UDP_SEGMENT
+      /* only segmentation offload messages carry control messages */
+      if (msg->num_control_messages > 0) {
+        GstFlowReturn flow_ret;
+
+        flow_ret = gst_multiudpsink_send_segments (sink, socket, msg, err);
+        g_clear_error (&err);
+
+        if (flow_ret != GST_FLOW_OK)
+          return flow_ret;
+
+        messages += err_idx + 1;
+        num_messages -= err_idx + 1;
+        continue;
+      }
+#endif
+
       GST_LOG_OBJECT (sink, "error sending %u bytes to client %s: %s", msg_size,
           gst_udp_address_get_string (msg->address, astr, sizeof (astr)),
           err->message);
@@ -714,6 +900,130 @@ gst_multiudpsink_send_messages (GstMultiUDPSink * sink, GSocket * socket,
   return GST_FLOW_OK;
 }
 
+#ifdef UDP_SEGMENT
+/* Sends the packets of a segmentation offload message one by one after the
+ * kernel refused it, and stops using segmentation offload if the refusal
+ * means it is not supported for this socket or route */
+static GstFlowReturn
+gst_multiudpsink_send_segments (GstMultiUDPSink * sink, GSocket * socket,
+    GstOutputMessage * msg, GError * err)
+{
+  GstUDPSegmentMessage *gso = GST_UDP_SEGMENT_MESSAGE (msg->control_messages[0]);
+  GstOutputMessage *segments;
+  GstFlowReturn flow_ret;
+  guint i, first_vec = 0, n_segments = 0;
+  gsize size = 0;
+
+  if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_FAILED) ||
+      g_error_matches (err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT) ||
+      g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED) ||
+      g_error_matches (err, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE)) {
+    GST_WARNING_OBJECT (sink, "Disabling UDP segmentation offload: %s",
+        err->message);
+    sink->gso_active = FALSE;
+  }
+
+  /* all segments have gso_size bytes except the last one, and never share
+   * a vector as each of them is a separate buffer */
+  segments = g_newa (GstOutputMessage, UDP_MAX_SEGMENTS);
+  for (i = 0; i < msg->num_vectors; ++i) {
+    size += msg->vectors[i].size;
+
+    if (size >= gso->gso_size || (i == msg->num_vectors - 1 && size > 0)) {
+      g_assert (n_segments < UDP_MAX_SEGMENTS);
+
+      segments[n_segments].address = msg->address;
+      segments[n_segments].vectors = &msg->vectors[first_vec];
+      segments[n_segments].num_vectors = i + 1 - first_vec;
+      segments[n_segments].bytes_sent = 0;
+      segments[n_segments].control_messages = NULL;
+      segments[n_segments].num_control_messages = 0;
+      n_segments++;
+
+      first_vec = i + 1;
+      size = 0;
+    }
+  }
+
+  GST_DEBUG_OBJECT (sink, "sending %u segments of %u bytes separately",
+      n_segments, gso->gso_size);
+
+  flow_ret = gst_multiudpsink_send_messages (sink, socket, segments,
+      n_segments);
+
+  msg->bytes_sent = 0;
+  for (i = 0; i < n_segments; ++i)
+    msg->bytes_sent += segments[i].bytes_sent;
+
+  /* not sent with segmentation offload after all */
+  msg->num_control_messages = 0;
+
+  return flow_ret;
+}
+#endif
+
+/* Merges runs of consecutive messages of the same size, of which only the
+ * last may be shorter, into single UDP_SEGMENT messages. The vectors of
+ * consecutive messages are contiguous, so merging only needs to extend the
+ * vector count. Returns the new number of messages. */
+static guint
+gst_multiudpsink_coalesce_messages (GstMultiUDPSink * sink,
+    GstOutputMessage * msgs, guint num_msgs)
+{
+#ifdef UDP_SEGMENT
+  guint i, n;
+
+  if (sink->n_msg_gso < num_msgs) {
+    sink->n_msg_gso = GST_ROUND_UP_16 (num_msgs);
+    g_free (sink->msg_gso);
+    sink->msg_gso = g_new (GSocketControlMessage *, sink->n_msg_gso);
+    g_free (sink->msg_segments);
+    sink->msg_segments = g_new (guint, sink->n_msg_gso);
+  }
+
+  for (i = 0, n = 0; i < num_msgs; ++n) {
+    GstOutputMessage msg = msgs[i];
+    gsize seg_size, total;
+    guint n_segs = 1;
+
+    seg_size = total = gst_udp_calc_message_size (&msg);
+
+    while (seg_size > 0 && seg_size <= G_MAXUINT16 && i + n_segs < num_msgs
+        && n_segs < UDP_MAX_SEGMENTS) {
+      gsize size = gst_udp_calc_message_size (&msgs[i + n_segs]);
+
+      if (size == 0 || size > seg_size || total + size > UDP_MAX_SIZE)
+        break;
+
+      msg.num_vectors += msgs[i + n_segs].num_vectors;
+      total += size;
+      n_segs++;
+
+      /* only the last segment can be shorter */
+      if (size < seg_size)
+        break;
+    }
+
+    sink->msg_gso[n] = NULL;
+    if (n_segs > 1) {
+      sink->msg_gso[n] = gst_udp_segment_message_new (seg_size);
+      msg.control_messages = &sink->msg_gso[n];
+      msg.num_control_messages = 1;
+    }
+    sink->msg_segments[n] = n_segs;
+
+    msgs[n] = msg;
+    i += n_segs;
+  }
+
+  GST_LOG_OBJECT (sink, "coalesced %u packets into %u messages", num_msgs, n);
+
+  return n;
+#else
+  return num_msgs;
+#endif
+}
+
 static void
 _set_time_on_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
     guint num_buffers)
@@ -747,7 +1057,8 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
   GstMapInfo *map_infos;
   GstFlowReturn flow_ret;
   guint num_addr_v4, num_addr_v6;
-  guint num_addr, num_msgs;
+  guint num_addr, num_msgs, num_client_msgs;
+  gboolean coalesced = FALSE;
   guint i, j, mem;
   gsize size = 0;
   GList *l;
@@ -821,12 +1132,20 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
   /* FIXME: how about some locking? (there wasn't any before either, but..) */
   sink->bytes_to_serve += size;
 
-  /* now copy the pre-filled num_buffer messages over to the next num_buffer
-   * messages for the next client, where we also change the target address */
+  num_client_msgs = num_buffers;
+  if (sink->gso_active && num_buffers > 1) {
+    num_client_msgs =
+        gst_multiudpsink_coalesce_messages (sink, msgs, num_buffers);
+    coalesced = TRUE;
+  }
+  num_msgs = num_addr * num_client_msgs;
+
+  /* now copy the pre-filled messages over to the next messages for the
+   * next client, where we also change the target address */
   for (i = 1; i < num_addr; ++i) {
-    for (j = 0; j < num_buffers; ++j) {
-      msgs[i * num_buffers + j] = msgs[j];
-      msgs[i * num_buffers + j].address = clients[i]->addr;
+    for (j = 0; j < num_client_msgs; ++j) {
+      msgs[i * num_client_msgs + j] = msgs[j];
+      msgs[i * num_client_msgs + j].address = clients[i]->addr;
     }
   }
 
@@ -837,8 +1156,8 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
     flow_ret = gst_multiudpsink_send_messages (sink, sink->used_socket_v6,
         msgs, num_msgs);
   } else {
-    guint num_msgs_v4 = num_buffers * num_addr_v4;
-    guint num_msgs_v6 = num_buffers * num_addr_v6;
+    guint num_msgs_v4 = num_client_msgs * num_addr_v4;
+    guint num_msgs_v6 = num_client_msgs * num_addr_v6;
 
     /* our client list is sorted with IPv4 clients first and IPv6 ones last */
     flow_ret = gst_multiudpsink_send_messages (sink, sink->used_socket,
@@ -863,15 +1182,18 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
   for (i = 0; i < num_addr; ++i) {
     GstUDPClient *client = clients[i];
 
-    for (j = 0; j < num_buffers; ++j) {
-      gsize bytes_sent;
-
-      bytes_sent = msgs[i * num_buffers + j].bytes_sent;
+    for (j = 0; j < num_client_msgs; ++j) {
+      GstOutputMessage *msg = &msgs[i * num_client_msgs + j];
+      guint packets = coalesced ? sink->msg_segments[j] : 1;
 
+      client->bytes_sent += msg->bytes_sent;
+      client->packets_sent += packets;
+      sink->bytes_served += msg->bytes_sent;
 
-      client->bytes_sent += bytes_sent;
-      client->packets_sent++;
-      sink->bytes_served += bytes_sent;
+      if (msg->num_control_messages > 0) {
+        sink->gso_sends++;
+        sink->gso_segments += packets;
+      }
     }
     gst_udp_client_unref (client);
   }
@@ -880,6 +1202,11 @@ gst_multiudpsink_render_buffers (GstMultiUDPSink * sink, GstBuffer ** buffers,
 
 out:
 
+  for (i = 0; coalesced && i < num_client_msgs; ++i) {
+    if (sink->msg_gso[i])
+      g_object_unref (sink->msg_gso[i]);
+  }
+
   for (i = 0; i < mem; ++i)
     gst_memory_unmap (map_infos[i].memory, &map_infos[i]);
 
@@ -1120,6 +1447,9 @@ gst_multiudpsink_set_property (GObject * object, guint prop_id,
     case PROP_BIND_PORT:
       udpsink->bind_port = g_value_get_int (value);
       break;
+    case PROP_GSO:
+      udpsink->gso = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1193,6 +1523,15 @@ gst_multiudpsink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BIND_PORT:
       g_value_set_int (value, udpsink->bind_port);
       break;
+    case PROP_GSO:
+      g_value_set_boolean (value, udpsink->gso);
+      break;
+    case PROP_GSO_SENDS:
+      g_value_set_uint64 (value, udpsink->gso_sends);
+      break;
+    case PROP_GSO_SEGMENTS:
+      g_value_set_uint64 (value, udpsink->gso_segments);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1257,6 +1596,32 @@ invalid_family:
   }
 }
 
+static gboolean
+gst_multiudpsink_check_gso (GstMultiUDPSink * sink, GSocket * socket)
+{
+#ifdef UDP_SEGMENT
+  GError *err = NULL;
+  gint val;
+
+  if (socket == NULL)
+    return TRUE;
+
+  /* kernels that know UDP_SEGMENT as a socket option also accept it as
+   * a control message */
+  if (!g_socket_get_option (socket, IPPROTO_UDP, UDP_SEGMENT, &val, &err)) {
+    GST_WARNING_OBJECT (sink, "UDP segmentation offload not supported: %s",
+        err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  return TRUE;
+#else
+  GST_WARNING_OBJECT (sink, "UDP segmentation offload not supported");
+  return FALSE;
+#endif
+}
+
 /* create a socket for sending to remote machine */
 static gboolean
 gst_multiudpsink_start (GstBaseSink * bsink)
@@ -1450,6 +1815,12 @@ gst_multiudpsink_start (GstBaseSink * bsink)
 
   sink->bytes_to_serve = 0;
   sink->bytes_served = 0;
+  sink->gso_sends = 0;
+  sink->gso_segments = 0;
+
+  sink->gso_active = sink->gso
+      && gst_multiudpsink_check_gso (sink, sink->used_socket)
+      && gst_multiudpsink_check_gso (sink, sink->used_socket_v6);
 
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket);
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket_v6);
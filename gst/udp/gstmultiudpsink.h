@@ -82,6 +82,13 @@ struct _GstMultiUDPSink {
   GstOutputMessage *messages;
   guint             n_messages;
 
+  /* segmentation offload control message and number of packets for each
+   * message sent to a client, shared between all clients */
+  GSocketControlMessage **msg_gso;
+  guint            *msg_segments;
+  guint             n_msg_gso;
+  gboolean          gso_active;
+
   /* properties */
   guint64        bytes_to_serve;
   guint64        bytes_served;
@@ -102,6 +109,11 @@ struct _GstMultiUDPSink {
   gint           buffer_size;
   gchar         *bind_address;
   gint           bind_port;
+  gboolean       gso;
+
+  /* stats */
+  guint64        gso_sends;
+  guint64        gso_segments;
 };
 
 struct _GstMultiUDPSinkClass {
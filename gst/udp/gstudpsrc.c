@@ -112,6 +112,9 @@
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_LINUX_NET_TSTAMP_H
+#include <linux/net_tstamp.h>
+#endif
 
 #include <string.h>
 #include "gstudpelements.h"
@@ -414,6 +417,10 @@ gst_socket_timestamp_mode_get_type (void)
     {GST_SOCKET_TIMESTAMP_MODE_REALTIME,
           "Timestamp with realtime clock (nsec resolution, may not be monotonic)",
         "realtime"},
+    {GST_SOCKET_TIMESTAMP_MODE_TIMESTAMPING,
+          "Timestamp with SO_TIMESTAMPING software receive timestamps, taken "
+          "by the kernel when the packet arrives",
+        "timestamping"},
     {0, NULL, NULL}
   };
 
@@ -425,6 +432,10 @@ gst_socket_timestamp_mode_get_type (void)
   return socket_timestamp_mode_type;
 }
 
+#if defined(SO_TIMESTAMPING) && defined(HAVE_LINUX_NET_TSTAMP_H)
+#define HAVE_SO_TIMESTAMPING
+#endif
+
 #ifdef SO_TIMESTAMPNS
 GType gst_socket_timestamp_message_get_type (void);
 
@@ -479,6 +490,30 @@ gst_socket_timestamp_message_deserialize (gint level,
   if (level != SOL_SOCKET)
     return NULL;
 
+#ifdef HAVE_SO_TIMESTAMPING
+  if (type == SCM_TIMESTAMPING) {
+    struct timespec ts[3];
+
+    /* struct scm_timestamping: ts[0] is the software timestamp in the
+     * CLOCK_REALTIME domain. ts[2] is the raw hardware one, which is in the
+     * clock domain of the NIC and never requested */
+    if (size < sizeof (ts))
+      return NULL;
+
+    memcpy (ts, data, sizeof (ts));
+    if (ts[0].tv_sec == 0 && ts[0].tv_nsec == 0)
+      return NULL;
+
+    message = g_object_new (GST_TYPE_SOCKET_TIMESTAMP_MESSAGE, NULL);
+    message->socket_ts = ts[0];
+
+    return G_SOCKET_CONTROL_MESSAGE (message);
+  }
+#endif
+
+  if (type != SCM_TIMESTAMPNS)
+    return NULL;
+
   if (size < sizeof (struct timespec))
     return NULL;
 
@@ -570,6 +605,7 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
 #define UDP_DEFAULT_LOOP               TRUE
 #define UDP_DEFAULT_RETRIEVE_SENDER_ADDRESS TRUE
 #define UDP_DEFAULT_MTU                (1492)
+#define UDP_DEFAULT_BATCH_SIZE         1
 
 enum
 {
@@ -593,6 +629,7 @@ enum
   PROP_RETRIEVE_SENDER_ADDRESS,
   PROP_MTU,
   PROP_SOCKET_TIMESTAMP,
+  PROP_BATCH_SIZE,
 };
 
 static void gst_udpsrc_uri_handler_init (gpointer g_iface, gpointer iface_data);
@@ -602,6 +639,9 @@ static gboolean gst_udpsrc_close (GstUDPSrc * src);
 static gboolean gst_udpsrc_unlock (GstBaseSrc * bsrc);
 static gboolean gst_udpsrc_unlock_stop (GstBaseSrc * bsrc);
 static GstFlowReturn gst_udpsrc_fill (GstPushSrc * psrc, GstBuffer * outbuf);
+static GstFlowReturn gst_udpsrc_create (GstBaseSrc * bsrc, guint64 offset,
+    guint length, GstBuffer ** buf);
+static void gst_udpsrc_free_batch (GstUDPSrc * udpsrc);
 
 static void gst_udpsrc_finalize (GObject * object);
 
@@ -770,6 +810,12 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
    * Can be used to read the timestamp on incoming buffers using socket
    * control messages and set as the DTS.
    *
+   * With the `timestamping` mode the kernel timestamps packets with
+   * SO_TIMESTAMPING when they arrive from the network driver, so the DTS
+   * reflects the arrival time rather than the time the streaming thread got
+   * to read the packet. If SO_TIMESTAMPING is not available, the `realtime`
+   * mode is used instead, without changing the property.
+   *
    * Since: 1.20
    */
   g_object_class_install_property (gobject_class, PROP_SOCKET_TIMESTAMP,
@@ -779,6 +825,22 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
           GST_SOCKET_TIMESTAMP_MODE, GST_SOCKET_TIMESTAMP_MODE_REALTIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstUDPSrc:batch-size:
+   *
+   * Maximum number of packets to read from the socket per wakeup. When
+   * bigger than 1, packets are read with a single system call where
+   * supported (recvmmsg) and pushed downstream as a #GstBufferList.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch Size",
+          "Maximum number of packets to read per wakeup and push as a "
+          "buffer list (1 = no batching)", 1, G_MAXUINT16,
+          UDP_DEFAULT_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -793,6 +855,7 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
   gstbasesrc_class->unlock_stop = gst_udpsrc_unlock_stop;
   gstbasesrc_class->get_caps = gst_udpsrc_getcaps;
   gstbasesrc_class->decide_allocation = gst_udpsrc_decide_allocation;
+  gstbasesrc_class->create = gst_udpsrc_create;
 
   gstpushsrc_class->fill = gst_udpsrc_fill;
 
@@ -821,6 +884,7 @@ gst_udpsrc_init (GstUDPSrc * udpsrc)
   udpsrc->loop = UDP_DEFAULT_LOOP;
   udpsrc->retrieve_sender_address = UDP_DEFAULT_RETRIEVE_SENDER_ADDRESS;
   udpsrc->mtu = UDP_DEFAULT_MTU;
+  udpsrc->batch_size = UDP_DEFAULT_BATCH_SIZE;
 
   /* configure basesrc to be a live source */
   gst_base_src_set_live (GST_BASE_SRC (udpsrc), TRUE);
@@ -863,6 +927,8 @@ gst_udpsrc_finalize (GObject * object)
     gst_memory_unref (udpsrc->extra_mem);
   udpsrc->extra_mem = NULL;
 
+  gst_udpsrc_free_batch (udpsrc);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -912,81 +978,61 @@ gst_udpsrc_free_cancellable (GstUDPSrc * src)
   src->cancellable = NULL;
 }
 
-static GstFlowReturn
-gst_udpsrc_fill (GstPushSrc * psrc, GstBuffer * outbuf)
+/* optimization: use messages only in multicast mode and
+ * if we can't let the kernel do the filtering for us */
+static gboolean
+gst_udpsrc_need_control_messages (GstUDPSrc * udpsrc)
 {
-  GstUDPSrc *udpsrc;
-  GSocketAddress *saddr = NULL;
-  GSocketAddress **p_saddr;
-  gint flags = G_SOCKET_MSG_NONE;
-  gboolean try_again;
-  GError *err = NULL;
-  gssize res;
-  gsize offset;
-  GSocketControlMessage **msgs = NULL;
-  GSocketControlMessage ***p_msgs;
-  gint n_msgs = 0, i;
-  GstMapInfo info;
-  GstMapInfo extra_info;
-  GInputVector ivec[2];
+  gboolean need_msgs;
 
-  udpsrc = GST_UDPSRC_CAST (psrc);
-
-  /* optimization: use messages only in multicast mode and
-   * if we can't let the kernel do the filtering for us */
-  p_msgs =
-      (g_inet_address_get_is_multicast (g_inet_socket_address_get_address
-          (udpsrc->addr))) ? &msgs : NULL;
+  need_msgs =
+      g_inet_address_get_is_multicast (g_inet_socket_address_get_address
+      (udpsrc->addr));
 #ifdef IP_MULTICAST_ALL
   if (g_inet_address_get_family (g_inet_socket_address_get_address
           (udpsrc->addr)) == G_SOCKET_FAMILY_IPV4)
-    p_msgs = NULL;
+    need_msgs = FALSE;
 #endif
 #ifdef SO_TIMESTAMPNS
-  if (udpsrc->socket_timestamp_mode == GST_SOCKET_TIMESTAMP_MODE_REALTIME)
-    p_msgs = &msgs;
+  if (udpsrc->effective_timestamp_mode != GST_SOCKET_TIMESTAMP_MODE_DISABLED)
+    need_msgs = TRUE;
 #endif
 
-  /* Retrieve sender address unless we've been configured not to do so */
-  p_saddr = (udpsrc->retrieve_sender_address) ? &saddr : NULL;
-
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_READWRITE))
-    goto buffer_map_error;
-
-  ivec[0].buffer = info.data;
-  ivec[0].size = info.size;
-
-  /* Prepare memory in case the data size exceeds mtu */
-  if (udpsrc->extra_mem == NULL) {
-    GstBufferPool *pool;
-    GstStructure *config;
-    GstAllocator *allocator = NULL;
-    GstAllocationParams params;
+  return need_msgs;
+}
 
-    pool = gst_base_src_get_buffer_pool (GST_BASE_SRC_CAST (psrc));
-    config = gst_buffer_pool_get_config (pool);
-    gst_buffer_pool_config_get_allocator (config, &allocator, &params);
+/* Memory that is appended to the receive buffer in case the data size
+ * exceeds the mtu */
+static GstMemory *
+gst_udpsrc_alloc_extra_mem (GstUDPSrc * udpsrc)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+  GstMemory *mem;
 
-    udpsrc->extra_mem =
-        gst_allocator_alloc (allocator, MAX_IPV4_UDP_PACKET_SIZE, &params);
+  pool = gst_base_src_get_buffer_pool (GST_BASE_SRC_CAST (udpsrc));
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_get_allocator (config, &allocator, &params);
 
-    gst_object_unref (pool);
-    gst_structure_free (config);
-    if (allocator)
-      gst_object_unref (allocator);
-  }
+  mem = gst_allocator_alloc (allocator, MAX_IPV4_UDP_PACKET_SIZE, &params);
 
-  if (!gst_memory_map (udpsrc->extra_mem, &extra_info, GST_MAP_READWRITE))
-    goto memory_map_error;
+  gst_object_unref (pool);
+  gst_structure_free (config);
+  if (allocator)
+    gst_object_unref (allocator);
 
-  ivec[1].buffer = extra_info.data;
-  ivec[1].size = extra_info.size;
+  return mem;
+}
 
-retry:
-  if (saddr != NULL) {
-    g_object_unref (saddr);
-    saddr = NULL;
-  }
+/* Waits for the socket to become readable, posting a timeout message
+ * every time the configured timeout expires */
+static GstFlowReturn
+gst_udpsrc_wait (GstUDPSrc * udpsrc)
+{
+  GError *err = NULL;
+  gboolean try_again;
 
   do {
     gint64 timeout;
@@ -1020,133 +1066,215 @@ retry:
     }
   } while (G_UNLIKELY (try_again));
 
-  res =
-      g_socket_receive_message (udpsrc->used_socket, p_saddr, ivec, 2,
-      p_msgs, &n_msgs, &flags, udpsrc->cancellable, &err);
+  return GST_FLOW_OK;
 
-  if (G_UNLIKELY (res < 0)) {
-    /* G_IO_ERROR_HOST_UNREACHABLE for a UDP socket means that a packet sent
-     * with udpsink generated a "port unreachable" ICMP response. We ignore
-     * that and try again.
-     * On Windows we get G_IO_ERROR_CONNECTION_CLOSED instead */
-    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE) ||
-        g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED)) {
-      g_clear_error (&err);
-      goto retry;
-    }
-    goto receive_error;
+  /* ERRORS */
+select_error:
+  {
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+        ("select error: %s", err->message));
+    g_clear_error (&err);
+    return GST_FLOW_ERROR;
   }
+stopped:
+  {
+    GST_DEBUG ("stop called");
+    g_clear_error (&err);
+    return GST_FLOW_FLUSHING;
+  }
+}
 
-  /* Retry if multicast and the destination address is not ours. We don't want
-   * to receive arbitrary packets */
-  if (p_msgs) {
-    GInetAddress *iaddr = g_inet_socket_address_get_address (udpsrc->addr);
-    gboolean skip_packet = FALSE;
-    gsize iaddr_size = g_inet_address_get_native_size (iaddr);
-    const guint8 *iaddr_bytes = g_inet_address_to_bytes (iaddr);
+/* Applies the control messages received along with @outbuf and frees them.
+ * Returns %TRUE if the packet was sent to a different multicast address
+ * and should be dropped */
+static gboolean
+gst_udpsrc_process_control_messages (GstUDPSrc * udpsrc,
+    GSocketControlMessage ** msgs, guint n_msgs, GstBuffer * outbuf)
+{
+  GInetAddress *iaddr = g_inet_socket_address_get_address (udpsrc->addr);
+  gboolean skip_packet = FALSE;
+  gsize iaddr_size = g_inet_address_get_native_size (iaddr);
+  const guint8 *iaddr_bytes = g_inet_address_to_bytes (iaddr);
+  guint i;
 
-    for (i = 0; i < n_msgs && !skip_packet; i++) {
+  for (i = 0; i < n_msgs && !skip_packet; i++) {
 #ifdef IP_PKTINFO
-      if (GST_IS_IP_PKTINFO_MESSAGE (msgs[i])) {
-        GstIPPktinfoMessage *msg = GST_IP_PKTINFO_MESSAGE (msgs[i]);
+    if (GST_IS_IP_PKTINFO_MESSAGE (msgs[i])) {
+      GstIPPktinfoMessage *msg = GST_IP_PKTINFO_MESSAGE (msgs[i]);
 
-        if (sizeof (msg->addr) == iaddr_size
-            && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
-          skip_packet = TRUE;
-      }
+      if (sizeof (msg->addr) == iaddr_size
+          && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
+        skip_packet = TRUE;
+    }
 #endif
 #ifdef IPV6_PKTINFO
-      if (GST_IS_IPV6_PKTINFO_MESSAGE (msgs[i])) {
-        GstIPV6PktinfoMessage *msg = GST_IPV6_PKTINFO_MESSAGE (msgs[i]);
+    if (GST_IS_IPV6_PKTINFO_MESSAGE (msgs[i])) {
+      GstIPV6PktinfoMessage *msg = GST_IPV6_PKTINFO_MESSAGE (msgs[i]);
 
-        if (sizeof (msg->addr) == iaddr_size
-            && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
-          skip_packet = TRUE;
-      }
+      if (sizeof (msg->addr) == iaddr_size
+          && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
+        skip_packet = TRUE;
+    }
 #endif
 #ifdef IP_RECVDSTADDR
-      if (GST_IS_IP_RECVDSTADDR_MESSAGE (msgs[i])) {
-        GstIPRecvdstaddrMessage *msg = GST_IP_RECVDSTADDR_MESSAGE (msgs[i]);
+    if (GST_IS_IP_RECVDSTADDR_MESSAGE (msgs[i])) {
+      GstIPRecvdstaddrMessage *msg = GST_IP_RECVDSTADDR_MESSAGE (msgs[i]);
 
-        if (sizeof (msg->addr) == iaddr_size
-            && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
-          skip_packet = TRUE;
-      }
+      if (sizeof (msg->addr) == iaddr_size
+          && memcmp (iaddr_bytes, &msg->addr, sizeof (msg->addr)))
+        skip_packet = TRUE;
+    }
 #endif
 #ifdef SO_TIMESTAMPNS
-      if (GST_IS_SOCKET_TIMESTAMP_MESSAGE (msgs[i])) {
-        GstSocketTimestampMessage *msg = GST_SOCKET_TIMESTAMP_MESSAGE (msgs[i]);
-        GstClock *clock;
-        GstClockTime socket_ts;
-
-        socket_ts = GST_TIMESPEC_TO_TIME (msg->socket_ts);
-        GST_TRACE_OBJECT (udpsrc,
-            "Got SCM_TIMESTAMPNS %" GST_TIME_FORMAT " in msg",
-            GST_TIME_ARGS (socket_ts));
-
-        clock = gst_element_get_clock (GST_ELEMENT_CAST (udpsrc));
-        if (clock != NULL) {
-          gint64 adjust_dts, cur_sys_time, delta;
-          GstClockTime base_time, cur_gst_clk_time, running_time;
-
+    if (GST_IS_SOCKET_TIMESTAMP_MESSAGE (msgs[i])) {
+      GstSocketTimestampMessage *msg = GST_SOCKET_TIMESTAMP_MESSAGE (msgs[i]);
+      GstClock *clock;
+      GstClockTime socket_ts;
+
+      socket_ts = GST_TIMESPEC_TO_TIME (msg->socket_ts);
+      GST_TRACE_OBJECT (udpsrc,
+          "Got socket timestamp %" GST_TIME_FORMAT " in msg",
+          GST_TIME_ARGS (socket_ts));
+
+      clock = gst_element_get_clock (GST_ELEMENT_CAST (udpsrc));
+      if (clock != NULL) {
+        gint64 adjust_dts, cur_sys_time, delta;
+        GstClockTime base_time, cur_gst_clk_time, running_time;
+
+        /*
+         * We use g_get_real_time as the time reference for SCM timestamps
+         * is always CLOCK_REALTIME.
+         */
+        cur_sys_time = g_get_real_time () * GST_USECOND;
+        cur_gst_clk_time = gst_clock_get_time (clock);
+        base_time = gst_element_get_base_time (GST_ELEMENT_CAST (udpsrc));
+        running_time = (cur_gst_clk_time > base_time) ?
+            cur_gst_clk_time - base_time : 0;
+
+        delta = (gint64) cur_sys_time - (gint64) socket_ts;
+        if (delta < 0) {
           /*
-           * We use g_get_real_time as the time reference for SCM timestamps
-           * is always CLOCK_REALTIME.
+           * The current system time will always be greater than the SCM
+           * timestamp as the packet would have been timestamped at least
+           * some clock cycles before. If it is not, then the system time
+           * was adjusted. Since we cannot rely on the delta calculation in
+           * such a case, set the DTS to the current running time when this
+           * happens.
            */
-          cur_sys_time = g_get_real_time () * GST_USECOND;
-          cur_gst_clk_time = gst_clock_get_time (clock);
-
-          delta = (gint64) cur_sys_time - (gint64) socket_ts;
-          if (delta < 0) {
-            /*
-             * The current system time will always be greater than the SCM
-             * timestamp as the packet would have been timestamped at least
-             * some clock cycles before. If it is not, then the system time
-             * was adjusted. Since we cannot rely on the delta calculation in
-             * such a case, set the DTS to current pipeline clock when this
-             * happens.
-             */
+          GST_LOG_OBJECT (udpsrc,
+              "Current system time is behind SCM timestamp, setting DTS to running time");
+          GST_BUFFER_DTS (outbuf) = running_time;
+        } else {
+          adjust_dts = (gint64) running_time - delta;
+          /*
+           * If the system time was adjusted much further ahead, we might
+           * end up with delta > running_time. Set the DTS to the current
+           * running time for this scenario as well.
+           */
+          if (adjust_dts < 0) {
             GST_LOG_OBJECT (udpsrc,
-                "Current system time is behind SCM timestamp, setting DTS to pipeline clock");
-            GST_BUFFER_DTS (outbuf) = cur_gst_clk_time;
+                "Current system time much ahead in time, setting DTS to running time");
+            GST_BUFFER_DTS (outbuf) = running_time;
           } else {
-            base_time = gst_element_get_base_time (GST_ELEMENT_CAST (udpsrc));
-            running_time = cur_gst_clk_time - base_time;
-            adjust_dts = (gint64) running_time - delta;
-            /*
-             * If the system time was adjusted much further ahead, we might
-             * end up with delta > cur_gst_clk_time. Set the DTS to current
-             * pipeline clock for this scenario as well.
-             */
-            if (adjust_dts < 0) {
-              GST_LOG_OBJECT (udpsrc,
-                  "Current system time much ahead in time, setting DTS to pipeline clock");
-              GST_BUFFER_DTS (outbuf) = cur_gst_clk_time;
-            } else {
-              GST_BUFFER_DTS (outbuf) = adjust_dts;
-              GST_LOG_OBJECT (udpsrc, "Setting DTS to %" GST_TIME_FORMAT,
-                  GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)));
-            }
+            GST_BUFFER_DTS (outbuf) = adjust_dts;
+            GST_LOG_OBJECT (udpsrc, "Setting DTS to %" GST_TIME_FORMAT
+                " (received %" GST_TIME_FORMAT " ago)",
+                GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)),
+                GST_TIME_ARGS (delta));
           }
-          g_object_unref (clock);
-        } else {
-          GST_ERROR_OBJECT (udpsrc,
-              "Failed to get element clock, not setting DTS");
         }
+        g_object_unref (clock);
+      } else {
+        GST_ERROR_OBJECT (udpsrc,
+            "Failed to get element clock, not setting DTS");
       }
-#endif
     }
+#endif
+  }
 
-    for (i = 0; i < n_msgs; i++) {
-      g_object_unref (msgs[i]);
-    }
-    g_free (msgs);
+  for (i = 0; i < n_msgs; i++) {
+    g_object_unref (msgs[i]);
+  }
+  g_free (msgs);
+
+  return skip_packet;
+}
+
+static GstFlowReturn
+gst_udpsrc_fill (GstPushSrc * psrc, GstBuffer * outbuf)
+{
+  GstUDPSrc *udpsrc;
+  GSocketAddress *saddr = NULL;
+  GSocketAddress **p_saddr;
+  gint flags = G_SOCKET_MSG_NONE;
+  GError *err = NULL;
+  GstFlowReturn ret;
+  gssize res;
+  gsize offset;
+  GSocketControlMessage **msgs = NULL;
+  GSocketControlMessage ***p_msgs;
+  gint n_msgs = 0;
+  GstMapInfo info;
+  GstMapInfo extra_info;
+  GInputVector ivec[2];
+
+  udpsrc = GST_UDPSRC_CAST (psrc);
+
+  p_msgs = gst_udpsrc_need_control_messages (udpsrc) ? &msgs : NULL;
+
+  /* Retrieve sender address unless we've been configured not to do so */
+  p_saddr = (udpsrc->retrieve_sender_address) ? &saddr : NULL;
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READWRITE))
+    goto buffer_map_error;
+
+  ivec[0].buffer = info.data;
+  ivec[0].size = info.size;
+
+  /* Prepare memory in case the data size exceeds mtu */
+  if (udpsrc->extra_mem == NULL)
+    udpsrc->extra_mem = gst_udpsrc_alloc_extra_mem (udpsrc);
+
+  if (!gst_memory_map (udpsrc->extra_mem, &extra_info, GST_MAP_READWRITE))
+    goto memory_map_error;
+
+  ivec[1].buffer = extra_info.data;
+  ivec[1].size = extra_info.size;
+
+retry:
+  if (saddr != NULL) {
+    g_object_unref (saddr);
+    saddr = NULL;
+  }
 
-    if (skip_packet) {
-      GST_DEBUG_OBJECT (udpsrc,
-          "Dropping packet for a different multicast address");
+  ret = gst_udpsrc_wait (udpsrc);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    goto wait_failed;
+
+  res =
+      g_socket_receive_message (udpsrc->used_socket, p_saddr, ivec, 2,
+      p_msgs, &n_msgs, &flags, udpsrc->cancellable, &err);
+
+  if (G_UNLIKELY (res < 0)) {
+    /* G_IO_ERROR_HOST_UNREACHABLE for a UDP socket means that a packet sent
+     * with udpsink generated a "port unreachable" ICMP response. We ignore
+     * that and try again.
+     * On Windows we get G_IO_ERROR_CONNECTION_CLOSED instead */
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE) ||
+        g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED)) {
+      g_clear_error (&err);
       goto retry;
     }
+    goto receive_error;
+  }
+
+  /* Retry if multicast and the destination address is not ours. We don't want
+   * to receive arbitrary packets */
+  if (p_msgs && gst_udpsrc_process_control_messages (udpsrc, msgs, n_msgs,
+          outbuf)) {
+    GST_DEBUG_OBJECT (udpsrc,
+        "Dropping packet for a different multicast address");
+    goto retry;
   }
 
   gst_buffer_unmap (outbuf, &info);
@@ -1192,22 +1320,11 @@ memory_map_error:
         ("Failed to map memory"));
     return GST_FLOW_ERROR;
   }
-select_error:
+wait_failed:
   {
     gst_buffer_unmap (outbuf, &info);
     gst_memory_unmap (udpsrc->extra_mem, &extra_info);
-    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
-        ("select error: %s", err->message));
-    g_clear_error (&err);
-    return GST_FLOW_ERROR;
-  }
-stopped:
-  {
-    gst_buffer_unmap (outbuf, &info);
-    gst_memory_unmap (udpsrc->extra_mem, &extra_info);
-    GST_DEBUG ("stop called");
-    g_clear_error (&err);
-    return GST_FLOW_FLUSHING;
+    return ret;
   }
 receive_error:
   {
@@ -1234,6 +1351,297 @@ skip_error:
   }
 }
 
+struct _GstUDPSrcBatchSlot
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstMemory *extra_mem;
+  GstMapInfo extra_map;
+  GInputVector ivec[2];
+  GSocketAddress *saddr;
+  GSocketControlMessage **msgs;
+  guint n_msgs;
+};
+
+static void
+gst_udpsrc_free_batch (GstUDPSrc * udpsrc)
+{
+  guint i;
+
+  for (i = 0; i < udpsrc->n_batch_slots; i++) {
+    GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+
+    if (slot->buf)
+      gst_buffer_unref (slot->buf);
+    if (slot->extra_mem)
+      gst_memory_unref (slot->extra_mem);
+  }
+
+  g_free (udpsrc->batch_slots);
+  udpsrc->batch_slots = NULL;
+  g_free (udpsrc->batch_msgs);
+  udpsrc->batch_msgs = NULL;
+  udpsrc->n_batch_slots = 0;
+}
+
+static void
+gst_udpsrc_unmap_batch (GstUDPSrc * udpsrc, guint n_mapped)
+{
+  guint i;
+
+  for (i = 0; i < n_mapped; i++) {
+    GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+
+    gst_buffer_unmap (slot->buf, &slot->map);
+    gst_memory_unmap (slot->extra_mem, &slot->extra_map);
+  }
+}
+
+static GstClockTime
+gst_udpsrc_get_running_time (GstUDPSrc * udpsrc)
+{
+  GstClock *clock;
+  GstClockTime base_time, now;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (udpsrc));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  base_time = gst_element_get_base_time (GST_ELEMENT_CAST (udpsrc));
+  gst_object_unref (clock);
+
+  return (now > base_time) ? now - base_time : 0;
+}
+
+/* Receives up to batch-size packets with a single g_socket_receive_messages()
+ * call (recvmmsg on Linux) into buffers acquired from the pool and submits
+ * them downstream as one buffer list */
+static GstFlowReturn
+gst_udpsrc_create_batch (GstUDPSrc * udpsrc)
+{
+  GstBufferPool *pool;
+  GstBufferList *list = NULL;
+  GstClockTime running_time;
+  GError *err = NULL;
+  GstFlowReturn ret;
+  gboolean need_msgs;
+  guint n_slots, n_mapped = 0;
+  gsize offset;
+  gint res, i;
+
+  if (udpsrc->n_batch_slots != udpsrc->batch_size) {
+    gst_udpsrc_free_batch (udpsrc);
+    udpsrc->batch_slots = g_new0 (GstUDPSrcBatchSlot, udpsrc->batch_size);
+    udpsrc->batch_msgs = g_new0 (GInputMessage, udpsrc->batch_size);
+    udpsrc->n_batch_slots = udpsrc->batch_size;
+  }
+  n_slots = udpsrc->n_batch_slots;
+
+  need_msgs = gst_udpsrc_need_control_messages (udpsrc);
+  offset = udpsrc->skip_first_bytes;
+
+  pool = gst_base_src_get_buffer_pool (GST_BASE_SRC_CAST (udpsrc));
+
+  do {
+    /* Slots that were not filled by the previous read keep their buffers */
+    for (n_mapped = 0; n_mapped < n_slots; n_mapped++) {
+      GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[n_mapped];
+      GInputMessage *msg = &udpsrc->batch_msgs[n_mapped];
+
+      if (slot->buf == NULL) {
+        ret = gst_buffer_pool_acquire_buffer (pool, &slot->buf, NULL);
+        if (G_UNLIKELY (ret != GST_FLOW_OK))
+          goto acquire_failed;
+      }
+      if (slot->extra_mem == NULL)
+        slot->extra_mem = gst_udpsrc_alloc_extra_mem (udpsrc);
+
+      if (!gst_buffer_map (slot->buf, &slot->map, GST_MAP_READWRITE))
+        goto map_error;
+      if (!gst_memory_map (slot->extra_mem, &slot->extra_map,
+              GST_MAP_READWRITE)) {
+        gst_buffer_unmap (slot->buf, &slot->map);
+        goto map_error;
+      }
+
+      slot->ivec[0].buffer = slot->map.data;
+      slot->ivec[0].size = slot->map.size;
+      slot->ivec[1].buffer = slot->extra_map.data;
+      slot->ivec[1].size = slot->extra_map.size;
+
+      msg->address = udpsrc->retrieve_sender_address ? &slot->saddr : NULL;
+      msg->vectors = slot->ivec;
+      msg->num_vectors = 2;
+      msg->bytes_received = 0;
+      msg->flags = 0;
+      msg->control_messages = need_msgs ? &slot->msgs : NULL;
+      msg->num_control_messages = need_msgs ? &slot->n_msgs : NULL;
+    }
+
+  retry:
+    ret = gst_udpsrc_wait (udpsrc);
+    if (G_UNLIKELY (ret != GST_FLOW_OK))
+      goto wait_failed;
+
+    res = g_socket_receive_messages (udpsrc->used_socket, udpsrc->batch_msgs,
+        n_slots, G_SOCKET_MSG_NONE, udpsrc->cancellable, &err);
+
+    if (G_UNLIKELY (res < 0)) {
+      /* See gst_udpsrc_fill() */
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE) ||
+          g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED)) {
+        g_clear_error (&err);
+        goto retry;
+      }
+      goto receive_error;
+    }
+
+    /* All packets of this wakeup get the same capture time, unless the
+     * socket provides one per packet */
+    running_time = gst_udpsrc_get_running_time (udpsrc);
+
+    gst_udpsrc_unmap_batch (udpsrc, n_mapped);
+    n_mapped = 0;
+
+    list = gst_buffer_list_new_sized (res);
+
+    for (i = 0; i < res; i++) {
+      GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+      gsize size = udpsrc->batch_msgs[i].bytes_received;
+      GstBuffer *buf;
+
+      buf = slot->buf;
+      slot->buf = NULL;
+
+      if (slot->msgs) {
+        gboolean skip_packet;
+
+        skip_packet = gst_udpsrc_process_control_messages (udpsrc, slot->msgs,
+            slot->n_msgs, buf);
+        slot->msgs = NULL;
+        slot->n_msgs = 0;
+
+        if (skip_packet) {
+          GST_DEBUG_OBJECT (udpsrc,
+              "Dropping packet for a different multicast address");
+          g_clear_object (&slot->saddr);
+          gst_buffer_unref (buf);
+          continue;
+        }
+      }
+
+      if (size > udpsrc->mtu) {
+        gst_buffer_append_memory (buf, slot->extra_mem);
+        slot->extra_mem = NULL;
+      }
+
+      if (G_UNLIKELY (offset > 0 && size < offset)) {
+        g_clear_object (&slot->saddr);
+        gst_buffer_unref (buf);
+        goto skip_error;
+      }
+
+      gst_buffer_resize (buf, offset, size - offset);
+
+      if (slot->saddr) {
+        gst_buffer_add_net_address_meta (buf, slot->saddr);
+        g_clear_object (&slot->saddr);
+      }
+
+      if (!GST_BUFFER_DTS_IS_VALID (buf))
+        GST_BUFFER_DTS (buf) = running_time;
+
+      gst_buffer_list_add (list, buf);
+    }
+
+    GST_LOG_OBJECT (udpsrc, "read %d packets, pushing %u", res,
+        gst_buffer_list_length (list));
+
+    if (gst_buffer_list_length (list) == 0)
+      gst_clear_buffer_list (&list);
+  } while (list == NULL);
+
+  gst_object_unref (pool);
+
+  gst_base_src_submit_buffer_list (GST_BASE_SRC_CAST (udpsrc), list);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+acquire_failed:
+  {
+    GST_DEBUG_OBJECT (udpsrc, "failed to acquire buffer: %s",
+        gst_flow_get_name (ret));
+    gst_udpsrc_unmap_batch (udpsrc, n_mapped);
+    gst_object_unref (pool);
+    return ret;
+  }
+map_error:
+  {
+    gst_udpsrc_unmap_batch (udpsrc, n_mapped);
+    gst_object_unref (pool);
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+        ("Failed to map memory"));
+    return GST_FLOW_ERROR;
+  }
+wait_failed:
+  {
+    gst_udpsrc_unmap_batch (udpsrc, n_mapped);
+    gst_object_unref (pool);
+    return ret;
+  }
+receive_error:
+  {
+    gst_udpsrc_unmap_batch (udpsrc, n_mapped);
+    gst_object_unref (pool);
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_BUSY) ||
+        g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_clear_error (&err);
+      return GST_FLOW_FLUSHING;
+    } else {
+      GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+          ("receive error: %s", err->message));
+      g_clear_error (&err);
+      return GST_FLOW_ERROR;
+    }
+  }
+skip_error:
+  {
+    /* Release what is left of this read, the slots get refilled on the
+     * next call */
+    for (i = i + 1; i < res; i++) {
+      GstUDPSrcBatchSlot *slot = &udpsrc->batch_slots[i];
+      guint j;
+
+      g_clear_object (&slot->saddr);
+      for (j = 0; j < slot->n_msgs; j++)
+        g_object_unref (slot->msgs[j]);
+      g_free (slot->msgs);
+      slot->msgs = NULL;
+      slot->n_msgs = 0;
+    }
+    gst_buffer_list_unref (list);
+    gst_object_unref (pool);
+    GST_ELEMENT_ERROR (udpsrc, STREAM, DECODE, (NULL),
+        ("UDP buffer to small to skip header"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_udpsrc_create (GstBaseSrc * bsrc, guint64 offset, guint length,
+    GstBuffer ** buf)
+{
+  GstUDPSrc *udpsrc = GST_UDPSRC_CAST (bsrc);
+
+  if (udpsrc->batch_size <= 1)
+    return GST_BASE_SRC_CLASS (parent_class)->create (bsrc, offset, length,
+        buf);
+
+  return gst_udpsrc_create_batch (udpsrc);
+}
+
 static gboolean
 gst_udpsrc_set_uri (GstUDPSrc * src, const gchar * uri, GError ** error)
 {
@@ -1374,6 +1782,9 @@ gst_udpsrc_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_SOCKET_TIMESTAMP:
       udpsrc->socket_timestamp_mode = g_value_get_enum (value);
       break;
+    case PROP_BATCH_SIZE:
+      udpsrc->batch_size = g_value_get_uint (value);
+      break;
     default:
       break;
   }
@@ -1440,6 +1851,9 @@ gst_udpsrc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_SOCKET_TIMESTAMP:
       g_value_set_enum (value, udpsrc->socket_timestamp_mode);
       break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, udpsrc->batch_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1733,7 +2147,31 @@ gst_udpsrc_open (GstUDPSrc * src)
     }
   }
 
-  if (src->socket_timestamp_mode == GST_SOCKET_TIMESTAMP_MODE_REALTIME) {
+  /* the mode actually in use, the property keeps what the user asked for */
+  src->effective_timestamp_mode = src->socket_timestamp_mode;
+
+  if (src->effective_timestamp_mode == GST_SOCKET_TIMESTAMP_MODE_TIMESTAMPING) {
+#ifdef HAVE_SO_TIMESTAMPING
+    gint ts_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+
+    if (!g_socket_set_option (src->used_socket, SOL_SOCKET, SO_TIMESTAMPING,
+            ts_flags, &err)) {
+      GST_WARNING_OBJECT (src,
+          "Failed to enable SO_TIMESTAMPING, falling back to realtime: %s",
+          err->message);
+      g_clear_error (&err);
+      src->effective_timestamp_mode = GST_SOCKET_TIMESTAMP_MODE_REALTIME;
+    } else {
+      GST_LOG_OBJECT (src, "SO_TIMESTAMPING receive timestamps enabled");
+    }
+#else
+    GST_WARNING_OBJECT (src,
+        "SO_TIMESTAMPING is not available, falling back to realtime");
+    src->effective_timestamp_mode = GST_SOCKET_TIMESTAMP_MODE_REALTIME;
+#endif
+  }
+
+  if (src->effective_timestamp_mode == GST_SOCKET_TIMESTAMP_MODE_REALTIME) {
 #ifdef SO_TIMESTAMPNS
     if (!g_socket_set_option (src->used_socket, SOL_SOCKET, SO_TIMESTAMPNS,
             TRUE, &err)) {
@@ -1741,8 +2179,7 @@ gst_udpsrc_open (GstUDPSrc * src)
           "Failed to enable socket control message timestamps: %s",
           err->message);
       g_clear_error (&err);
-      src->socket_timestamp_mode = GST_SOCKET_TIMESTAMP_MODE_DISABLED;
-      g_object_notify (G_OBJECT (src), "socket-timestamp");
+      src->effective_timestamp_mode = GST_SOCKET_TIMESTAMP_MODE_DISABLED;
     } else {
       GST_LOG_OBJECT (src, "Socket control message timestamps enabled");
     }
@@ -1901,6 +2338,7 @@ gst_udpsrc_close (GstUDPSrc * src)
     src->addr = NULL;
   }
 
+  gst_udpsrc_free_batch (src);
   gst_udpsrc_free_cancellable (src);
 
   return TRUE;
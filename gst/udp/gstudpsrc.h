@@ -43,6 +43,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstUDPSrc GstUDPSrc;
 typedef struct _GstUDPSrcClass GstUDPSrcClass;
+typedef struct _GstUDPSrcBatchSlot GstUDPSrcBatchSlot;
 
 
 /**
@@ -50,13 +51,17 @@ typedef struct _GstUDPSrcClass GstUDPSrcClass;
  * @GST_SOCKET_TIMESTAMP_MODE_DISABLED: Disable additional timestamps
  * @GST_SOCKET_TIMESTAMP_MODE_REALTIME: Timestamp with realtime clock (nsec
  *      resolution, may not be monotonic)
+ * @GST_SOCKET_TIMESTAMP_MODE_TIMESTAMPING: Timestamp with SO_TIMESTAMPING
+ *      receive timestamps, generated by the network driver or the hardware
+ *      when available. Falls back to realtime if unsupported
  *
  * Since: 1.20
  */
 typedef enum
 {
   GST_SOCKET_TIMESTAMP_MODE_DISABLED = 0,
-  GST_SOCKET_TIMESTAMP_MODE_REALTIME
+  GST_SOCKET_TIMESTAMP_MODE_REALTIME,
+  GST_SOCKET_TIMESTAMP_MODE_TIMESTAMPING
 } GstSocketTimestampMode;
 
 struct _GstUDPSrc {
@@ -83,6 +88,8 @@ struct _GstUDPSrc {
   gboolean   reuse;
   gboolean   loop;
   GstSocketTimestampMode socket_timestamp_mode;
+  GstSocketTimestampMode effective_timestamp_mode;
+  guint      batch_size;
 
   /* stats */
   guint      max_size;
@@ -96,6 +103,11 @@ struct _GstUDPSrc {
   /* Extra memory for buffers with a size superior to max_packet_size */
   GstMemory *extra_mem;
 
+  /* Per-packet receive state when reading batch_size packets at once */
+  GstUDPSrcBatchSlot *batch_slots;
+  GInputMessage *batch_msgs;
+  guint n_batch_slots;
+
   gchar     *uri;
 };
 
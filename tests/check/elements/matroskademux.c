@@ -19,6 +19,9 @@
 
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
+#include <gst/app/gstappsrc.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 const gchar mkv_sub_base64[] =
     "GkXfowEAAAAAAAAUQoKJbWF0cm9za2EAQoeBAkKFgQIYU4BnAQAAAAAAAg0RTZt0AQAAAAAAAIxN"
@@ -307,6 +310,159 @@ GST_START_TEST (test_toc_demux)
 
 GST_END_TEST;
 
+#define CUELESS_DURATION (600 * GST_SECOND)
+#define CUELESS_SUB_INTERVAL (100 * GST_MSECOND)
+
+/* A subtitle-only file gets no Cues from matroskamux, one cluster per
+ * second. */
+static gchar *
+create_cueless_file (void)
+{
+  GstElement *pipeline, *src;
+  GstClockTime ts;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *launch, *path;
+  gint fd;
+
+  fd = g_file_open_tmp ("matroskademux-XXXXXX.mkv", &path, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  launch = g_strdup_printf ("appsrc name=src format=time "
+      "caps=text/x-raw,format=utf8 ! "
+      "matroskamux max-cluster-duration=1000000000 ! "
+      "filesink location=\"%s\"", path);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  for (ts = 0; ts < CUELESS_DURATION; ts += CUELESS_SUB_INTERVAL) {
+    gchar *text = g_strdup_printf ("%" GST_TIME_FORMAT, GST_TIME_ARGS (ts));
+    GstBuffer *buf = gst_buffer_new_wrapped (text, strlen (text));
+
+    GST_BUFFER_PTS (buf) = ts;
+    GST_BUFFER_DURATION (buf) = CUELESS_SUB_INTERVAL;
+    fail_unless_equals_int (gst_app_src_push_buffer (GST_APP_SRC (src), buf),
+        GST_FLOW_OK);
+  }
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+
+  return path;
+}
+
+static GstPadProbeReturn
+count_pulls (GstPad * pad, GstPadProbeInfo * info, gint * n_pulls)
+{
+  g_atomic_int_inc (n_pulls);
+  return GST_PAD_PROBE_OK;
+}
+
+/* does a flushing seek to @time and returns the number of reads it took */
+static gint
+seek_and_count_pulls (GstElement * pipeline, GstElement * sink,
+    gint * n_pulls, GstClockTime time)
+{
+  GstSample *sample;
+  GstClockTime pts;
+  gint pulls;
+
+  g_atomic_int_set (n_pulls, 0);
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, time));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+  pulls = g_atomic_int_get (n_pulls);
+
+  /* we preroll on the subtitle shown at the target time */
+  g_object_get (sink, "last-sample", &sample, NULL);
+  fail_unless (sample != NULL);
+  pts = GST_BUFFER_PTS (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+  fail_unless (pts <= time && time - pts < CUELESS_SUB_INTERVAL,
+      "seek to %" GST_TIME_FORMAT " prerolled on %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (time), GST_TIME_ARGS (pts));
+
+  GST_INFO ("seek to %" GST_TIME_FORMAT " took %d reads", GST_TIME_ARGS (time),
+      pulls);
+
+  return pulls;
+}
+
+GST_START_TEST (test_cueless_seek_cluster_index)
+{
+  GstElement *pipeline, *src, *sink;
+  GstPad *srcpad;
+  gint n_pulls = 0;
+  gint cold, warm, narrowed;
+  gchar *launch, *path;
+
+  path = create_cueless_file ();
+
+  launch = g_strdup_printf ("filesrc name=src location=\"%s\" ! "
+      "matroskademux ! fakesink name=sink sync=false", path);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+
+  srcpad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_PULL |
+      GST_PAD_PROBE_TYPE_BUFFER, (GstPadProbeCallback) count_pulls,
+      &n_pulls, NULL);
+  gst_object_unref (srcpad);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  /* nothing known about the middle of the file, bisect */
+  cold = seek_and_count_pulls (pipeline, sink, &n_pulls, 300 * GST_SECOND);
+
+  /* the clusters found by the first seek are remembered, a seek close to
+   * them doesn't need to search */
+  warm = seek_and_count_pulls (pipeline, sink, &n_pulls,
+      302 * GST_SECOND + 50 * GST_MSECOND);
+  fail_unless (warm < cold, "seek near a known cluster took %d reads, "
+      "the first one %d", warm, cold);
+
+  /* and further away they still bound the bisection */
+  narrowed = seek_and_count_pulls (pipeline, sink, &n_pulls,
+      200 * GST_SECOND);
+  fail_unless (narrowed > 0);
+  warm = seek_and_count_pulls (pipeline, sink, &n_pulls,
+      200 * GST_SECOND + 500 * GST_MSECOND);
+  fail_unless (warm < narrowed, "seek near a known cluster took %d reads, "
+      "the first one %d", warm, narrowed);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
 static Suite *
 matroskademux_suite (void)
 {
@@ -316,6 +472,7 @@ matroskademux_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_sub_terminator);
   tcase_add_test (tc_chain, test_toc_demux);
+  tcase_add_test (tc_chain, test_cueless_seek_cluster_index);
 
   return s;
 }
@@ -270,6 +270,76 @@ GST_START_TEST (test_multifilesink_key_unit)
 
 GST_END_TEST;
 
+GST_START_TEST (test_multifilesink_buffer_list)
+{
+  GstElement *mfs;
+  const gchar *tmpdir;
+  gchar *my_tmpdir;
+  gchar *template;
+  gchar *mfs_pattern;
+  gchar *filename;
+  gchar *contents;
+  gsize length;
+  GstBufferList *list;
+  GstBuffer *buf;
+  GstPad *sink;
+  GstSegment segment;
+
+  tmpdir = g_get_tmp_dir ();
+  template = g_build_filename (tmpdir, "multifile-test-XXXXXX", NULL);
+  my_tmpdir = g_mkdtemp (template);
+  fail_if (my_tmpdir == NULL);
+
+  mfs = gst_element_factory_make ("multifilesink", NULL);
+  fail_if (mfs == NULL);
+  mfs_pattern = g_build_filename (my_tmpdir, "%05d", NULL);
+  /* max-size with a limit that's never reached, so all goes in one file */
+  g_object_set (G_OBJECT (mfs), "location", mfs_pattern, "next-file", 4,
+      "background-flush", TRUE, NULL);
+  fail_if (gst_element_set_state (mfs,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  sink = gst_element_get_static_pad (mfs, "sink");
+
+  gst_pad_send_event (sink, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_send_event (sink, gst_event_new_segment (&segment));
+
+  fail_if (gst_pad_chain (sink, gst_buffer_new_wrapped (g_strdup ("foo"),
+              3)) != GST_FLOW_OK);
+
+  list = gst_buffer_list_new ();
+  buf = gst_buffer_new_wrapped (g_strdup ("bar"), 3);
+  gst_buffer_append_memory (buf,
+      gst_memory_new_wrapped (0, g_strdup ("baz"), 4, 0, 3, NULL, g_free));
+  gst_buffer_list_add (list, buf);
+  gst_buffer_list_add (list, gst_buffer_new ());
+  gst_buffer_list_add (list, gst_buffer_new_wrapped (g_strdup ("qux"), 3));
+  fail_if (gst_pad_chain_list (sink, list) != GST_FLOW_OK);
+
+  gst_pad_send_event (sink, gst_event_new_eos ());
+
+  fail_if (gst_element_set_state (mfs,
+          GST_STATE_NULL) == GST_STATE_CHANGE_FAILURE);
+
+  filename = g_strdup_printf (mfs_pattern, 0);
+  fail_unless (g_file_get_contents (filename, &contents, &length, NULL));
+  fail_unless_equals_int (length, 12);
+  fail_unless (memcmp (contents, "foobarbazqux", 12) == 0);
+  g_free (contents);
+
+  fail_if (g_remove (filename) != 0);
+  fail_if (g_remove (my_tmpdir) != 0);
+
+  g_free (filename);
+  g_free (mfs_pattern);
+  g_free (my_tmpdir);
+  gst_object_unref (sink);
+  gst_object_unref (mfs);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_multifilesrc)
 {
   GstElement *pipeline;
@@ -388,6 +458,7 @@ multifile_suite (void)
   tcase_add_test (tc_chain, test_multifilesink_key_frame);
   tcase_add_test (tc_chain, test_multifilesink_max_files);
   tcase_add_test (tc_chain, test_multifilesink_key_unit);
+  tcase_add_test (tc_chain, test_multifilesink_buffer_list);
   tcase_add_test (tc_chain, test_multifilesrc);
   tcase_add_test (tc_chain, test_multifilesrc_stop_index);
 
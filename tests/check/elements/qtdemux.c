@@ -22,7 +22,9 @@
 
 #include "qtdemux.h"
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 #include <gst/check/gstharness.h>
+#include <string.h>
 
 typedef struct
 {
@@ -888,6 +890,662 @@ GST_START_TEST (test_qtdemux_pad_names)
 
 GST_END_TEST;
 
+static void
+run_pipeline_to_eos (GstElement * pipeline)
+{
+  GstBus *bus;
+  GstMessage *msg;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+static void
+count_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    gint * n_buffers)
+{
+  g_atomic_int_inc (n_buffers);
+}
+
+GST_START_TEST (test_qtdemux_background_index_seek)
+{
+  GstElement *pipeline, *sink;
+  GstSample *sample;
+  gchar *launch, *path;
+  gint n_buffers = 0;
+  gint fd;
+
+  /* The goal of this test is to check that a seek right after the streams
+   * got exposed works while the sample index is still being built in the
+   * background.
+   *
+   * Input:
+   *   - a non-fragmented file with 10000 one millisecond samples
+   *
+   * Expected behaviour
+   *  - the seek lands on the requested sample
+   *  - all samples after it are pushed
+   */
+  fd = g_file_open_tmp ("qtdemux-XXXXXX.mov", &path, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  launch = g_strdup_printf ("videotestsrc num-buffers=10000 ! "
+      "video/x-raw,format=UYVY,width=16,height=16,framerate=1000/1 ! "
+      "qtmux ! filesink location=\"%s\"", path);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  run_pipeline_to_eos (pipeline);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  launch = g_strdup_printf ("filesrc location=\"%s\" ! "
+      "qtdemux background-index=true ! fakesink name=sink sync=false "
+      "signal-handoffs=true", path);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (count_handoff), &n_buffers);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  /* seek close to the end, the index is most likely not complete yet */
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, 7 * GST_SECOND));
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  g_object_get (sink, "last-sample", &sample, NULL);
+  fail_unless (sample != NULL);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (gst_sample_get_buffer (sample)),
+      7 * GST_SECOND);
+  gst_sample_unref (sample);
+
+  g_atomic_int_set (&n_buffers, 0);
+  run_pipeline_to_eos (pipeline);
+  fail_unless_equals_int (g_atomic_int_get (&n_buffers), 3000);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+static gchar *
+create_faststart_file (guint n_samples)
+{
+  GstElement *pipeline;
+  gchar *launch, *path;
+  gint fd;
+
+  fd = g_file_open_tmp ("qtdemux-XXXXXX.mov", &path, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  launch = g_strdup_printf ("videotestsrc num-buffers=%u ! "
+      "video/x-raw,format=UYVY,width=16,height=16,framerate=30/1 ! "
+      "qtmux faststart=true ! filesink location=\"%s\"", n_samples, path);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  run_pipeline_to_eos (pipeline);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return path;
+}
+
+static void
+push_file_and_get_stats (const gchar * path, guint blocksize,
+    guint64 * shared, guint64 * copied)
+{
+  GstElement *pipeline, *demux;
+  GstStructure *stats;
+  gchar *launch;
+
+  /* the queue makes qtdemux run in push mode */
+  launch = g_strdup_printf ("filesrc location=\"%s\" blocksize=%u ! queue ! "
+      "qtdemux name=demux ! fakesink sync=false", path, blocksize);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+
+  run_pipeline_to_eos (pipeline);
+
+  /* read them before the demuxer resets them on the way to NULL */
+  g_object_get (demux, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-shared", shared));
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-copied", copied));
+  gst_structure_free (stats);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (demux);
+  gst_object_unref (pipeline);
+}
+
+GST_START_TEST (test_qtdemux_push_mode_zero_copy)
+{
+  const guint n_samples = 100, sample_size = 16 * 16 * 2;
+  guint64 shared, copied;
+  GStatBuf st;
+  gchar *path;
+
+  /* The goal of this test is to check that in push mode samples are pushed
+   * as sub-buffers of the upstream buffers whenever they don't span
+   * several of them.
+   *
+   * Input:
+   *   - a file with 100 samples of 512 bytes, pushed as one buffer and
+   *     then in blocks of 700 bytes
+   *
+   * Expected behaviour
+   *  - with one buffer no sample data is copied
+   *  - with small blocks only the spanning samples are copied
+   */
+  path = create_faststart_file (n_samples);
+  fail_unless (g_stat (path, &st) == 0);
+
+  push_file_and_get_stats (path, st.st_size, &shared, &copied);
+  fail_unless_equals_uint64 (shared, n_samples * sample_size);
+  fail_unless_equals_uint64 (copied, 0);
+
+  push_file_and_get_stats (path, 700, &shared, &copied);
+  fail_unless_equals_uint64 (shared + copied, n_samples * sample_size);
+  fail_unless (shared > 0);
+  fail_unless (copied > 0);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+/* a small mp4 writer, just enough for one video track. The samples are
+ * described in the moov, or in fragments when the moov has none. */
+#define MP4_TIMESCALE 1000
+#define MP4_SAMPLE_DURATION 40
+#define MP4_SAMPLE_SIZE 16
+#define MP4_NON_KEYFRAME 0x10000
+
+static void
+mp4_put_u16 (GByteArray * data, guint16 val)
+{
+  guint8 bytes[2];
+
+  GST_WRITE_UINT16_BE (bytes, val);
+  g_byte_array_append (data, bytes, sizeof (bytes));
+}
+
+static void
+mp4_put_u32 (GByteArray * data, guint32 val)
+{
+  guint8 bytes[4];
+
+  GST_WRITE_UINT32_BE (bytes, val);
+  g_byte_array_append (data, bytes, sizeof (bytes));
+}
+
+static void
+mp4_put_u64 (GByteArray * data, guint64 val)
+{
+  guint8 bytes[8];
+
+  GST_WRITE_UINT64_BE (bytes, val);
+  g_byte_array_append (data, bytes, sizeof (bytes));
+}
+
+static void
+mp4_put_zeroes (GByteArray * data, guint len)
+{
+  guint old_len = data->len;
+
+  g_byte_array_set_size (data, old_len + len);
+  memset (data->data + old_len, 0, len);
+}
+
+static void
+mp4_put_matrix (GByteArray * data)
+{
+  mp4_put_u32 (data, 0x10000);
+  mp4_put_zeroes (data, 12);
+  mp4_put_u32 (data, 0x10000);
+  mp4_put_zeroes (data, 12);
+  mp4_put_u32 (data, 0x40000000);
+}
+
+static guint
+mp4_box_start (GByteArray * data, const gchar * fourcc)
+{
+  guint offset = data->len;
+
+  mp4_put_u32 (data, 0);
+  g_byte_array_append (data, (const guint8 *) fourcc, 4);
+
+  return offset;
+}
+
+static guint
+mp4_full_box_start (GByteArray * data, const gchar * fourcc, guint8 version,
+    guint32 flags)
+{
+  guint offset = mp4_box_start (data, fourcc);
+
+  mp4_put_u32 (data, (version << 24) | flags);
+
+  return offset;
+}
+
+static void
+mp4_box_end (GByteArray * data, guint offset)
+{
+  GST_WRITE_UINT32_BE (data->data + offset, data->len - offset);
+}
+
+/* returns the position of the chunk offset to fill in, or 0 */
+static guint
+mp4_put_moov (GByteArray * data, guint n_samples,
+    const guint32 * sample_flags, const guint32 * ct_offsets)
+{
+  guint moov, trak, mdia, minf, dinf, dref, stbl, stsd, entry, mvex, box;
+  guint n_keyframes = 0, stco_pos = 0, i;
+
+  box = mp4_box_start (data, "ftyp");
+  g_byte_array_append (data, (const guint8 *) "iso5", 4);
+  mp4_put_u32 (data, 0);
+  g_byte_array_append (data, (const guint8 *) "iso5", 4);
+  mp4_box_end (data, box);
+
+  moov = mp4_box_start (data, "moov");
+
+  box = mp4_full_box_start (data, "mvhd", 0, 0);
+  mp4_put_zeroes (data, 8);
+  mp4_put_u32 (data, MP4_TIMESCALE);
+  mp4_put_u32 (data, n_samples * MP4_SAMPLE_DURATION);
+  mp4_put_u32 (data, 0x10000);
+  mp4_put_u16 (data, 0x100);
+  mp4_put_zeroes (data, 10);
+  mp4_put_matrix (data);
+  mp4_put_zeroes (data, 24);
+  mp4_put_u32 (data, 2);
+  mp4_box_end (data, box);
+
+  trak = mp4_box_start (data, "trak");
+  box = mp4_full_box_start (data, "tkhd", 0, 7);
+  mp4_put_zeroes (data, 8);
+  mp4_put_u32 (data, 1);
+  mp4_put_zeroes (data, 24);
+  mp4_put_matrix (data);
+  mp4_put_u32 (data, 16 << 16);
+  mp4_put_u32 (data, 16 << 16);
+  mp4_box_end (data, box);
+
+  mdia = mp4_box_start (data, "mdia");
+  box = mp4_full_box_start (data, "mdhd", 0, 0);
+  mp4_put_zeroes (data, 8);
+  mp4_put_u32 (data, MP4_TIMESCALE);
+  mp4_put_u32 (data, n_samples * MP4_SAMPLE_DURATION);
+  mp4_put_u16 (data, 0x55c4);
+  mp4_put_u16 (data, 0);
+  mp4_box_end (data, box);
+
+  box = mp4_full_box_start (data, "hdlr", 0, 0);
+  mp4_put_u32 (data, 0);
+  g_byte_array_append (data, (const guint8 *) "vide", 4);
+  mp4_put_zeroes (data, 13);
+  mp4_box_end (data, box);
+
+  minf = mp4_box_start (data, "minf");
+  box = mp4_full_box_start (data, "vmhd", 0, 1);
+  mp4_put_zeroes (data, 8);
+  mp4_box_end (data, box);
+
+  dinf = mp4_box_start (data, "dinf");
+  dref = mp4_full_box_start (data, "dref", 0, 0);
+  mp4_put_u32 (data, 1);
+  box = mp4_full_box_start (data, "url ", 0, 1);
+  mp4_box_end (data, box);
+  mp4_box_end (data, dref);
+  mp4_box_end (data, dinf);
+
+  stbl = mp4_box_start (data, "stbl");
+  stsd = mp4_full_box_start (data, "stsd", 0, 0);
+  mp4_put_u32 (data, 1);
+  entry = mp4_box_start (data, "jpeg");
+  mp4_put_zeroes (data, 6);
+  mp4_put_u16 (data, 1);
+  mp4_put_zeroes (data, 16);
+  mp4_put_u16 (data, 16);
+  mp4_put_u16 (data, 16);
+  mp4_put_u32 (data, 0x480000);
+  mp4_put_u32 (data, 0x480000);
+  mp4_put_u32 (data, 0);
+  mp4_put_u16 (data, 1);
+  mp4_put_zeroes (data, 32);
+  mp4_put_u16 (data, 24);
+  mp4_put_u16 (data, 0xffff);
+  mp4_box_end (data, entry);
+  mp4_box_end (data, stsd);
+
+  /* all samples in one chunk */
+  box = mp4_full_box_start (data, "stts", 0, 0);
+  mp4_put_u32 (data, n_samples ? 1 : 0);
+  if (n_samples) {
+    mp4_put_u32 (data, n_samples);
+    mp4_put_u32 (data, MP4_SAMPLE_DURATION);
+  }
+  mp4_box_end (data, box);
+  if (n_samples && ct_offsets) {
+    box = mp4_full_box_start (data, "ctts", 0, 0);
+    mp4_put_u32 (data, n_samples);
+    for (i = 0; i < n_samples; i++) {
+      mp4_put_u32 (data, 1);
+      mp4_put_u32 (data, ct_offsets[i]);
+    }
+    mp4_box_end (data, box);
+  }
+  if (n_samples) {
+    for (i = 0; i < n_samples; i++)
+      if (sample_flags[i] != MP4_NON_KEYFRAME)
+        n_keyframes++;
+    box = mp4_full_box_start (data, "stss", 0, 0);
+    mp4_put_u32 (data, n_keyframes);
+    for (i = 0; i < n_samples; i++)
+      if (sample_flags[i] != MP4_NON_KEYFRAME)
+        mp4_put_u32 (data, i + 1);
+    mp4_box_end (data, box);
+  }
+  box = mp4_full_box_start (data, "stsc", 0, 0);
+  mp4_put_u32 (data, n_samples ? 1 : 0);
+  if (n_samples) {
+    mp4_put_u32 (data, 1);
+    mp4_put_u32 (data, n_samples);
+    mp4_put_u32 (data, 1);
+  }
+  mp4_box_end (data, box);
+  box = mp4_full_box_start (data, "stsz", 0, 0);
+  mp4_put_u32 (data, n_samples ? MP4_SAMPLE_SIZE : 0);
+  mp4_put_u32 (data, n_samples);
+  mp4_box_end (data, box);
+  box = mp4_full_box_start (data, "stco", 0, 0);
+  mp4_put_u32 (data, n_samples ? 1 : 0);
+  if (n_samples) {
+    stco_pos = data->len;
+    mp4_put_u32 (data, 0);
+  }
+  mp4_box_end (data, box);
+  mp4_box_end (data, stbl);
+
+  mp4_box_end (data, minf);
+  mp4_box_end (data, mdia);
+  mp4_box_end (data, trak);
+
+  if (n_samples == 0) {
+    mvex = mp4_box_start (data, "mvex");
+    box = mp4_full_box_start (data, "trex", 0, 0);
+    mp4_put_u32 (data, 1);
+    mp4_put_u32 (data, 1);
+    mp4_put_zeroes (data, 12);
+    mp4_box_end (data, box);
+    mp4_box_end (data, mvex);
+  }
+
+  mp4_box_end (data, moov);
+
+  return stco_pos;
+}
+
+static void
+mp4_put_mdat (GByteArray * data, guint n_samples)
+{
+  guint box;
+
+  box = mp4_box_start (data, "mdat");
+  mp4_put_zeroes (data, n_samples * MP4_SAMPLE_SIZE);
+  mp4_box_end (data, box);
+}
+
+/* one moof with a trun that has per-sample flags, and composition time
+ * offsets when @ct_offsets is given, followed by its mdat */
+static void
+mp4_put_fragment (GByteArray * data, guint32 seqnum, guint64 decode_time,
+    guint n_samples, const guint32 * sample_flags, const guint32 * ct_offsets)
+{
+  guint moof, traf, trun, box, data_offset_pos, i;
+
+  moof = mp4_box_start (data, "moof");
+  box = mp4_full_box_start (data, "mfhd", 0, 0);
+  mp4_put_u32 (data, seqnum);
+  mp4_box_end (data, box);
+
+  traf = mp4_box_start (data, "traf");
+  /* default-base-is-moof */
+  box = mp4_full_box_start (data, "tfhd", 0, 0x020000);
+  mp4_put_u32 (data, 1);
+  mp4_box_end (data, box);
+  box = mp4_full_box_start (data, "tfdt", 1, 0);
+  mp4_put_u64 (data, decode_time);
+  mp4_box_end (data, box);
+
+  /* data-offset, sample-duration, sample-size, sample-flags and maybe
+   * sample-composition-time-offsets */
+  trun = mp4_full_box_start (data, "trun", 0,
+      0x000701 | (ct_offsets ? 0x000800 : 0));
+  mp4_put_u32 (data, n_samples);
+  data_offset_pos = data->len;
+  mp4_put_u32 (data, 0);
+  for (i = 0; i < n_samples; i++) {
+    mp4_put_u32 (data, MP4_SAMPLE_DURATION);
+    mp4_put_u32 (data, MP4_SAMPLE_SIZE);
+    mp4_put_u32 (data, sample_flags[i]);
+    if (ct_offsets)
+      mp4_put_u32 (data, ct_offsets[i]);
+  }
+  mp4_box_end (data, trun);
+  mp4_box_end (data, traf);
+  mp4_box_end (data, moof);
+
+  /* the samples start right after the mdat header */
+  GST_WRITE_UINT32_BE (data->data + data_offset_pos, data->len - moof + 8);
+
+  mp4_put_mdat (data, n_samples);
+}
+
+typedef struct
+{
+  GstClockTime dts;
+  GstClockTime pts;
+  gboolean delta_unit;
+} SampleInfo;
+
+static void
+collect_sample_info (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    GArray * samples)
+{
+  SampleInfo info;
+
+  info.dts = GST_BUFFER_DTS (buf);
+  info.pts = GST_BUFFER_PTS (buf);
+  info.delta_unit = GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  g_array_append_val (samples, info);
+}
+
+static gchar *
+write_temp_file (GByteArray * data)
+{
+  gchar *path;
+  gint fd;
+
+  fd = g_file_open_tmp ("qtdemux-XXXXXX.mp4", &path, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+  fail_unless (g_file_set_contents (path, (const gchar *) data->data,
+          data->len, NULL));
+
+  return path;
+}
+
+/* demuxes @path and checks the timestamps and keyframe flags of its
+ * samples, @ct_offsets can be NULL when there are none */
+static void
+check_demuxed_samples (const gchar * path, guint n_samples,
+    const guint32 * sample_flags, const guint32 * ct_offsets)
+{
+  GstElement *pipeline, *sink;
+  GArray *samples;
+  gchar *launch;
+  guint i;
+
+  samples = g_array_new (FALSE, FALSE, sizeof (SampleInfo));
+  launch = g_strdup_printf ("filesrc location=\"%s\" ! qtdemux ! "
+      "fakesink name=sink sync=false signal-handoffs=true", path);
+  pipeline = gst_parse_launch (launch, NULL);
+  g_free (launch);
+  fail_unless (pipeline != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (collect_sample_info),
+      samples);
+
+  run_pipeline_to_eos (pipeline);
+
+  fail_unless_equals_int (samples->len, n_samples);
+  for (i = 0; i < samples->len; i++) {
+    SampleInfo *info = &g_array_index (samples, SampleInfo, i);
+    GstClockTime dts, pts;
+
+    dts = gst_util_uint64_scale (i * MP4_SAMPLE_DURATION, GST_SECOND,
+        MP4_TIMESCALE);
+    pts = dts;
+    if (ct_offsets)
+      pts += gst_util_uint64_scale (ct_offsets[i], GST_SECOND, MP4_TIMESCALE);
+
+    fail_unless_equals_uint64 (info->dts, dts);
+    fail_unless_equals_uint64 (info->pts, pts);
+    fail_unless_equals_int (info->delta_unit,
+        sample_flags[i] == MP4_NON_KEYFRAME);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  g_array_free (samples, TRUE);
+}
+
+/* two fragments worth of samples, with keyframes past the first 32 samples
+ * of each fragment and composition time offsets only in the second one. The
+ * last sample has none so that no pts goes past the duration. */
+#define FRAGMENT_SAMPLES 40
+
+static void
+init_late_offsets_samples (guint32 * sample_flags, guint32 * ct_offsets)
+{
+  guint i;
+
+  for (i = 0; i < 2 * FRAGMENT_SAMPLES; i++) {
+    sample_flags[i] = (i == 0 || i == 35 || i == FRAGMENT_SAMPLES ||
+        i == FRAGMENT_SAMPLES + 33) ? 0 : MP4_NON_KEYFRAME;
+    ct_offsets[i] = (i >= FRAGMENT_SAMPLES && i < 2 * FRAGMENT_SAMPLES - 1
+        && (i & 1)) ? 2 * MP4_SAMPLE_DURATION : 0;
+  }
+}
+
+GST_START_TEST (test_qtdemux_keyframes_and_late_trun_offsets)
+{
+  guint32 sample_flags[2 * FRAGMENT_SAMPLES];
+  guint32 ct_offsets[2 * FRAGMENT_SAMPLES];
+  GByteArray *data;
+  gchar *path;
+
+  /* The goal of this test is to check the keyframe bitmap and the
+   * pts offsets table, which is only allocated once a trun with
+   * composition time offsets shows up.
+   *
+   * Input:
+   *   - a fragmented file with two fragments of 40 samples. The first one
+   *     has keyframes at 0 and 35 and no composition time offsets, the
+   *     second one has keyframes at 0 and 33 and offsets on every other
+   *     sample.
+   *
+   * Expected behaviour
+   *  - only the keyframes come without the DELTA_UNIT flag, also past the
+   *    first 32 samples of each fragment
+   *  - the samples of the first fragment have pts == dts, the ones of the
+   *    second fragment get their offset
+   */
+  init_late_offsets_samples (sample_flags, ct_offsets);
+
+  data = g_byte_array_new ();
+  mp4_put_moov (data, 0, NULL, NULL);
+  mp4_put_fragment (data, 1, 0, FRAGMENT_SAMPLES, sample_flags, NULL);
+  mp4_put_fragment (data, 2, FRAGMENT_SAMPLES * MP4_SAMPLE_DURATION,
+      FRAGMENT_SAMPLES, sample_flags + FRAGMENT_SAMPLES,
+      ct_offsets + FRAGMENT_SAMPLES);
+  path = write_temp_file (data);
+  g_byte_array_free (data, TRUE);
+
+  check_demuxed_samples (path, 2 * FRAGMENT_SAMPLES, sample_flags,
+      ct_offsets);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_qtdemux_keyframes_and_late_ctts_offsets)
+{
+  guint32 sample_flags[2 * FRAGMENT_SAMPLES];
+  guint32 ct_offsets[2 * FRAGMENT_SAMPLES];
+  GByteArray *data;
+  guint stco_pos;
+  gchar *path;
+
+  /* The goal of this test is to check the keyframe bitmap built from the
+   * stss and the pts offsets filled from the ctts, when the first non-zero
+   * offset only comes halfway through the samples.
+   *
+   * Input:
+   *   - a non-fragmented file with the same samples as
+   *     test_qtdemux_keyframes_and_late_trun_offsets in a single chunk
+   *
+   * Expected behaviour
+   *  - the same timestamps and keyframe flags as from the fragments
+   */
+  init_late_offsets_samples (sample_flags, ct_offsets);
+
+  data = g_byte_array_new ();
+  stco_pos = mp4_put_moov (data, 2 * FRAGMENT_SAMPLES, sample_flags,
+      ct_offsets);
+  GST_WRITE_UINT32_BE (data->data + stco_pos, data->len + 8);
+  mp4_put_mdat (data, 2 * FRAGMENT_SAMPLES);
+  path = write_temp_file (data);
+  g_byte_array_free (data, TRUE);
+
+  check_demuxed_samples (path, 2 * FRAGMENT_SAMPLES, sample_flags,
+      ct_offsets);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
 static Suite *
 qtdemux_suite (void)
 {
@@ -901,6 +1559,10 @@ qtdemux_suite (void)
   tcase_add_test (tc_chain, test_qtdemux_duplicated_moov);
   tcase_add_test (tc_chain, test_qtdemux_stream_change);
   tcase_add_test (tc_chain, test_qtdemux_pad_names);
+  tcase_add_test (tc_chain, test_qtdemux_background_index_seek);
+  tcase_add_test (tc_chain, test_qtdemux_push_mode_zero_copy);
+  tcase_add_test (tc_chain, test_qtdemux_keyframes_and_late_trun_offsets);
+  tcase_add_test (tc_chain, test_qtdemux_keyframes_and_late_ctts_offsets);
 
   return s;
 }
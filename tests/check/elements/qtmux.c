@@ -445,6 +445,86 @@ check_qtmux_pad_fragmented (GstStaticPadTemplate * srctemplate,
   buffers = NULL;
 }
 
+static void
+check_qtmux_pad_fragmented_chunked (GstStaticPadTemplate * srctemplate,
+    const gchar * sinkname)
+{
+  GstElement *qtmux;
+  GstBuffer *inbuffer, *outbuffer;
+  GstCaps *caps;
+  int num_buffers;
+  int i, num_moofs = 0;
+  guint8 data0[4] = "moof";
+  GstSegment segment;
+
+  qtmux = setup_qtmux (srctemplate, sinkname, FALSE);
+  g_object_set (qtmux, "fragment-duration", 2000, NULL);
+  g_object_set (qtmux, "chunk-duration", 40, NULL);
+  g_object_set (qtmux, "streamable", TRUE, NULL);
+  fail_unless (gst_element_set_state (qtmux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+
+  caps = gst_pad_get_pad_template_caps (mysrcpad);
+  gst_pad_set_caps (mysrcpad, caps);
+  gst_caps_unref (caps);
+
+  /* ensure segment (format) properly setup */
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  /* one keyframe followed by two delta frames, all in the same fragment */
+  for (i = 0; i < 3; i++) {
+    inbuffer = gst_buffer_new_and_alloc (1);
+    gst_buffer_memset (inbuffer, 0, 0, 1);
+    GST_BUFFER_TIMESTAMP (inbuffer) = i * 40 * GST_MSECOND;
+    GST_BUFFER_DURATION (inbuffer) = 40 * GST_MSECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    ASSERT_BUFFER_REFCOUNT (inbuffer, "inbuffer", 1);
+    fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+  }
+
+  /* send eos to have all written */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()) == TRUE);
+
+  wait_for_eos ();
+
+  num_buffers = g_list_length (buffers);
+  /* expect ftyp, moov and a moof, mdat header and buffer chunk per frame */
+  fail_unless (num_buffers >= 11);
+
+  /* clean up first to clear any pending refs in sticky caps */
+  cleanup_qtmux (qtmux, sinkname);
+
+  for (i = 0; i < num_buffers; ++i) {
+    outbuffer = GST_BUFFER (buffers->data);
+    fail_if (outbuffer == NULL);
+    buffers = g_list_remove (buffers, outbuffer);
+
+    if (gst_buffer_get_size (outbuffer) > 8 &&
+        gst_buffer_memcmp (outbuffer, 4, data0, sizeof (data0)) == 0) {
+      /* only the moof starting the fragment is not a delta unit */
+      if (num_moofs == 0)
+        fail_if (GST_BUFFER_FLAG_IS_SET (outbuffer,
+                GST_BUFFER_FLAG_DELTA_UNIT));
+      else
+        fail_unless (GST_BUFFER_FLAG_IS_SET (outbuffer,
+                GST_BUFFER_FLAG_DELTA_UNIT));
+      num_moofs++;
+    }
+
+    gst_buffer_unref (outbuffer);
+    outbuffer = NULL;
+  }
+  fail_unless_equals_int (num_moofs, 3);
+
+  g_list_free (buffers);
+  buffers = NULL;
+}
+
 static void
 check_qtmux_pad_fragmented_finalise (GstStaticPadTemplate * srctemplate,
     const gchar * sinkname, guint32 dts_method, gboolean streamable)
@@ -649,6 +729,13 @@ GST_START_TEST (test_video_pad_frag_dd_finalise)
 
 GST_END_TEST;
 
+GST_START_TEST (test_video_pad_frag_dd_chunked)
+{
+  check_qtmux_pad_fragmented_chunked (&srcvideotemplate, "video_%u");
+}
+
+GST_END_TEST;
+
 /* dts-method reorder */
 
 GST_START_TEST (test_video_pad_reorder)
@@ -757,6 +844,269 @@ GST_START_TEST (test_video_pad_frag_asc_finalise)
 
 GST_END_TEST;
 
+typedef struct
+{
+  GArray *offsets;
+  guint64 position;
+} WriteOffsets;
+
+static GstPadProbeReturn
+track_write_offsets (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  WriteOffsets *data = user_data;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    g_array_append_val (data->offsets, data->position);
+    data->position += gst_buffer_get_size (buf);
+  } else {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    const GstSegment *segment;
+
+    /* qtmux seeks with byte segments */
+    if (GST_EVENT_TYPE (event) != GST_EVENT_SEGMENT)
+      return GST_PAD_PROBE_OK;
+    gst_event_parse_segment (event, &segment);
+    if (segment->format == GST_FORMAT_BYTES)
+      data->position = segment->start;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* muxes a single buffer with faststart into reserved space, returns the
+ * byte offset each output buffer was written at */
+static GArray *
+mux_faststart_reserved (guint reserved_bytes_per_sec, gboolean * warned)
+{
+  GstElement *qtmux;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GstSegment segment;
+  GstBus *bus;
+  GstMessage *message;
+  WriteOffsets data;
+
+  data.offsets = g_array_new (FALSE, FALSE, sizeof (guint64));
+  data.position = 0;
+
+  qtmux = setup_qtmux (&srcvideotemplate, "video_%u", TRUE);
+  g_object_set (qtmux, "faststart", TRUE, NULL);
+  g_object_set (qtmux, "reserved-max-duration", 10 * GST_SECOND, NULL);
+  g_object_set (qtmux, "reserved-bytes-per-sec", reserved_bytes_per_sec,
+      NULL);
+  gst_pad_add_probe (mysinkpad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, track_write_offsets, &data, NULL);
+  fail_unless (gst_element_set_state (qtmux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  /* set a bus here so we avoid getting state change messages */
+  bus = gst_bus_new ();
+  gst_element_set_bus (qtmux, bus);
+
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+
+  caps = gst_pad_get_pad_template_caps (mysrcpad);
+  gst_pad_set_caps (mysrcpad, caps);
+  gst_caps_unref (caps);
+
+  /* ensure segment (format) properly setup */
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  inbuffer = gst_buffer_new_and_alloc (1);
+  gst_buffer_memset (inbuffer, 0, 0, 1);
+  GST_BUFFER_TIMESTAMP (inbuffer) = 0;
+  GST_BUFFER_DURATION (inbuffer) = 40 * GST_MSECOND;
+  ASSERT_BUFFER_REFCOUNT (inbuffer, "inbuffer", 1);
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+
+  /* send eos to have moov written */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()) == TRUE);
+
+  wait_for_eos ();
+
+  /* the message holds a ref to qtmux, drop it before cleaning up */
+  message = gst_bus_pop_filtered (bus, GST_MESSAGE_WARNING);
+  *warned = message != NULL;
+  if (message)
+    gst_message_unref (message);
+  gst_element_set_bus (qtmux, NULL);
+  gst_object_unref (bus);
+
+  /* clean up first to clear any pending refs in sticky caps */
+  cleanup_qtmux (qtmux, "video_%u");
+
+  fail_unless_equals_int (data.offsets->len, g_list_length (buffers));
+
+  return data.offsets;
+}
+
+GST_START_TEST (test_faststart_reserved)
+{
+  GstBuffer *outbuffer;
+  GArray *offsets;
+  gboolean warned;
+  guint64 moov_pos = 0;
+  guint64 mdat_pos = 0;
+  int num_buffers;
+  int i;
+  guint8 data0[4] = "ftyp";
+  guint8 data1[4] = "free";
+  guint8 data2[4] = "moov";
+
+  offsets = mux_faststart_reserved (100, &warned);
+  fail_if (warned);
+
+  num_buffers = g_list_length (buffers);
+  /* expect ftyp, reserved free atom, mdat header, buffer chunk, then the
+   * moov and its padding into the reserved space and the mdat header
+   * rewrite, without any data being pushed again */
+  fail_unless_equals_int (num_buffers, 7);
+
+  for (i = 0; i < num_buffers; ++i) {
+    guint64 offset = g_array_index (offsets, guint64, i);
+
+    outbuffer = GST_BUFFER (buffers->data);
+    fail_if (outbuffer == NULL);
+    buffers = g_list_remove (buffers, outbuffer);
+
+    switch (i) {
+      case 0:                  /* ftyp */
+        fail_unless_equals_uint64 (offset, 0);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data0,
+                sizeof (data0)) == 0);
+        moov_pos = gst_buffer_get_size (outbuffer);
+        break;
+      case 1:                  /* reserved space */
+      {
+        GstMapInfo map;
+
+        fail_unless_equals_uint64 (offset, moov_pos);
+        fail_unless (gst_buffer_get_size (outbuffer) == 8);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data1,
+                sizeof (data1)) == 0);
+        gst_buffer_map (outbuffer, &map, GST_MAP_READ);
+        mdat_pos = moov_pos + GST_READ_UINT32_BE (map.data);
+        gst_buffer_unmap (outbuffer, &map);
+        break;
+      }
+      case 5:                  /* moov padding */
+        fail_unless (offset > moov_pos);
+        fail_unless (gst_buffer_get_size (outbuffer) == 8);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data1,
+                sizeof (data1)) == 0);
+        break;
+      case 2:                  /* mdat header */
+      case 6:                  /* mdat header rewrite */
+        fail_unless_equals_uint64 (offset, mdat_pos);
+        fail_unless (gst_buffer_get_size (outbuffer) == 16);
+        break;
+      case 3:                  /* buffer we put in */
+        fail_unless_equals_uint64 (offset, mdat_pos + 16);
+        fail_unless (gst_buffer_get_size (outbuffer) == 1);
+        break;
+      case 4:                  /* moov, written into the reserved space */
+        fail_unless_equals_uint64 (offset, moov_pos);
+        fail_unless (gst_buffer_get_size (outbuffer) > 8);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data2,
+                sizeof (data2)) == 0);
+        break;
+      default:
+        break;
+    }
+
+    gst_buffer_unref (outbuffer);
+    outbuffer = NULL;
+  }
+
+  g_list_free (buffers);
+  buffers = NULL;
+  g_array_free (offsets, TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_faststart_reserved_too_small)
+{
+  GstBuffer *outbuffer;
+  GArray *offsets;
+  gboolean warned;
+  guint64 moov_pos = 0;
+  guint64 mdat_pos = 0;
+  int num_buffers;
+  int i;
+  guint8 data0[4] = "ftyp";
+  guint8 data1[4] = "free";
+  guint8 data2[4] = "moov";
+
+  /* only the space for a moov without any samples gets reserved */
+  offsets = mux_faststart_reserved (0, &warned);
+  fail_unless (warned);
+
+  num_buffers = g_list_length (buffers);
+  /* expect ftyp, reserved free atom, mdat header, buffer chunk, then the
+   * moov after the mdat and the mdat header rewrite */
+  fail_unless_equals_int (num_buffers, 6);
+
+  for (i = 0; i < num_buffers; ++i) {
+    guint64 offset = g_array_index (offsets, guint64, i);
+
+    outbuffer = GST_BUFFER (buffers->data);
+    fail_if (outbuffer == NULL);
+    buffers = g_list_remove (buffers, outbuffer);
+
+    switch (i) {
+      case 0:                  /* ftyp */
+        fail_unless_equals_uint64 (offset, 0);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data0,
+                sizeof (data0)) == 0);
+        moov_pos = gst_buffer_get_size (outbuffer);
+        break;
+      case 1:                  /* reserved space, stays a free atom */
+      {
+        GstMapInfo map;
+
+        fail_unless_equals_uint64 (offset, moov_pos);
+        fail_unless (gst_buffer_get_size (outbuffer) == 8);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data1,
+                sizeof (data1)) == 0);
+        gst_buffer_map (outbuffer, &map, GST_MAP_READ);
+        mdat_pos = moov_pos + GST_READ_UINT32_BE (map.data);
+        gst_buffer_unmap (outbuffer, &map);
+        break;
+      }
+      case 2:                  /* mdat header */
+      case 5:                  /* mdat header rewrite */
+        fail_unless_equals_uint64 (offset, mdat_pos);
+        fail_unless (gst_buffer_get_size (outbuffer) == 16);
+        break;
+      case 3:                  /* buffer we put in */
+        fail_unless_equals_uint64 (offset, mdat_pos + 16);
+        fail_unless (gst_buffer_get_size (outbuffer) == 1);
+        break;
+      case 4:                  /* moov, right after the mdat */
+        fail_unless_equals_uint64 (offset, mdat_pos + 16 + 1);
+        fail_unless (gst_buffer_memcmp (outbuffer, 4, data2,
+                sizeof (data2)) == 0);
+        break;
+      default:
+        break;
+    }
+
+    gst_buffer_unref (outbuffer);
+    outbuffer = NULL;
+  }
+
+  g_list_free (buffers);
+  buffers = NULL;
+  g_array_free (offsets, TRUE);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_reuse)
 {
   GstElement *qtmux = setup_qtmux (&srcvideotemplate, "video_%u", TRUE);
@@ -1870,6 +2220,7 @@ qtmux_suite (void)
   tcase_add_test (tc_chain, test_video_pad_frag_dd_streamable);
   tcase_add_test (tc_chain, test_audio_pad_frag_dd_streamable);
   tcase_add_test (tc_chain, test_video_pad_frag_dd_finalise);
+  tcase_add_test (tc_chain, test_video_pad_frag_dd_chunked);
 
   tcase_add_test (tc_chain, test_video_pad_reorder);
   tcase_add_test (tc_chain, test_audio_pad_reorder);
@@ -1889,6 +2240,8 @@ qtmux_suite (void)
 
   tcase_add_test (tc_chain, test_average_bitrate);
 
+  tcase_add_test (tc_chain, test_faststart_reserved);
+  tcase_add_test (tc_chain, test_faststart_reserved_too_small);
   tcase_add_test (tc_chain, test_reuse);
   tcase_add_test (tc_chain, test_encodebin_qtmux);
   tcase_add_test (tc_chain, test_encodebin_mp4mux);
@@ -1070,6 +1070,62 @@ GST_START_TEST (test_recv_rtp_and_rtcp_simultaneously)
 
 GST_END_TEST;
 
+GST_START_TEST (test_scheduler_threads)
+{
+  GstTestClock *testclock = GST_TEST_CLOCK_CAST (gst_test_clock_new ());
+  GstHarness *h_rtp[3];
+  GstHarness *h_rtcp[3];
+  GstElement *rtpbin;
+  gboolean done = FALSE;
+  guint threads;
+  guint i;
+
+  /* the RTCP timeouts are scheduled on the system clock */
+  gst_system_clock_set_default (GST_CLOCK_CAST (testclock));
+
+  rtpbin = gst_element_factory_make ("rtpbin", NULL);
+  g_object_set (rtpbin, "scheduler-threads", 2, NULL);
+  g_object_get (rtpbin, "scheduler-threads", &threads, NULL);
+  fail_unless_equals_int (threads, 2);
+
+  for (i = 0; i < G_N_ELEMENTS (h_rtp); i++) {
+    gchar *sinkname = g_strdup_printf ("send_rtp_sink_%u", i);
+    gchar *srcname = g_strdup_printf ("send_rtp_src_%u", i);
+    gchar *rtcpname = g_strdup_printf ("send_rtcp_src_%u", i);
+
+    h_rtp[i] = gst_harness_new_with_element (rtpbin, sinkname, srcname);
+    h_rtcp[i] = gst_harness_new_with_element (rtpbin, NULL, rtcpname);
+    gst_harness_set_src_caps_str (h_rtp[i],
+        "application/x-rtp, clock-rate=(int)8000, payload=(int)100");
+    gst_harness_push (h_rtp[i], generate_rtp_buffer (0, 0, 0, 100, 1000 + i));
+
+    g_free (sinkname);
+    g_free (srcname);
+    g_free (rtcpname);
+  }
+
+  /* all sessions share the workers and still send their RTCP */
+  while (!done) {
+    done = TRUE;
+    for (i = 0; i < G_N_ELEMENTS (h_rtcp); i++)
+      if (gst_harness_buffers_received (h_rtcp[i]) == 0)
+        done = FALSE;
+    if (!done)
+      gst_test_clock_crank (testclock);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (h_rtp); i++) {
+    gst_harness_teardown (h_rtcp[i]);
+    gst_harness_teardown (h_rtp[i]);
+  }
+  gst_object_unref (rtpbin);
+
+  gst_system_clock_set_default (NULL);
+  gst_object_unref (testclock);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtpbin_suite (void)
 {
@@ -1089,6 +1145,7 @@ rtpbin_suite (void)
   tcase_add_test (tc_chain, test_sender_eos);
   tcase_add_test (tc_chain, test_quick_shutdown);
   tcase_add_test (tc_chain, test_recv_rtp_and_rtcp_simultaneously);
+  tcase_add_test (tc_chain, test_scheduler_threads);
 
   return s;
 }
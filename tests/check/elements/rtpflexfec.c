@@ -0,0 +1,339 @@
+/* GStreamer plugin for forward error correction
+ * Copyright (C) 2021 Pexip
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/check/gstcheck.h>
+
+#define RTP_PACKET_DUR (10 * GST_MSECOND)
+#define MEDIA_SSRC 0x01bada55
+#define MEDIA_PT 96
+#define FEC_SSRC 0x0fecfec0
+#define FEC_PT 122
+#define SEQ_BASE 65530
+
+static GstBuffer *
+create_media_packet (guint16 seq)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint payload_len = 20 + seq % 7;
+  GstBuffer *buf = gst_rtp_buffer_new_allocate (payload_len, 0, 0);
+  guint8 *payload;
+  guint i;
+
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, MEDIA_PT);
+  gst_rtp_buffer_set_seq (&rtp, seq);
+  gst_rtp_buffer_set_timestamp (&rtp, seq * 3000);
+  gst_rtp_buffer_set_ssrc (&rtp, MEDIA_SSRC);
+  gst_rtp_buffer_set_marker (&rtp, seq % 3 == 0);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < payload_len; i++)
+    payload[i] = seq + i;
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_BUFFER_DTS (buf) = (guint16) (seq - SEQ_BASE) * RTP_PACKET_DUR;
+
+  return buf;
+}
+
+static GstHarness *
+harness_rtpflexfecenc (guint columns, guint rows, gboolean row_fec,
+    gboolean column_fec)
+{
+  GstHarness *h = gst_harness_new ("rtpflexfecenc");
+
+  gst_harness_set (h, "rtpflexfecenc", "pt", FEC_PT, "ssrc", FEC_SSRC,
+      "columns", columns, "rows", rows, "enable-row-fec", row_fec,
+      "enable-column-fec", column_fec, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+
+  return h;
+}
+
+static GstHarness *
+harness_rtpflexfecdec (void)
+{
+  GstHarness *h = gst_harness_new_parse ("rtpstorage ! rtpflexfecdec");
+  GObject *internal_storage;
+
+  gst_harness_set (h, "rtpstorage", "size-time", (guint64) 200 * RTP_PACKET_DUR,
+      NULL);
+  gst_harness_get (h, "rtpstorage", "internal-storage", &internal_storage,
+      NULL);
+  gst_harness_set (h, "rtpflexfecdec", "storage", internal_storage, "pt",
+      FEC_PT, NULL);
+  g_object_unref (internal_storage);
+
+  gst_harness_set_src_caps_str (h,
+      "application/x-rtp,ssrc=(uint)" G_STRINGIFY (MEDIA_SSRC)
+      ",payload=(int)" G_STRINGIFY (MEDIA_PT));
+
+  return h;
+}
+
+/* Protects @n_packets packets and returns everything the encoder pushed,
+ * media and repair packets interleaved */
+static GList *
+encode_packets (GstHarness * h, guint n_packets)
+{
+  GList *out = NULL;
+  GstBuffer *buf;
+  guint i;
+
+  for (i = 0; i < n_packets; i++)
+    fail_unless_equals_int (GST_FLOW_OK,
+        gst_harness_push (h, create_media_packet (SEQ_BASE + i)));
+
+  while ((buf = gst_harness_try_pull (h)))
+    out = g_list_append (out, buf);
+
+  return out;
+}
+
+static gboolean
+packet_is_lost (GstBuffer * buf, const guint16 * lost, guint n_lost)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  gboolean ret = FALSE;
+  guint i;
+
+  gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp);
+  if (gst_rtp_buffer_get_ssrc (&rtp) == MEDIA_SSRC) {
+    for (i = 0; i < n_lost; i++)
+      if (gst_rtp_buffer_get_seq (&rtp) == lost[i])
+        ret = TRUE;
+  }
+  gst_rtp_buffer_unmap (&rtp);
+
+  return ret;
+}
+
+static gboolean
+push_lost_event (GstHarness * h, guint16 seq)
+{
+  GstEvent *event = gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM,
+      gst_structure_new ("GstRTPPacketLost",
+          "seqnum", G_TYPE_UINT, (guint) seq,
+          "timestamp", G_TYPE_UINT64, (guint64) 111111,
+          "duration", G_TYPE_UINT64, (guint64) RTP_PACKET_DUR, NULL));
+  gboolean went_through = FALSE;
+
+  fail_unless (gst_harness_push_event (h, event));
+
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_DOWNSTREAM &&
+        gst_event_has_name (event, "GstRTPPacketLost"))
+      went_through = TRUE;
+    gst_event_unref (event);
+  }
+
+  return went_through;
+}
+
+static void
+check_recovered (GstHarness * h, guint16 seq)
+{
+  GstBuffer *expected = create_media_packet (seq);
+  GstBuffer *recovered;
+  GstMapInfo map;
+
+  fail_if (push_lost_event (h, seq));
+
+  recovered = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (recovered),
+      gst_buffer_get_size (expected));
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (recovered), 111111);
+
+  gst_buffer_map (expected, &map, GST_MAP_READ);
+  fail_unless (gst_buffer_memcmp (recovered, 0, map.data, map.size) == 0);
+  gst_buffer_unmap (expected, &map);
+
+  gst_buffer_unref (expected);
+  gst_buffer_unref (recovered);
+}
+
+static void
+check_rtpflexfecdec_stats (GstHarness * h, guint packets_recovered,
+    guint packets_unrecovered)
+{
+  guint packets_recovered_out;
+  guint packets_unrecovered_out;
+
+  gst_harness_get (h, "rtpflexfecdec",
+      "recovered", &packets_recovered_out,
+      "unrecovered", &packets_unrecovered_out, NULL);
+
+  fail_unless_equals_int (packets_recovered, packets_recovered_out);
+  fail_unless_equals_int (packets_unrecovered, packets_unrecovered_out);
+}
+
+/* Encodes @n_packets packets, drops the @lost ones and pushes the rest
+ * through a decoder */
+static GstHarness *
+transmit_with_losses (GstHarness * enc, guint n_packets, const guint16 * lost,
+    guint n_lost)
+{
+  GstHarness *dec = harness_rtpflexfecdec ();
+  GList *packets = encode_packets (enc, n_packets);
+  GList *it;
+
+  for (it = packets; it; it = it->next) {
+    GstBuffer *buf = it->data;
+
+    if (packet_is_lost (buf, lost, n_lost)) {
+      gst_buffer_unref (buf);
+      continue;
+    }
+
+    fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (dec, buf));
+    gst_buffer_unref (gst_harness_pull (dec));
+  }
+  g_list_free (packets);
+
+  return dec;
+}
+
+GST_START_TEST (rtpflexfecenc_row_fec)
+{
+  GstHarness *h = harness_rtpflexfecenc (4, 1, TRUE, FALSE);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GList *packets = encode_packets (h, 4);
+  GstBuffer *fec;
+  guint8 *payload;
+
+  /* 4 media packets followed by the repair packet */
+  fail_unless_equals_int (g_list_length (packets), 5);
+  fec = g_list_last (packets)->data;
+
+  fail_unless (gst_rtp_buffer_map (fec, GST_MAP_READ, &rtp));
+  fail_unless_equals_int (gst_rtp_buffer_get_payload_type (&rtp), FEC_PT);
+  fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), FEC_SSRC);
+  fail_unless_equals_int (gst_rtp_buffer_get_csrc_count (&rtp), 1);
+  fail_unless_equals_int (gst_rtp_buffer_get_csrc (&rtp, 0), MEDIA_SSRC);
+
+  /* Short mask, k bit set, protecting the first 4 sequence numbers.
+   * The largest media payload is 26 bytes */
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  fail_unless_equals_int (gst_rtp_buffer_get_payload_len (&rtp), 12 + 26);
+  fail_unless_equals_int (payload[0] & 0xc0, 0);
+  fail_unless_equals_int (GST_READ_UINT16_BE (payload + 8), SEQ_BASE);
+  fail_unless_equals_int (GST_READ_UINT16_BE (payload + 10), 0xf800);
+  gst_rtp_buffer_unmap (&rtp);
+
+  g_list_free_full (packets, (GDestroyNotify) gst_buffer_unref);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtpflexfec_recover_single)
+{
+  GstHarness *enc = harness_rtpflexfecenc (4, 1, TRUE, FALSE);
+  const guint16 lost[] = { SEQ_BASE + 6 };
+  GstHarness *dec = transmit_with_losses (enc, 8, lost, G_N_ELEMENTS (lost));
+
+  check_recovered (dec, lost[0]);
+  check_rtpflexfecdec_stats (dec, 1, 0);
+
+  gst_harness_teardown (dec);
+  gst_harness_teardown (enc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtpflexfec_recover_burst)
+{
+  /* Column protection recovers a burst as long as the row length */
+  GstHarness *enc = harness_rtpflexfecenc (4, 4, FALSE, TRUE);
+  const guint16 lost[] = { SEQ_BASE + 5, SEQ_BASE + 6, SEQ_BASE + 7,
+    SEQ_BASE + 8
+  };
+  GstHarness *dec = transmit_with_losses (enc, 16, lost, G_N_ELEMENTS (lost));
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (lost); i++)
+    check_recovered (dec, lost[i]);
+  check_rtpflexfecdec_stats (dec, G_N_ELEMENTS (lost), 0);
+
+  gst_harness_teardown (dec);
+  gst_harness_teardown (enc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtpflexfec_recover_iterative)
+{
+  /* 3x3 block, the whole first row and one packet of the second are lost.
+   * The second row repair packet recovers SEQ_BASE + 4, after which every
+   * column misses a single packet */
+  GstHarness *enc = harness_rtpflexfecenc (3, 3, TRUE, TRUE);
+  const guint16 lost[] = { SEQ_BASE + 0, SEQ_BASE + 1, SEQ_BASE + 2,
+    SEQ_BASE + 4
+  };
+  GstHarness *dec = transmit_with_losses (enc, 9, lost, G_N_ELEMENTS (lost));
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (lost); i++)
+    check_recovered (dec, lost[i]);
+  check_rtpflexfecdec_stats (dec, G_N_ELEMENTS (lost), 0);
+
+  gst_harness_teardown (dec);
+  gst_harness_teardown (enc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (rtpflexfec_unrecoverable)
+{
+  GstHarness *enc = harness_rtpflexfecenc (4, 1, TRUE, FALSE);
+  const guint16 lost[] = { SEQ_BASE + 1, SEQ_BASE + 2 };
+  GstHarness *dec = transmit_with_losses (enc, 4, lost, G_N_ELEMENTS (lost));
+
+  fail_unless (push_lost_event (dec, lost[0]));
+  fail_unless_equals_int (gst_harness_buffers_in_queue (dec), 0);
+  check_rtpflexfecdec_stats (dec, 0, 1);
+
+  gst_harness_teardown (dec);
+  gst_harness_teardown (enc);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtpflexfec_suite (void)
+{
+  Suite *s = suite_create ("rtpflexfec");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, rtpflexfecenc_row_fec);
+  tcase_add_test (tc_chain, rtpflexfec_recover_single);
+  tcase_add_test (tc_chain, rtpflexfec_recover_burst);
+  tcase_add_test (tc_chain, rtpflexfec_recover_iterative);
+  tcase_add_test (tc_chain, rtpflexfec_unrecoverable);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtpflexfec)
@@ -2970,6 +2970,83 @@ GST_START_TEST (test_fill_queue)
 
 GST_END_TEST;
 
+GST_START_TEST (test_reorder_large_window)
+{
+  GstHarness *h =
+      gst_harness_new_parse ("rtpjitterbuffer max-misorder-time=10000");
+  const gint num_packets = 64;
+  GstBuffer *buf;
+  gint i;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps (h, generate_caps ());
+  gst_harness_play (h);
+
+  /* seqnum 0 goes out straight away */
+  gst_harness_push (h, generate_test_buffer (0));
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (0, get_rtp_seq_num (buf));
+  gst_buffer_unref (buf);
+
+  /* push the even packets backwards, then the odd ones forward with some
+   * duplicates in between. Nothing goes out until 1 arrives */
+  for (i = num_packets - 2; i > 0; i -= 2)
+    gst_harness_push (h, generate_test_buffer (i));
+  for (i = 3; i < num_packets; i += 2) {
+    gst_harness_push (h, generate_test_buffer (i));
+    if (i % 10 == 3)
+      gst_harness_push (h, generate_test_buffer (i - 1));
+  }
+  fail_unless_equals_int (0, gst_harness_buffers_in_queue (h));
+  gst_harness_push (h, generate_test_buffer (1));
+
+  for (i = 1; i < num_packets; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_int (i, get_rtp_seq_num (buf));
+    gst_buffer_unref (buf);
+  }
+  fail_unless_equals_int (0, gst_harness_buffers_in_queue (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_object_pool_stats)
+{
+  GstHarness *h = gst_harness_new ("rtpjitterbuffer");
+  guint64 hits, misses;
+  guint high_water;
+  GstStructure *stats;
+  gint i;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps (h, generate_caps ());
+  gst_harness_play (h);
+
+  for (i = 0; i < 20; i++) {
+    gst_harness_push (h, generate_test_buffer (i));
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats,
+          "pool-hits", G_TYPE_UINT64, &hits,
+          "pool-misses", G_TYPE_UINT64, &misses,
+          "pool-high-water", G_TYPE_UINT, &high_water, NULL));
+  gst_structure_free (stats);
+
+  /* packets go out one by one, so their items get recycled */
+  fail_unless (hits >= 19);
+  fail_unless (misses > 0);
+  fail_unless (high_water > 0);
+  fail_unless (high_water <= misses);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 typedef struct
 {
   gint64 dts_skew;
@@ -3874,6 +3951,8 @@ rtpjitterbuffer_suite (void)
       G_N_ELEMENTS (big_gap_testdata));
   tcase_add_test (tc_chain, test_big_gap_arrival_time);
   tcase_add_test (tc_chain, test_fill_queue);
+  tcase_add_test (tc_chain, test_reorder_large_window);
+  tcase_add_test (tc_chain, test_object_pool_stats);
 
   tcase_add_loop_test (tc_chain,
       test_considered_lost_packet_in_large_gap_arrives, 0,
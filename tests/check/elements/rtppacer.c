@@ -0,0 +1,355 @@
+/* GStreamer
+ *
+ * unit test for rtppacer
+ *
+ * Copyright (C) 2021 Pexip (http://pexip.com/)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#define VIDEO_CAPS "application/x-rtp, media=(string)video, " \
+    "clock-rate=(int)90000, encoding-name=(string)VP8, payload=(int)96"
+
+static GstBuffer *
+create_rtp_buffer (guint32 ssrc, guint16 seqnum, guint size)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf = gst_rtp_buffer_new_allocate (size - 12, 0, 0);
+
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_ssrc (&rtp, ssrc);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+static GstHarness *
+create_harness (gint bitrate, gdouble pacing_factor)
+{
+  GstHarness *h = gst_harness_new ("rtppacer");
+
+  g_object_set (h->element, "bitrate", bitrate,
+      "pacing-factor", pacing_factor, NULL);
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS);
+
+  return h;
+}
+
+static void
+pull_and_verify (GstHarness * h, guint32 ssrc, guint16 seqnum,
+    GstClockTime now)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf = gst_harness_pull (h);
+
+  fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+  fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), ssrc);
+  fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), seqnum);
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (buf);
+
+  fail_unless_equals_uint64 (now,
+      gst_clock_get_time (GST_CLOCK_CAST (h->testclock)));
+}
+
+GST_START_TEST (test_rtppacer_passthrough)
+{
+  GstHarness *h = create_harness (-1, 1.0);
+  guint16 i;
+
+  /* without a bitrate everything goes straight through */
+  for (i = 0; i < 10; i++)
+    fail_unless_equals_int (GST_FLOW_OK,
+        gst_harness_push (h, create_rtp_buffer (0x1234, i, 1250)));
+
+  for (i = 0; i < 10; i++)
+    pull_and_verify (h, 0x1234, i, 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtppacer_spreads_packets)
+{
+  GstHarness *h = create_harness (100000, 1.0);
+  guint16 i;
+
+  /* a frame of 5 packets, 10000 bits each at 100 kbps */
+  for (i = 0; i < 5; i++)
+    fail_unless_equals_int (GST_FLOW_OK,
+        gst_harness_push (h, create_rtp_buffer (0x1234, i, 1250)));
+
+  /* the first one goes out right away, the rest 100 ms apart */
+  pull_and_verify (h, 0x1234, 0, 0);
+  for (i = 1; i < 5; i++) {
+    fail_unless (gst_harness_crank_single_clock_wait (h));
+    pull_and_verify (h, 0x1234, i, i * 100 * GST_MSECOND);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtppacer_priority)
+{
+  GstHarness *h = create_harness (100000, 1.0);
+  GstCaps *caps;
+  GstBuffer *rtx;
+
+  caps = gst_caps_from_string
+      ("application/x-rtp, media=(string)audio, ssrc=(uint)1");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  /* the first video packet leaves the token bucket in debt */
+  gst_harness_push (h, create_rtp_buffer (2, 0, 125));
+  pull_and_verify (h, 2, 0, 0);
+
+  gst_harness_push (h, create_rtp_buffer (2, 1, 125));
+  rtx = create_rtp_buffer (3, 0, 125);
+  GST_BUFFER_FLAG_SET (rtx, GST_RTP_BUFFER_FLAG_RETRANSMISSION);
+  gst_harness_push (h, rtx);
+  gst_harness_push (h, create_rtp_buffer (1, 0, 125));
+
+  /* audio, then retransmissions, then video, 10 ms apart */
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  pull_and_verify (h, 1, 0, 10 * GST_MSECOND);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  pull_and_verify (h, 3, 0, 20 * GST_MSECOND);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  pull_and_verify (h, 2, 1, 30 * GST_MSECOND);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtppacer_bandwidth_estimate)
+{
+  GstHarness *h = create_harness (-1, 2.5);
+  GstStructure *stats;
+  GstEvent *event;
+  gboolean found = FALSE;
+  gint bitrate;
+  gint64 pacing_bitrate;
+  guint64 packets_sent;
+
+  gst_harness_push_upstream_event (h,
+      gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+          gst_structure_new ("GstRTPBandwidthEstimate",
+              "bitrate", G_TYPE_UINT, 200000, NULL)));
+  g_object_get (h->element, "bitrate", &bitrate, NULL);
+  fail_unless_equals_int (200000, bitrate);
+
+  /* the estimate is passed on upstream as well */
+  while (!found && (event = gst_harness_try_pull_upstream_event (h))) {
+    found = gst_event_has_name (event, "GstRTPBandwidthEstimate");
+    gst_event_unref (event);
+  }
+  fail_unless (found);
+
+  /* paced at 2.5 x 200 kbps, 10000 bits take 20 ms */
+  gst_harness_push (h, create_rtp_buffer (0x1234, 0, 1250));
+  gst_harness_push (h, create_rtp_buffer (0x1234, 1, 1250));
+  pull_and_verify (h, 0x1234, 0, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  pull_and_verify (h, 0x1234, 1, 20 * GST_MSECOND);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_int64 (stats, "pacing-bitrate",
+          &pacing_bitrate));
+  fail_unless_equals_int64 (500000, pacing_bitrate);
+  fail_unless (gst_structure_get_uint64 (stats, "packets-sent",
+          &packets_sent));
+  fail_unless_equals_uint64 (2, packets_sent);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtppacer_bandwidth_estimate_downstream)
+{
+  GstHarness *h = create_harness (-1, 2.5);
+  gint bitrate;
+
+  /* as sent by rtpsession on its send_rtp_src pad */
+  gst_harness_push_event (h,
+      gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM_OOB,
+          gst_structure_new ("GstRTPBandwidthEstimate",
+              "bitrate", G_TYPE_UINT, 200000, NULL)));
+  g_object_get (h->element, "bitrate", &bitrate, NULL);
+  fail_unless_equals_int (200000, bitrate);
+
+  gst_harness_push (h, create_rtp_buffer (0x1234, 0, 1250));
+  gst_harness_push (h, create_rtp_buffer (0x1234, 1, 1250));
+  pull_and_verify (h, 0x1234, 0, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  pull_and_verify (h, 0x1234, 1, 20 * GST_MSECOND);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtppacer_pacing_rate_clamped)
+{
+  GstHarness *h = create_harness (G_MAXINT, 1e300);
+  GstStructure *stats;
+  gint64 pacing_bitrate;
+
+  gst_harness_push (h, create_rtp_buffer (0x1234, 0, 1250));
+  pull_and_verify (h, 0x1234, 0, 0);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_int64 (stats, "pacing-bitrate",
+          &pacing_bitrate));
+  fail_unless (pacing_bitrate > 0);
+  fail_unless (pacing_bitrate <= G_GINT64_CONSTANT (1000000000000));
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GstHarness *h;
+  guint16 seqnum;
+  guint n_packets;
+  guint pushed;
+  GstFlowReturn ret;
+} PushThreadData;
+
+static gpointer
+push_packets (PushThreadData * data)
+{
+  guint i;
+
+  for (i = 0; i < data->n_packets && data->ret == GST_FLOW_OK; i++) {
+    data->ret = gst_harness_push (data->h,
+        create_rtp_buffer (0x1234, data->seqnum + i, 1250));
+    g_atomic_int_inc (&data->pushed);
+  }
+
+  return NULL;
+}
+
+static guint64
+get_queued_bytes (GstHarness * h)
+{
+  GstStructure *stats;
+  guint64 queued_bytes;
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "queued-bytes",
+          &queued_bytes));
+  gst_structure_free (stats);
+
+  return queued_bytes;
+}
+
+GST_START_TEST (test_rtppacer_max_queue_bytes)
+{
+  GstHarness *h = create_harness (100000, 1.0);
+  PushThreadData data = { h, 0, 4, 0, GST_FLOW_OK };
+  GThread *thread;
+  guint16 i;
+
+  g_object_set (h->element, "max-queue-bytes", (guint64) 2500, NULL);
+  thread = g_thread_new ("push", (GThreadFunc) push_packets, &data);
+
+  /* the first packet goes out right away, the next two fill the queue */
+  pull_and_verify (h, 0x1234, 0, 0);
+  while (get_queued_bytes (h) < 2500)
+    g_usleep (G_USEC_PER_SEC / 1000);
+
+  /* and the last one has to wait until there is room again */
+  g_usleep (G_USEC_PER_SEC / 20);
+  fail_unless_equals_int (3, g_atomic_int_get (&data.pushed));
+
+  for (i = 1; i < 4; i++) {
+    fail_unless (gst_harness_crank_single_clock_wait (h));
+    pull_and_verify (h, 0x1234, i, i * 100 * GST_MSECOND);
+  }
+  g_thread_join (thread);
+  fail_unless_equals_int (GST_FLOW_OK, data.ret);
+  fail_unless_equals_int (4, data.pushed);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtppacer_max_queue_bytes_flush)
+{
+  GstHarness *h = create_harness (100000, 1.0);
+  PushThreadData data = { h, 1, 2, 0, GST_FLOW_OK };
+  GThread *thread;
+
+  g_object_set (h->element, "max-queue-bytes", (guint64) 1250, NULL);
+
+  /* leaves the token bucket in debt, so the queue doesn't drain */
+  gst_harness_push (h, create_rtp_buffer (0x1234, 0, 1250));
+  pull_and_verify (h, 0x1234, 0, 0);
+
+  /* the second packet of the thread blocks until the flush */
+  thread = g_thread_new ("push", (GThreadFunc) push_packets, &data);
+  while (get_queued_bytes (h) < 1250)
+    g_usleep (G_USEC_PER_SEC / 1000);
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  g_thread_join (thread);
+  fail_unless_equals_int (GST_FLOW_FLUSHING, data.ret);
+  fail_unless_equals_int (2, data.pushed);
+  fail_unless_equals_int (0, get_queued_bytes (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtppacer_suite (void)
+{
+  Suite *s = suite_create ("rtppacer");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, test_rtppacer_passthrough);
+  tcase_add_test (tc_chain, test_rtppacer_spreads_packets);
+  tcase_add_test (tc_chain, test_rtppacer_priority);
+  tcase_add_test (tc_chain, test_rtppacer_bandwidth_estimate);
+  tcase_add_test (tc_chain, test_rtppacer_bandwidth_estimate_downstream);
+  tcase_add_test (tc_chain, test_rtppacer_pacing_rate_clamped);
+  tcase_add_test (tc_chain, test_rtppacer_max_queue_bytes);
+  tcase_add_test (tc_chain, test_rtppacer_max_queue_bytes_flush);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtppacer)
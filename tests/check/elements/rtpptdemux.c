@@ -128,6 +128,75 @@ GST_START_TEST (test_rtpptdemux_srccaps_from_signal_nossrc)
 
 GST_END_TEST;
 
+static void
+new_payload_type_harness (GstElement * element, guint pt,
+    G_GNUC_UNUSED GstPad * pad, GstHarness ** src_h)
+{
+  gchar *name = g_strdup_printf ("src_%u", pt);
+
+  fail_unless (pt < 2);
+  src_h[pt] = gst_harness_new_with_element (element, NULL, name);
+  g_free (name);
+}
+
+static void
+payload_type_change (G_GNUC_UNUSED GstElement * element,
+    G_GNUC_UNUSED guint pt, guint * changes)
+{
+  (*changes)++;
+}
+
+GST_START_TEST (test_rtpptdemux_buffer_list)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("rtpptdemux", "sink", NULL);
+  GstHarness *src_h[2] = { NULL, NULL };
+  const guint8 pts[] = { 0, 0, 1, 1, 1, 0 };
+  GstBufferList *list = gst_buffer_list_new ();
+  guint changes = 0;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+  g_signal_connect (h->element,
+      "new-payload-type", (GCallback) new_payload_type_harness, src_h);
+  g_signal_connect (h->element,
+      "payload-type-change", (GCallback) payload_type_change, &changes);
+  gst_harness_play (h);
+
+  for (i = 0; i < G_N_ELEMENTS (pts); i++) {
+    GstBuffer *buf = gst_rtp_buffer_new_allocate (0, 0, 0);
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+    gst_rtp_buffer_set_payload_type (&rtp, pts[i]);
+    gst_rtp_buffer_set_seq (&rtp, i);
+    gst_rtp_buffer_unmap (&rtp);
+    gst_buffer_list_add (list, buf);
+  }
+
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+
+  /* one signal per run of consecutive packets with the same payload type */
+  fail_unless_equals_int (changes, 3);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (src_h[0]), 3);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (src_h[1]), 3);
+
+  for (i = 0; i < G_N_ELEMENTS (pts); i++) {
+    GstBuffer *buf = gst_harness_pull (src_h[pts[i]]);
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp);
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), i);
+    gst_rtp_buffer_unmap (&rtp);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (src_h[0]);
+  gst_harness_teardown (src_h[1]);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtpptdemux_suite (void)
 {
@@ -139,6 +208,7 @@ rtpptdemux_suite (void)
   tcase_add_test (tc_chain, test_rtpptdemux_srccaps_from_sinkcaps_nossrc);
   tcase_add_test (tc_chain, test_rtpptdemux_srccaps_from_signal);
   tcase_add_test (tc_chain, test_rtpptdemux_srccaps_from_signal_nossrc);
+  tcase_add_test (tc_chain, test_rtpptdemux_buffer_list);
   suite_add_tcase (s, tc_chain);
 
   return s;
@@ -217,6 +217,113 @@ GST_START_TEST (test_rtxsend_basic)
 
 GST_END_TEST;
 
+GST_START_TEST (test_rtxsend_generic_nack)
+{
+  const guint32 main_ssrc = 1234567;
+  const guint main_pt = 96;
+  const guint32 rtx_ssrc = 7654321;
+  const guint rtx_pt = 106;
+  guint rtx_requests, rtx_packets;
+  GstStructure *s;
+  guint i;
+
+  GstHarness *h = gst_harness_new ("rtprtxsend");
+  GstStructure *ssrc_map =
+      create_rtx_map ("application/x-rtp-ssrc-map", main_ssrc, rtx_ssrc);
+  GstStructure *pt_map =
+      create_rtx_map ("application/x-rtp-pt-map", main_pt, rtx_pt);
+
+  gst_harness_set_src_caps_str (h, "application/x-rtp, "
+      "clock-rate = (int)90000");
+
+  g_object_set (h->element, "ssrc-map", ssrc_map, NULL);
+  g_object_set (h->element, "payload-type-map", pt_map, NULL);
+
+  for (i = 0; i < 20; i++) {
+    push_pull_and_verify (h, create_rtp_buffer (main_ssrc, main_pt,
+            65530 + i), FALSE, main_ssrc, main_pt, (guint16) (65530 + i));
+  }
+
+  /* one request for 65534, and following 0, 2 and 14 (not sent yet) through
+   * the bitmask */
+  s = gst_structure_new ("GstRTPRetransmissionRequest",
+      "seqnum", G_TYPE_UINT, 65534, "ssrc", G_TYPE_UINT, main_ssrc,
+      "blp", G_TYPE_UINT, (1 << 1) | (1 << 3) | (1 << 15), NULL);
+  gst_harness_push_upstream_event (h,
+      gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, s));
+
+  pull_and_verify (h, TRUE, rtx_ssrc, rtx_pt, 65534);
+  pull_and_verify (h, TRUE, rtx_ssrc, rtx_pt, 0);
+  pull_and_verify (h, TRUE, rtx_ssrc, rtx_pt, 2);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  g_object_get (G_OBJECT (h->element),
+      "num-rtx-requests", &rtx_requests,
+      "num-rtx-packets", &rtx_packets, NULL);
+  fail_unless_equals_int (rtx_requests, 4);
+  fail_unless_equals_int (rtx_packets, 3);
+
+  gst_structure_free (ssrc_map);
+  gst_structure_free (pt_map);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtxsend_unlimited_history)
+{
+  const guint32 main_ssrc = 1234567;
+  const guint main_pt = 96;
+  const guint32 rtx_ssrc = 7654321;
+  const guint rtx_pt = 106;
+  guint i;
+
+  GstHarness *h = gst_harness_new ("rtprtxsend");
+  GstStructure *ssrc_map =
+      create_rtx_map ("application/x-rtp-ssrc-map", main_ssrc, rtx_ssrc);
+  GstStructure *pt_map =
+      create_rtx_map ("application/x-rtp-pt-map", main_pt, rtx_pt);
+
+  gst_harness_set_src_caps_str (h, "application/x-rtp, "
+      "clock-rate = (int)90000");
+
+  g_object_set (h->element, "ssrc-map", ssrc_map, "payload-type-map", pt_map,
+      "max-size-packets", 0, NULL);
+
+  /* enough packets for the history to grow a few times, with a gap */
+  for (i = 0; i < 500; i++) {
+    if (i >= 200 && i < 210)
+      continue;
+    gst_buffer_unref (gst_harness_push_and_pull (h,
+            create_rtp_buffer (main_ssrc, main_pt, 65300 + i)));
+  }
+
+  for (i = 0; i < 500; i += 7) {
+    gst_harness_push_upstream_event (h,
+        create_rtx_event (main_ssrc, main_pt, (guint16) (65300 + i)));
+    if (i >= 200 && i < 210)
+      fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+    else
+      pull_and_verify (h, TRUE, rtx_ssrc, rtx_pt, (guint16) (65300 + i));
+  }
+
+  /* the seqnums going back restarts the history */
+  gst_buffer_unref (gst_harness_push_and_pull (h,
+          create_rtp_buffer (main_ssrc, main_pt, 60300)));
+  gst_harness_push_upstream_event (h,
+      create_rtx_event (main_ssrc, main_pt, 65300));
+  gst_harness_push_upstream_event (h,
+      create_rtx_event (main_ssrc, main_pt, 60300));
+  pull_and_verify (h, TRUE, rtx_ssrc, rtx_pt, 60300);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_structure_free (ssrc_map);
+  gst_structure_free (pt_map);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_rtxsend_disabled_enabled_disabled)
 {
   const guint32 main_ssrc = 1234567;
@@ -321,6 +428,57 @@ GST_START_TEST (test_rtxreceive_empty_rtx_packet)
 
 GST_END_TEST;
 
+GST_START_TEST (test_rtxreceive_buffer_list)
+{
+  guint rtx_ssrc = 7654321;
+  guint master_ssrc = 1234567;
+  guint master_pt = 96;
+  guint rtx_pt = 99;
+  GstStructure *pt_map;
+  GstBufferList *list;
+  GstRTPBuffer *rtp;
+  GstHarness *h = gst_harness_new ("rtprtxreceive");
+
+  pt_map = gst_structure_new ("application/x-rtp-pt-map",
+      "96", G_TYPE_UINT, rtx_pt, NULL);
+  g_object_set (h->element, "payload-type-map", pt_map, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, "
+      "clock-rate = (int)90000");
+
+  gst_harness_push_upstream_event (h,
+      create_rtx_event (master_ssrc, master_pt, 50));
+
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, create_rtp_buffer (master_ssrc, master_pt, 100));
+
+  /* RTX packet with seqnum=200 containing master stream buffer with seqnum=50 */
+  rtp = create_rtp_buffer_ex (rtx_ssrc, rtx_pt, 200, 0, 4);
+  GST_WRITE_UINT16_BE (gst_rtp_buffer_get_payload (rtp), 50);
+  gst_rtp_buffer_unmap (rtp);
+  gst_buffer_list_add (list, rtp->buffer);
+  g_free (rtp);
+
+  /* empty RTX packet, dropped from the output list */
+  rtp = create_rtp_buffer_ex (rtx_ssrc, rtx_pt, 201, 0, 0);
+  gst_rtp_buffer_unmap (rtp);
+  gst_buffer_list_add (list, rtp->buffer);
+  g_free (rtp);
+
+  gst_buffer_list_add (list, create_rtp_buffer (master_ssrc, master_pt, 101));
+
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+  pull_and_verify (h, FALSE, master_ssrc, master_pt, 100);
+  pull_and_verify (h, FALSE, master_ssrc, master_pt, 50);
+  pull_and_verify (h, FALSE, master_ssrc, master_pt, 101);
+
+  gst_structure_free (pt_map);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_rtxsend_rtxreceive)
 {
   const guint packets_num = 5;
@@ -1153,9 +1311,12 @@ rtprtx_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_rtxsend_basic);
+  tcase_add_test (tc_chain, test_rtxsend_generic_nack);
+  tcase_add_test (tc_chain, test_rtxsend_unlimited_history);
   tcase_add_test (tc_chain, test_rtxsend_disabled_enabled_disabled);
 
   tcase_add_test (tc_chain, test_rtxreceive_empty_rtx_packet);
+  tcase_add_test (tc_chain, test_rtxreceive_buffer_list);
   tcase_add_test (tc_chain, test_rtxsend_rtxreceive);
   tcase_add_test (tc_chain, test_rtxsend_rtxreceive_with_packet_loss);
   tcase_add_test (tc_chain, test_multi_rtxsend_rtxreceive_with_packet_loss);
@@ -1059,6 +1059,93 @@ GST_START_TEST (test_receive_pli_no_sender_ssrc)
 
 GST_END_TEST;
 
+static void
+receive_nack_and_pull_reconfigure (SessionHarness * h, guint n_requests)
+{
+  GstEvent *ev;
+
+  /* Generic NACK for #100, with blp asking for #101 and #103 too */
+  guint8 rtcp_pkt[] = {
+    0x81,                       /* Generic NACK */
+    0xcd,                       /* Type 205 Transport layer feedback */
+    0x00, 0x03,                 /* Length */
+    0x37, 0x56, 0x93, 0xed,     /* Sender SSRC */
+    0x37, 0x56, 0x93, 0xed,     /* Media SSRC */
+    0x00, 0x64,                 /* PID */
+    0x00, 0x05                  /* BLP */
+  };
+
+  fail_unless_equals_int (GST_FLOW_OK,
+      session_harness_send_rtp (h, generate_test_buffer (0, 928420845)));
+
+  session_harness_recv_rtcp (h, create_buffer (rtcp_pkt, sizeof (rtcp_pkt)));
+  fail_unless_equals_int (2 + n_requests,
+      gst_harness_upstream_events_received (h->send_rtp_h));
+
+  /* Remove the first 2 reconfigure events */
+  fail_unless ((ev = gst_harness_pull_upstream_event (h->send_rtp_h)) != NULL);
+  fail_unless_equals_int (GST_EVENT_RECONFIGURE, GST_EVENT_TYPE (ev));
+  gst_event_unref (ev);
+  fail_unless ((ev = gst_harness_pull_upstream_event (h->send_rtp_h)) != NULL);
+  fail_unless_equals_int (GST_EVENT_RECONFIGURE, GST_EVENT_TYPE (ev));
+  gst_event_unref (ev);
+}
+
+GST_START_TEST (test_receive_nack_rtx_requests)
+{
+  SessionHarness *h = session_harness_new ();
+  const guint expected_seqnums[] = { 100, 101, 103 };
+  const GstStructure *s;
+  GstEvent *ev;
+  guint i, seqnum;
+
+  receive_nack_and_pull_reconfigure (h, G_N_ELEMENTS (expected_seqnums));
+
+  /* by default every lost packet gets its own request */
+  for (i = 0; i < G_N_ELEMENTS (expected_seqnums); i++) {
+    fail_unless ((ev =
+            gst_harness_pull_upstream_event (h->send_rtp_h)) != NULL);
+    fail_unless_equals_int (GST_EVENT_CUSTOM_UPSTREAM, GST_EVENT_TYPE (ev));
+    s = gst_event_get_structure (ev);
+    fail_unless (gst_structure_has_name (s, "GstRTPRetransmissionRequest"));
+    fail_unless (gst_structure_get_uint (s, "seqnum", &seqnum));
+    fail_unless_equals_int (expected_seqnums[i], seqnum);
+    fail_if (gst_structure_has_field (s, "blp"));
+    gst_event_unref (ev);
+  }
+
+  session_harness_free (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_receive_nack_batch_rtx_requests)
+{
+  SessionHarness *h = session_harness_new ();
+  const GstStructure *s;
+  GstEvent *ev;
+  guint seqnum, blp;
+
+  g_object_set (h->session, "batch-rtx-requests", TRUE, NULL);
+
+  receive_nack_and_pull_reconfigure (h, 1);
+
+  /* the whole generic NACK is forwarded as one request */
+  fail_unless ((ev = gst_harness_pull_upstream_event (h->send_rtp_h)) != NULL);
+  fail_unless_equals_int (GST_EVENT_CUSTOM_UPSTREAM, GST_EVENT_TYPE (ev));
+  s = gst_event_get_structure (ev);
+  fail_unless (gst_structure_has_name (s, "GstRTPRetransmissionRequest"));
+  fail_unless (gst_structure_get_uint (s, "seqnum", &seqnum));
+  fail_unless_equals_int (100, seqnum);
+  fail_unless (gst_structure_get_uint (s, "blp", &blp));
+  fail_unless_equals_int (0x0005, blp);
+  gst_event_unref (ev);
+
+  session_harness_free (h);
+}
+
+GST_END_TEST;
+
 static void
 add_rtcp_sdes_packet (GstBuffer * gstbuf, guint32 ssrc, const char *cname)
 {
@@ -2751,6 +2838,102 @@ GST_START_TEST (test_clear_pt_map_stress)
 
 GST_END_TEST;
 
+#define STATS_POLL_PACKETS 500
+
+typedef struct
+{
+  SessionHarness *h;
+  GstFlowReturn ret;
+  gint done;
+} StatsPollThreadData;
+
+static gpointer
+_stats_poll_send (StatsPollThreadData * data)
+{
+  guint i;
+
+  for (i = 0; i < STATS_POLL_PACKETS && data->ret == GST_FLOW_OK; i++) {
+    data->ret = session_harness_send_rtp (data->h,
+        generate_test_buffer (i, 0xDEADBEEF));
+    gst_buffer_unref (session_harness_pull_send_rtp (data->h));
+  }
+  g_atomic_int_set (&data->done, TRUE);
+
+  return NULL;
+}
+
+static gpointer
+_stats_poll_recv (StatsPollThreadData * data)
+{
+  guint i;
+
+  for (i = 0; i < STATS_POLL_PACKETS && data->ret == GST_FLOW_OK; i++) {
+    data->ret = session_harness_recv_rtp (data->h,
+        generate_test_buffer (i, 0x01BADBAD));
+  }
+  g_atomic_int_set (&data->done, TRUE);
+
+  return NULL;
+}
+
+GST_START_TEST (test_stats_while_sending_and_receiving)
+{
+  SessionHarness *h = session_harness_new ();
+  StatsPollThreadData send = { h, GST_FLOW_OK, FALSE };
+  StatsPollThreadData recv = { h, GST_FLOW_OK, FALSE };
+  GThread *send_thread, *recv_thread;
+  GstStructure *stats;
+  GValueArray *stats_arr;
+  guint64 packets_sent = 0, packets_received = 0;
+  guint num_sources;
+  guint i;
+
+  send_thread = g_thread_new (NULL, (GThreadFunc) _stats_poll_send, &send);
+  recv_thread = g_thread_new (NULL, (GThreadFunc) _stats_poll_recv, &recv);
+
+  /* the stats are collected one source at a time, while packets keep
+   * creating and updating sources */
+  while (!g_atomic_int_get (&send.done) || !g_atomic_int_get (&recv.done)) {
+    g_object_get (h->internal_session, "stats", &stats, NULL);
+    fail_unless (gst_structure_has_field (stats, "source-stats"));
+    gst_structure_free (stats);
+  }
+
+  g_thread_join (send_thread);
+  g_thread_join (recv_thread);
+  fail_unless_equals_int (send.ret, GST_FLOW_OK);
+  fail_unless_equals_int (recv.ret, GST_FLOW_OK);
+
+  g_object_get (h->internal_session, "num-sources", &num_sources,
+      "stats", &stats, NULL);
+  fail_unless (num_sources >= 2);
+
+  stats_arr =
+      g_value_get_boxed (gst_structure_get_value (stats, "source-stats"));
+  fail_unless (stats_arr != NULL);
+  fail_unless_equals_int (stats_arr->n_values, num_sources);
+  for (i = 0; i < stats_arr->n_values; i++) {
+    GstStructure *source_stats =
+        g_value_get_boxed (g_value_array_get_nth (stats_arr, i));
+    guint ssrc;
+
+    fail_unless (gst_structure_get_uint (source_stats, "ssrc", &ssrc));
+    if (ssrc == 0xDEADBEEF)
+      fail_unless (gst_structure_get_uint64 (source_stats, "packets-sent",
+              &packets_sent));
+    else if (ssrc == 0x01BADBAD)
+      fail_unless (gst_structure_get_uint64 (source_stats,
+              "packets-received", &packets_received));
+  }
+  fail_unless_equals_int (packets_sent, STATS_POLL_PACKETS);
+  fail_unless (packets_received > 0);
+  gst_structure_free (stats);
+
+  session_harness_free (h);
+}
+
+GST_END_TEST;
+
 static GstBuffer *
 generate_stepped_ts_buffer (guint i, gboolean stepped)
 {
@@ -4068,6 +4251,43 @@ GST_START_TEST (test_twcc_recv_packets_reordered)
 
 GST_END_TEST;
 
+GST_START_TEST (test_twcc_recv_packets_reordered_within_feedback)
+{
+  SessionHarness *h = session_harness_new ();
+  GstBuffer *buf;
+
+  /* #2 arrives after #3, turning the delta of #3 negative */
+  TWCCPacket packets[] = {
+    {1, 1 * 250 * GST_USECOND, FALSE},
+    {3, 2 * 250 * GST_USECOND, FALSE},
+    {2, 3 * 250 * GST_USECOND, FALSE},
+    {4, 4 * 250 * GST_USECOND, TRUE},
+  };
+
+  guint8 exp_fci[] = {
+    0x00, 0x01,                 /* base sequence number: 1 */
+    0x00, 0x04,                 /* packet status count: 4 */
+    0x00, 0x00, 0x00,           /* reference time: 0 */
+    0x00,                       /* feedback packet count: 0 */
+    0xd6, 0x40,                 /* packet chunk: 1 1 0 1 0 1 1 0 | 0 1 0 0 0 0 0 0 */
+    0x01,                       /* recv delta: +0:00:00.000250000 */
+    0x02,                       /* recv delta: +0:00:00.000500000 */
+    0xff, 0xff,                 /* recv delta: -0:00:00.000250000 */
+    0x02,                       /* recv delta: +0:00:00.000500000 */
+    0x00,                       /* padding */
+  };
+
+  twcc_push_packets (h, packets);
+
+  buf = session_harness_produce_twcc (h);
+  twcc_verify_fci (buf, exp_fci);
+  gst_buffer_unref (buf);
+
+  session_harness_free (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_twcc_recv_late_packet_fb_pkt_count_wrap)
 {
   SessionHarness *h = session_harness_new ();
@@ -4276,6 +4496,147 @@ GST_START_TEST (test_twcc_send_and_recv)
 
 GST_END_TEST;
 
+#define BWE_TEST_SLICES 15
+#define BWE_TEST_MIN_BITRATE 100000
+
+/* sends one frame worth of packets, delaying each by the queuing delay
+ * built up so far plus delay_step, optionally losing every other packet
+ * but the marker, and returns the estimate after the TWCC feedback */
+static guint
+send_bwe_test_frame (SessionHarness * h_send, SessionHarness * h_recv,
+    guint frame, GstClockTime * queue_delay, GstClockTime delay_step,
+    gboolean lossy)
+{
+  GstStructure *twcc_stats;
+  guint estimated_bitrate = 0;
+  guint slice;
+
+  for (slice = 0; slice < BWE_TEST_SLICES; slice++) {
+    guint seq = frame * BWE_TEST_SLICES + slice;
+    GstBuffer *buf;
+
+    buf = generate_twcc_send_buffer (seq, slice == BWE_TEST_SLICES - 1);
+    fail_unless_equals_int (GST_FLOW_OK,
+        session_harness_send_rtp (h_send, buf));
+    session_harness_advance_and_crank (h_send, TEST_BUF_DURATION);
+
+    buf = session_harness_pull_send_rtp (h_send);
+    if (lossy && slice % 2 == 1) {
+      gst_buffer_unref (buf);
+      continue;
+    }
+
+    /* the arrival time is taken from the DTS */
+    *queue_delay += delay_step;
+    buf = gst_buffer_make_writable (buf);
+    GST_BUFFER_DTS (buf) = seq * TEST_BUF_DURATION + *queue_delay;
+    fail_unless_equals_int (GST_FLOW_OK,
+        session_harness_recv_rtp (h_recv, buf));
+  }
+
+  session_harness_recv_rtcp (h_send, session_harness_produce_twcc (h_recv));
+
+  twcc_stats = session_harness_get_last_twcc_stats (h_send);
+  fail_unless (gst_structure_get_uint (twcc_stats,
+          "estimated-bitrate", &estimated_bitrate));
+  gst_structure_free (twcc_stats);
+
+  return estimated_bitrate;
+}
+
+GST_START_TEST (test_twcc_bandwidth_estimation)
+{
+  SessionHarness *h_send = session_harness_new ();
+  SessionHarness *h_recv = session_harness_new ();
+  GstStructure *twcc_stats;
+  GstEvent *event;
+  GstClockTime queue_delay = 0;
+  guint estimated_bitrate = 0;
+  guint increased_bitrate;
+  guint event_bitrate = 0;
+  gboolean probing = FALSE;
+  const gchar *state;
+  guint frame = 0;
+
+  /* enable twcc and the bandwidth estimation on top of it */
+  session_harness_set_twcc_recv_ext_id (h_recv, TEST_TWCC_EXT_ID);
+  session_harness_set_twcc_send_ext_id (h_send, TEST_TWCC_EXT_ID);
+  g_object_set (h_send->internal_session, "bandwidth-estimation", TRUE,
+      "bwe-start-bitrate", 300000,
+      "bwe-min-bitrate", BWE_TEST_MIN_BITRATE, NULL);
+
+  for (; frame < 5; frame++)
+    send_bwe_test_frame (h_send, h_recv, frame, &queue_delay, 0, FALSE);
+
+  /* no queuing delay and no loss, the estimate grows from the start rate */
+  twcc_stats = session_harness_get_last_twcc_stats (h_send);
+  fail_unless (gst_structure_get (twcc_stats,
+          "estimated-bitrate", G_TYPE_UINT, &estimated_bitrate,
+          "bwe-probing", G_TYPE_BOOLEAN, &probing, NULL));
+  state = gst_structure_get_string (twcc_stats, "bwe-state");
+  fail_unless (estimated_bitrate > 300000);
+  fail_unless (probing);
+  fail_unless_equals_string (state, "increase");
+
+  /* and is sent upstream for a pacer or encoder to act on */
+  while ((event = gst_harness_try_pull_upstream_event (h_send->send_rtp_h))) {
+    if (gst_event_has_name (event, "GstRTPBandwidthEstimate"))
+      fail_unless (gst_structure_get_uint (gst_event_get_structure (event),
+              "bitrate", &event_bitrate));
+    gst_event_unref (event);
+  }
+  fail_unless_equals_int (estimated_bitrate, event_bitrate);
+
+  /* and downstream for a pacer after the session */
+  event_bitrate = 0;
+  while ((event = gst_harness_try_pull_event (h_send->send_rtp_h))) {
+    if (gst_event_has_name (event, "GstRTPBandwidthEstimate")) {
+      fail_unless_equals_int (GST_EVENT_CUSTOM_DOWNSTREAM_OOB,
+          GST_EVENT_TYPE (event));
+      fail_unless (gst_structure_get_uint (gst_event_get_structure (event),
+              "bitrate", &event_bitrate));
+    }
+    gst_event_unref (event);
+  }
+  fail_unless_equals_int (estimated_bitrate, event_bitrate);
+  gst_structure_free (twcc_stats);
+  increased_bitrate = estimated_bitrate;
+
+  /* a queue building up at the bottleneck: every packet arrives 20ms
+   * later than the one before it would have, so the receive rate halves
+   * and the trendline detects overuse */
+  for (; frame < 10; frame++)
+    send_bwe_test_frame (h_send, h_recv, frame, &queue_delay,
+        TEST_BUF_DURATION, FALSE);
+
+  twcc_stats = session_harness_get_last_twcc_stats (h_send);
+  fail_unless (gst_structure_get (twcc_stats,
+          "estimated-bitrate", G_TYPE_UINT, &estimated_bitrate,
+          "bwe-probing", G_TYPE_BOOLEAN, &probing, NULL));
+  state = gst_structure_get_string (twcc_stats, "bwe-state");
+  fail_unless (estimated_bitrate < increased_bitrate);
+  fail_unless (estimated_bitrate >= BWE_TEST_MIN_BITRATE);
+  fail_if (probing);
+  fail_unless_equals_string (state, "decrease");
+  gst_structure_free (twcc_stats);
+
+  /* the queue stops growing, but close to half of the packets are lost,
+   * which takes the estimate down to the configured minimum and no
+   * further */
+  for (; frame < 16; frame++) {
+    estimated_bitrate = send_bwe_test_frame (h_send, h_recv, frame,
+        &queue_delay, 0, TRUE);
+    fail_unless (estimated_bitrate < increased_bitrate);
+    fail_unless (estimated_bitrate >= BWE_TEST_MIN_BITRATE);
+  }
+  fail_unless_equals_int (estimated_bitrate, BWE_TEST_MIN_BITRATE);
+
+  session_harness_free (h_send);
+  session_harness_free (h_recv);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_twcc_multiple_payloads_below_window)
 {
   SessionHarness *h_send = session_harness_new ();
@@ -5112,6 +5473,8 @@ rtpsession_suite (void)
   tcase_add_test (tc_chain, test_feedback_rtcp_race);
   tcase_add_test (tc_chain, test_receive_regular_pli);
   tcase_add_test (tc_chain, test_receive_pli_no_sender_ssrc);
+  tcase_add_test (tc_chain, test_receive_nack_rtx_requests);
+  tcase_add_test (tc_chain, test_receive_nack_batch_rtx_requests);
   tcase_add_test (tc_chain, test_dont_send_rtcp_while_idle);
   tcase_add_test (tc_chain, test_send_rtcp_when_signalled);
   tcase_add_test (tc_chain, test_change_sent_sdes);
@@ -5120,6 +5483,7 @@ rtpsession_suite (void)
   tcase_add_test (tc_chain, test_disable_probation);
   tcase_add_test (tc_chain, test_request_late_nack);
   tcase_add_test (tc_chain, test_clear_pt_map_stress);
+  tcase_add_test (tc_chain, test_stats_while_sending_and_receiving);
   tcase_add_test (tc_chain, test_packet_rate);
   tcase_add_test (tc_chain, test_stepped_packet_rate);
   tcase_add_test (tc_chain, test_creating_srrr);
@@ -5149,10 +5513,12 @@ rtpsession_suite (void)
   tcase_add_test (tc_chain, test_twcc_delta_ts_rounding);
   tcase_add_test (tc_chain, test_twcc_double_gap);
   tcase_add_test (tc_chain, test_twcc_recv_packets_reordered);
+  tcase_add_test (tc_chain, test_twcc_recv_packets_reordered_within_feedback);
   tcase_add_test (tc_chain, test_twcc_recv_late_packet_fb_pkt_count_wrap);
   tcase_add_test (tc_chain, test_twcc_recv_rtcp_reordered);
   tcase_add_test (tc_chain, test_twcc_no_exthdr_in_buffer);
   tcase_add_test (tc_chain, test_twcc_send_and_recv);
+  tcase_add_test (tc_chain, test_twcc_bandwidth_estimation);
   tcase_add_test (tc_chain, test_twcc_multiple_payloads_below_window);
   tcase_add_loop_test (tc_chain, test_twcc_feedback_interval, 0,
       G_N_ELEMENTS (test_twcc_feedback_interval_ctx));
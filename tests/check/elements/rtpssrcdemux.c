@@ -286,6 +286,56 @@ GST_START_TEST (test_rtpssrcdemux_max_streams)
 
 GST_END_TEST;
 
+GST_START_TEST (test_rtpssrcdemux_buffer_list)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("rtpssrcdemux", "sink", NULL);
+  GstBufferList *list = gst_buffer_list_new ();
+  GSList *src_h = NULL;
+  GSList *walk;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "application/x-rtp");
+  g_signal_connect (h->element,
+      "new-ssrc-pad", (GCallback) new_ssrc_pad_found, &src_h);
+  gst_harness_play (h);
+
+  /* interleave two SSRCs and an invalid packet in the same list */
+  for (i = 0; i < 6; i++)
+    gst_buffer_list_add (list, create_buffer (i, 1111 + (i & 1)));
+  gst_buffer_list_insert (list, 3, gst_buffer_new_allocate (NULL, 4, NULL));
+
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+  fail_unless_equals_int (g_slist_length (src_h), 2);
+
+  for (walk = src_h; walk; walk = walk->next) {
+    GstHarness *sh = walk->data;
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint32 ssrc = 0;
+    guint16 expected_seq = 0;
+
+    fail_unless_equals_int (gst_harness_buffers_in_queue (sh), 3);
+    for (i = 0; i < 3; i++) {
+      GstBuffer *buf = gst_harness_pull (sh);
+
+      fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+      if (i == 0) {
+        ssrc = gst_rtp_buffer_get_ssrc (&rtp);
+        expected_seq = ssrc - 1111;
+      }
+      fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), ssrc);
+      fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), expected_seq);
+      gst_rtp_buffer_unmap (&rtp);
+      gst_buffer_unref (buf);
+      expected_seq += 2;
+    }
+  }
+
+  g_slist_free_full (src_h, (GDestroyNotify) gst_harness_teardown);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static void
 new_rtcp_ssrc_pad_found (GstElement * element, guint ssrc,
     G_GNUC_UNUSED GstPad * rtp_pad, GSList ** src_h)
@@ -463,6 +513,7 @@ rtpssrcdemux_suite (void)
   tcase_add_test (tc_chain, test_event_forwarding);
   tcase_add_test (tc_chain, test_oob_event_locking);
   tcase_add_test (tc_chain, test_rtpssrcdemux_max_streams);
+  tcase_add_test (tc_chain, test_rtpssrcdemux_buffer_list);
   tcase_add_test (tc_chain, test_rtpssrcdemux_rtcp_app);
   tcase_add_test (tc_chain, test_rtpssrcdemux_invalid_rtp);
   tcase_add_test (tc_chain, test_rtpssrcdemux_invalid_rtcp);
@@ -305,6 +305,204 @@ GST_START_TEST (test_timer_queue_timer_offset)
 
 GST_END_TEST;
 
+GST_START_TEST (test_timer_queue_wheel_backend)
+{
+  RtpTimerQueue *queue = rtp_timer_queue_new ();
+  RtpTimer *timer;
+
+  /* switching with queued timers keeps them */
+  rtp_timer_queue_set_deadline (queue, 3, 3 * GST_SECOND, 0);
+  rtp_timer_queue_set_deadline (queue, 1, 1 * GST_SECOND, 0);
+  rtp_timer_queue_set_backend (queue, RTP_TIMER_QUEUE_BACKEND_WHEEL);
+  fail_unless_equals_int (RTP_TIMER_QUEUE_BACKEND_WHEEL,
+      rtp_timer_queue_get_backend (queue));
+
+  rtp_timer_queue_set_deadline (queue, 2, 2 * GST_SECOND, 0);
+  rtp_timer_queue_set_deadline (queue, 4, 3 * GST_SECOND, 0);
+  rtp_timer_queue_set_deadline (queue, 0, -1, 0);
+  /* same timeout, one wheel revolution later */
+  rtp_timer_queue_set_deadline (queue, 5, 1 * GST_SECOND + 2048 * GST_MSECOND,
+      0);
+  fail_unless_equals_int (6, rtp_timer_queue_length (queue));
+
+  /* move 1 after 4 */
+  timer = rtp_timer_queue_find (queue, 1);
+  rtp_timer_queue_update_timer (queue, timer, 1, 3 * GST_SECOND, GST_MSECOND,
+      0, FALSE);
+
+  timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (0, timer->seqnum);
+  rtp_timer_free (timer);
+  timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (2, timer->seqnum);
+  rtp_timer_free (timer);
+  timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (3, timer->seqnum);
+  rtp_timer_free (timer);
+  timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (4, timer->seqnum);
+  rtp_timer_free (timer);
+  timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (1, timer->seqnum);
+  rtp_timer_free (timer);
+  timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (5, timer->seqnum);
+  rtp_timer_free (timer);
+  fail_unless (rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE) == NULL);
+
+  g_object_unref (queue);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_timer_queue_object_pool)
+{
+  RtpObjectPool *pool = rtp_object_pool_new (sizeof (RtpTimer), 2);
+  RtpTimerQueue *queue = rtp_timer_queue_new ();
+  RtpTimerQueue *other = rtp_timer_queue_new ();
+  RtpTimer *timer, *copy;
+  guint64 hits, misses;
+  guint high_water;
+  gint i;
+
+  rtp_timer_queue_set_pool (queue, pool);
+
+  for (i = 0; i < 3; i++)
+    rtp_timer_queue_set_deadline (queue, i, i * GST_SECOND, 0);
+
+  /* moving a timer and duplicating it keeps the pool */
+  timer = rtp_timer_queue_pop_until (queue, 0);
+  fail_unless (timer->pool == pool);
+  copy = rtp_timer_dup (timer);
+  copy->seqnum = 10;
+  fail_unless (copy->pool == pool);
+  rtp_timer_queue_insert (other, copy);
+  rtp_timer_queue_insert (other, timer);
+  rtp_timer_queue_remove_all (queue);
+  rtp_timer_queue_remove_all (other);
+
+  rtp_object_pool_get_stats (pool, &hits, &misses, &high_water);
+  fail_unless_equals_uint64 (0, hits);
+  fail_unless_equals_uint64 (4, misses);
+  fail_unless_equals_int (4, high_water);
+
+  /* only two were kept around */
+  for (i = 0; i < 3; i++)
+    rtp_timer_queue_set_deadline (queue, i, i * GST_SECOND, 0);
+  rtp_object_pool_get_stats (pool, &hits, &misses, &high_water);
+  fail_unless_equals_uint64 (2, hits);
+  fail_unless_equals_uint64 (5, misses);
+  fail_unless_equals_int (4, high_water);
+
+  g_object_unref (queue);
+  g_object_unref (other);
+  rtp_object_pool_unref (pool);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GstClockTime timeout;
+  guint16 seqnum;
+} PoppedTimer;
+
+/* Bursts of up to 200 missing packets create expected timers, one in three
+ * being a lost timer at the end of the 1s latency instead. Half of each burst
+ * gets a retransmission retry, and the timers expire as time goes by. */
+static gdouble
+run_burst_loss (RtpTimerQueueBackend backend, guint num_timers, GArray * popped)
+{
+  RtpTimerQueue *queue = rtp_timer_queue_new ();
+  GRand *rand = g_rand_new_with_seed (0x5eed);
+  GTimer *gtimer = g_timer_new ();
+  GstClockTime now = 0;
+  RtpTimer *timer;
+  guint seqnum = 0;
+  gdouble elapsed;
+
+  rtp_timer_queue_set_backend (queue, backend);
+
+  while (seqnum < num_timers) {
+    guint burst = g_rand_int_range (rand, 1, 200);
+    guint i;
+
+    for (i = 0; i < burst && seqnum < num_timers; i++, seqnum++) {
+      if (seqnum % 3 == 0)
+        rtp_timer_queue_set_lost (queue, seqnum, now + i * GST_MSECOND,
+            GST_MSECOND, GST_SECOND);
+      else
+        rtp_timer_queue_set_expected (queue, seqnum, now + i * GST_MSECOND,
+            20 * GST_MSECOND, GST_MSECOND);
+    }
+
+    for (i = 0; i < burst / 2; i++) {
+      timer = rtp_timer_queue_find (queue,
+          seqnum - 1 - g_rand_int_range (rand, 0, burst));
+      if (timer && timer->type == RTP_TIMER_EXPECTED)
+        rtp_timer_queue_update_timer (queue, timer, timer->seqnum,
+            timer->timeout, 40 * GST_MSECOND, 0, FALSE);
+    }
+
+    now += burst * GST_MSECOND;
+    while ((timer = rtp_timer_queue_pop_until (queue, now))) {
+      PoppedTimer p = { timer->timeout, timer->seqnum };
+      g_array_append_val (popped, p);
+      rtp_timer_free (timer);
+    }
+  }
+
+  while ((timer = rtp_timer_queue_pop_until (queue, GST_CLOCK_TIME_NONE))) {
+    PoppedTimer p = { timer->timeout, timer->seqnum };
+    g_array_append_val (popped, p);
+    rtp_timer_free (timer);
+  }
+
+  elapsed = g_timer_elapsed (gtimer, NULL);
+
+  g_timer_destroy (gtimer);
+  g_rand_free (rand);
+  g_object_unref (queue);
+
+  return elapsed;
+}
+
+GST_START_TEST (test_timer_queue_burst_loss_performance)
+{
+  const guint num_timers = 10000;
+  GArray *list_popped = g_array_new (FALSE, FALSE, sizeof (PoppedTimer));
+  GArray *wheel_popped = g_array_new (FALSE, FALSE, sizeof (PoppedTimer));
+  gdouble list_time, wheel_time;
+  guint i;
+
+  list_time = run_burst_loss (RTP_TIMER_QUEUE_BACKEND_LIST, num_timers,
+      list_popped);
+  wheel_time = run_burst_loss (RTP_TIMER_QUEUE_BACKEND_WHEEL, num_timers,
+      wheel_popped);
+
+  GST_INFO ("%u timers, list %.3f ms, wheel %.3f ms", num_timers,
+      list_time * 1000, wheel_time * 1000);
+
+  /* both backends must expire the timers in the same order */
+  fail_unless_equals_int (num_timers, list_popped->len);
+  fail_unless_equals_int (num_timers, wheel_popped->len);
+  for (i = 0; i < num_timers; i++) {
+    PoppedTimer *l = &g_array_index (list_popped, PoppedTimer, i);
+    PoppedTimer *w = &g_array_index (wheel_popped, PoppedTimer, i);
+
+    fail_unless_equals_int (l->seqnum, w->seqnum);
+    fail_unless_equals_uint64 (l->timeout, w->timeout);
+    if (i > 0)
+      fail_unless (w->timeout >=
+          g_array_index (wheel_popped, PoppedTimer, i - 1).timeout);
+  }
+
+  g_array_free (list_popped, TRUE);
+  g_array_free (wheel_popped, TRUE);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtptimerqueue_suite (void)
 {
@@ -319,6 +517,9 @@ rtptimerqueue_suite (void)
   tcase_add_test (tc_chain, test_timer_queue_update_timer_seqnum);
   tcase_add_test (tc_chain, test_timer_queue_dup_timer);
   tcase_add_test (tc_chain, test_timer_queue_timer_offset);
+  tcase_add_test (tc_chain, test_timer_queue_wheel_backend);
+  tcase_add_test (tc_chain, test_timer_queue_object_pool);
+  tcase_add_test (tc_chain, test_timer_queue_burst_loss_performance);
 
   return s;
 }
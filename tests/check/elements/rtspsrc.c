@@ -0,0 +1,593 @@
+/* GStreamer
+ * Copyright (C) 2021 Pexip (http://pexip.com/)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <gst/check/gstcheck.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+#include <gio/gio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SSRC 0x12345678
+#define TEST_SESSION "12345678"
+#define TEST_N_PACKETS 50
+
+/* A minimal RTSP server, just enough for rtspsrc to set up one stream with
+ * TCP interleaved transport. After PLAY it sends one RTP packet, then the
+ * remaining packets followed by an RTCP BYE in a single write, so that they
+ * are all waiting on the socket at once.
+ *
+ * With @parameter_burst set it describes a second stream that only ever
+ * sends an RTCP receiver report. That report is sent in the middle of the
+ * burst, and the rest of the packets only follow once a GET_PARAMETER has
+ * been answered. */
+typedef struct
+{
+  GSocketListener *listener;
+  guint16 port;
+  GThread *thread;
+  gboolean parameter_burst;
+} TestServer;
+
+#define TEST_BURST_RTCP_AT 10
+#define TEST_BURST_RESUME_AT 20
+
+static void
+append_frame (GByteArray * data, guint8 channel, GstBuffer * buf)
+{
+  GstMapInfo map;
+  guint8 header[4];
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  header[0] = '$';
+  header[1] = channel;
+  GST_WRITE_UINT16_BE (header + 2, map.size);
+  g_byte_array_append (data, header, sizeof (header));
+  g_byte_array_append (data, map.data, map.size);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+}
+
+static GstBuffer *
+create_rtp_buffer (guint16 seqnum)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+
+  buf = gst_rtp_buffer_new_allocate (8, 0, 0);
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 96);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  gst_rtp_buffer_set_timestamp (&rtp, seqnum * 3000);
+  gst_rtp_buffer_set_ssrc (&rtp, TEST_SSRC);
+  memset (gst_rtp_buffer_get_payload (&rtp), seqnum & 0xff, 8);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+static GstBuffer *
+create_rtcp_rr (guint32 ssrc)
+{
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket packet;
+  GstBuffer *buf;
+
+  buf = gst_rtcp_buffer_new (1000);
+  gst_rtcp_buffer_map (buf, GST_MAP_READWRITE, &rtcp);
+  fail_unless (gst_rtcp_buffer_add_packet (&rtcp, GST_RTCP_TYPE_RR, &packet));
+  gst_rtcp_packet_rr_set_ssrc (&packet, ssrc);
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  return buf;
+}
+
+static GstBuffer *
+create_rtcp_bye (void)
+{
+  GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+  GstRTCPPacket packet;
+  GstBuffer *buf;
+
+  buf = gst_rtcp_buffer_new (1000);
+  gst_rtcp_buffer_map (buf, GST_MAP_READWRITE, &rtcp);
+  fail_unless (gst_rtcp_buffer_add_packet (&rtcp, GST_RTCP_TYPE_RR, &packet));
+  gst_rtcp_packet_rr_set_ssrc (&packet, TEST_SSRC);
+  fail_unless (gst_rtcp_buffer_add_packet (&rtcp, GST_RTCP_TYPE_BYE, &packet));
+  fail_unless (gst_rtcp_packet_bye_add_ssrc (&packet, TEST_SSRC));
+  gst_rtcp_buffer_unmap (&rtcp);
+
+  return buf;
+}
+
+static void
+server_write (GOutputStream * out, const gchar * data, gsize size)
+{
+  fail_unless (g_output_stream_write_all (out, data, size, NULL, NULL, NULL));
+}
+
+static void
+server_reply (GOutputStream * out, guint cseq, const gchar * headers,
+    const gchar * body)
+{
+  gchar *reply;
+
+  reply = g_strdup_printf ("RTSP/1.0 200 OK\r\nCSeq: %u\r\n%s"
+      "Content-Length: %" G_GSIZE_FORMAT "\r\n\r\n%s", cseq, headers,
+      body ? strlen (body) : 0, body ? body : "");
+  server_write (out, reply, strlen (reply));
+  g_free (reply);
+}
+
+static void
+server_send_media (TestServer * server, GOutputStream * out)
+{
+  GByteArray *data;
+  guint16 i;
+
+  data = g_byte_array_new ();
+  append_frame (data, 0, create_rtp_buffer (0));
+  server_write (out, (const gchar *) data->data, data->len);
+  g_byte_array_set_size (data, 0);
+
+  /* let rtspsrc handle the first packet on its own */
+  g_usleep (G_USEC_PER_SEC / 10);
+
+  if (server->parameter_burst) {
+    /* the receiver report of the second stream lands while the RTP before
+     * it is still being collected for the first stream */
+    for (i = 1; i < TEST_BURST_RESUME_AT; i++) {
+      if (i == TEST_BURST_RTCP_AT)
+        append_frame (data, 3, create_rtcp_rr (TEST_SSRC + 1));
+      append_frame (data, 0, create_rtp_buffer (i));
+    }
+  } else {
+    for (i = 1; i < TEST_N_PACKETS; i++)
+      append_frame (data, 0, create_rtp_buffer (i));
+    append_frame (data, 1, create_rtcp_bye ());
+  }
+  server_write (out, (const gchar *) data->data, data->len);
+  g_byte_array_free (data, TRUE);
+}
+
+static void
+server_send_media_rest (GOutputStream * out)
+{
+  GByteArray *data;
+  guint16 i;
+
+  data = g_byte_array_new ();
+  for (i = TEST_BURST_RESUME_AT; i < TEST_N_PACKETS; i++)
+    append_frame (data, 0, create_rtp_buffer (i));
+  append_frame (data, 1, create_rtcp_bye ());
+  server_write (out, (const gchar *) data->data, data->len);
+  g_byte_array_free (data, TRUE);
+}
+
+/* reads the next request, skipping the RTCP that rtspsrc sends on the
+ * interleaved channels */
+static gchar *
+server_read_request (GDataInputStream * in, guint * cseq)
+{
+  GBufferedInputStream *bin = G_BUFFERED_INPUT_STREAM (in);
+  gchar *method, *line, *space;
+  gint c;
+
+  while ((c = g_buffered_input_stream_read_byte (bin, NULL, NULL)) == '$') {
+    guint8 header[3];
+
+    if (!g_input_stream_read_all (G_INPUT_STREAM (in), header,
+            sizeof (header), NULL, NULL, NULL))
+      return NULL;
+    g_input_stream_skip (G_INPUT_STREAM (in), GST_READ_UINT16_BE (header + 1),
+        NULL, NULL);
+  }
+  if (c < 0)
+    return NULL;
+
+  line = g_data_input_stream_read_line (in, NULL, NULL, NULL);
+  if (line == NULL)
+    return NULL;
+  method = g_strdup_printf ("%c%s", c, line);
+  if ((space = strchr (method, ' ')))
+    *space = '\0';
+  g_free (line);
+
+  /* headers, up to the empty line */
+  while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+    g_strchomp (line);
+    if (*line == '\0') {
+      g_free (line);
+      break;
+    }
+    if (g_ascii_strncasecmp (line, "CSeq:", 5) == 0)
+      *cseq = atoi (line + 5);
+    g_free (line);
+  }
+
+  return method;
+}
+
+static gpointer
+server_thread_func (TestServer * server)
+{
+  GSocketConnection *conn;
+  GDataInputStream *in;
+  GOutputStream *out;
+  gchar *method;
+  guint cseq = 0;
+  guint n_setups = 0;
+  gboolean resumed = FALSE;
+
+  conn = g_socket_listener_accept (server->listener, NULL, NULL, NULL);
+  fail_unless (conn != NULL);
+
+  in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (conn)));
+  out = g_io_stream_get_output_stream (G_IO_STREAM (conn));
+
+  while ((method = server_read_request (in, &cseq))) {
+    if (g_str_equal (method, "DESCRIBE")) {
+      gchar *headers, *sdp;
+
+      headers = g_strdup_printf ("Content-Type: application/sdp\r\n"
+          "Content-Base: rtsp://127.0.0.1:%u/test/\r\n", server->port);
+      sdp = g_strdup ("v=0\r\n"
+          "o=- 0 0 IN IP4 127.0.0.1\r\n"
+          "s=test\r\n"
+          "c=IN IP4 0.0.0.0\r\n"
+          "t=0 0\r\n"
+          "m=application 0 RTP/AVP 96\r\n"
+          "a=rtpmap:96 X-TEST/90000\r\n" "a=control:stream=0\r\n");
+      if (server->parameter_burst) {
+        gchar *tmp = sdp;
+
+        sdp = g_strconcat (tmp, "m=application 0 RTP/AVP 96\r\n"
+            "a=rtpmap:96 X-TEST/90000\r\n" "a=control:stream=1\r\n", NULL);
+        g_free (tmp);
+      }
+      server_reply (out, cseq, headers, sdp);
+      g_free (headers);
+      g_free (sdp);
+    } else if (g_str_equal (method, "SETUP")) {
+      gchar *headers;
+
+      headers = g_strdup_printf ("Transport: RTP/AVP/TCP;unicast;"
+          "interleaved=%u-%u;ssrc=%08X\r\nSession: " TEST_SESSION "\r\n",
+          2 * n_setups, 2 * n_setups + 1, TEST_SSRC + n_setups);
+      server_reply (out, cseq, headers, NULL);
+      g_free (headers);
+      n_setups++;
+    } else if (g_str_equal (method, "PLAY")) {
+      server_reply (out, cseq, "Session: " TEST_SESSION "\r\n"
+          "Range: npt=0-\r\n", NULL);
+      server_send_media (server, out);
+    } else if (g_str_equal (method, "GET_PARAMETER") &&
+        server->parameter_burst && !resumed) {
+      server_reply (out, cseq, "Session: " TEST_SESSION "\r\n"
+          "Content-Type: text/parameters\r\n", "param: 1\r\n");
+      server_send_media_rest (out);
+      resumed = TRUE;
+    } else if (g_str_equal (method, "TEARDOWN")) {
+      server_reply (out, cseq, "Session: " TEST_SESSION "\r\n", NULL);
+      g_free (method);
+      break;
+    } else {
+      server_reply (out, cseq, "Public: OPTIONS, DESCRIBE, SETUP, PLAY, "
+          "TEARDOWN, GET_PARAMETER\r\n", NULL);
+    }
+    g_free (method);
+  }
+
+  g_object_unref (in);
+  g_io_stream_close (G_IO_STREAM (conn), NULL, NULL);
+  g_object_unref (conn);
+
+  return NULL;
+}
+
+static TestServer *
+test_server_new (gboolean parameter_burst)
+{
+  TestServer *server = g_new0 (TestServer, 1);
+
+  server->parameter_burst = parameter_burst;
+
+  server->listener = g_socket_listener_new ();
+  server->port = g_socket_listener_add_any_inet_port (server->listener, NULL,
+      NULL);
+  fail_unless (server->port != 0);
+
+  server->thread = g_thread_new ("rtsp-server",
+      (GThreadFunc) server_thread_func, server);
+
+  return server;
+}
+
+static void
+test_server_free (TestServer * server)
+{
+  g_thread_join (server->thread);
+  g_socket_listener_close (server->listener);
+  g_object_unref (server->listener);
+  g_free (server);
+}
+
+typedef struct
+{
+  GMutex lock;
+  GArray *seqnums;
+  gboolean got_eos;
+  gboolean buffer_after_eos;
+} ReceivedData;
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    ReceivedData * received)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint16 seqnum;
+
+  fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+  seqnum = gst_rtp_buffer_get_seq (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  g_mutex_lock (&received->lock);
+  if (received->got_eos)
+    received->buffer_after_eos = TRUE;
+  g_array_append_val (received->seqnums, seqnum);
+  g_mutex_unlock (&received->lock);
+}
+
+static GstPadProbeReturn
+eos_probe (GstPad * pad, GstPadProbeInfo * info, ReceivedData * received)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS) {
+    g_mutex_lock (&received->lock);
+    received->got_eos = TRUE;
+    g_mutex_unlock (&received->lock);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_interleaved_rtp_rtcp_eos_order)
+{
+  TestServer *server;
+  GstElement *pipeline, *src, *sink;
+  GstPad *sinkpad;
+  GstBus *bus;
+  GstMessage *msg;
+  ReceivedData received;
+  gchar *location;
+  guint i;
+
+  g_mutex_init (&received.lock);
+  received.seqnums = g_array_new (FALSE, FALSE, sizeof (guint16));
+  received.got_eos = FALSE;
+  received.buffer_after_eos = FALSE;
+
+  server = test_server_new (FALSE);
+
+  pipeline = gst_parse_launch ("rtspsrc name=src protocols=tcp latency=0 "
+      "! fakesink name=sink signal-handoffs=true sync=false", NULL);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+
+  location = g_strdup_printf ("rtsp://127.0.0.1:%u/test", server->port);
+  g_object_set (src, "location", location, NULL);
+  g_free (location);
+
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), &received);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) eos_probe, &received, NULL);
+  gst_object_unref (sinkpad);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  /* the BYE after the last packet ends the stream */
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  /* every RTP packet sent before the BYE arrived, in order, before EOS */
+  g_mutex_lock (&received.lock);
+  fail_if (received.buffer_after_eos);
+  fail_unless_equals_int (received.seqnums->len, TEST_N_PACKETS);
+  for (i = 0; i < received.seqnums->len; i++)
+    fail_unless_equals_int (g_array_index (received.seqnums, guint16, i), i);
+  g_mutex_unlock (&received.lock);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+
+  test_server_free (server);
+
+  g_array_free (received.seqnums, TRUE);
+  g_mutex_clear (&received.lock);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gboolean blocked;
+  gboolean released;
+} BlockData;
+
+static GstPadProbeReturn
+block_rtcp_probe (GstPad * pad, GstPadProbeInfo * info, BlockData * block)
+{
+  g_mutex_lock (&block->lock);
+  block->blocked = TRUE;
+  g_cond_broadcast (&block->cond);
+  while (!block->released)
+    g_cond_wait (&block->cond, &block->lock);
+  g_mutex_unlock (&block->lock);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+static void
+on_manager_pad_added (GstElement * manager, GstPad * pad, BlockData * block)
+{
+  gchar *name = gst_pad_get_name (pad);
+
+  /* the second stream only carries RTCP */
+  if (g_str_equal (name, "recv_rtcp_sink_1"))
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        (GstPadProbeCallback) block_rtcp_probe, block, NULL);
+  g_free (name);
+}
+
+static void
+on_new_manager (GstElement * src, GstElement * manager, BlockData * block)
+{
+  g_signal_connect (manager, "pad-added", G_CALLBACK (on_manager_pad_added),
+      block);
+}
+
+GST_START_TEST (test_interleaved_get_parameter_during_burst)
+{
+  TestServer *server;
+  GstElement *pipeline, *src, *sink;
+  GstPad *sinkpad;
+  GstBus *bus;
+  GstMessage *msg;
+  GstPromise *promise;
+  const GstStructure *reply;
+  ReceivedData received;
+  BlockData block;
+  gchar *location;
+  gint64 end_time;
+  gboolean ret = FALSE;
+  gint code;
+  guint i;
+
+  g_mutex_init (&received.lock);
+  received.seqnums = g_array_new (FALSE, FALSE, sizeof (guint16));
+  received.got_eos = FALSE;
+  received.buffer_after_eos = FALSE;
+
+  g_mutex_init (&block.lock);
+  g_cond_init (&block.cond);
+  block.blocked = FALSE;
+  block.released = FALSE;
+
+  server = test_server_new (TRUE);
+
+  pipeline = gst_parse_launch ("rtspsrc name=src protocols=tcp latency=0 "
+      "! fakesink name=sink signal-handoffs=true sync=false", NULL);
+  fail_unless (pipeline != NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+
+  location = g_strdup_printf ("rtsp://127.0.0.1:%u/test", server->port);
+  g_object_set (src, "location", location, NULL);
+  g_free (location);
+
+  g_signal_connect (src, "new-manager", G_CALLBACK (on_new_manager), &block);
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), &received);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) eos_probe, &received, NULL);
+  gst_object_unref (sinkpad);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  /* wait until the receive loop is stuck on the RTCP of the second stream,
+   * with the RTP before it still collected for the first one */
+  end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&block.lock);
+  while (!block.blocked)
+    fail_unless (g_cond_wait_until (&block.cond, &block.lock, end_time));
+  g_mutex_unlock (&block.lock);
+
+  /* this interrupts the loop, which then finds more data on the socket */
+  promise = gst_promise_new ();
+  g_signal_emit_by_name (src, "get-parameter", "param", NULL, promise, &ret);
+  fail_unless (ret);
+
+  g_mutex_lock (&block.lock);
+  block.released = TRUE;
+  g_cond_broadcast (&block.cond);
+  g_mutex_unlock (&block.lock);
+
+  fail_unless_equals_int (gst_promise_wait (promise),
+      GST_PROMISE_RESULT_REPLIED);
+  reply = gst_promise_get_reply (promise);
+  fail_unless (gst_structure_get_int (reply, "rtsp-code", &code));
+  fail_unless_equals_int (code, 200);
+  gst_promise_unref (promise);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  /* the interruption did not lose any of the packets collected before it */
+  g_mutex_lock (&received.lock);
+  fail_if (received.buffer_after_eos);
+  fail_unless_equals_int (received.seqnums->len, TEST_N_PACKETS);
+  for (i = 0; i < received.seqnums->len; i++)
+    fail_unless_equals_int (g_array_index (received.seqnums, guint16, i), i);
+  g_mutex_unlock (&received.lock);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+
+  test_server_free (server);
+
+  g_cond_clear (&block.cond);
+  g_mutex_clear (&block.lock);
+  g_array_free (received.seqnums, TRUE);
+  g_mutex_clear (&received.lock);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtspsrc_suite (void)
+{
+  Suite *s = suite_create ("rtspsrc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_interleaved_rtp_rtcp_eos_order);
+  tcase_add_test (tc_chain, test_interleaved_get_parameter_during_burst);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtspsrc);
@@ -589,6 +589,176 @@ GST_START_TEST (test_splitmuxsink_async)
 
 GST_END_TEST;
 
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint muxers_created;
+  gboolean checked_first, checked_second;
+  GPtrArray *added;
+  GstElement *splitmuxsink;
+} PreparedFragmentState;
+
+/* matroskamux adds its src pad on creation, before it is named */
+static gboolean
+count_muxer_created (G_GNUC_UNUSED GSignalInvocationHint * ihint,
+    G_GNUC_UNUSED guint n_param_values, const GValue * param_values,
+    gpointer user_data)
+{
+  PreparedFragmentState *state = user_data;
+  GstElement *element = g_value_get_object (&param_values[0]);
+  GstPad *pad = g_value_get_object (&param_values[1]);
+
+  if (g_str_equal (G_OBJECT_TYPE_NAME (element), "GstMatroskaMux") &&
+      GST_PAD_IS_SRC (pad)) {
+    g_mutex_lock (&state->lock);
+    state->muxers_created++;
+    g_cond_broadcast (&state->cond);
+    g_mutex_unlock (&state->lock);
+  }
+
+  return TRUE;
+}
+
+static void
+wait_muxers_created (PreparedFragmentState * state, guint count)
+{
+  gint64 deadline = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&state->lock);
+  while (state->muxers_created < count)
+    fail_unless (g_cond_wait_until (&state->cond, &state->lock, deadline),
+        "Timed out waiting for muxer %u to be created", count);
+  g_mutex_unlock (&state->lock);
+}
+
+static void
+record_muxer_added (G_GNUC_UNUSED GstElement * splitmuxsink,
+    GstElement * muxer, PreparedFragmentState * state)
+{
+  gchar *writing_app;
+
+  /* only the muxers of the fragments after the first one */
+  if (!g_str_has_prefix (GST_OBJECT_NAME (muxer), "muxer_"))
+    return;
+
+  g_object_get (muxer, "writing-app", &writing_app, NULL);
+  g_ptr_array_add (state->added, g_strdup_printf ("%s:%s",
+          GST_OBJECT_NAME (muxer), writing_app));
+  g_free (writing_app);
+}
+
+static GstPadProbeReturn
+change_muxer_properties (G_GNUC_UNUSED GstPad * pad, GstPadProbeInfo * info,
+    PreparedFragmentState * state)
+{
+  GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime pts = GST_BUFFER_PTS (buf);
+
+  if (!state->checked_first && pts >= 1400 * GST_MSECOND) {
+    /* the first fragment has started, the muxer for the second one is
+     * prepared */
+    wait_muxers_created (state, 2);
+    state->checked_first = TRUE;
+  } else if (!state->checked_second && pts >= 2400 * GST_MSECOND) {
+    GstStructure *props;
+
+    /* the second fragment has started, with the prepared muxer, and the
+     * muxer for the third one is prepared */
+    wait_muxers_created (state, 3);
+    g_mutex_lock (&state->lock);
+    fail_unless_equals_int (3, state->muxers_created);
+    g_mutex_unlock (&state->lock);
+
+    /* which makes the prepared one stale */
+    props = gst_structure_new ("properties",
+        "writing-app", G_TYPE_STRING, "changed", NULL);
+    g_object_set (state->splitmuxsink, "muxer-properties", props, NULL);
+    gst_structure_free (props);
+    state->checked_second = TRUE;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_splitmuxsink_async_prepared)
+{
+  PreparedFragmentState state = { {0}, };
+  GstMessage *msg;
+  GstElement *pipeline;
+  GstElement *sink, *enc;
+  GstPad *enc_src_pad;
+  gchar *dest_pattern;
+  guint count, pad_added_id;
+  gulong hook_id;
+
+  g_mutex_init (&state.lock);
+  g_cond_init (&state.cond);
+  state.added = g_ptr_array_new_with_free_func (g_free);
+
+  pad_added_id = g_signal_lookup ("pad-added", GST_TYPE_ELEMENT);
+  hook_id = g_signal_add_emission_hook (pad_added_id, 0, count_muxer_created,
+      &state, NULL);
+
+  pipeline =
+      gst_parse_launch
+      ("videotestsrc num-buffers=15 ! video/x-raw,width=80,height=64,framerate=5/1 ! videoconvert !"
+      " queue ! theoraenc name=enc keyframe-force=5 ! splitmuxsink name=splitsink "
+      " max-size-time=1000000000 async-finalize=true muxer-factory=matroskamux",
+      NULL);
+  fail_if (pipeline == NULL);
+  state.splitmuxsink = sink =
+      gst_bin_get_by_name (GST_BIN (pipeline), "splitsink");
+  fail_if (sink == NULL);
+  g_signal_connect (sink, "muxer-added", (GCallback) record_muxer_added,
+      &state);
+  dest_pattern = g_build_filename (tmpdir, "matroska%05d.mkv", NULL);
+  g_object_set (G_OBJECT (sink), "location", dest_pattern, NULL);
+  g_free (dest_pattern);
+
+  enc = gst_bin_get_by_name (GST_BIN (pipeline), "enc");
+  fail_if (enc == NULL);
+  enc_src_pad = gst_element_get_static_pad (enc, "src");
+  gst_pad_add_probe (enc_src_pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) change_muxer_properties, &state, NULL);
+  gst_object_unref (enc_src_pad);
+  gst_object_unref (enc);
+
+  msg = run_pipeline (pipeline);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+    dump_error (msg);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  fail_unless (state.checked_first);
+  fail_unless (state.checked_second);
+
+  /* the prepared muxer is used for the second fragment, the stale one for
+   * the third fragment is replaced, and the signal is only emitted for the
+   * muxers that were used */
+  fail_unless_equals_int (2, state.added->len);
+  fail_unless (g_str_has_prefix (g_ptr_array_index (state.added, 0),
+          "muxer_1:"));
+  fail_if (g_str_has_suffix (g_ptr_array_index (state.added, 0),
+          ":changed"));
+  fail_unless_equals_string ("muxer_2:changed",
+      g_ptr_array_index (state.added, 1));
+
+  g_signal_remove_emission_hook (pad_added_id, hook_id);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+
+  count = count_files (tmpdir);
+  fail_unless (count == 3, "Expected 3 output files, got %d", count);
+
+  g_ptr_array_unref (state.added);
+  g_mutex_clear (&state.lock);
+  g_cond_clear (&state.cond);
+}
+
+GST_END_TEST;
+
 /* For verifying bug https://bugzilla.gnome.org/show_bug.cgi?id=762893 */
 GST_START_TEST (test_splitmuxsink_reuse_simple)
 {
@@ -851,6 +1021,7 @@ splitmuxsink_suite (void)
           tempdir_cleanup);
 
       tcase_add_test (tc_chain, test_splitmuxsink_async);
+      tcase_add_test (tc_chain, test_splitmuxsink_async_prepared);
     } else {
       GST_INFO ("Skipping tests, missing plugins: matroska and/or vorbis");
     }
@@ -239,6 +239,78 @@ GST_START_TEST (test_udpsink_dscp)
 
 GST_END_TEST;
 
+GST_START_TEST (test_udpsink_gso)
+{
+  GstSegment segment;
+  GstElement *udpsink;
+  GstPad *srcpad;
+  GstBufferList *list;
+  GSocket *socket;
+  GInetAddress *ia;
+  GSocketAddress *sa, *local_sa;
+  guint64 gso_sends, gso_segments;
+  gchar data[2000];
+  gint port, i;
+
+  ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  sa = g_inet_socket_address_new (ia, 0);
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+  fail_unless (g_socket_bind (socket, sa, TRUE, NULL));
+  local_sa = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (local_sa));
+  g_object_unref (local_sa);
+  g_object_unref (sa);
+  g_object_unref (ia);
+
+  /* five packets of the same size and a shorter one, which can all be sent
+   * as one segmentation offload message, followed by a bigger packet */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 5; i++)
+    gst_buffer_list_add (list, gst_buffer_new_allocate (NULL, 1000, NULL));
+  gst_buffer_list_add (list, gst_buffer_new_allocate (NULL, 500, NULL));
+  gst_buffer_list_add (list, gst_buffer_new_allocate (NULL, 1200, NULL));
+
+  udpsink = gst_check_setup_element ("udpsink");
+  g_object_set (udpsink, "host", "127.0.0.1", "port", port, "gso", TRUE, NULL);
+  srcpad = gst_check_setup_src_pad_by_name (udpsink, &srctemplate, "sink");
+
+  gst_element_set_state (udpsink, GST_STATE_PLAYING);
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("hey there!"));
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  fail_unless_equals_int (gst_pad_push_list (srcpad, list), GST_FLOW_OK);
+
+  /* whether offloaded or not, the receiver sees the original packets */
+  for (i = 0; i < 7; i++) {
+    gssize expected = (i < 5) ? 1000 : (i == 5) ? 500 : 1200;
+
+    fail_unless_equals_int (g_socket_receive (socket, data, sizeof (data),
+            NULL, NULL), expected);
+  }
+
+  g_object_get (udpsink, "gso-sends", &gso_sends, "gso-segments",
+      &gso_segments, NULL);
+  GST_INFO ("%" G_GUINT64_FORMAT " GSO sends, %" G_GUINT64_FORMAT
+      " segments", gso_sends, gso_segments);
+  if (gso_sends > 0) {
+    fail_unless_equals_int (gso_sends, 1);
+    fail_unless_equals_int (gso_segments, 6);
+  }
+
+  gst_check_teardown_pad_by_name (udpsink, "sink");
+  gst_check_teardown_element (udpsink);
+
+  g_object_unref (socket);
+}
+
+GST_END_TEST;
+
 static Suite *
 udpsink_suite (void)
 {
@@ -251,6 +323,7 @@ udpsink_suite (void)
   tcase_add_test (tc_chain, test_udpsink_bufferlist);
   tcase_add_test (tc_chain, test_udpsink_client_add_remove);
   tcase_add_test (tc_chain, test_udpsink_dscp);
+  tcase_add_test (tc_chain, test_udpsink_gso);
 
   return s;
 }
@@ -17,6 +17,7 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <gst/check/gstcheck.h>
+#include <gst/net/gstnetaddressmeta.h>
 #include <gio/gio.h>
 #include <stdlib.h>
 
@@ -27,7 +28,7 @@ static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
 
 static gboolean
 udpsrc_setup (GstElement ** udpsrc, GSocket ** socket,
-    GstPad ** sinkpad, GSocketAddress ** sa)
+    GstPad ** sinkpad, GSocketAddress ** sa, guint batch_size)
 {
   GInetAddress *ia;
   int port = 0;
@@ -35,7 +36,7 @@ udpsrc_setup (GstElement ** udpsrc, GSocket ** socket,
 
   *udpsrc = gst_check_setup_element ("udpsrc");
   fail_unless (*udpsrc != NULL);
-  g_object_set (*udpsrc, "port", 0, NULL);
+  g_object_set (*udpsrc, "port", 0, "batch-size", batch_size, NULL);
 
   *sinkpad = gst_check_setup_sink_pad_by_name (*udpsrc, &sinktemplate, "src");
   fail_unless (*sinkpad != NULL);
@@ -70,7 +71,7 @@ GST_START_TEST (test_udpsrc_empty_packet)
   GSocket *socket = NULL;
   GstPad *sinkpad = NULL;
 
-  if (!udpsrc_setup (&udpsrc, &socket, &sinkpad, &sa))
+  if (!udpsrc_setup (&udpsrc, &socket, &sinkpad, &sa, 1))
     goto no_socket;
 
   if (g_socket_send_to (socket, sa, "HeLL0", 0, NULL, NULL) == 0) {
@@ -152,7 +153,7 @@ GST_START_TEST (test_udpsrc)
   for (i = 0; i < G_N_ELEMENTS (data); ++i)
     data[i] = i & 0xff;
 
-  if (!udpsrc_setup (&udpsrc, &socket, &sinkpad, &sa))
+  if (!udpsrc_setup (&udpsrc, &socket, &sinkpad, &sa, 1))
     goto no_socket;
 
   if ((sent = g_socket_send_to (socket, sa, data, 48000, NULL, &err)) == -1)
@@ -247,6 +248,171 @@ send_failure:
 
 GST_END_TEST;
 
+GST_START_TEST (test_udpsrc_batch)
+{
+  GSocketAddress *sa = NULL;
+  GstElement *udpsrc = NULL;
+  GSocket *socket = NULL;
+  GstPad *sinkpad = NULL;
+  GstBuffer *buf;
+  GstNetAddressMeta *meta;
+  gchar data[3000];
+  int i, len = 0;
+  gssize sent;
+  GError *err = NULL;
+
+  for (i = 0; i < G_N_ELEMENTS (data); ++i)
+    data[i] = i & 0xff;
+
+  if (!udpsrc_setup (&udpsrc, &socket, &sinkpad, &sa, 8))
+    goto no_socket;
+
+  /* more packets than fit in one batch, one of them bigger than the mtu */
+  for (i = 0; i < 12; i++) {
+    gsize size = (i == 5) ? 3000 : 100 + i;
+
+    if ((sent = g_socket_send_to (socket, sa, data, size, NULL, &err)) == -1)
+      goto send_failure;
+    fail_unless_equals_int (sent, size);
+  }
+
+  GST_INFO ("sent some packets");
+
+  g_mutex_lock (&check_mutex);
+  len = g_list_length (buffers);
+  while (len < 12) {
+    g_cond_wait (&check_cond, &check_mutex);
+    len = g_list_length (buffers);
+    GST_INFO ("%u buffers", len);
+  }
+
+  for (i = 0; i < 12; i++) {
+    buf = GST_BUFFER (g_list_nth_data (buffers, i));
+    if (i == 5) {
+      fail_unless_equals_int (gst_buffer_get_size (buf), 3000);
+      fail_unless_equals_int (gst_buffer_n_memory (buf), 2);
+    } else {
+      fail_unless_equals_int (gst_buffer_get_size (buf), 100 + i);
+      fail_unless_equals_int (gst_buffer_n_memory (buf), 1);
+    }
+    fail_unless (GST_BUFFER_DTS_IS_VALID (buf));
+    fail_unless_equals_int (gst_buffer_memcmp (buf, 0, data, 100), 0);
+
+    meta = gst_buffer_get_net_address_meta (buf);
+    fail_unless (meta != NULL);
+    fail_unless (G_IS_INET_SOCKET_ADDRESS (meta->addr));
+  }
+
+  g_list_foreach (buffers, (GFunc) gst_buffer_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+
+  g_mutex_unlock (&check_mutex);
+
+no_socket:
+send_failure:
+  if (err) {
+    GST_WARNING ("Socket send error, skipping test: %s", err->message);
+    g_clear_error (&err);
+  }
+
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+
+  g_object_unref (socket);
+  g_object_unref (sa);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_udpsrc_socket_timestamp)
+{
+  GSocketAddress *sa = NULL;
+  GstElement *udpsrc;
+  GSocket *socket;
+  GstPad *sinkpad;
+  GInetAddress *ia;
+  GParamSpec *pspec;
+  GEnumClass *enum_class;
+  GstClock *clock;
+  GstClockTime now;
+  GstBuffer *buf;
+  gint port = 0, mode = 0;
+  gssize sent;
+  GError *err = NULL;
+
+  udpsrc = gst_check_setup_element ("udpsrc");
+  gst_util_set_object_arg (G_OBJECT (udpsrc), "socket-timestamp",
+      "timestamping");
+  g_object_set (udpsrc, "port", 0, NULL);
+
+  clock = gst_system_clock_obtain ();
+  gst_element_set_clock (udpsrc, clock);
+  gst_element_set_base_time (udpsrc, gst_clock_get_time (clock));
+
+  sinkpad = gst_check_setup_sink_pad_by_name (udpsrc, &sinktemplate, "src");
+  gst_pad_set_active (sinkpad, TRUE);
+
+  fail_unless_equals_int (gst_element_set_state (udpsrc, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (udpsrc, "port", &port, NULL);
+
+  /* falling back to another mode must not change the property */
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (udpsrc),
+      "socket-timestamp");
+  enum_class = g_type_class_ref (G_PARAM_SPEC_VALUE_TYPE (pspec));
+  g_object_get (udpsrc, "socket-timestamp", &mode, NULL);
+  fail_unless_equals_string (g_enum_get_value (enum_class, mode)->value_nick,
+      "timestamping");
+  g_type_class_unref (enum_class);
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  if (socket == NULL)
+    goto no_socket;
+
+  ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  sa = g_inet_socket_address_new (ia, port);
+  g_object_unref (ia);
+
+  if ((sent = g_socket_send_to (socket, sa, "HeLL0", 6, NULL, &err)) == -1)
+    goto send_failure;
+  fail_unless_equals_int (sent, 6);
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 1)
+    g_cond_wait (&check_cond, &check_mutex);
+
+  /* the arrival time is a running time from before we got the buffer */
+  now = gst_clock_get_time (clock) - gst_element_get_base_time (udpsrc);
+  buf = GST_BUFFER (buffers->data);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 6);
+  fail_unless (GST_BUFFER_DTS_IS_VALID (buf));
+  fail_unless (GST_BUFFER_DTS (buf) <= now);
+  g_mutex_unlock (&check_mutex);
+
+send_failure:
+  if (err) {
+    GST_WARNING ("Socket send error, skipping test: %s", err->message);
+    g_clear_error (&err);
+  }
+  g_object_unref (socket);
+  g_object_unref (sa);
+
+no_socket:
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_drop_buffers ();
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 static Suite *
 udpsrc_suite (void)
 {
@@ -256,6 +422,8 @@ udpsrc_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_udpsrc_empty_packet);
   tcase_add_test (tc_chain, test_udpsrc);
+  tcase_add_test (tc_chain, test_udpsrc_batch);
+  tcase_add_test (tc_chain, test_udpsrc_socket_timestamp);
   return s;
 }
 